@@ -168,7 +168,115 @@ int stress_change_cpu(stress_args_t *args, const int old_cpu)
 	return (int)from_cpu;
 }
 
+/* CPU topology for stress_affinity_cpus_by_core() */
+typedef struct {
+	int cpu;		/* CPU number */
+	int package;		/* physical package (socket) */
+	int sibling;		/* 1 if not the first SMT thread of a core */
+	int core;		/* core id in the package */
+} stress_affinity_cpu_t;
+
+/*
+ *  stress_affinity_topology()
+ *	read the first number from a CPU topology file, -1 on failure
+ */
+static int stress_affinity_topology(const int cpu, const char *name)
+{
+	char path[PATH_MAX], buf[64];
+	int val;
+
+	(void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+	if (stress_system_read(path, buf, sizeof(buf)) <= 0)
+		return -1;
+	if (sscanf(buf, "%d", &val) != 1)
+		return -1;
+	return val;
+}
+
+/*
+ *  stress_affinity_cpu_cmp()
+ *	sort by package, first threads before siblings, core, cpu
+ */
+static int stress_affinity_cpu_cmp(const void *p1, const void *p2)
+{
+	const stress_affinity_cpu_t *c1 = (const stress_affinity_cpu_t *)p1;
+	const stress_affinity_cpu_t *c2 = (const stress_affinity_cpu_t *)p2;
+
+	if (c1->package != c2->package)
+		return (c1->package < c2->package) ? -1 : 1;
+	if (c1->sibling != c2->sibling)
+		return (c1->sibling < c2->sibling) ? -1 : 1;
+	if (c1->core != c2->core)
+		return (c1->core < c2->core) ? -1 : 1;
+	return (c1->cpu < c2->cpu) ? -1 : (c1->cpu > c2->cpu);
+}
+
+/*
+ *  stress_affinity_cpus_by_core()
+ *	fill cpus with up to max_cpus of the CPUs the process can
+ *	run on, ordered by package with one CPU per physical core
+ *	first followed by the SMT siblings, returns the number of CPUs
+ */
+int stress_affinity_cpus_by_core(int *cpus, const int max_cpus)
+{
+	cpu_set_t mask;
+	stress_affinity_cpu_t *info;
+	int cpu, i, n = 0;
+
+	if (sched_getaffinity(0, sizeof(mask), &mask) < 0)
+		return -1;
+	info = calloc((size_t)CPU_SETSIZE, sizeof(*info));
+	if (!info)
+		return -1;
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &mask))
+			continue;
+		info[n].cpu = cpu;
+		info[n].package = stress_affinity_topology(cpu, "physical_package_id");
+		info[n].core = stress_affinity_topology(cpu, "core_id");
+		i = stress_affinity_topology(cpu, "thread_siblings_list");
+		info[n].sibling = (i >= 0) && (i != cpu);
+		n++;
+	}
+	qsort(info, (size_t)n, sizeof(*info), stress_affinity_cpu_cmp);
+	if (n > max_cpus)
+		n = max_cpus;
+	for (i = 0; i < n; i++)
+		cpus[i] = info[i].cpu;
+	free(info);
+
+	return n;
+}
+
+/*
+ *  stress_affinity_pin()
+ *	pin the calling process to a CPU
+ */
+int stress_affinity_pin(const int cpu)
+{
+	cpu_set_t mask;
+
+	CPU_ZERO(&mask);
+	CPU_SET(cpu, &mask);
+	return sched_setaffinity(0, sizeof(mask), &mask);
+}
 #else
+int stress_affinity_cpus_by_core(int *cpus, const int max_cpus)
+{
+	(void)cpus;
+	(void)max_cpus;
+
+	return -1;
+}
+
+int stress_affinity_pin(const int cpu)
+{
+	(void)cpu;
+
+	errno = ENOSYS;
+	return -1;
+}
+
 int stress_change_cpu(stress_args_t *args, const int old_cpu)
 {
 	(void)args;
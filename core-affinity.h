@@ -21,5 +21,7 @@
 
 extern int stress_set_cpu_affinity(const char *arg);
 extern int stress_change_cpu(stress_args_t *args, const int old_cpu);
+extern int stress_affinity_cpus_by_core(int *cpus, const int max_cpus);
+extern int stress_affinity_pin(const int cpu);
 
 #endif
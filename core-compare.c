@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-compare.h"
+
+#define STRESS_COMPARE_RUNS_MAX		(1000)	/* maximum number of repeated runs */
+#define STRESS_COMPARE_TOLERANCE	(5.0)	/* default tolerance in percent */
+
+/* baseline throughput of a stressor from the baseline YAML log */
+typedef struct stress_compare_baseline {
+	struct stress_compare_baseline *next; /* next in list */
+	char *name;			/* stressor name */
+	double rate;			/* bogo-ops per second (real time) */
+} stress_compare_baseline_t;
+
+/* per stressor throughput samples, one per run */
+typedef struct stress_compare_info {
+	struct stress_compare_info *next; /* next in list */
+	const stress_stressor_t *ss;	/* stressor being sampled */
+	uint64_t last_ops;		/* bogo-ops total at end of last run */
+	double last_duration;		/* run time total at end of last run */
+	size_t n;			/* number of samples */
+	double *rates;			/* bogo-ops per second per run */
+} stress_compare_info_t;
+
+/* two sided 95% Student's t critical values, 1..30 degrees of freedom */
+static const double stress_compare_t95[] = {
+	12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+	2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+	2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+static uint32_t compare_runs = 1;
+static double compare_tolerance = STRESS_COMPARE_TOLERANCE;
+static stress_compare_baseline_t *baseline_head = NULL;
+static stress_compare_info_t *compare_head = NULL;
+
+/*
+ *  stress_set_compare_runs()
+ *	parse --compare-runs option
+ */
+int stress_set_compare_runs(const char *const opt)
+{
+	const uint32_t runs = stress_get_uint32(opt);
+
+	stress_check_range("compare-runs", (uint64_t)runs, 1, STRESS_COMPARE_RUNS_MAX);
+	compare_runs = runs;
+	return 0;
+}
+
+/*
+ *  stress_set_compare_tolerance()
+ *	parse --compare-tolerance option, a percentage
+ */
+int stress_set_compare_tolerance(const char *const opt)
+{
+	double tolerance;
+
+	if ((sscanf(opt, "%lf", &tolerance) != 1) ||
+	    (tolerance < 0.0) || (tolerance > 100.0)) {
+		(void)fprintf(stderr, "compare-tolerance must be a percentage in the range 0 to 100.\n");
+		_exit(EXIT_FAILURE);
+	}
+	compare_tolerance = tolerance;
+	return 0;
+}
+
+/*
+ *  stress_compare_enabled()
+ *	return true if comparing against a baseline
+ */
+bool stress_compare_enabled(void)
+{
+	return baseline_head != NULL;
+}
+
+/*
+ *  stress_compare_runs()
+ *	number of times to run the stressors
+ */
+uint32_t stress_compare_runs(void)
+{
+	return stress_compare_enabled() ? compare_runs : 1;
+}
+
+/*
+ *  stress_compare_baseline_add()
+ *	add baseline throughput for stressor name
+ */
+static int stress_compare_baseline_add(const char *name, const double rate)
+{
+	stress_compare_baseline_t *baseline;
+
+	baseline = calloc(1, sizeof(*baseline));
+	if (!baseline)
+		return -1;
+	baseline->name = strdup(name);
+	if (!baseline->name) {
+		free(baseline);
+		return -1;
+	}
+	baseline->rate = rate;
+	baseline->next = baseline_head;
+	baseline_head = baseline;
+	return 0;
+}
+
+/*
+ *  stress_compare_baseline_find()
+ *	find baseline of stressor name, NULL if not found
+ */
+static const stress_compare_baseline_t *stress_compare_baseline_find(const char *name)
+{
+	const stress_compare_baseline_t *baseline;
+
+	for (baseline = baseline_head; baseline; baseline = baseline->next) {
+		if (!strcmp(baseline->name, name))
+			return baseline;
+	}
+	return NULL;
+}
+
+/*
+ *  stress_compare_load()
+ *	load the bogo-ops per second (real time) of each stressor
+ *	from the metrics section of a YAML log written by a previous
+ *	run with --metrics and --yaml
+ */
+int stress_compare_load(void)
+{
+	char *filename = NULL;
+	char buffer[4096];
+	char name[128];
+	FILE *fp;
+	bool in_metrics = false;
+	size_t n = 0;
+
+	if (!stress_get_setting("compare", &filename) || !filename)
+		return 0;
+
+	fp = fopen(filename, "r");
+	if (!fp) {
+		pr_err("compare: cannot open baseline file %s, errno=%d (%s)\n",
+			filename, errno, strerror(errno));
+		return -1;
+	}
+
+	*name = '\0';
+	while (fgets(buffer, sizeof(buffer), fp)) {
+		char value[128];
+		double rate;
+
+		/* top level keys start a new section */
+		if (isalpha((unsigned char)buffer[0])) {
+			in_metrics = !strncmp(buffer, "metrics:", 8);
+			*name = '\0';
+			continue;
+		}
+		if (!in_metrics)
+			continue;
+		if (sscanf(buffer, " - stressor: %127s", value) == 1) {
+			(void)shim_strscpy(name, value, sizeof(name));
+			continue;
+		}
+		if (*name &&
+		    (sscanf(buffer, " bogo-ops-per-second-real-time: %lf", &rate) == 1)) {
+			if (stress_compare_baseline_add(name, rate) < 0) {
+				pr_err("compare: out of memory loading baseline file %s\n", filename);
+				(void)fclose(fp);
+				return -1;
+			}
+			*name = '\0';
+			n++;
+		}
+	}
+	(void)fclose(fp);
+
+	if (n == 0) {
+		pr_err("compare: no stressor metrics found in baseline file %s, "
+			"it should be a YAML log of a run with --metrics\n", filename);
+		return -1;
+	}
+	pr_dbg("compare: loaded baseline metrics of %zu stressor%s from %s\n",
+		n, (n == 1) ? "" : "s", filename);
+	return 0;
+}
+
+/*
+ *  stress_compare_info_get()
+ *	find compare info for a stressor, create a new one if not found
+ */
+static stress_compare_info_t *stress_compare_info_get(const stress_stressor_t *ss)
+{
+	stress_compare_info_t *info;
+
+	for (info = compare_head; info; info = info->next) {
+		if (info->ss == ss)
+			return info;
+	}
+	info = calloc(1, sizeof(*info));
+	if (!info)
+		return NULL;
+	info->rates = calloc(compare_runs, sizeof(*info->rates));
+	if (!info->rates) {
+		free(info);
+		return NULL;
+	}
+	info->ss = ss;
+	info->next = compare_head;
+	compare_head = info;
+
+	return info;
+}
+
+/*
+ *  stress_compare_sample()
+ *	sample the bogo-ops per second (real time) of each stressor
+ *	for the run that just completed, this is computed the same
+ *	way as the bogo ops/s (real time) metric
+ */
+void stress_compare_sample(stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+
+	if (!stress_compare_enabled())
+		return;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		stress_compare_info_t *info;
+		uint64_t ops = 0;
+		double duration = 0.0, run_duration;
+		int32_t j;
+
+		if (ss->ignore.run || ss->ignore.permute || !ss->stats)
+			continue;
+		info = stress_compare_info_get(ss);
+		if (!info)
+			continue;
+
+		for (j = 0; j < ss->num_instances; j++) {
+			ops += ss->stats[j]->counter_total;
+			duration += ss->stats[j]->duration_total;
+		}
+		run_duration = (ss->num_instances > 0) ?
+			(duration - info->last_duration) / (double)ss->num_instances : 0.0;
+		if ((run_duration > 0.0) && (info->n < compare_runs))
+			info->rates[info->n++] = (double)(ops - info->last_ops) / run_duration;
+		info->last_ops = ops;
+		info->last_duration = duration;
+	}
+}
+
+/*
+ *  stress_compare_dump()
+ *	compare the mean throughput of each stressor against the
+ *	baseline with a 95% confidence interval, a stressor has
+ *	regressed if the entire confidence interval of the change
+ *	is below the negative tolerance. Returns true if any of
+ *	the stressors regressed.
+ */
+bool stress_compare_dump(FILE *yaml, stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+	bool pr_heading = false;
+	bool regressed = false;
+
+	if (!stress_compare_enabled())
+		return false;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		const stress_compare_info_t *info;
+		const stress_compare_baseline_t *baseline;
+		double sum = 0.0, mean, stddev = 0.0, ci = 0.0;
+		double delta, delta_ci, delta_lo, delta_hi;
+		const char *verdict;
+		char munged[64];
+		size_t i;
+
+		if (ss->ignore.run)
+			continue;
+		for (info = compare_head; info; info = info->next) {
+			if (info->ss == ss)
+				break;
+		}
+		if (!info || (info->n == 0))
+			continue;
+
+		(void)stress_munge_underscore(munged, ss->stressor->name, sizeof(munged));
+		if (!pr_heading) {
+			pr_inf("compare: %-13s %12s %12s %5s %9s %9s %-9s\n",
+				"stressor", "base ops/s", "mean ops/s", "runs",
+				"change %", "95% CI", "verdict");
+			pr_yaml(yaml, "compare-metrics:\n");
+			pr_yaml(yaml, "    - tolerance-percent: %f\n", compare_tolerance);
+			pr_heading = true;
+		}
+
+		for (i = 0; i < info->n; i++)
+			sum += info->rates[i];
+		mean = sum / (double)info->n;
+		if (info->n > 1) {
+			const size_t df = info->n - 1;
+			const double t = (df <= SIZEOF_ARRAY(stress_compare_t95)) ?
+				stress_compare_t95[df - 1] : 1.96;
+
+			for (i = 0; i < info->n; i++) {
+				const double diff = info->rates[i] - mean;
+
+				stddev += diff * diff;
+			}
+			stddev = sqrt(stddev / (double)df);
+			ci = t * stddev / sqrt((double)info->n);
+		}
+
+		baseline = stress_compare_baseline_find(munged);
+		if (!baseline || (baseline->rate <= 0.0)) {
+			pr_inf("compare: %-13s %12s %12.2f %5zu %9s %9s %-9s\n",
+				munged, "n/a", mean, info->n, "n/a", "n/a", "no baseline");
+			pr_yaml(yaml, "    - stressor: %s\n", munged);
+			pr_yaml(yaml, "      mean-bogo-ops-per-second: %f\n", mean);
+			pr_yaml(yaml, "      runs: %zu\n", info->n);
+			pr_yaml(yaml, "      verdict: no-baseline\n");
+			pr_yaml(yaml, "\n");
+			continue;
+		}
+
+		delta = 100.0 * (mean - baseline->rate) / baseline->rate;
+		delta_ci = 100.0 * ci / baseline->rate;
+		delta_lo = delta - delta_ci;
+		delta_hi = delta + delta_ci;
+		if (delta_hi < -compare_tolerance) {
+			verdict = "regressed";
+			regressed = true;
+		} else if (delta_lo > compare_tolerance) {
+			verdict = "improved";
+		} else {
+			verdict = "pass";
+		}
+
+		pr_inf("compare: %-13s %12.2f %12.2f %5zu %+9.2f %9.2f %-9s\n",
+			munged, baseline->rate, mean, info->n, delta, delta_ci, verdict);
+		pr_yaml(yaml, "    - stressor: %s\n", munged);
+		pr_yaml(yaml, "      baseline-bogo-ops-per-second: %f\n", baseline->rate);
+		pr_yaml(yaml, "      mean-bogo-ops-per-second: %f\n", mean);
+		pr_yaml(yaml, "      stddev-bogo-ops-per-second: %f\n", stddev);
+		pr_yaml(yaml, "      runs: %zu\n", info->n);
+		pr_yaml(yaml, "      change-percent: %f\n", delta);
+		pr_yaml(yaml, "      change-percent-ci95-low: %f\n", delta_lo);
+		pr_yaml(yaml, "      change-percent-ci95-high: %f\n", delta_hi);
+		pr_yaml(yaml, "      verdict: %s\n", verdict);
+		pr_yaml(yaml, "\n");
+	}
+	if (regressed)
+		pr_inf("compare: throughput regressed by more than %.2f%% against the baseline\n",
+			compare_tolerance);
+	return regressed;
+}
+
+/*
+ *  stress_compare_free()
+ *	free baseline and samples
+ */
+void stress_compare_free(void)
+{
+	stress_compare_baseline_t *baseline = baseline_head;
+	stress_compare_info_t *info = compare_head;
+
+	while (baseline) {
+		stress_compare_baseline_t *next = baseline->next;
+
+		free(baseline->name);
+		free(baseline);
+		baseline = next;
+	}
+	baseline_head = NULL;
+
+	while (info) {
+		stress_compare_info_t *next = info->next;
+
+		free(info->rates);
+		free(info);
+		info = next;
+	}
+	compare_head = NULL;
+}
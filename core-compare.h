@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef CORE_COMPARE_H
+#define CORE_COMPARE_H
+
+#include "stress-ng.h"
+
+/* comparison of throughput against a baseline YAML log */
+extern WARN_UNUSED int stress_set_compare_runs(const char *const opt);
+extern WARN_UNUSED int stress_set_compare_tolerance(const char *const opt);
+extern bool stress_compare_enabled(void);
+extern uint32_t stress_compare_runs(void);
+extern WARN_UNUSED int stress_compare_load(void);
+extern void stress_compare_sample(stress_stressor_t *stressors_list);
+extern WARN_UNUSED bool stress_compare_dump(FILE *yaml, stress_stressor_t *stressors_list);
+extern void stress_compare_free(void);
+
+#endif
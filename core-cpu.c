@@ -668,3 +668,43 @@ bool stress_cpu_x86_has_avx512_bw(void)
 #endif
 }
 
+/*
+ *  stress_cpu_x86_has_avx2()
+ *	does x86 cpu support avx2
+ */
+bool stress_cpu_x86_has_avx2(void)
+{
+#if defined(STRESS_ARCH_X86)
+	uint32_t eax = 0x7, ebx = 0, ecx = 0, edx = 0;
+
+	if (!stress_cpu_is_x86())
+		return false;
+
+	stress_asm_x86_cpuid(eax, ebx, ecx, edx);
+
+	return !!(ebx & CPUID_avx2_EBX);
+#else
+	return false;
+#endif
+}
+
+/*
+ *  stress_cpu_x86_has_avx512_f()
+ *	does x86 cpu support avx512 foundation instructions
+ */
+bool stress_cpu_x86_has_avx512_f(void)
+{
+#if defined(STRESS_ARCH_X86)
+	uint32_t eax = 0x7, ebx = 0, ecx = 0, edx = 0;
+
+	if (!stress_cpu_is_x86())
+		return false;
+
+	stress_asm_x86_cpuid(eax, ebx, ecx, edx);
+
+	return !!(ebx & CPUID_avx512_f_EBX);
+#else
+	return false;
+#endif
+}
+
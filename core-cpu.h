@@ -42,5 +42,7 @@ extern WARN_UNUSED bool stress_cpu_x86_has_avx_vnni(void);
 extern WARN_UNUSED bool stress_cpu_x86_has_avx512_vl(void);
 extern WARN_UNUSED bool stress_cpu_x86_has_avx512_vnni(void);
 extern WARN_UNUSED bool stress_cpu_x86_has_avx512_bw(void);
+extern WARN_UNUSED bool stress_cpu_x86_has_avx2(void);
+extern WARN_UNUSED bool stress_cpu_x86_has_avx512_f(void);
 
 #endif
@@ -26,9 +26,11 @@
 #include "core-cpu-cache.h"
 #include "core-hash.h"
 #include "core-lock.h"
+#include "core-mmap.h"
 #include "core-numa.h"
 #include "core-pthread.h"
 #include "core-pragma.h"
+#include "core-prefork.h"
 #include "core-sort.h"
 
 #include <sched.h>
@@ -1340,6 +1342,8 @@ void stress_set_proc_state(const char *name, const int state)
 		return;
 
 	stress_set_proc_state_str(name, stress_states[state]);
+	if (state == STRESS_STATE_RUN)
+		stress_sync_start_wait();
 }
 
 /*
@@ -1989,10 +1993,10 @@ int stress_cache_alloc(const char *name)
 init_done:
 
 	stress_free_cpu_caches(cpu_caches);
+	g_shared->mem_cache.mmap_size = (size_t)g_shared->mem_cache.size;
 	g_shared->mem_cache.buffer =
-		(uint8_t *)stress_mmap_populate(NULL, g_shared->mem_cache.size,
-				PROT_READ | PROT_WRITE,
-				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		(uint8_t *)stress_mmap_buffer(name, 0, &g_shared->mem_cache.mmap_size,
+				PROT_READ | PROT_WRITE, MAP_SHARED);
 	if (g_shared->mem_cache.buffer == MAP_FAILED) {
 		g_shared->mem_cache.buffer = NULL;
 		pr_err("%s: failed to mmap shared cache buffer, errno=%d (%s)\n",
@@ -2031,7 +2035,7 @@ init_done:
 void stress_cache_free(void)
 {
 	if (g_shared->mem_cache.buffer)
-		(void)munmap((void *)g_shared->mem_cache.buffer, g_shared->mem_cache.size);
+		(void)munmap((void *)g_shared->mem_cache.buffer, g_shared->mem_cache.mmap_size);
 	if (g_shared->cacheline.buffer)
 		(void)munmap((void *)g_shared->cacheline.buffer, g_shared->cacheline.size);
 }
@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-interval.h"
+
+#include <float.h>
+
+#define STRESS_INTERVAL_POLL_NS		(100000000ULL)	/* 0.1 sec child exit poll */
+
+typedef struct {
+	double time;			/* time since start of run */
+	uint64_t ops;			/* bogo-ops in the interval */
+	double rate;			/* bogo-ops per second in the interval */
+} stress_interval_sample_t;
+
+/* per stressor interval samples */
+typedef struct stress_interval_info {
+	struct stress_interval_info *next; /* next in list */
+	const stress_stressor_t *ss;	/* stressor being sampled */
+	uint64_t last_ops;		/* bogo-ops total at last sample */
+	size_t n;			/* number of samples */
+	size_t max;			/* number of samples allocated */
+	stress_interval_sample_t *samples; /* samples */
+} stress_interval_info_t;
+
+static int32_t interval_delay = 0;
+static stress_interval_info_t *interval_head = NULL;
+static FILE *interval_csv = NULL;
+
+/*
+ *  stress_set_interval()
+ *	parse --interval option
+ */
+int stress_set_interval(const char *const opt)
+{
+	const uint64_t delay64 = stress_get_uint64_time(opt);
+
+	if ((delay64 < 1) || (delay64 > 3600)) {
+		(void)fprintf(stderr, "interval must be in the range 1 to 3600 seconds.\n");
+		_exit(EXIT_FAILURE);
+	}
+	interval_delay = (int32_t)(delay64 & 0x7fffffff);
+	return 0;
+}
+
+/*
+ *  stress_interval_enabled()
+ *	return true if per interval sampling is enabled
+ */
+bool stress_interval_enabled(void)
+{
+	return interval_delay > 0;
+}
+
+#if defined(HAVE_WAITID) &&	\
+    defined(WNOWAIT)
+/*
+ *  stress_interval_ops()
+ *	sum the bogo-op counters of all instances of a stressor,
+ *	this is a lock-free read of the shared stats
+ */
+static uint64_t stress_interval_ops(const stress_stressor_t *ss)
+{
+	int32_t j;
+	uint64_t ops = 0;
+
+	for (j = 0; j < ss->num_instances; j++)
+		ops += ss->stats[j]->args.ci.counter;
+
+	return ops;
+}
+
+/*
+ *  stress_interval_alive()
+ *	return true if any stressor instances are still running,
+ *	child processes are not reaped so the exit status is left
+ *	intact for stress_wait_pid()
+ */
+static bool stress_interval_alive(stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		int32_t j;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+
+		for (j = 0; j < ss->num_instances; j++) {
+			const pid_t pid = ss->stats[j]->pid;
+			siginfo_t info;
+
+			if (pid <= 0)
+				continue;
+			(void)shim_memset(&info, 0, sizeof(info));
+			if ((waitid(P_PID, (id_t)pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0) &&
+			    (info.si_pid == 0))
+				return true;
+		}
+	}
+	return false;
+}
+
+/*
+ *  stress_interval_info_get()
+ *	find interval info for a stressor, create a new one if not found
+ */
+static stress_interval_info_t *stress_interval_info_get(const stress_stressor_t *ss)
+{
+	stress_interval_info_t *info;
+
+	for (info = interval_head; info; info = info->next) {
+		if (info->ss == ss)
+			return info;
+	}
+	info = calloc(1, sizeof(*info));
+	if (!info)
+		return NULL;
+	info->ss = ss;
+	info->next = interval_head;
+	interval_head = info;
+
+	return info;
+}
+
+/*
+ *  stress_interval_csv_open()
+ *	open optional CSV file for streamed interval samples
+ */
+static void stress_interval_csv_open(void)
+{
+	char *filename = NULL;
+
+	if (interval_csv)
+		return;
+	if (!stress_get_setting("interval-csv", &filename))
+		return;
+
+	interval_csv = fopen(filename, "w");
+	if (!interval_csv) {
+		pr_err("cannot open interval CSV file %s, errno=%d (%s)\n",
+			filename, errno, strerror(errno));
+		return;
+	}
+	(void)fprintf(interval_csv, "time,stressor,instances,bogo-ops,bogo-ops-per-second\n");
+	(void)fflush(interval_csv);
+}
+
+/*
+ *  stress_interval_sample()
+ *	snapshot the bogo-op counters of all the stressors
+ */
+static void stress_interval_sample(
+	stress_stressor_t *stressors_list,
+	const double now,
+	const double duration)
+{
+	stress_stressor_t *ss;
+	const double t = now - g_shared->time_started;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		stress_interval_info_t *info;
+		stress_interval_sample_t *sample;
+		uint64_t ops, delta;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		info = stress_interval_info_get(ss);
+		if (!info)
+			continue;
+
+		if (info->n >= info->max) {
+			const size_t max = info->max ? info->max << 1 : 64;
+			stress_interval_sample_t *samples;
+
+			samples = realloc(info->samples, max * sizeof(*samples));
+			if (!samples)
+				continue;
+			info->samples = samples;
+			info->max = max;
+		}
+
+		ops = stress_interval_ops(ss);
+		delta = (ops > info->last_ops) ? ops - info->last_ops : 0;
+		info->last_ops = ops;
+
+		sample = &info->samples[info->n++];
+		sample->time = t;
+		sample->ops = delta;
+		sample->rate = (duration > 0.0) ? (double)delta / duration : 0.0;
+
+		if (interval_csv) {
+			char munged[64];
+
+			(void)stress_munge_underscore(munged, ss->stressor->name, sizeof(munged));
+			(void)fprintf(interval_csv, "%.3f,%s,%" PRId32 ",%" PRIu64 ",%.2f\n",
+				sample->time, munged, ss->num_instances,
+				sample->ops, sample->rate);
+		}
+	}
+	if (interval_csv)
+		(void)fflush(interval_csv);
+}
+#endif
+
+/*
+ *  stress_interval_wait()
+ *	sample bogo-op throughput of running stressors every
+ *	interval seconds until all the stressors have exited
+ */
+void stress_interval_wait(stress_stressor_t *stressors_list)
+{
+#if defined(HAVE_WAITID) &&	\
+    defined(WNOWAIT)
+	stress_stressor_t *ss;
+	double t_last, t_next;
+
+	if (!interval_delay)
+		return;
+
+	stress_interval_csv_open();
+
+	/* Counters are reset before each run, so re-baseline */
+	for (ss = stressors_list; ss; ss = ss->next) {
+		stress_interval_info_t *info;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		info = stress_interval_info_get(ss);
+		if (info)
+			info->last_ops = stress_interval_ops(ss);
+	}
+
+	t_last = stress_time_now();
+	t_next = t_last + (double)interval_delay;
+
+	while (stress_continue_flag() && stress_interval_alive(stressors_list)) {
+		const double now = stress_time_now();
+
+		if (now < t_next) {
+			uint64_t nsec = (uint64_t)((t_next - now) * STRESS_DBL_NANOSECOND);
+
+			if (nsec > STRESS_INTERVAL_POLL_NS)
+				nsec = STRESS_INTERVAL_POLL_NS;
+			(void)shim_nanosleep_uint64(nsec);
+			continue;
+		}
+		stress_interval_sample(stressors_list, now, now - t_last);
+		t_last = now;
+		t_next += (double)interval_delay;
+		if (t_next < now)
+			t_next = now + (double)interval_delay;
+	}
+#else
+	(void)stressors_list;
+
+	if (interval_delay)
+		pr_inf("interval: sampling not supported, waitid() is not available\n");
+#endif
+}
+
+/*
+ *  stress_interval_dump()
+ *	dump interval throughput summary and YAML time series
+ */
+void stress_interval_dump(FILE *yaml, stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+	bool pr_heading = false;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		stress_interval_info_t *info;
+		double sum = 0.0, sum_sq = 0.0, min = DBL_MAX, max = 0.0;
+		double mean, stddev;
+		char munged[64];
+		size_t i;
+
+		if (ss->ignore.run)
+			continue;
+		for (info = interval_head; info; info = info->next) {
+			if (info->ss == ss)
+				break;
+		}
+		if (!info || (info->n == 0))
+			continue;
+
+		for (i = 0; i < info->n; i++) {
+			const double rate = info->samples[i].rate;
+
+			sum += rate;
+			sum_sq += rate * rate;
+			if (min > rate)
+				min = rate;
+			if (max < rate)
+				max = rate;
+		}
+		mean = sum / (double)info->n;
+		stddev = sum_sq / (double)info->n - (mean * mean);
+		stddev = (stddev > 0.0) ? sqrt(stddev) : 0.0;
+
+		(void)stress_munge_underscore(munged, ss->stressor->name, sizeof(munged));
+		if (!pr_heading) {
+			pr_inf("interval: %-13s %8s %12s %12s %12s %7s\n",
+				"stressor", "samples", "mean ops/s", "min ops/s",
+				"max ops/s", "cv %");
+			pr_yaml(yaml, "interval-metrics:\n");
+			pr_heading = true;
+		}
+		pr_inf("interval: %-13s %8zu %12.2f %12.2f %12.2f %7.2f\n",
+			munged, info->n, mean, min, max,
+			(mean > 0.0) ? 100.0 * stddev / mean : 0.0);
+
+		pr_yaml(yaml, "    - stressor: %s\n", munged);
+		pr_yaml(yaml, "      interval: %" PRId32 "\n", interval_delay);
+		pr_yaml(yaml, "      samples:\n");
+		for (i = 0; i < info->n; i++) {
+			const stress_interval_sample_t *sample = &info->samples[i];
+
+			pr_yaml(yaml, "        - { time: %f, bogo-ops: %" PRIu64 ", bogo-ops-per-second: %f }\n",
+				sample->time, sample->ops, sample->rate);
+		}
+		pr_yaml(yaml, "\n");
+	}
+}
+
+/*
+ *  stress_interval_free()
+ *	free interval samples and close CSV file
+ */
+void stress_interval_free(void)
+{
+	stress_interval_info_t *info = interval_head;
+
+	while (info) {
+		stress_interval_info_t *next = info->next;
+
+		free(info->samples);
+		free(info);
+		info = next;
+	}
+	interval_head = NULL;
+
+	if (interval_csv) {
+		(void)fclose(interval_csv);
+		interval_csv = NULL;
+	}
+}
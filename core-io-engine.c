@@ -0,0 +1,914 @@
+/*
+ * Copyright (C) 2024      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-io-engine.h"
+#include "io-uring.h"
+
+#if defined(HAVE_LINUX_AIO_ABI_H)
+#include <linux/aio_abi.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H)
+#include <linux/io_uring.h>
+#endif
+
+/*
+ *  I/O engines submit batches of requests and reap completed
+ *  requests, so the same access pattern can be driven through
+ *  blocking system calls or the Linux asynchronous I/O interfaces.
+ *  Requests carry a slot number, 0 .. depth - 1, that the caller
+ *  owns and back-ends use to index per-request state.
+ */
+typedef struct stress_io_engine_ops {
+	const char *name;		/* --io-engine name */
+	int (*open)(stress_io_engine_t *engine);
+	int (*submit)(stress_io_engine_t *engine, stress_io_req_t *reqs[], const uint32_t n);
+	int (*reap)(stress_io_engine_t *engine, stress_io_req_t *reqs[], const uint32_t min, const uint32_t max);
+	void (*close)(stress_io_engine_t *engine);
+} stress_io_engine_ops_t;
+
+/*
+ *  sync, psync and mmap engine state, requests are performed
+ *  at submit time and queued up for the next reap
+ */
+typedef struct {
+	stress_io_req_t **done;		/* completed requests */
+	uint32_t head;			/* next request to reap */
+	uint32_t tail;			/* next free done entry */
+	uint8_t *map;			/* mmap engine file mapping */
+	size_t map_size;		/* size of the mapping */
+	struct sigaction sigbus_action;	/* mmap engine original SIGBUS action */
+} stress_io_engine_sync_t;
+
+static sigjmp_buf mmap_jmp_env;
+static volatile bool mmap_jmp_env_set;
+
+/*
+ *  stress_io_engine_sync_open()
+ *	allocate the completed request queue
+ */
+static int stress_io_engine_sync_open(stress_io_engine_t *engine)
+{
+	stress_io_engine_sync_t *sync;
+
+	/* requests complete one at a time, so deeper queues just add latency */
+	engine->depth = 1;
+	sync = (stress_io_engine_sync_t *)calloc(1, sizeof(*sync));
+	if (!sync)
+		return -1;
+	sync->done = (stress_io_req_t **)calloc((size_t)engine->depth, sizeof(*sync->done));
+	if (!sync->done) {
+		free(sync);
+		return -1;
+	}
+	engine->priv = (void *)sync;
+	return 0;
+}
+
+/*
+ *  stress_io_engine_sync_submit()
+ *	perform the requests with lseek() and read() or write()
+ */
+static int stress_io_engine_sync_submit(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t n)
+{
+	stress_io_engine_sync_t *sync = (stress_io_engine_sync_t *)engine->priv;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		stress_io_req_t *req = reqs[i];
+
+		if (lseek(engine->fd, (off_t)req->offset, SEEK_SET) < 0) {
+			req->res = -errno;
+		} else {
+			req->res = req->write ?
+				write(engine->fd, req->buf, req->size) :
+				read(engine->fd, req->buf, req->size);
+			if (req->res < 0)
+				req->res = -errno;
+		}
+		sync->done[sync->tail++] = req;
+	}
+	return (int)n;
+}
+
+/*
+ *  stress_io_engine_psync_submit()
+ *	perform the requests with pread() or pwrite()
+ */
+static int stress_io_engine_psync_submit(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t n)
+{
+	stress_io_engine_sync_t *sync = (stress_io_engine_sync_t *)engine->priv;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		stress_io_req_t *req = reqs[i];
+
+		req->res = req->write ?
+			pwrite(engine->fd, req->buf, req->size, (off_t)req->offset) :
+			pread(engine->fd, req->buf, req->size, (off_t)req->offset);
+		if (req->res < 0)
+			req->res = -errno;
+		sync->done[sync->tail++] = req;
+	}
+	return (int)n;
+}
+
+/*
+ *  stress_io_engine_sync_reap()
+ *	hand back the requests performed at submit time
+ */
+static int stress_io_engine_sync_reap(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t min,
+	const uint32_t max)
+{
+	stress_io_engine_sync_t *sync = (stress_io_engine_sync_t *)engine->priv;
+	uint32_t n = 0;
+
+	(void)min;
+
+	while ((n < max) && (sync->head < sync->tail))
+		reqs[n++] = sync->done[sync->head++];
+	if (sync->head == sync->tail)
+		sync->head = sync->tail = 0;
+	return (int)n;
+}
+
+/*
+ *  stress_io_engine_sync_close()
+ *	free the completed request queue
+ */
+static void stress_io_engine_sync_close(stress_io_engine_t *engine)
+{
+	stress_io_engine_sync_t *sync = (stress_io_engine_sync_t *)engine->priv;
+
+	free(sync->done);
+	free(sync);
+}
+
+/*
+ *  stress_io_engine_mmap_sighandler()
+ *	a SIGBUS while copying to or from the mapping, for example
+ *	if the file was truncated or made immutable by another
+ *	process, fails the request with -EFAULT rather than
+ *	killing the stressor. A SIGBUS anywhere else is a real
+ *	fault, so restore the default action and re-raise it
+ *	rather than returning to the faulting instruction
+ */
+static void MLOCKED_TEXT stress_io_engine_mmap_sighandler(int signum)
+{
+	if (mmap_jmp_env_set)
+		siglongjmp(mmap_jmp_env, 1);
+
+	(void)stress_sighandler_default(signum);
+	(void)shim_raise(signum);
+}
+
+/*
+ *  stress_io_engine_mmap_open()
+ *	allocate the completed request queue and catch SIGBUS,
+ *	the file is mapped on the first request
+ */
+static int stress_io_engine_mmap_open(stress_io_engine_t *engine)
+{
+	stress_io_engine_sync_t *sync;
+
+	if (stress_io_engine_sync_open(engine) < 0)
+		return -1;
+	sync = (stress_io_engine_sync_t *)engine->priv;
+	if (stress_sighandler("io-engine", SIGBUS, stress_io_engine_mmap_sighandler,
+			      &sync->sigbus_action) < 0) {
+		stress_io_engine_sync_close(engine);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ *  stress_io_engine_mmap_remap()
+ *	make sure the file mapping covers up to end bytes, files
+ *	are extended for writes beyond the end of file, reads
+ *	beyond the end of file are clipped by the caller
+ */
+static int stress_io_engine_mmap_remap(
+	stress_io_engine_t *engine,
+	stress_io_engine_sync_t *sync,
+	const uint64_t end,
+	const bool is_write)
+{
+	struct stat statbuf;
+	uint64_t size;
+	void *ptr;
+
+	if (end <= (uint64_t)sync->map_size)
+		return 0;
+	if (shim_fstat(engine->fd, &statbuf) < 0)
+		return -1;
+	size = (uint64_t)statbuf.st_size;
+	if (is_write && (size < end)) {
+		if (ftruncate(engine->fd, (off_t)end) < 0)
+			return -1;
+		size = end;
+	}
+	if ((size <= (uint64_t)sync->map_size) || (size > (uint64_t)SIZE_MAX))
+		return 0;
+
+	ptr = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE,
+		MAP_SHARED, engine->fd, 0);
+	if (ptr == MAP_FAILED)
+		return -1;
+	if (sync->map)
+		(void)munmap((void *)sync->map, sync->map_size);
+	sync->map = (uint8_t *)ptr;
+	sync->map_size = (size_t)size;
+	return 0;
+}
+
+/*
+ *  stress_io_engine_mmap_submit()
+ *	perform the requests by copying to or from a shared
+ *	mapping of the file
+ */
+static int stress_io_engine_mmap_submit(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t n)
+{
+	stress_io_engine_sync_t *sync = (stress_io_engine_sync_t *)engine->priv;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		stress_io_req_t *req = reqs[i];
+
+		if (stress_io_engine_mmap_remap(engine, sync,
+				req->offset + req->size, req->write) < 0) {
+			req->res = -errno;
+		} else if (req->offset >= (uint64_t)sync->map_size) {
+			req->res = 0;
+		} else {
+			const size_t size = STRESS_MINIMUM(req->size,
+				sync->map_size - (size_t)req->offset);
+
+			if (sigsetjmp(mmap_jmp_env, 1) != 0) {
+				req->res = -EFAULT;
+			} else {
+				mmap_jmp_env_set = true;
+				if (req->write)
+					(void)shim_memcpy(sync->map + req->offset, req->buf, size);
+				else
+					(void)shim_memcpy(req->buf, sync->map + req->offset, size);
+				req->res = (ssize_t)size;
+			}
+			mmap_jmp_env_set = false;
+		}
+		sync->done[sync->tail++] = req;
+	}
+	return (int)n;
+}
+
+/*
+ *  stress_io_engine_mmap_close()
+ *	unmap the file and free the completed request queue
+ */
+static void stress_io_engine_mmap_close(stress_io_engine_t *engine)
+{
+	stress_io_engine_sync_t *sync = (stress_io_engine_sync_t *)engine->priv;
+
+	if (sync->map)
+		(void)munmap((void *)sync->map, sync->map_size);
+	(void)stress_sigrestore("io-engine", SIGBUS, &sync->sigbus_action);
+	stress_io_engine_sync_close(engine);
+}
+
+#if defined(HAVE_LINUX_AIO_ABI_H) &&	\
+    defined(HAVE_SYSCALL) &&		\
+    defined(__NR_io_setup) &&		\
+    defined(__NR_io_destroy) &&		\
+    defined(__NR_io_submit) &&		\
+    defined(__NR_io_getevents)
+#define HAVE_IO_ENGINE_LIBAIO
+
+/*
+ *  libaio engine state, one iocb per request slot. The engine
+ *  uses the Linux native aio system calls directly, as libaio
+ *  does, so it does not depend on the libaio library
+ */
+typedef struct {
+	aio_context_t ctx;		/* aio context */
+	struct iocb *iocbs;		/* iocbs, indexed by slot */
+	struct iocb **iocbps;		/* iocbs to submit */
+	struct io_event *events;	/* completion events */
+} stress_io_engine_libaio_t;
+
+/*
+ *  stress_io_engine_libaio_free()
+ *	free libaio engine state
+ */
+static void stress_io_engine_libaio_free(stress_io_engine_libaio_t *aio)
+{
+	free(aio->events);
+	free(aio->iocbps);
+	free(aio->iocbs);
+	free(aio);
+}
+
+/*
+ *  stress_io_engine_libaio_open()
+ *	set up an aio context for depth requests
+ */
+static int stress_io_engine_libaio_open(stress_io_engine_t *engine)
+{
+	stress_io_engine_libaio_t *aio;
+	const size_t depth = (size_t)engine->depth;
+
+	aio = (stress_io_engine_libaio_t *)calloc(1, sizeof(*aio));
+	if (!aio)
+		return -1;
+	aio->iocbs = (struct iocb *)calloc(depth, sizeof(*aio->iocbs));
+	aio->iocbps = (struct iocb **)calloc(depth, sizeof(*aio->iocbps));
+	aio->events = (struct io_event *)calloc(depth, sizeof(*aio->events));
+	if (!aio->iocbs || !aio->iocbps || !aio->events) {
+		stress_io_engine_libaio_free(aio);
+		errno = ENOMEM;
+		return -1;
+	}
+	if ((int)syscall(__NR_io_setup, engine->depth, &aio->ctx) < 0) {
+		const int saved_errno = errno;
+
+		stress_io_engine_libaio_free(aio);
+		errno = saved_errno;
+		return -1;
+	}
+	engine->priv = (void *)aio;
+	return 0;
+}
+
+/*
+ *  stress_io_engine_libaio_submit()
+ *	submit requests with io_submit()
+ */
+static int stress_io_engine_libaio_submit(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t n)
+{
+	stress_io_engine_libaio_t *aio = (stress_io_engine_libaio_t *)engine->priv;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		stress_io_req_t *req = reqs[i];
+		struct iocb *cb = &aio->iocbs[req->slot];
+
+		(void)shim_memset(cb, 0, sizeof(*cb));
+		cb->aio_lio_opcode = req->write ? IOCB_CMD_PWRITE : IOCB_CMD_PREAD;
+		cb->aio_fildes = (uint32_t)engine->fd;
+		cb->aio_buf = (uint64_t)(uintptr_t)req->buf;
+		cb->aio_nbytes = (uint64_t)req->size;
+		cb->aio_offset = (int64_t)req->offset;
+		cb->aio_data = (uint64_t)(uintptr_t)req;
+		aio->iocbps[i] = cb;
+	}
+	return (int)syscall(__NR_io_submit, aio->ctx, (long)n, aio->iocbps);
+}
+
+/*
+ *  stress_io_engine_libaio_reap()
+ *	wait for at least min and at most max completions
+ */
+static int stress_io_engine_libaio_reap(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t min,
+	const uint32_t max)
+{
+	stress_io_engine_libaio_t *aio = (stress_io_engine_libaio_t *)engine->priv;
+	int i, ret;
+
+	ret = (int)syscall(__NR_io_getevents, aio->ctx, (long)min,
+		(long)max, aio->events, NULL);
+	for (i = 0; i < ret; i++) {
+		stress_io_req_t *req = (stress_io_req_t *)(uintptr_t)aio->events[i].data;
+
+		req->res = (ssize_t)aio->events[i].res;
+		reqs[i] = req;
+	}
+	return ret;
+}
+
+/*
+ *  stress_io_engine_libaio_close()
+ *	destroy the aio context, cancelling requests in flight
+ */
+static void stress_io_engine_libaio_close(stress_io_engine_t *engine)
+{
+	stress_io_engine_libaio_t *aio = (stress_io_engine_libaio_t *)engine->priv;
+
+	(void)syscall(__NR_io_destroy, aio->ctx);
+	stress_io_engine_libaio_free(aio);
+}
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H) &&	\
+    defined(HAVE_SYSCALL) &&		\
+    defined(__NR_io_uring_setup) &&	\
+    defined(__NR_io_uring_enter) &&	\
+    defined(IORING_OFF_SQ_RING) &&	\
+    defined(IORING_OFF_CQ_RING) &&	\
+    defined(IORING_OFF_SQES) &&		\
+    defined(HAVE_IORING_OP_READ) &&	\
+    defined(HAVE_IORING_OP_WRITE)
+#define HAVE_IO_ENGINE_IO_URING
+
+/*
+ *  Avoid GCCism of void * pointer arithmetic by casting to
+ *  uint8_t *, doing the offset and then casting back to void *
+ */
+#define IO_ENGINE_ADDR_OFFSET(addr, offset)	\
+	((void *)(((uint8_t *)addr) + offset))
+
+/*
+ *  io-uring engine state
+ */
+typedef struct {
+	int ring_fd;			/* io-uring file descriptor */
+	unsigned *sq_head;		/* submission queue head */
+	unsigned *sq_tail;		/* submission queue tail */
+	unsigned *sq_mask;		/* submission queue ring mask */
+	unsigned *sq_array;		/* submission queue index array */
+	unsigned *cq_head;		/* completion queue head */
+	unsigned *cq_tail;		/* completion queue tail */
+	unsigned *cq_mask;		/* completion queue ring mask */
+	struct io_uring_cqe *cqes;	/* completion queue entries */
+	struct io_uring_sqe *sqes;	/* submission queue entries */
+	void *sq_mmap;			/* submission queue ring mapping */
+	void *cq_mmap;			/* completion queue ring mapping */
+	size_t sq_size;			/* size of sq_mmap */
+	size_t cq_size;			/* size of cq_mmap */
+	size_t sqes_size;		/* size of sqes mapping */
+} stress_io_engine_io_uring_t;
+
+/*
+ *  stress_io_engine_io_uring_unmap()
+ *	unmap the rings and close the io-uring
+ */
+static void stress_io_engine_io_uring_unmap(stress_io_engine_io_uring_t *ring)
+{
+	if (ring->sqes)
+		(void)munmap((void *)ring->sqes, ring->sqes_size);
+	if (ring->cq_mmap && (ring->cq_mmap != ring->sq_mmap))
+		(void)munmap(ring->cq_mmap, ring->cq_size);
+	if (ring->sq_mmap)
+		(void)munmap(ring->sq_mmap, ring->sq_size);
+	if (ring->ring_fd >= 0)
+		(void)close(ring->ring_fd);
+	free(ring);
+}
+
+/*
+ *  stress_io_engine_io_uring_open()
+ *	set up an io-uring with depth entries and map the rings
+ */
+static int stress_io_engine_io_uring_open(stress_io_engine_t *engine)
+{
+	stress_io_engine_io_uring_t *ring;
+	struct io_uring_params p;
+	void *ptr;
+
+	ring = (stress_io_engine_io_uring_t *)calloc(1, sizeof(*ring));
+	if (!ring)
+		return -1;
+
+	(void)shim_memset(&p, 0, sizeof(p));
+	ring->ring_fd = (int)syscall(__NR_io_uring_setup, engine->depth, &p);
+	if (ring->ring_fd < 0) {
+		free(ring);
+		return -1;
+	}
+
+	ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_size > ring->sq_size)
+			ring->sq_size = ring->cq_size;
+		ring->cq_size = ring->sq_size;
+	}
+	ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED)
+		goto err;
+	ring->sq_mmap = ptr;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_mmap = ring->sq_mmap;
+	} else {
+		ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING);
+		if (ptr == MAP_FAILED)
+			goto err;
+		ring->cq_mmap = ptr;
+	}
+
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES);
+	if (ptr == MAP_FAILED)
+		goto err;
+	ring->sqes = (struct io_uring_sqe *)ptr;
+
+	ring->sq_head = IO_ENGINE_ADDR_OFFSET(ring->sq_mmap, p.sq_off.head);
+	ring->sq_tail = IO_ENGINE_ADDR_OFFSET(ring->sq_mmap, p.sq_off.tail);
+	ring->sq_mask = IO_ENGINE_ADDR_OFFSET(ring->sq_mmap, p.sq_off.ring_mask);
+	ring->sq_array = IO_ENGINE_ADDR_OFFSET(ring->sq_mmap, p.sq_off.array);
+	ring->cq_head = IO_ENGINE_ADDR_OFFSET(ring->cq_mmap, p.cq_off.head);
+	ring->cq_tail = IO_ENGINE_ADDR_OFFSET(ring->cq_mmap, p.cq_off.tail);
+	ring->cq_mask = IO_ENGINE_ADDR_OFFSET(ring->cq_mmap, p.cq_off.ring_mask);
+	ring->cqes = IO_ENGINE_ADDR_OFFSET(ring->cq_mmap, p.cq_off.cqes);
+
+	engine->priv = (void *)ring;
+	return 0;
+err:
+	{
+		const int saved_errno = errno;
+
+		stress_io_engine_io_uring_unmap(ring);
+		errno = saved_errno;
+	}
+	return -1;
+}
+
+/*
+ *  stress_io_engine_io_uring_submit()
+ *	queue IORING_OP_READ or IORING_OP_WRITE requests and
+ *	submit them with one io_uring_enter() call, entries the
+ *	kernel did not consume are taken off the ring again so
+ *	the caller can reuse or resubmit those requests
+ */
+static int stress_io_engine_io_uring_submit(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t n)
+{
+	stress_io_engine_io_uring_t *ring = (stress_io_engine_io_uring_t *)engine->priv;
+	const unsigned mask = *ring->sq_mask;
+	const unsigned start = *ring->sq_tail;
+	unsigned tail = start, consumed;
+	uint32_t i;
+	int ret, saved_errno;
+
+	for (i = 0; i < n; i++) {
+		stress_io_req_t *req = reqs[i];
+		const unsigned index = tail & mask;
+		struct io_uring_sqe *sqe = &ring->sqes[index];
+
+		(void)shim_memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = req->write ? IORING_OP_WRITE : IORING_OP_READ;
+		sqe->fd = engine->fd;
+		sqe->off = req->offset;
+		sqe->addr = (uintptr_t)req->buf;
+		sqe->len = (uint32_t)req->size;
+		sqe->user_data = (uint64_t)(uintptr_t)req;
+		ring->sq_array[index] = index;
+		tail++;
+	}
+	stress_asm_mb();
+	*ring->sq_tail = tail;
+	stress_asm_mb();
+
+	ret = (int)syscall(__NR_io_uring_enter, ring->ring_fd, n, 0, 0, NULL, 0);
+	saved_errno = errno;
+
+	/* without SQPOLL the kernel only consumes entries in io_uring_enter() */
+	stress_asm_mb();
+	consumed = *ring->sq_head - start;
+	*ring->sq_tail = start + consumed;
+	stress_asm_mb();
+
+	if ((ret < 0) && (consumed == 0)) {
+		errno = saved_errno;
+		return -1;
+	}
+	return (int)consumed;
+}
+
+/*
+ *  stress_io_engine_io_uring_reap()
+ *	reap up to max completions, waiting until at least
+ *	min have completed
+ */
+static int stress_io_engine_io_uring_reap(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t min,
+	const uint32_t max)
+{
+	stress_io_engine_io_uring_t *ring = (stress_io_engine_io_uring_t *)engine->priv;
+	uint32_t n = 0;
+
+	for (;;) {
+		unsigned head = *ring->cq_head;
+
+		for (;;) {
+			const struct io_uring_cqe *cqe;
+			stress_io_req_t *req;
+
+			stress_asm_mb();
+			if ((n >= max) || (head == *ring->cq_tail))
+				break;
+			cqe = &ring->cqes[head & *ring->cq_mask];
+			req = (stress_io_req_t *)(uintptr_t)cqe->user_data;
+			req->res = (ssize_t)cqe->res;
+			reqs[n++] = req;
+			head++;
+		}
+		*ring->cq_head = head;
+		stress_asm_mb();
+
+		if (n >= min)
+			break;
+		if (syscall(__NR_io_uring_enter, ring->ring_fd, 0, min - n,
+			    IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+			return (n > 0) ? (int)n : -1;
+	}
+	return (int)n;
+}
+
+/*
+ *  stress_io_engine_io_uring_close()
+ *	close the io-uring, the kernel cancels requests in flight
+ */
+static void stress_io_engine_io_uring_close(stress_io_engine_t *engine)
+{
+	stress_io_engine_io_uring_unmap((stress_io_engine_io_uring_t *)engine->priv);
+}
+#endif
+
+static const stress_io_engine_ops_t io_engines[] = {
+	{ "sync",	stress_io_engine_sync_open, stress_io_engine_sync_submit,
+			stress_io_engine_sync_reap, stress_io_engine_sync_close },
+	{ "psync",	stress_io_engine_sync_open, stress_io_engine_psync_submit,
+			stress_io_engine_sync_reap, stress_io_engine_sync_close },
+#if defined(HAVE_IO_ENGINE_LIBAIO)
+	{ "libaio",	stress_io_engine_libaio_open, stress_io_engine_libaio_submit,
+			stress_io_engine_libaio_reap, stress_io_engine_libaio_close },
+#endif
+#if defined(HAVE_IO_ENGINE_IO_URING)
+	{ "io_uring",	stress_io_engine_io_uring_open, stress_io_engine_io_uring_submit,
+			stress_io_engine_io_uring_reap, stress_io_engine_io_uring_close },
+#endif
+	{ "mmap",	stress_io_engine_mmap_open, stress_io_engine_mmap_submit,
+			stress_io_engine_sync_reap, stress_io_engine_mmap_close },
+};
+
+/*
+ *  stress_set_io_engine()
+ *	parse --io-engine option
+ */
+int stress_set_io_engine(const char *opt)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(io_engines); i++) {
+		if (!strcmp(opt, io_engines[i].name))
+			return stress_set_setting_global("io-engine", TYPE_ID_SIZE_T, &i);
+	}
+	(void)fprintf(stderr, "invalid io-engine '%s', allowed engines are:", opt);
+	for (i = 0; i < SIZEOF_ARRAY(io_engines); i++)
+		(void)fprintf(stderr, " %s", io_engines[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+/*
+ *  stress_io_engine_index()
+ *	return the --io-engine index, default is sync
+ */
+static size_t stress_io_engine_index(void)
+{
+	size_t i = 0;
+
+	(void)stress_get_setting("io-engine", &i);
+	return (i < SIZEOF_ARRAY(io_engines)) ? i : 0;
+}
+
+/*
+ *  stress_io_engine_selected()
+ *	return true if an engine was selected with --io-engine,
+ *	stressors with their own I/O loops only use the engines
+ *	when asked to
+ */
+bool stress_io_engine_selected(void)
+{
+	size_t i;
+
+	return stress_get_setting("io-engine", &i);
+}
+
+/*
+ *  stress_io_engine_name()
+ *	return the name of the --io-engine selected engine
+ */
+const char *stress_io_engine_name(void)
+{
+	return io_engines[stress_io_engine_index()].name;
+}
+
+/*
+ *  stress_io_engine_open()
+ *	set up the --io-engine selected engine for I/O on fd with
+ *	up to depth requests in flight, returns EXIT_SUCCESS or
+ *	EXIT_NO_RESOURCE if the engine is not usable. Engines may
+ *	lower engine->depth, callers must not have more requests
+ *	than that in flight
+ */
+int stress_io_engine_open(
+	stress_args_t *args,
+	stress_io_engine_t *engine,
+	const int fd,
+	const uint32_t depth)
+{
+	(void)shim_memset(engine, 0, sizeof(*engine));
+	engine->ops = &io_engines[stress_io_engine_index()];
+	engine->fd = fd;
+	engine->depth = depth;
+
+	if (engine->ops->open(engine) < 0) {
+		pr_inf_skip("%s: cannot set up %s I/O engine with %" PRIu32
+			" requests, errno=%d (%s), skipping stressor\n",
+			args->name, engine->ops->name, depth,
+			errno, strerror(errno));
+		engine->ops = NULL;
+		return EXIT_NO_RESOURCE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  stress_io_engine_submit()
+ *	submit n requests, returns the number submitted or
+ *	-1 with errno set on failure
+ */
+int stress_io_engine_submit(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t n)
+{
+	int ret;
+
+	if (n == 0)
+		return 0;
+	if (!engine->ops) {
+		errno = EBADF;
+		return -1;
+	}
+	ret = engine->ops->submit(engine, reqs, n);
+	if (ret > 0)
+		engine->inflight += (uint32_t)ret;
+	return ret;
+}
+
+/*
+ *  stress_io_engine_reap()
+ *	reap up to max completed requests into reqs, waiting for
+ *	at least min, returns the number reaped or -1 with errno
+ *	set on failure
+ */
+int stress_io_engine_reap(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t min,
+	const uint32_t max)
+{
+	int ret;
+
+	if (engine->inflight == 0)
+		return 0;
+	if (!engine->ops) {
+		errno = EBADF;
+		return -1;
+	}
+	ret = engine->ops->reap(engine, reqs,
+		STRESS_MINIMUM(min, engine->inflight),
+		STRESS_MINIMUM(max, engine->inflight));
+	if (ret > 0)
+		engine->inflight -= (uint32_t)ret;
+	return ret;
+}
+
+/*
+ *  stress_io_engine_close()
+ *	tear down the engine
+ */
+void stress_io_engine_close(stress_io_engine_t *engine)
+{
+	if (engine->ops) {
+		engine->ops->close(engine);
+		engine->ops = NULL;
+	}
+	engine->priv = NULL;
+	engine->inflight = 0;
+}
+
+/*
+ *  stress_io_engine_batch()
+ *	submit n requests in batches of up to engine->depth and
+ *	wait for each batch to complete. Request slots are assigned
+ *	here, requests that could not be submitted are completed
+ *	with -ECANCELED. If requests in flight cannot be reaped the
+ *	engine is closed to cancel them. Returns 0 or -1 with errno
+ *	set on failure
+ */
+int stress_io_engine_batch(
+	stress_io_engine_t *engine,
+	stress_io_req_t *reqs[],
+	const uint32_t n)
+{
+	stress_io_req_t *done[64];
+	uint32_t i, j;
+	int saved_errno = 0;
+
+	for (i = 0; i < n; i++)
+		reqs[i]->res = -ECANCELED;
+
+	for (i = 0; (i < n) && !saved_errno; ) {
+		const uint32_t batch = STRESS_MINIMUM(n - i, engine->depth);
+		uint32_t submitted = 0;
+
+		for (j = 0; j < batch; j++)
+			reqs[i + j]->slot = j;
+
+		while (submitted < batch) {
+			const int ret = stress_io_engine_submit(engine,
+				&reqs[i + submitted], batch - submitted);
+
+			if (ret < 0) {
+				if (((errno == EAGAIN) || (errno == EINTR)) &&
+				    stress_continue_flag())
+					continue;
+				saved_errno = errno;
+				break;
+			}
+			if (ret == 0) {
+				/* nothing submitted, reap to make room and retry */
+				if (engine->inflight == 0) {
+					saved_errno = EBUSY;
+					break;
+				}
+				if (!stress_continue_flag()) {
+					saved_errno = EINTR;
+					break;
+				}
+				if ((stress_io_engine_reap(engine, done, 1,
+						(uint32_t)SIZEOF_ARRAY(done)) < 0) &&
+				    (errno != EINTR)) {
+					saved_errno = errno;
+					break;
+				}
+				continue;
+			}
+			submitted += (uint32_t)ret;
+		}
+
+		/* always drain, the requests may use the caller's stack */
+		while (engine->inflight > 0) {
+			const int ret = stress_io_engine_reap(engine, done,
+				1, (uint32_t)SIZEOF_ARRAY(done));
+
+			if ((ret < 0) && (errno != EINTR)) {
+				/* cannot reap, tear down the engine to cancel them */
+				saved_errno = errno;
+				stress_io_engine_close(engine);
+				break;
+			}
+		}
+		i += batch;
+	}
+	if (saved_errno) {
+		errno = saved_errno;
+		return -1;
+	}
+	return 0;
+}
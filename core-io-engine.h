@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2024      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef CORE_IO_ENGINE_H
+#define CORE_IO_ENGINE_H
+
+/*
+ *  an I/O request, submitted to an engine and handed back
+ *  by stress_io_engine_reap() once it has completed
+ */
+typedef struct {
+	void *buf;		/* I/O buffer */
+	uint64_t offset;	/* file offset */
+	size_t size;		/* I/O size in bytes */
+	bool write;		/* true = write, false = read */
+	ssize_t res;		/* bytes transferred or -errno */
+	uint64_t start_ns;	/* submit time, for latency measurements */
+	uint32_t slot;		/* request slot, 0 .. depth - 1 */
+} stress_io_req_t;
+
+struct stress_io_engine_ops;
+
+typedef struct {
+	const struct stress_io_engine_ops *ops;	/* back-end */
+	int fd;			/* file being exercised */
+	uint32_t depth;		/* maximum requests in flight */
+	uint32_t inflight;	/* requests submitted and not yet reaped */
+	void *priv;		/* back-end private data */
+} stress_io_engine_t;
+
+extern int stress_set_io_engine(const char *opt);
+extern bool stress_io_engine_selected(void);
+extern const char *stress_io_engine_name(void);
+extern int stress_io_engine_open(stress_args_t *args, stress_io_engine_t *engine,
+	const int fd, const uint32_t depth);
+extern int stress_io_engine_submit(stress_io_engine_t *engine,
+	stress_io_req_t *reqs[], const uint32_t n);
+extern int stress_io_engine_reap(stress_io_engine_t *engine,
+	stress_io_req_t *reqs[], const uint32_t min, const uint32_t max);
+extern int stress_io_engine_batch(stress_io_engine_t *engine,
+	stress_io_req_t *reqs[], const uint32_t n);
+extern void stress_io_engine_close(stress_io_engine_t *engine);
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-latency.h"
+
+/*
+ *  stress_latency_init()
+ *	initialize a latency histogram
+ */
+void stress_latency_init(stress_latency_t *lat)
+{
+	(void)shim_memset(lat, 0, sizeof(*lat));
+	lat->min_ns = UINT64_MAX;
+	lat->metrics_idx = -1;
+}
+
+/*
+ *  stress_latency_merge()
+ *	merge latency histogram src into dst
+ */
+void stress_latency_merge(stress_latency_t *dst, const stress_latency_t *src)
+{
+	size_t i;
+
+	if (!src->count)
+		return;
+
+	dst->count += src->count;
+	dst->total_ns += src->total_ns;
+	if (dst->min_ns > src->min_ns)
+		dst->min_ns = src->min_ns;
+	if (dst->max_ns < src->max_ns)
+		dst->max_ns = src->max_ns;
+	for (i = 0; i < STRESS_LATENCY_BUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+}
+
+/*
+ *  stress_latency_bucket_ns()
+ *	return the lowest latency in nanoseconds that maps to bucket idx
+ */
+uint64_t stress_latency_bucket_ns(const size_t idx)
+{
+	size_t octave;
+
+	if (idx < (2 * STRESS_LATENCY_SUB_BUCKETS))
+		return (uint64_t)idx;
+
+	octave = idx >> STRESS_LATENCY_SUB_BITS;
+	return (uint64_t)(STRESS_LATENCY_SUB_BUCKETS + (idx & (STRESS_LATENCY_SUB_BUCKETS - 1))) << (octave - 1);
+}
+
+/*
+ *  stress_latency_percentile()
+ *	return the latency in nanoseconds at the given percentile,
+ *	this is the highest value of the bucket the percentile lands
+ *	in, clamped to the range of latencies recorded
+ */
+uint64_t stress_latency_percentile(const stress_latency_t *lat, const double percentile)
+{
+	uint64_t target, total = 0, ns;
+	size_t i;
+
+	if (!lat->count)
+		return 0;
+
+	target = (uint64_t)ceil(((double)lat->count * percentile) / 100.0);
+	if (target < 1)
+		target = 1;
+	if (target > lat->count)
+		target = lat->count;
+
+	for (i = 0; i < STRESS_LATENCY_BUCKETS; i++) {
+		total += lat->buckets[i];
+		if (total >= target)
+			break;
+	}
+	if (i >= STRESS_LATENCY_BUCKETS - 1)
+		return lat->max_ns;
+
+	ns = stress_latency_bucket_ns(i + 1) - 1;
+	if (ns > lat->max_ns)
+		ns = lat->max_ns;
+	if (ns < lat->min_ns)
+		ns = lat->min_ns;
+	return ns;
+}
+
+/*
+ *  stress_latency_mode()
+ *	return the lowest latency of the most populated bucket
+ */
+uint64_t stress_latency_mode(const stress_latency_t *lat)
+{
+	size_t i, mode = 0;
+
+	for (i = 1; i < STRESS_LATENCY_BUCKETS; i++) {
+		if (lat->buckets[i] > lat->buckets[mode])
+			mode = i;
+	}
+	return stress_latency_bucket_ns(mode);
+}
+
+/*
+ *  stress_latency_stressor()
+ *	merge the latency histograms of all the instances of a stressor,
+ *	returns the number of latencies recorded
+ */
+static uint64_t stress_latency_stressor(const stress_stressor_t *ss, stress_latency_t *lat)
+{
+	int32_t j;
+
+	stress_latency_init(lat);
+	if (ss->ignore.run || ss->ignore.permute)
+		return 0;
+	if (!ss->stats)
+		return 0;
+
+	for (j = 0; j < ss->num_instances; j++)
+		stress_latency_merge(lat, &ss->stats[j]->latency);
+	return lat->count;
+}
+
+/*
+ *  stress_latency_values()
+ *	fill in the mean, percentile and maximum latencies
+ *	reported as metrics by stress_latency_metrics()
+ */
+static void stress_latency_values(const stress_latency_t *lat, double values[STRESS_LATENCY_METRICS])
+{
+	values[0] = lat->count ? lat->total_ns / (double)lat->count : 0.0;
+	values[1] = (double)stress_latency_percentile(lat, 50.0);
+	values[2] = (double)stress_latency_percentile(lat, 99.0);
+	values[3] = (double)stress_latency_percentile(lat, 99.9);
+	values[4] = (double)stress_latency_percentile(lat, 99.99);
+	values[5] = (double)lat->max_ns;
+}
+
+/*
+ *  stress_latency_metrics()
+ *	add the mean, percentile and maximum latencies to the stressor
+ *	metrics starting at metrics index idx, these are the per-instance
+ *	values until stress_latency_metrics_merge() replaces them with
+ *	the values of the histogram merged from all the instances
+ */
+void stress_latency_metrics(stress_args_t *args, const size_t idx)
+{
+	stress_latency_t *lat = args->latency;
+	double values[STRESS_LATENCY_METRICS];
+
+	if (!lat || !stress_latency_enabled())
+		return;
+
+	stress_latency_values(lat, values);
+	lat->metrics_idx = (ssize_t)idx;
+	stress_metrics_set(args, idx + 0, "nanosec mean latency",
+		values[0], STRESS_MERGED_VALUE);
+	stress_metrics_set(args, idx + 1, "nanosec p50 latency",
+		values[1], STRESS_MERGED_VALUE);
+	stress_metrics_set(args, idx + 2, "nanosec p99 latency",
+		values[2], STRESS_MERGED_VALUE);
+	stress_metrics_set(args, idx + 3, "nanosec p99.9 latency",
+		values[3], STRESS_MERGED_VALUE);
+	stress_metrics_set(args, idx + 4, "nanosec p99.99 latency",
+		values[4], STRESS_MERGED_VALUE);
+	stress_metrics_set(args, idx + 5, "nanosec max latency",
+		values[5], STRESS_MERGED_VALUE);
+}
+
+/*
+ *  stress_latency_metrics_merge()
+ *	merge the latency histograms of all the instances of each
+ *	stressor and set the latency metrics of every instance to
+ *	the mean, percentiles and maximum of the merged histogram
+ */
+void stress_latency_metrics_merge(stress_stressor_t *stressors_list)
+{
+	static stress_latency_t lat;
+	stress_stressor_t *ss;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		double values[STRESS_LATENCY_METRICS];
+		int32_t j;
+
+		if (!stress_latency_stressor(ss, &lat))
+			continue;
+
+		stress_latency_values(&lat, values);
+		for (j = 0; j < ss->num_instances; j++) {
+			stress_stats_t *const stats = ss->stats[j];
+			const ssize_t idx = stats->latency.metrics_idx;
+			size_t i;
+
+			if (idx < 0)
+				continue;
+			for (i = 0; i < STRESS_LATENCY_METRICS; i++) {
+				if ((size_t)idx + i >= STRESS_MISC_METRICS_MAX)
+					break;
+				stats->metrics.items[(size_t)idx + i].value = values[i];
+			}
+		}
+	}
+}
+
+/*
+ *  stress_latency_dump()
+ *	dump latency percentiles and histogram buckets of all
+ *	the stressors that recorded latencies to the YAML log
+ */
+void stress_latency_dump(FILE *yaml, stress_stressor_t *stressors_list)
+{
+	static stress_latency_t lat;
+	stress_stressor_t *ss;
+	bool pr_heading = false;
+
+	if (!yaml)
+		return;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		char munged[64];
+		size_t i;
+
+		if (!stress_latency_stressor(ss, &lat))
+			continue;
+
+		if (!pr_heading) {
+			pr_yaml(yaml, "latency-metrics:\n");
+			pr_heading = true;
+		}
+		(void)stress_munge_underscore(munged, ss->stressor->name, sizeof(munged));
+		pr_yaml(yaml, "    - stressor: %s\n", munged);
+		pr_yaml(yaml, "      samples: %" PRIu64 "\n", lat.count);
+		pr_yaml(yaml, "      min-ns: %" PRIu64 "\n", lat.min_ns);
+		pr_yaml(yaml, "      mean-ns: %f\n", lat.total_ns / (double)lat.count);
+		pr_yaml(yaml, "      p50-ns: %" PRIu64 "\n", stress_latency_percentile(&lat, 50.0));
+		pr_yaml(yaml, "      p99-ns: %" PRIu64 "\n", stress_latency_percentile(&lat, 99.0));
+		pr_yaml(yaml, "      p99.9-ns: %" PRIu64 "\n", stress_latency_percentile(&lat, 99.9));
+		pr_yaml(yaml, "      p99.99-ns: %" PRIu64 "\n", stress_latency_percentile(&lat, 99.99));
+		pr_yaml(yaml, "      max-ns: %" PRIu64 "\n", lat.max_ns);
+		pr_yaml(yaml, "      buckets:\n");
+		for (i = 0; i < STRESS_LATENCY_BUCKETS; i++) {
+			if (!lat.buckets[i])
+				continue;
+			pr_yaml(yaml, "        - { ns: %" PRIu64 ", count: %" PRIu64 " }\n",
+				stress_latency_bucket_ns(i), lat.buckets[i]);
+		}
+		pr_yaml(yaml, "\n");
+	}
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef CORE_LATENCY_H
+#define CORE_LATENCY_H
+
+#include "stress-ng.h"
+
+#define STRESS_LATENCY_METRICS	(6)	/* metrics set by stress_latency_metrics */
+
+extern void stress_latency_init(stress_latency_t *lat);
+extern void stress_latency_merge(stress_latency_t *dst, const stress_latency_t *src);
+extern uint64_t stress_latency_bucket_ns(const size_t idx);
+extern uint64_t stress_latency_percentile(const stress_latency_t *lat, const double percentile);
+extern uint64_t stress_latency_mode(const stress_latency_t *lat);
+extern void stress_latency_metrics(stress_args_t *args, const size_t idx);
+extern void stress_latency_metrics_merge(stress_stressor_t *stressors_list);
+extern void stress_latency_dump(FILE *yaml, stress_stressor_t *stressors_list);
+
+/*
+ *  stress_latency_index()
+ *	map a latency in nanoseconds to a histogram bucket, values
+ *	below 2 * STRESS_LATENCY_SUB_BUCKETS are exact, larger
+ *	values are bucketed with a relative error of at most
+ *	1 / STRESS_LATENCY_SUB_BUCKETS
+ */
+static inline size_t ALWAYS_INLINE stress_latency_index(const uint64_t ns)
+{
+	uint32_t msb;
+
+	if (ns < (2 * STRESS_LATENCY_SUB_BUCKETS))
+		return (size_t)ns;
+#if defined(HAVE_BUILTIN_CLZLL)
+	msb = 63 - (uint32_t)__builtin_clzll(ns);
+#else
+	{
+		uint64_t v = ns;
+
+		for (msb = 0; v >>= 1; msb++)
+			;
+	}
+#endif
+	if (msb >= STRESS_LATENCY_MAX_SHIFT)
+		return STRESS_LATENCY_BUCKETS - 1;
+
+	return ((size_t)(msb - STRESS_LATENCY_SUB_BITS + 1) << STRESS_LATENCY_SUB_BITS) +
+		(size_t)((ns >> (msb - STRESS_LATENCY_SUB_BITS)) - STRESS_LATENCY_SUB_BUCKETS);
+}
+
+/*
+ *  stress_latency_add()
+ *	add a latency in nanoseconds to a latency histogram, O(1)
+ */
+static inline void ALWAYS_INLINE stress_latency_add(stress_latency_t *lat, const uint64_t ns)
+{
+	lat->count++;
+	lat->total_ns += (double)ns;
+	if (ns < lat->min_ns)
+		lat->min_ns = ns;
+	if (ns > lat->max_ns)
+		lat->max_ns = ns;
+	lat->buckets[stress_latency_index(ns)]++;
+}
+
+/*
+ *  stress_latency_now()
+ *	monotonic time in nanoseconds for latency measurements
+ */
+static inline uint64_t ALWAYS_INLINE stress_latency_now(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) &&	\
+    defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	if (LIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) == 0))
+		return ((uint64_t)ts.tv_sec * STRESS_NANOSECOND) + (uint64_t)ts.tv_nsec;
+#endif
+	return (uint64_t)(stress_time_now() * STRESS_DBL_NANOSECOND);
+}
+
+/*
+ *  stress_latency_enabled()
+ *	true if per operation latency recording is enabled with --latency
+ */
+static inline bool ALWAYS_INLINE stress_latency_enabled(void)
+{
+	return !!(g_opt_flags & OPT_FLAGS_LATENCY);
+}
+
+/*
+ *  stress_latency_record()
+ *	record the latency of an operation in nanoseconds in the
+ *	per-instance latency histogram. Note that this is not atomic,
+ *	so only one process or thread per instance should record.
+ */
+static inline void ALWAYS_INLINE stress_latency_record(stress_args_t *args, const uint64_t ns)
+{
+	if (LIKELY(args->latency != NULL))
+		stress_latency_add(args->latency, ns);
+}
+
+#endif
@@ -18,6 +18,7 @@
  *
  */
 #include "stress-ng.h"
+#include "core-builtin.h"
 #include "core-mincore.h"
 
 /*
@@ -158,3 +159,68 @@ int stress_mincore_touch_pages_interruptible(void *buf, const size_t buf_len)
 {
 	return stress_mincore_touch_pages_generic(buf, buf_len, true);
 }
+
+/*
+ *  stress_page_cache_stat()
+ *	get the page cache state of the file range offset..offset + len - 1
+ *	using cachestat(), or if that is not available by sampling page
+ *	residency with mincore() on a shared read-only mapping of the
+ *	range. Returns 0 on success, -1 on failure.
+ */
+int stress_page_cache_stat(
+	const int fd,
+	const off_t offset,
+	const off_t len,
+	stress_page_cache_stat_t *pcstat)
+{
+	const size_t page_size = stress_get_page_size();
+	const off_t start = offset & ~(off_t)(page_size - 1);
+	const off_t end = (offset + len + (off_t)page_size - 1) & ~(off_t)(page_size - 1);
+	struct shim_cachestat_range cstat_range;
+	struct shim_cachestat cstat;
+#if defined(HAVE_MINCORE)
+	unsigned char vec[1024];
+	off_t posn;
+#endif
+
+	(void)shim_memset(pcstat, 0, sizeof(*pcstat));
+	if ((offset < 0) || (len <= 0))
+		return -1;
+	pcstat->pages = (uint64_t)(end - start) / page_size;
+
+	cstat_range.off = (uint64_t)offset;
+	cstat_range.len = (uint64_t)len;
+	if (shim_cachestat(fd, &cstat_range, &cstat, 0) == 0) {
+		pcstat->cached = cstat.nr_cache;
+		pcstat->dirty = cstat.nr_dirty;
+		pcstat->writeback = cstat.nr_writeback;
+		pcstat->evicted = cstat.nr_evicted;
+		pcstat->cachestat = true;
+		return 0;
+	}
+
+#if defined(HAVE_MINCORE)
+	/* map and check the range a chunk of pages at a time */
+	for (posn = start; posn < end; ) {
+		const size_t n_pages = STRESS_MINIMUM((size_t)(end - posn) / page_size, sizeof(vec));
+		const size_t size = n_pages * page_size;
+		void *ptr;
+		size_t i;
+
+		ptr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, posn);
+		if (ptr == MAP_FAILED)
+			return -1;
+		if (shim_mincore(ptr, size, vec) < 0) {
+			(void)munmap(ptr, size);
+			return -1;
+		}
+		for (i = 0; i < n_pages; i++)
+			pcstat->cached += (vec[i] & 1);
+		(void)munmap(ptr, size);
+		posn += (off_t)size;
+	}
+	return 0;
+#else
+	return -1;
+#endif
+}
@@ -19,7 +19,23 @@
 #ifndef CORE_MINCORE_H
 #define CORE_MINCORE_H
 
+/*
+ *  page cache state of a file range, dirty, writeback and
+ *  evicted counts are only available when cachestat() is
+ *  supported
+ */
+typedef struct {
+	uint64_t pages;		/* pages in the range */
+	uint64_t cached;	/* pages in the page cache */
+	uint64_t dirty;		/* dirty pages */
+	uint64_t writeback;	/* pages under writeback */
+	uint64_t evicted;	/* pages evicted from the page cache */
+	bool cachestat;		/* true if filled in by cachestat() */
+} stress_page_cache_stat_t;
+
 extern int stress_mincore_touch_pages(void *buf, const size_t buf_len);
 extern int stress_mincore_touch_pages_interruptible(void *buf, const size_t buf_len);
+extern int stress_page_cache_stat(const int fd, const off_t offset, const off_t len,
+	stress_page_cache_stat_t *pcstat);
 
 #endif
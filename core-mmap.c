@@ -199,3 +199,352 @@ int OPTIMIZE3 stress_mmap_check_light(
 	return 0;
 }
 
+
+typedef struct {
+	const char *name;		/* --page-size option name */
+	const int mode;			/* STRESS_PAGE_SIZE_* mode */
+} stress_page_size_info_t;
+
+static const stress_page_size_info_t page_size_info[] = {
+	{ "default",	STRESS_PAGE_SIZE_DEFAULT },
+	{ "4k",		STRESS_PAGE_SIZE_BASE },
+	{ "thp",	STRESS_PAGE_SIZE_THP },
+	{ "2m",		STRESS_PAGE_SIZE_2M },
+	{ "1g",		STRESS_PAGE_SIZE_1G },
+};
+
+/*
+ *  stress_set_page_size()
+ *	parse --page-size option
+ */
+int stress_set_page_size(const char *opt)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(page_size_info); i++) {
+		if (!strcasecmp(opt, page_size_info[i].name))
+			return stress_set_setting_global("page-size", TYPE_ID_INT, &page_size_info[i].mode);
+	}
+	(void)fprintf(stderr, "invalid page-size '%s', allowed page sizes are:", opt);
+	for (i = 0; i < SIZEOF_ARRAY(page_size_info); i++)
+		(void)fprintf(stderr, " %s", page_size_info[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+/*
+ *  stress_page_size_mode()
+ *	return the --page-size backing mode
+ */
+static int stress_page_size_mode(void)
+{
+	int mode = STRESS_PAGE_SIZE_DEFAULT;
+
+	(void)stress_get_setting("page-size", &mode);
+	return mode;
+}
+
+/*
+ *  stress_page_size_enabled()
+ *	return true if --page-size selects the buffer backing,
+ *	stressors should not apply their own huge page advice
+ */
+bool stress_page_size_enabled(void)
+{
+	return stress_page_size_mode() != STRESS_PAGE_SIZE_DEFAULT;
+}
+
+/*
+ *  stress_mmap_smaps()
+ *	get the kernel page size and the transparent huge page
+ *	usage in KB of the mapping at addr from /proc/self/smaps,
+ *	kernel_page_kb is zero if it cannot be determined
+ */
+static void stress_mmap_smaps(
+	const void *addr,
+	size_t *kernel_page_kb,
+	size_t *huge_kb)
+{
+	*kernel_page_kb = 0;
+	*huge_kb = 0;
+#if defined(__linux__)
+	FILE *fp;
+	char line[256];
+	bool found = false;
+
+	fp = fopen("/proc/self/smaps", "r");
+	if (!fp)
+		return;
+	while (fgets(line, sizeof(line), fp)) {
+		unsigned long int start, end;
+		size_t kb;
+
+		if (sscanf(line, "%lx-%lx", &start, &end) == 2) {
+			if (found)
+				break;
+			found = ((uintptr_t)addr >= start) && ((uintptr_t)addr < end);
+			continue;
+		}
+		if (!found)
+			continue;
+		if (sscanf(line, "KernelPageSize: %zu", &kb) == 1)
+			*kernel_page_kb = kb;
+		else if ((sscanf(line, "AnonHugePages: %zu", &kb) == 1) ||
+			 (sscanf(line, "ShmemPmdMapped: %zu", &kb) == 1))
+			*huge_kb += kb;
+	}
+	(void)fclose(fp);
+#else
+	(void)addr;
+#endif
+}
+
+/*
+ *  stress_mmap_thp_size()
+ *	return the transparent huge page size
+ */
+size_t stress_mmap_thp_size(void)
+{
+	char buf[32];
+	unsigned long int sz;
+
+	if ((stress_system_read("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", buf, sizeof(buf)) > 0) &&
+	    (sscanf(buf, "%lu", &sz) == 1) && (sz > 0))
+		return (size_t)sz;
+	return 2 * MB;
+}
+
+/*
+ *  stress_mmap_page_size()
+ *	return the size of the pages that back most of the
+ *	mapping of size bytes at addr, 0 if unknown
+ */
+size_t stress_mmap_page_size(const void *addr, const size_t size)
+{
+	size_t kernel_page_kb, huge_kb;
+
+	stress_mmap_smaps(addr, &kernel_page_kb, &huge_kb);
+	if (!kernel_page_kb)
+		return 0;
+	if ((kernel_page_kb * KB <= stress_get_page_size()) &&
+	    (huge_kb * KB * 2 >= size))
+		return stress_mmap_thp_size();
+	return kernel_page_kb * KB;
+}
+
+/*
+ *  stress_mmap_buffer_backing()
+ *	describe the pages backing the mapping at addr
+ */
+static void stress_mmap_buffer_backing(
+	const void *addr,
+	const size_t size,
+	char *buf,
+	const size_t buf_len)
+{
+	size_t kernel_page_kb, huge_kb;
+
+	(void)snprintf(buf, buf_len, "unknown pages");
+	stress_mmap_smaps(addr, &kernel_page_kb, &huge_kb);
+	if (!kernel_page_kb)
+		return;
+	if (kernel_page_kb * KB > stress_get_page_size()) {
+		(void)snprintf(buf, buf_len, "%zuK hugetlbfs pages", kernel_page_kb);
+	} else {
+		double pc = size ? 100.0 * (double)huge_kb * KB / (double)size : 0.0;
+
+		if (pc > 100.0)
+			pc = 100.0;
+		(void)snprintf(buf, buf_len, "%zuK pages, %.1f%% transparent huge pages",
+			kernel_page_kb, pc);
+	}
+}
+
+/*
+ *  stress_mmap_buffer_report()
+ *	report the backing achieved, instance 0 logs the first
+ *	buffer, all buffers are logged in debug mode
+ */
+static void stress_mmap_buffer_report(
+	const char *name,
+	const uint32_t instance,
+	const void *addr,
+	const size_t size,
+	const char *requested)
+{
+	static bool reported = false;
+	char backing[64];
+
+	stress_mmap_buffer_backing(addr, size, backing, sizeof(backing));
+	if ((instance == 0) && !reported) {
+		pr_inf("%s: page-size %s: %zuK buffer backed by %s\n",
+			name, requested, size / 1024, backing);
+		reported = true;
+	} else {
+		pr_dbg("%s: page-size %s: %zuK buffer backed by %s\n",
+			name, requested, size / 1024, backing);
+	}
+}
+
+/*
+ *  stress_mmap_advised()
+ *	mmap an anonymous buffer aligned to align bytes, apply
+ *	madvise advice before the pages are faulted in so that
+ *	THP advice is honoured at fault time, then populate it
+ */
+static void *stress_mmap_advised(
+	const size_t size,
+	const int prot,
+	const int flags,
+	const size_t align,
+	const int advice)
+{
+	uint8_t *ptr, *aligned;
+	const size_t len = size + align;
+	int mmap_flags = flags | MAP_ANONYMOUS;
+
+#if defined(MAP_POPULATE)
+	/* pages must not be faulted in before the advice is applied */
+	mmap_flags &= ~MAP_POPULATE;
+#endif
+	ptr = (uint8_t *)mmap(NULL, len, prot, mmap_flags, -1, 0);
+	if (ptr == MAP_FAILED)
+		return MAP_FAILED;
+
+	aligned = align ? (uint8_t *)(((uintptr_t)ptr + align - 1) & ~(uintptr_t)(align - 1)) : ptr;
+	if (aligned > ptr)
+		(void)munmap((void *)ptr, (size_t)(aligned - ptr));
+	if (ptr + len > aligned + size)
+		(void)munmap((void *)(aligned + size), (size_t)((ptr + len) - (aligned + size)));
+
+#if defined(HAVE_MADVISE)
+	if (advice >= 0)
+		(void)madvise((void *)aligned, size, advice);
+#else
+	(void)advice;
+#endif
+	if (prot & PROT_WRITE) {
+		const size_t page_size = stress_get_page_size();
+		size_t i;
+
+#if defined(HAVE_MADVISE) &&	\
+    defined(MADV_POPULATE_WRITE)
+		if (madvise((void *)aligned, size, MADV_POPULATE_WRITE) == 0)
+			return (void *)aligned;
+#endif
+		for (i = 0; i < size; i += page_size)
+			aligned[i] = 0;
+	}
+	return (void *)aligned;
+}
+
+/*
+ *  stress_mmap_buffer_mode()
+ *	mmap an anonymous large buffer for stressor name and instance
+ *	backed by the pages selected by STRESS_PAGE_SIZE_* mode, flags
+ *	are MAP_PRIVATE or MAP_SHARED plus any extra mmap flags. size
+ *	is rounded up to the mode's page size and must be used to
+ *	munmap the buffer, the rounding only depends on the page size
+ *	so buffers of the same size are the same size when mapped.
+ *	hugetlbfs pages fall back to transparent huge pages if they
+ *	are not available, the size is then rounded to the transparent
+ *	huge page mode's page size instead. Returns MAP_FAILED on failure.
+ */
+void *stress_mmap_buffer_mode(
+	const char *name,
+	const uint32_t instance,
+	size_t *size,
+	const int prot,
+	const int flags,
+	const int mode)
+{
+	const size_t page_size = (mode == STRESS_PAGE_SIZE_1G) ? GB :
+		((mode == STRESS_PAGE_SIZE_2M) ? 2 * MB : stress_get_page_size());
+	size_t sz = (*size + page_size - 1) & ~(page_size - 1);
+	const char *requested = "default";
+	void *ptr = MAP_FAILED;
+	int advice = -1;
+	size_t align = 0;
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(page_size_info); i++) {
+		if (page_size_info[i].mode == mode)
+			requested = page_size_info[i].name;
+	}
+
+	switch (mode) {
+	case STRESS_PAGE_SIZE_2M:
+	case STRESS_PAGE_SIZE_1G:
+#if defined(MAP_HUGETLB)
+		{
+			int huge_flags = MAP_HUGETLB;
+
+			if (mode == STRESS_PAGE_SIZE_1G) {
+#if defined(MAP_HUGE_1GB)
+				huge_flags |= MAP_HUGE_1GB;
+#else
+				huge_flags = 0;
+#endif
+			} else {
+#if defined(MAP_HUGE_2MB)
+				huge_flags |= MAP_HUGE_2MB;
+#endif
+			}
+			if (huge_flags) {
+				ptr = stress_mmap_populate(NULL, sz, prot,
+					flags | MAP_ANONYMOUS | huge_flags, -1, 0);
+				if (ptr != MAP_FAILED) {
+					*size = sz;
+					stress_mmap_buffer_report(name, instance, ptr, sz, requested);
+					return ptr;
+				}
+			}
+		}
+#endif
+		if (stress_warn_once())
+			pr_inf("%s: cannot mmap %s hugetlbfs pages, using transparent huge pages instead\n",
+				name, requested);
+		sz = (*size + stress_get_page_size() - 1) & ~(stress_get_page_size() - 1);
+		goto case_page_size_thp;
+	case STRESS_PAGE_SIZE_THP:
+case_page_size_thp:
+#if defined(MADV_HUGEPAGE)
+		advice = MADV_HUGEPAGE;
+#endif
+		align = 2 * MB;
+		break;
+	case STRESS_PAGE_SIZE_BASE:
+#if defined(MADV_NOHUGEPAGE)
+		advice = MADV_NOHUGEPAGE;
+#endif
+		break;
+	default:
+		ptr = stress_mmap_populate(NULL, sz, prot, flags | MAP_ANONYMOUS, -1, 0);
+		if (ptr != MAP_FAILED)
+			*size = sz;
+		return ptr;
+	}
+
+	ptr = stress_mmap_advised(sz, prot, flags, align, advice);
+	if (ptr != MAP_FAILED) {
+		*size = sz;
+		stress_mmap_buffer_report(name, instance, ptr, sz, requested);
+	}
+	return ptr;
+}
+
+/*
+ *  stress_mmap_buffer()
+ *	mmap an anonymous large buffer backed by the pages
+ *	selected with --page-size, see stress_mmap_buffer_mode()
+ */
+void *stress_mmap_buffer(
+	const char *name,
+	const uint32_t instance,
+	size_t *size,
+	const int prot,
+	const int flags)
+{
+	return stress_mmap_buffer_mode(name, instance, size, prot, flags,
+		stress_page_size_mode());
+}
@@ -19,9 +19,24 @@
 #ifndef CORE_MMAP_H
 #define CORE_MMAP_H
 
+/* --page-size backing modes */
+#define STRESS_PAGE_SIZE_DEFAULT	(0)	/* stressor default backing */
+#define STRESS_PAGE_SIZE_BASE		(1)	/* base pages, no THP */
+#define STRESS_PAGE_SIZE_THP		(2)	/* transparent huge pages */
+#define STRESS_PAGE_SIZE_2M		(3)	/* hugetlbfs 2MB pages */
+#define STRESS_PAGE_SIZE_1G		(4)	/* hugetlbfs 1GB pages */
+
 extern void stress_mmap_set(uint8_t *buf, const size_t sz, const size_t page_size);
 extern int stress_mmap_check( uint8_t *buf, const size_t sz, const size_t page_size);
 extern void stress_mmap_set_light(uint8_t *buf, const size_t sz, const size_t page_size);
 extern int stress_mmap_check_light( uint8_t *buf, const size_t sz, const size_t page_size);
+extern int stress_set_page_size(const char *opt);
+extern bool stress_page_size_enabled(void);
+extern void *stress_mmap_buffer(const char *name, const uint32_t instance,
+	size_t *size, const int prot, const int flags);
+extern void *stress_mmap_buffer_mode(const char *name, const uint32_t instance,
+	size_t *size, const int prot, const int flags, const int mode);
+extern size_t stress_mmap_page_size(const void *addr, const size_t size);
+extern size_t stress_mmap_thp_size(void);
 
 #endif
@@ -25,6 +25,94 @@
 
 static const char option[] = "option --mbind";
 
+/*
+ *  stress_numa_cpu_node()
+ *	return the NUMA node a CPU belongs to, -1 if not known
+ */
+int stress_numa_cpu_node(const unsigned int cpu)
+{
+#if defined(__linux__)
+	char path[PATH_MAX];
+	DIR *dir;
+	const struct dirent *d;
+	int node = -1;
+
+	(void)snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+	dir = opendir(path);
+	if (!dir)
+		return -1;
+	while ((d = readdir(dir)) != NULL) {
+		if (!strncmp(d->d_name, "node", 4) &&
+		    (sscanf(d->d_name + 4, "%d", &node) == 1))
+			break;
+		node = -1;
+	}
+	(void)closedir(dir);
+	return node;
+#else
+	(void)cpu;
+
+	return -1;
+#endif
+}
+
+#if defined(HAVE_SCHED_SETAFFINITY)
+static int stress_numa_cpu_nodes[CPU_SETSIZE];	/* cpu to node map */
+static int32_t stress_numa_cpu_nodes_max = -1;	/* cpus in map, -1 = not built */
+#endif
+
+/*
+ *  stress_numa_cpu_nodes_init()
+ *	scan sysfs once and cache the NUMA node of each CPU so that
+ *	stress_numa_bind_cpus() does not rescan it on each call
+ */
+void stress_numa_cpu_nodes_init(void)
+{
+#if defined(HAVE_SCHED_SETAFFINITY)
+	int32_t cpu;
+	const int32_t cpus = stress_get_processors_configured();
+
+	if (stress_numa_cpu_nodes_max >= 0)
+		return;
+	for (cpu = 0; (cpu < cpus) && (cpu < CPU_SETSIZE); cpu++)
+		stress_numa_cpu_nodes[cpu] = stress_numa_cpu_node((unsigned int)cpu);
+	stress_numa_cpu_nodes_max = cpu;
+#endif
+}
+
+/*
+ *  stress_numa_bind_cpus()
+ *	set the CPU affinity of the calling process to the CPUs
+ *	of a NUMA node, returns -1 on failure
+ */
+int stress_numa_bind_cpus(const int node)
+{
+#if defined(HAVE_SCHED_SETAFFINITY)
+	cpu_set_t mask;
+	int32_t cpu, n = 0;
+
+	stress_numa_cpu_nodes_init();
+
+	CPU_ZERO(&mask);
+	for (cpu = 0; cpu < stress_numa_cpu_nodes_max; cpu++) {
+		if (stress_numa_cpu_nodes[cpu] == node) {
+			CPU_SET(cpu, &mask);
+			n++;
+		}
+	}
+	if (n == 0) {
+		errno = ENODEV;
+		return -1;
+	}
+	return sched_setaffinity(0, sizeof(mask), &mask);
+#else
+	(void)node;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
 #if defined(__NR_get_mempolicy) &&      \
     defined(__NR_mbind) &&              \
     defined(__NR_migrate_pages) &&      \
@@ -54,15 +142,17 @@ static void stress_check_numa_range(
 }
 
 /*
- *  stress_numa_count_mem_nodes()
- *	determine the number of NUMA memory nodes
+ *  stress_numa_mem_node_ids()
+ *	determine the NUMA memory nodes, fill ids with up to
+ *	max_ids node ids (if ids is not NULL) in ascending order
+ *	and return the number of nodes, -1 if not known
  */
-int stress_numa_count_mem_nodes(unsigned long *max_node)
+int stress_numa_mem_node_ids(int *ids, const int max_ids, unsigned long *max_node)
 {
 	FILE *fp;
 	unsigned long node_id = 0;
 	char buffer[8192], *str = NULL, *ptr;
-	long n = 0;
+	int n = 0;
 
 	*max_node = 0;
 
@@ -104,8 +194,11 @@ int stress_numa_count_mem_nodes(unsigned long *max_node)
 
 		/* Each hex digit represent 4 memory nodes */
 		for (i = 0; i < 4; i++) {
-			if (val & (1 << i))
+			if (val & (1 << i)) {
+				if (ids && (n < max_ids))
+					ids[n] = (int)node_id;
 				n++;
+			}
 			node_id++;
 			if (*max_node < node_id)
 				*max_node = node_id;
@@ -116,6 +209,47 @@ int stress_numa_count_mem_nodes(unsigned long *max_node)
 	return n;
 }
 
+/*
+ *  stress_numa_count_mem_nodes()
+ *	determine the number of NUMA memory nodes
+ */
+int stress_numa_count_mem_nodes(unsigned long *max_node)
+{
+	return stress_numa_mem_node_ids(NULL, 0, max_node);
+}
+
+/*
+ *  stress_numa_mbind_node()
+ *	bind the memory at addr to NUMA node, moving any pages
+ *	that are already faulted in, returns -1 on failure
+ */
+int stress_numa_mbind_node(void *addr, const size_t len, const int node)
+{
+	unsigned long max_node;
+	unsigned long *nodemask;
+	const size_t nodemask_bits = sizeof(*nodemask) * 8;
+	size_t nodemask_sz;
+	long ret;
+
+	if (stress_numa_count_mem_nodes(&max_node) < 0)
+		return -1;
+	if ((node < 0) || ((unsigned long)node >= max_node)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	nodemask_sz = (max_node + (nodemask_bits - 1)) / nodemask_bits;
+	nodemask = calloc(nodemask_sz, sizeof(*nodemask));
+	if (!nodemask)
+		return -1;
+	STRESS_SETBIT(nodemask, node);
+	ret = shim_mbind(addr, (unsigned long)len, MPOL_BIND, nodemask,
+		max_node, MPOL_MF_MOVE | MPOL_MF_STRICT);
+	free(nodemask);
+
+	return (ret < 0) ? -1 : 0;
+}
+
 /*
  *  stress_numa_nodes()
  *	determine the number of NUMA memory nodes,
@@ -232,6 +366,16 @@ int stress_numa_nodes(void)
 	return 1;
 }
 
+int stress_numa_mem_node_ids(int *ids, const int max_ids, unsigned long *max_node)
+{
+	(void)ids;
+	(void)max_ids;
+
+	*max_node = 0;
+
+	return -1;
+}
+
 int stress_numa_count_mem_nodes(unsigned long *max_node)
 {
 	*max_node = 0;
@@ -239,6 +383,16 @@ int stress_numa_count_mem_nodes(unsigned long *max_node)
 	return -1;
 }
 
+int stress_numa_mbind_node(void *addr, const size_t len, const int node)
+{
+	(void)addr;
+	(void)len;
+	(void)node;
+
+	errno = ENOSYS;
+	return -1;
+}
+
 int stress_set_mbind(const char *arg)
 {
 	(void)arg;
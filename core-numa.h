@@ -22,5 +22,10 @@
 extern int stress_numa_count_mem_nodes(unsigned long *max_node);
 extern int stress_numa_nodes(void);
 extern int stress_set_mbind(const char *arg);
+extern int stress_numa_cpu_node(const unsigned int cpu);
+extern void stress_numa_cpu_nodes_init(void);
+extern int stress_numa_bind_cpus(const int node);
+extern int stress_numa_mem_node_ids(int *ids, const int max_ids, unsigned long *max_node);
+extern int stress_numa_mbind_node(void *addr, const size_t len, const int node);
 
 #endif
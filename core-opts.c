@@ -122,6 +122,9 @@ const struct option stress_long_options[] = {
 	{ "clone-ops",		1,	0,	OPT_clone_ops },
 	{ "close",		1,	0,	OPT_close },
 	{ "close-ops",		1,	0,	OPT_close_ops },
+	{ "compare",		1,	0,	OPT_compare },
+	{ "compare-runs",	1,	0,	OPT_compare_runs },
+	{ "compare-tolerance",	1,	0,	OPT_compare_tolerance },
 	{ "config",		0,	0,	OPT_config },
 	{ "context",		1,	0,	OPT_context },
 	{ "context-ops",	1,	0,	OPT_context_ops },
@@ -140,6 +143,7 @@ const struct option stress_long_options[] = {
 	{ "crypt",		1,	0,	OPT_crypt },
 	{ "crypt-method",	1,	0,	OPT_crypt_method },
 	{ "crypt-ops",		1,	0,	OPT_crypt_ops },
+	{ "csv",		1,	0,	OPT_csv },
 	{ "cyclic",		1,	0,	OPT_cyclic },
 	{ "cyclic-dist",	1,	0,	OPT_cyclic_dist },
 	{ "cyclic-method",	1,	0,	OPT_cyclic_method },
@@ -231,6 +235,9 @@ const struct option stress_long_options[] = {
 	{ "far-branch-pages",	1,	0,	OPT_far_branch_pages },
 	{ "fault",		1,	0,	OPT_fault },
 	{ "fault-ops",		1,	0,	OPT_fault_ops },
+	{ "fault-latency",	1,	0,	OPT_fault_latency },
+	{ "fault-latency-bytes",1,	0,	OPT_fault_latency_bytes },
+	{ "fault-latency-ops",	1,	0,	OPT_fault_latency_ops },
 	{ "fcntl",		1,	0,	OPT_fcntl},
 	{ "fcntl-ops",		1,	0,	OPT_fcntl_ops },
 	{ "fd-fork",		1,	0,	OPT_fd_fork },
@@ -321,9 +328,15 @@ const struct option stress_long_options[] = {
 	{ "hash-method",	1,	0,	OPT_hash_method },
 	{ "hash-ops",		1,	0,	OPT_hash_ops },
 	{ "hdd",		1,	0,	OPT_hdd },
+	{ "hdd-bs",		1,	0,	OPT_hdd_bs },
 	{ "hdd-bytes",		1,	0,	OPT_hdd_bytes },
+	{ "hdd-dist",		1,	0,	OPT_hdd_dist },
+	{ "hdd-iodepth",	1,	0,	OPT_hdd_iodepth },
+	{ "hdd-iops",		1,	0,	OPT_hdd_iops },
+	{ "hdd-job",		0,	0,	OPT_hdd_job },
 	{ "hdd-ops",		1,	0,	OPT_hdd_ops },
 	{ "hdd-opts",		1,	0,	OPT_hdd_opts },
+	{ "hdd-rwmix",		1,	0,	OPT_hdd_rwmix },
 	{ "hdd-write-size", 	1,	0,	OPT_hdd_write_size },
 	{ "heapsort",		1,	0,	OPT_heapsort },
 	{ "heapsort-method",	1,	0,	OPT_heapsort_method },
@@ -345,11 +358,14 @@ const struct option stress_long_options[] = {
 	{ "idle-page-ops",	1,	0,	OPT_idle_page_ops },
 	{ "ignite-cpu",		0,	0, 	OPT_ignite_cpu },
 	{ "interrupts",		0,	0,	OPT_interrupts },
+	{ "interval",		1,	0,	OPT_interval },
+	{ "interval-csv",	1,	0,	OPT_interval_csv },
 	{ "inode-flags",	1,	0,	OPT_inode_flags },
 	{ "inode-flags-ops",	1,	0,	OPT_inode_flags_ops },
 	{ "inotify",		1,	0,	OPT_inotify },
 	{ "inotify-ops",	1,	0,	OPT_inotify_ops },
 	{ "io",			1,	0,	OPT_io },
+	{ "io-engine",		1,	0,	OPT_io_engine },
 	{ "io-ops",		1,	0,	OPT_io_ops },
 	{ "iomix",		1,	0,	OPT_iomix },
 	{ "iomix-bytes",	1,	0,	OPT_iomix_bytes },
@@ -363,8 +379,14 @@ const struct option stress_long_options[] = {
 	{ "ioprio-ops",		1,	0,	OPT_ioprio_ops },
 	{ "iostat",		1,	0,	OPT_iostat },
 	{ "io-uring",		1,	0,	OPT_io_uring },
+	{ "io-uring-batch",	1,	0,	OPT_io_uring_batch },
+	{ "io-uring-bs",	1,	0,	OPT_io_uring_bs },
 	{ "io-uring-entries",	1,	0,	OPT_io_uring_entries },
 	{ "io-uring-ops",	1,	0,	OPT_io_uring_ops },
+	{ "io-uring-perf",	0,	0,	OPT_io_uring_perf },
+	{ "io-uring-qd",	1,	0,	OPT_io_uring_qd },
+	{ "io-uring-rw",	1,	0,	OPT_io_uring_rw },
+	{ "io-uring-sqpoll",	0,	0,	OPT_io_uring_sqpoll },
 	{ "ipsec-mb",		1,	0,	OPT_ipsec_mb },
 	{ "ipsec-mb-feature",	1,	0,	OPT_ipsec_mb_feature },
 	{ "ipsec-mb-jobs",	1,	0,	OPT_ipsec_mb_jobs },
@@ -381,6 +403,7 @@ const struct option stress_long_options[] = {
 	{ "jpeg-ops",		1,	0,	OPT_jpeg_ops },
 	{ "jpeg-quality",	1,	0,	OPT_jpeg_quality },
 	{ "jpeg-width",		1,	0,	OPT_jpeg_width },
+	{ "json",		1,	0,	OPT_json },
 	{ "judy",		1,	0,	OPT_judy },
 	{ "judy-ops",		1,	0,	OPT_judy_ops },
 	{ "judy-size",		1,	0,	OPT_judy_size },
@@ -408,6 +431,7 @@ const struct option stress_long_options[] = {
 	{ "l1cache-ways",	1,	0,	OPT_l1cache_ways},
 	{ "landlock",		1,	0,	OPT_landlock },
 	{ "landlock-ops",	1,	0,	OPT_landlock_ops },
+	{ "latency",		0,	0,	OPT_latency },
 	{ "led",		1,	0,	OPT_led },
 	{ "led-ops",		1,	0,	OPT_led_ops },
 	{ "lease",		1,	0,	OPT_lease },
@@ -485,6 +509,7 @@ const struct option stress_long_options[] = {
 	{ "memcpy",		1,	0,	OPT_memcpy },
 	{ "memcpy-method",	1,	0,	OPT_memcpy_method },
 	{ "memcpy-ops",		1,	0,	OPT_memcpy_ops },
+	{ "memcpy-sweep",	0,	0,	OPT_memcpy_sweep },
 	{ "memfd",		1,	0,	OPT_memfd },
 	{ "memfd-bytes",	1,	0,	OPT_memfd_bytes },
 	{ "memfd-fds",		1,	0,	OPT_memfd_fds },
@@ -498,9 +523,16 @@ const struct option stress_long_options[] = {
 	{ "memrate",		1,	0,	OPT_memrate },
 	{ "memrate-bytes",	1,	0,	OPT_memrate_bytes },
 	{ "memrate-flush",	0,	0,	OPT_memrate_flush },
+	{ "memrate-latency",	1,	0,	OPT_memrate_latency },
+	{ "memrate-method",	1,	0,	OPT_memrate_method },
 	{ "memrate-ops",	1,	0,	OPT_memrate_ops },
 	{ "memrate-rd-mbs",	1,	0,	OPT_memrate_rd_mbs },
+	{ "memrate-sweep",	0,	0,	OPT_memrate_sweep },
 	{ "memrate-wr-mbs",	1,	0,	OPT_memrate_wr_mbs },
+	{ "memscale",		1,	0,	OPT_memscale },
+	{ "memscale-bytes",	1,	0,	OPT_memscale_bytes },
+	{ "memscale-kernel",	1,	0,	OPT_memscale_kernel },
+	{ "memscale-ops",	1,	0,	OPT_memscale_ops },
 	{ "memthrash",		1,	0,	OPT_memthrash },
 	{ "memthrash-method",	1,	0,	OPT_memthrash_method },
 	{ "memthrash-ops",	1,	0,	OPT_memthrash_ops },
@@ -623,6 +655,7 @@ const struct option stress_long_options[] = {
 	{ "null-write",		0,	0,	OPT_null_write },
 	{ "numa",		1,	0,	OPT_numa },
 	{ "numa-bytes",		1,	0,	OPT_numa_bytes },
+	{ "numa-migrate",	0,	0,	OPT_numa_migrate },
 	{ "numa-ops",		1,	0,	OPT_numa_ops },
 	{ "numa-shuffle-addr",	0,	0,	OPT_numa_shuffle_addr },
 	{ "numa-shuffle-node",	0,	0,	OPT_numa_shuffle_node },
@@ -639,6 +672,7 @@ const struct option stress_long_options[] = {
 	{ "open-max",		1,	0,	OPT_open_max },
 	{ "open-ops",		1,	0,	OPT_open_ops },
 	{ "page-in",		0,	0,	OPT_page_in },
+	{ "page-size",		1,	0,	OPT_page_size },
 	{ "pagemove",		1,	0,	OPT_pagemove },
 	{ "pagemove-bytes",	1,	0,	OPT_pagemove_bytes },
 	{ "pagemove-mlock",	0,	0,	OPT_pagemove_mlock },
@@ -651,6 +685,7 @@ const struct option stress_long_options[] = {
 	{ "pci-ops",		1,	0,	OPT_pci_ops },
 #if defined(STRESS_PERF_STATS) && 	\
     defined(HAVE_LINUX_PERF_EVENT_H)
+	{ "per-cpu",		0,	0,	OPT_per_cpu },
 	{ "perf",		0,	0,	OPT_perf_stats },
 #endif
 	{ "permute",		1,	0,	OPT_permute },
@@ -693,6 +728,7 @@ const struct option stress_long_options[] = {
 	{ "prefetch-l3-size",	1,	0,	OPT_prefetch_l3_size },
 	{ "prefetch-method",	1,	0,	OPT_prefetch_method },
 	{ "prefetch-ops",	1,	0,	OPT_prefetch_ops },
+	{ "prefork",		0,	0,	OPT_prefork },
 	{ "prime",		1,	0,	OPT_prime },
 	{ "prime-method",	1,	0,	OPT_prime_method },
 	{ "prime-ops",		1,	0,	OPT_prime_ops },
@@ -955,6 +991,8 @@ const struct option stress_long_options[] = {
 	{ "stream-l3-size",	1,	0,	OPT_stream_l3_size },
 	{ "stream-madvise",	1,	0,	OPT_stream_madvise },
 	{ "stream-mlock",	0,	0,	OPT_stream_mlock },
+	{ "stream-method",	1,	0,	OPT_stream_method },
+	{ "stream-numa",	0,	0,	OPT_stream_numa },
 	{ "stream-ops",		1,	0,	OPT_stream_ops },
 	{ "swap",		1,	0,	OPT_swap },
 	{ "swap-ops",		1,	0,	OPT_swap_ops },
@@ -969,6 +1007,7 @@ const struct option stress_long_options[] = {
 	{ "sync-file",		1,	0,	OPT_sync_file },
 	{ "sync-file-bytes", 	1,	0,	OPT_sync_file_bytes },
 	{ "sync-file-ops", 	1,	0,	OPT_sync_file_ops },
+	{ "sync-start",		0,	0,	OPT_sync_start },
 	{ "syncload",		1,	0,	OPT_syncload },
 	{ "syncload-msbusy",	1,	0,	OPT_syncload_msbusy },
 	{ "syncload-mssleep",	1,	0,	OPT_syncload_mssleep },
@@ -1005,6 +1044,10 @@ const struct option stress_long_options[] = {
 	{ "timer-slack"	,	1,	0,	OPT_timer_slack },
 	{ "time-warp",		1,	0,	OPT_time_warp },
 	{ "time-warp-ops",	1,	0,	OPT_time_warp_ops },
+	{ "tlb-reach",		1,	0,	OPT_tlb_reach },
+	{ "tlb-reach-bytes",	1,	0,	OPT_tlb_reach_bytes },
+	{ "tlb-reach-ops",	1,	0,	OPT_tlb_reach_ops },
+	{ "tlb-reach-page-size",1,	0,	OPT_tlb_reach_page_size },
 	{ "tlb-shootdown",	1,	0,	OPT_tlb_shootdown },
 	{ "tlb-shootdown-ops",	1,	0,	OPT_tlb_shootdown_ops },
 	{ "tmpfs",		1,	0,	OPT_tmpfs },
@@ -1031,6 +1074,8 @@ const struct option stress_long_options[] = {
 	{ "tsearch-size",	1,	0,	OPT_tsearch_size },
 	{ "thermalstat",	1,	0,	OPT_thermalstat },
 	{ "thrash",		0,	0,	OPT_thrash },
+	{ "throttle-load",	1,	0,	OPT_throttle_load },
+	{ "throttle-ops",	1,	0,	OPT_throttle_ops },
 	{ "times",		0,	0,	OPT_times },
 	{ "timestamp",		0,	0,	OPT_timestamp },
 	{ "tz",			0,	0,	OPT_thermal_zones },
@@ -1157,6 +1202,11 @@ const struct option stress_long_options[] = {
 	{ "zero",		1,	0,	OPT_zero },
 	{ "zero-ops",		1,	0,	OPT_zero_ops },
 	{ "zero-read",		0,	0,	OPT_zero_read },
+	{ "zerocopy",		1,	0,	OPT_zerocopy },
+	{ "zerocopy-method",	1,	0,	OPT_zerocopy_method },
+	{ "zerocopy-ops",	1,	0,	OPT_zerocopy_ops },
+	{ "zerocopy-port",	1,	0,	OPT_zerocopy_port },
+	{ "zerocopy-size",	1,	0,	OPT_zerocopy_size },
 	{ "zlib",		1,	0,	OPT_zlib },
 	{ "zlib-level",		1,	0,	OPT_zlib_level },
 	{ "zlib-method",	1,	0,	OPT_zlib_method },
@@ -82,6 +82,10 @@
 #define OPT_FLAGS_PERMUTE	 STRESS_BIT_ULL(51)	/* --permute N */
 #define OPT_FLAGS_INTERRUPTS	 STRESS_BIT_ULL(52)	/* --interrupts */
 #define OPT_FLAGS_PROGRESS	 STRESS_BIT_ULL(53)	/* --progress */
+#define OPT_FLAGS_PREFORK	 STRESS_BIT_ULL(54)	/* --prefork */
+#define OPT_FLAGS_SYNC_START	 STRESS_BIT_ULL(55)	/* --sync-start */
+#define OPT_FLAGS_PER_CPU	 STRESS_BIT_ULL(56)	/* --per-cpu */
+#define OPT_FLAGS_LATENCY	 STRESS_BIT_ULL(57)	/* --latency */
 
 #define OPT_FLAGS_MINMAX_MASK		\
 	(OPT_FLAGS_MINIMIZE | OPT_FLAGS_MAXIMIZE)
@@ -268,6 +272,10 @@ typedef enum {
 	OPT_close,
 	OPT_close_ops,
 
+	OPT_compare,
+	OPT_compare_runs,
+	OPT_compare_tolerance,
+
 	OPT_context,
 	OPT_context_ops,
 
@@ -291,6 +299,8 @@ typedef enum {
 	OPT_crypt_method,
 	OPT_crypt_ops,
 
+	OPT_csv,
+
 	OPT_cyclic,
 	OPT_cyclic_ops,
 	OPT_cyclic_dist,
@@ -404,6 +414,9 @@ typedef enum {
 
 	OPT_fault,
 	OPT_fault_ops,
+	OPT_fault_latency,
+	OPT_fault_latency_bytes,
+	OPT_fault_latency_ops,
 
 	OPT_fcntl,
 	OPT_fcntl_ops,
@@ -522,10 +535,16 @@ typedef enum {
 	OPT_hash_ops,
 	OPT_hash_method,
 
+	OPT_hdd_bs,
 	OPT_hdd_bytes,
+	OPT_hdd_dist,
+	OPT_hdd_iodepth,
+	OPT_hdd_iops,
+	OPT_hdd_job,
 	OPT_hdd_write_size,
 	OPT_hdd_ops,
 	OPT_hdd_opts,
+	OPT_hdd_rwmix,
 
 	OPT_heapsort,
 	OPT_heapsort_method,
@@ -554,6 +573,9 @@ typedef enum {
 
 	OPT_interrupts,
 
+	OPT_interval,
+	OPT_interval_csv,
+
 	OPT_inode_flags,
 	OPT_inode_flags_ops,
 
@@ -576,11 +598,18 @@ typedef enum {
 
 	OPT_iostat,
 
+	OPT_io_engine,
 	OPT_io_ops,
 
 	OPT_io_uring,
+	OPT_io_uring_batch,
+	OPT_io_uring_bs,
 	OPT_io_uring_entries,
 	OPT_io_uring_ops,
+	OPT_io_uring_perf,
+	OPT_io_uring_qd,
+	OPT_io_uring_rw,
+	OPT_io_uring_sqpoll,
 
 	OPT_ipsec_mb,
 	OPT_ipsec_mb_ops,
@@ -600,6 +629,8 @@ typedef enum {
 	OPT_jpeg_width,
 	OPT_jpeg_quality,
 
+	OPT_json,
+
 	OPT_judy,
 	OPT_judy_ops,
 	OPT_judy_size,
@@ -637,6 +668,8 @@ typedef enum {
 	OPT_landlock,
 	OPT_landlock_ops,
 
+	OPT_latency,
+
 	OPT_lease,
 	OPT_lease_ops,
 	OPT_lease_breakers,
@@ -738,6 +771,7 @@ typedef enum {
 	OPT_memcpy,
 	OPT_memcpy_ops,
 	OPT_memcpy_method,
+	OPT_memcpy_sweep,
 
 	OPT_memfd,
 	OPT_memfd_bytes,
@@ -754,10 +788,18 @@ typedef enum {
 	OPT_memrate,
 	OPT_memrate_bytes,
 	OPT_memrate_flush,
+	OPT_memrate_latency,
+	OPT_memrate_method,
 	OPT_memrate_ops,
 	OPT_memrate_rd_mbs,
+	OPT_memrate_sweep,
 	OPT_memrate_wr_mbs,
 
+	OPT_memscale,
+	OPT_memscale_bytes,
+	OPT_memscale_kernel,
+	OPT_memscale_ops,
+
 	OPT_memthrash,
 	OPT_memthrash_ops,
 	OPT_memthrash_method,
@@ -915,6 +957,7 @@ typedef enum {
 
 	OPT_numa,
 	OPT_numa_bytes,
+	OPT_numa_migrate,
 	OPT_numa_ops,
 	OPT_numa_shuffle_addr,
 	OPT_numa_shuffle_node,
@@ -935,6 +978,7 @@ typedef enum {
 	OPT_open_max,
 
 	OPT_page_in,
+	OPT_page_size,
 	OPT_pathological,
 
 	OPT_pagemove,
@@ -948,6 +992,7 @@ typedef enum {
 	OPT_pci,
 	OPT_pci_ops,
 
+	OPT_per_cpu,
 	OPT_perf_stats,
 
 	OPT_permute,
@@ -997,6 +1042,8 @@ typedef enum {
 	OPT_prefetch_method,
 	OPT_prefetch_ops,
 
+	OPT_prefork,
+
 	OPT_prctl,
 	OPT_prctl_ops,
 
@@ -1357,6 +1404,8 @@ typedef enum {
 	OPT_stream_l3_size,
 	OPT_stream_madvise,
 	OPT_stream_mlock,
+	OPT_stream_method,
+	OPT_stream_numa,
 	OPT_stream_ops,
 
 	OPT_stressors,
@@ -1369,6 +1418,8 @@ typedef enum {
 	OPT_sync_file_ops,
 	OPT_sync_file_bytes,
 
+	OPT_sync_start,
+
 	OPT_syncload,
 	OPT_syncload_ops,
 	OPT_syncload_msbusy,
@@ -1405,6 +1456,9 @@ typedef enum {
 
 	OPT_thrash,
 
+	OPT_throttle_load,
+	OPT_throttle_ops,
+
 	OPT_timer_slack,
 
 	OPT_timer_ops,
@@ -1424,6 +1478,10 @@ typedef enum {
 	OPT_time_warp,
 	OPT_time_warp_ops,
 
+	OPT_tlb_reach,
+	OPT_tlb_reach_bytes,
+	OPT_tlb_reach_ops,
+	OPT_tlb_reach_page_size,
 	OPT_tlb_shootdown,
 	OPT_tlb_shootdown_ops,
 
@@ -1607,6 +1665,12 @@ typedef enum {
 	OPT_zero_read,
 	OPT_zero_ops,
 
+	OPT_zerocopy,
+	OPT_zerocopy_method,
+	OPT_zerocopy_ops,
+	OPT_zerocopy_port,
+	OPT_zerocopy_size,
+
 	OPT_zlib,
 	OPT_zlib_ops,
 	OPT_zlib_level,
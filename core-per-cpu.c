@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-numa.h"
+#include "core-per-cpu.h"
+
+#define STRESS_PER_CPU_NODE_UNKNOWN	(-2)	/* node not looked up yet */
+
+/*
+ *  stress_per_cpu_add()
+ *	account inc bogo-ops to the CPU the caller is running on,
+ *	sched_getcpu() is a vDSO call (or a read of the rseq cpu_id
+ *	with newer C libraries) so this is cheap enough to be done
+ *	on every bogo-op
+ */
+void OPTIMIZE3 stress_per_cpu_add(stress_per_cpu_t *per_cpu, const uint64_t inc)
+{
+	const unsigned int cpu = stress_get_cpu();
+
+	if (LIKELY(cpu < STRESS_PER_CPU_MAX))
+		per_cpu->ops[cpu] += inc;
+}
+
+/*
+ *  stress_per_cpu_node()
+ *	return cached NUMA node of a CPU, -1 if not known
+ */
+static int stress_per_cpu_node(const size_t cpu)
+{
+	static int nodes[STRESS_PER_CPU_MAX];
+	static bool init = false;
+
+	if (!init) {
+		size_t i;
+
+		for (i = 0; i < STRESS_PER_CPU_MAX; i++)
+			nodes[i] = STRESS_PER_CPU_NODE_UNKNOWN;
+		init = true;
+	}
+	if (nodes[cpu] == STRESS_PER_CPU_NODE_UNKNOWN)
+		nodes[cpu] = stress_numa_cpu_node((unsigned int)cpu);
+	return nodes[cpu];
+}
+
+/*
+ *  stress_per_cpu_stressor()
+ *	sum per CPU bogo-ops of all the instances of a stressor and
+ *	return the average run time of the instances in *duration,
+ *	the per CPU bogo-ops are reset at the start of each run
+ */
+static uint64_t stress_per_cpu_stressor(
+	const stress_stressor_t *ss,
+	stress_per_cpu_t *per_cpu,
+	double *duration)
+{
+	int32_t j;
+	uint64_t total = 0;
+	double duration_total = 0.0;
+
+	(void)shim_memset(per_cpu, 0, sizeof(*per_cpu));
+	*duration = 0.0;
+	if (ss->ignore.run || ss->ignore.permute || !ss->stats)
+		return 0;
+
+	for (j = 0; j < ss->num_instances; j++) {
+		const stress_stats_t *stats = ss->stats[j];
+		size_t cpu;
+
+		if (!stats->per_cpu)
+			continue;
+		for (cpu = 0; cpu < STRESS_PER_CPU_MAX; cpu++) {
+			per_cpu->ops[cpu] += stats->per_cpu->ops[cpu];
+			total += stats->per_cpu->ops[cpu];
+		}
+		duration_total += stats->duration;
+	}
+	if (ss->num_instances > 0)
+		*duration = duration_total / (double)ss->num_instances;
+	return total;
+}
+
+/*
+ *  stress_per_cpu_dump()
+ *	dump the bogo-ops and bogo-ops per second of each stressor
+ *	broken down by the CPUs and NUMA nodes that the work ran on
+ */
+void stress_per_cpu_dump(FILE *yaml, stress_stressor_t *stressors_list)
+{
+	static stress_per_cpu_t per_cpu;
+	static uint64_t node_ops[STRESS_PER_CPU_MAX + 1];
+	static uint32_t node_cpus[STRESS_PER_CPU_MAX + 1];
+	stress_stressor_t *ss;
+	bool pr_heading = false;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		double duration, scale;
+		char munged[64];
+		size_t cpu, node;
+
+		if (!stress_per_cpu_stressor(ss, &per_cpu, &duration))
+			continue;
+		scale = (duration > 0.0) ? 1.0 / duration : 0.0;
+
+		if (!pr_heading) {
+			pr_metrics("per-cpu metrics:\n");
+			pr_metrics("%-13s %5s %5s %12s %12s\n",
+				"stressor", "cpu", "node", "bogo ops", "bogo ops/s");
+			pr_yaml(yaml, "per-cpu-metrics:\n");
+			pr_heading = true;
+		}
+		(void)stress_munge_underscore(munged, ss->stressor->name, sizeof(munged));
+		pr_yaml(yaml, "    - stressor: %s\n", munged);
+		pr_yaml(yaml, "      cpus:\n");
+
+		(void)shim_memset(node_ops, 0, sizeof(node_ops));
+		(void)shim_memset(node_cpus, 0, sizeof(node_cpus));
+		for (cpu = 0; cpu < STRESS_PER_CPU_MAX; cpu++) {
+			const uint64_t ops = per_cpu.ops[cpu];
+			const int n = stress_per_cpu_node(cpu);
+			char node_str[16];
+
+			if (!ops)
+				continue;
+
+			/* unknown nodes are accounted to the last slot */
+			node = (n < 0) ? STRESS_PER_CPU_MAX : (size_t)n;
+			node_ops[node] += ops;
+			node_cpus[node]++;
+
+			if (n < 0)
+				(void)shim_strscpy(node_str, "n/a", sizeof(node_str));
+			else
+				(void)snprintf(node_str, sizeof(node_str), "%d", n);
+			pr_metrics("%-13s %5zu %5s %12" PRIu64 " %12.2f\n",
+				munged, cpu, node_str, ops, (double)ops * scale);
+			pr_yaml(yaml, "        - { cpu: %zu, node: %d, bogo-ops: %" PRIu64
+				", bogo-ops-per-second: %f }\n",
+				cpu, n, ops, (double)ops * scale);
+		}
+
+		pr_yaml(yaml, "      nodes:\n");
+		for (node = 0; node < STRESS_PER_CPU_MAX; node++) {
+			if (!node_ops[node])
+				continue;
+			pr_metrics("%-13s %5s %5zu %12" PRIu64 " %12.2f (%" PRIu32 " CPU%s)\n",
+				munged, "all", node, node_ops[node],
+				(double)node_ops[node] * scale,
+				node_cpus[node], node_cpus[node] == 1 ? "" : "s");
+			pr_yaml(yaml, "        - { node: %zu, cpus: %" PRIu32 ", bogo-ops: %" PRIu64
+				", bogo-ops-per-second: %f }\n",
+				node, node_cpus[node], node_ops[node],
+				(double)node_ops[node] * scale);
+		}
+		pr_yaml(yaml, "\n");
+	}
+}
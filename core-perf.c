@@ -22,6 +22,7 @@
 #include "core-lock.h"
 #include "core-perf.h"
 #include "core-perf-event.h"
+#include "core-stream.h"
 
 #if defined(HAVE_LINUX_PERF_EVENT_H)
 #include <linux/perf_event.h>
@@ -631,6 +632,66 @@ out_ok:
 	return 0;
 }
 
+/*
+ *  stress_perf_dtlb_open()
+ *	open an enabled user space dTLB read miss counter for
+ *	the calling process, returns the perf fd or -1 on failure
+ */
+int stress_perf_dtlb_open(void)
+{
+#if STRESS_PERF_DEFINED(HW_CACHE_DTLB)
+	struct perf_event_attr attr;
+
+	(void)shim_memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_INFO_HW_CACHE_CONFIG(DTLB, READ, MISS);
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.size = sizeof(attr);
+	return stress_sys_perf_event_open(&attr, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+}
+
+/*
+ *  stress_perf_cycles_open()
+ *	open an enabled CPU cycle counter for the calling process
+ *	that includes cycles spent in the kernel on its behalf,
+ *	returns the perf fd or -1 on failure
+ */
+int stress_perf_cycles_open(void)
+{
+#if STRESS_PERF_DEFINED(HW_CPU_CYCLES)
+	struct perf_event_attr attr;
+
+	(void)shim_memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.exclude_hv = 1;
+	attr.size = sizeof(attr);
+	return stress_sys_perf_event_open(&attr, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+}
+
+/*
+ *  stress_perf_counter_read()
+ *	read a counter opened without a read format,
+ *	returns STRESS_PERF_INVALID on failure
+ */
+uint64_t stress_perf_counter_read(const int fd)
+{
+	uint64_t counter;
+
+	if (fd < 0)
+		return STRESS_PERF_INVALID;
+	if (read(fd, &counter, sizeof(counter)) != (ssize_t)sizeof(counter))
+		return STRESS_PERF_INVALID;
+	return counter;
+}
+
 /*
  *  stress_perf_stat_succeeded()
  *	did perf event open work OK?
@@ -737,6 +798,9 @@ void stress_perf_stat_dump(FILE *yaml, stress_stressor_t *stressors_list, const
 	pr_yaml(yaml, "perfstats:\n");
 
 	for (ss = stressors_list; ss; ss = ss->next) {
+		static stress_stream_item_t items[STRESS_PERF_MAX * 2];
+		static char item_names[STRESS_PERF_MAX * 2][144];
+		size_t n_items = 0;
 		int p;
 		uint64_t counter_totals[STRESS_PERF_MAX];
 		bool got_data = false;
@@ -815,9 +879,19 @@ void stress_perf_stat_dump(FILE *yaml, stress_stressor_t *stressors_list, const
 					"\n", yaml_label, ct);
 				pr_yaml(yaml, "      %s_per_second: %f\n",
 					yaml_label, (double)ct / duration);
+
+				if (n_items + 2 <= SIZEOF_ARRAY(items)) {
+					(void)snprintf(item_names[n_items], sizeof(item_names[0]), "%s_total", yaml_label);
+					items[n_items].name = item_names[n_items];
+					items[n_items++].value = (double)ct;
+					(void)snprintf(item_names[n_items], sizeof(item_names[0]), "%s_per_second", yaml_label);
+					items[n_items].name = item_names[n_items];
+					items[n_items++].value = (double)ct / duration;
+				}
 			}
 		}
 		pr_yaml(yaml, "\n");
+		stress_stream_event("perf", munged, -1, items, n_items);
 	}
 	if (no_perf_stats) {
 		if (geteuid() != 0) {
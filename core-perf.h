@@ -47,6 +47,9 @@ extern int stress_perf_open(stress_perf_t *sp);
 extern int stress_perf_enable(stress_perf_t *sp);
 extern int stress_perf_disable(stress_perf_t *sp);
 extern int stress_perf_close(stress_perf_t *sp);
+extern int stress_perf_dtlb_open(void);
+extern int stress_perf_cycles_open(void);
+extern uint64_t stress_perf_counter_read(const int fd);
 extern void stress_perf_stat_dump(FILE *yaml, stress_stressor_t *procs_head,
 	const double duration);
 extern void stress_perf_init(void);
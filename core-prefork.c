@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-asm-generic.h"
+#include "core-prefork.h"
+
+#include <float.h>
+
+#define STRESS_PREFORK_READY_TIMEOUT	(60.0)		/* max secs to wait for instances */
+#define STRESS_PREFORK_POLL_NS		(100000000ULL)	/* 0.1 sec futex wait timeout */
+#define STRESS_SYNC_START_POLL_NS	(10000000ULL)	/* 0.01 sec window end poll */
+#define STRESS_SYNC_START_GUARD		(0.01)		/* secs before the deadline */
+
+/*
+ *  With --prefork all the stressor instances are forked and run their
+ *  per-process setup (scheduling, signal handlers, limits, perf counters)
+ *  and then park on a shared futex. Once every instance is parked the
+ *  parent releases them with a single futex wake so that they all start
+ *  stressing within a few microseconds of each other rather than being
+ *  spread out by the serial fork and setup costs and the backoff delay.
+ */
+
+/*
+ *  stress_prefork_released()
+ *	return true if the pre-forked instances have been released
+ */
+static inline bool stress_prefork_released(void)
+{
+	return *(volatile uint32_t *)&g_shared->prefork.release != 0;
+}
+
+/*
+ *  stress_prefork_reset()
+ *	reset release futex, must be called before
+ *	forking a new set of stressor instances
+ */
+void stress_prefork_reset(void)
+{
+	g_shared->prefork.release = 0;
+	g_shared->prefork.time_released = 0.0;
+}
+
+/*
+ *  stress_prefork_ready()
+ *	flag that a stressor instance has completed its
+ *	setup (or has given up) and is ready to be released
+ */
+void stress_prefork_ready(stress_stats_t *stats)
+{
+	*(volatile bool *)&stats->prefork_ready = true;
+	stress_asm_mb();
+}
+
+/*
+ *  stress_prefork_wait()
+ *	flag instance as ready and wait until the
+ *	parent releases all the pre-forked instances
+ */
+void stress_prefork_wait(stress_stats_t *stats)
+{
+	stress_prefork_ready(stats);
+
+	while (!stress_prefork_released() && stress_continue_flag()) {
+		struct timespec ts;
+
+		ts.tv_sec = 0;
+		ts.tv_nsec = STRESS_PREFORK_POLL_NS;
+		if ((shim_futex_wait(&g_shared->prefork.release, 0, &ts) < 0) &&
+		    (errno == ENOSYS))
+			(void)shim_usleep(1000);
+	}
+}
+
+/*
+ *  stress_prefork_all_ready()
+ *	return true if all the forked instances are ready
+ */
+static bool stress_prefork_all_ready(stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		int32_t j;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		for (j = 0; j < ss->num_instances; j++) {
+			const stress_stats_t *stats = ss->stats[j];
+
+			if ((stats->pid > 0) &&
+			    !*(const volatile bool *)&stats->prefork_ready)
+				return false;
+		}
+	}
+	return true;
+}
+
+/*
+ *  stress_prefork_release()
+ *	wait for all the forked instances to be ready and
+ *	release them with a single futex wake
+ */
+void stress_prefork_release(stress_stressor_t *stressors_list)
+{
+	const double t_start = stress_time_now();
+
+	while (stress_continue_flag() &&
+	       !stress_prefork_all_ready(stressors_list)) {
+		if (stress_time_now() - t_start > STRESS_PREFORK_READY_TIMEOUT) {
+			pr_inf("prefork: not all stressor instances ready after %.0f seconds, releasing them\n",
+				STRESS_PREFORK_READY_TIMEOUT);
+			break;
+		}
+		(void)shim_usleep(100);
+	}
+	g_shared->prefork.time_released = stress_time_now();
+	pr_dbg("prefork: stressors released after %.3f seconds\n",
+		g_shared->prefork.time_released - t_start);
+	*(volatile uint32_t *)&g_shared->prefork.release = 1;
+	stress_asm_mb();
+	(void)shim_futex_wake(&g_shared->prefork.release, INT_MAX);
+}
+
+/*
+ *  With --sync-start the instances park on the release barrier when
+ *  the stressor has completed its own setup and sets its state to
+ *  STRESS_STATE_RUN rather than before the stressor is called, so
+ *  the per-stressor setup costs are excluded from the common window
+ */
+static stress_stats_t *sync_start_stats;
+
+/*
+ *  stress_sync_start_init()
+ *	arm the --sync-start barrier for the instance that is
+ *	about to be run
+ */
+void stress_sync_start_init(stress_stats_t *stats)
+{
+	sync_start_stats = stats;
+}
+
+/*
+ *  stress_sync_start_wait()
+ *	wait at the --sync-start barrier the first time the stressor
+ *	sets its state to STRESS_STATE_RUN, once released the run time
+ *	and the alarm of the instance start from the release time
+ */
+void stress_sync_start_wait(void)
+{
+	stress_stats_t *stats = sync_start_stats;
+
+	if (!stats)
+		return;
+	sync_start_stats = NULL;
+
+	stress_prefork_wait(stats);
+	if (!stress_prefork_released())
+		return;
+	stats->args.time_end = g_shared->prefork.time_released + (double)g_opt_timeout;
+	if (g_opt_timeout && (getpid() == stats->pid))
+		(void)alarm((unsigned int)g_opt_timeout);
+}
+
+/*
+ *  stress_sync_start_any_completed()
+ *	return true if any of the instances have completed
+ */
+static bool stress_sync_start_any_completed(stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		int32_t j;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		for (j = 0; j < ss->num_instances; j++) {
+			const stress_stats_t *stats = ss->stats[j];
+
+			if ((stats->pid > 0) &&
+			    *(const volatile bool *)&stats->completed)
+				return true;
+		}
+	}
+	return false;
+}
+
+/*
+ *  stress_sync_start_window()
+ *	with --sync-start all the instances are released together
+ *	so the common window starts at the release time with zero
+ *	bogo-ops. The window ends just before the common deadline
+ *	or as soon as the first instance completes, whichever is
+ *	first, and the bogo-op counters of all the instances are
+ *	snapshotted at that point, excluding setup and teardown.
+ */
+void stress_sync_start_window(stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+	double t_end, t_now;
+
+	if (g_shared->prefork.time_released <= 0.0)
+		return;
+	t_end = g_opt_timeout ?
+		g_shared->prefork.time_released + (double)g_opt_timeout - STRESS_SYNC_START_GUARD :
+		DBL_MAX;
+
+	for (;;) {
+		t_now = stress_time_now();
+		if ((t_now >= t_end) ||
+		    !stress_continue_flag() ||
+		    stress_sync_start_any_completed(stressors_list))
+			break;
+		if (t_end - t_now < (double)STRESS_SYNC_START_POLL_NS / STRESS_DBL_NANOSECOND)
+			(void)shim_nanosleep_uint64((uint64_t)((t_end - t_now) * STRESS_DBL_NANOSECOND));
+		else
+			(void)shim_nanosleep_uint64(STRESS_SYNC_START_POLL_NS);
+	}
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		int32_t j;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		for (j = 0; j < ss->num_instances; j++) {
+			stress_stats_t *stats = ss->stats[j];
+
+			stats->sync_ops = stats->args.ci.counter;
+			stats->sync_duration = t_now - g_shared->prefork.time_released;
+		}
+	}
+}
+
+/*
+ *  stress_sync_start_dump()
+ *	dump bogo-op throughput over the common window
+ */
+void stress_sync_start_dump(FILE *yaml, stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+	bool pr_heading = false;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		uint64_t ops = 0;
+		double window = 0.0, rate;
+		int32_t j;
+		char munged[64];
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		if (!ss->stats)
+			continue;
+		for (j = 0; j < ss->num_instances; j++) {
+			ops += ss->stats[j]->sync_ops;
+			if (window < ss->stats[j]->sync_duration)
+				window = ss->stats[j]->sync_duration;
+		}
+		if (window <= 0.0)
+			continue;
+		rate = (double)ops / window;
+
+		(void)stress_munge_underscore(munged, ss->stressor->name, sizeof(munged));
+		if (!pr_heading) {
+			pr_inf("sync-start: %-13s %9s %9s %12s %12s\n",
+				"stressor", "instances", "window", "bogo ops", "bogo ops/s");
+			pr_yaml(yaml, "sync-start-metrics:\n");
+			pr_heading = true;
+		}
+		pr_inf("sync-start: %-13s %9" PRId32 " %9.3f %12" PRIu64 " %12.2f\n",
+			munged, ss->num_instances, window, ops, rate);
+		pr_yaml(yaml, "    - stressor: %s\n", munged);
+		pr_yaml(yaml, "      instances: %" PRId32 "\n", ss->num_instances);
+		pr_yaml(yaml, "      window: %f\n", window);
+		pr_yaml(yaml, "      bogo-ops: %" PRIu64 "\n", ops);
+		pr_yaml(yaml, "      bogo-ops-per-second: %f\n", rate);
+		pr_yaml(yaml, "\n");
+	}
+}
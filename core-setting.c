@@ -18,13 +18,19 @@
  *
  */
 #include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-hash.h"
 #include "core-setting.h"
 
+#define STRESS_SETTING_HASH_SIZE	(1021)	/* prime sized hash table */
+
 /* settings for storing opt arg parsed data */
 typedef struct stress_setting {
 	struct stress_setting *next;	/* next setting in list */
+	struct stress_setting *hash_next; /* next (older) setting in hash bucket */
 	struct stress_stressor_info *proc;
 	char *name;			/* name of setting */
+	size_t index;			/* position in the setting list */
 	stress_type_id_t type_id;	/* setting type */
 	bool		global;		/* true if global */
 	union {				/* setting value */
@@ -50,6 +56,20 @@ typedef struct stress_setting {
 
 static stress_setting_t *setting_head;	/* setting list head */
 static stress_setting_t *setting_tail;	/* setting list tail */
+static size_t setting_count;		/* number of settings in list */
+
+/*
+ *  Settings are also hashed by name, each hash bucket is ordered
+ *  newest setting first so the first name match in a bucket is the
+ *  most recent setting. The setting list index at which the lookups
+ *  for a stressor stop is cached per stressor, so lookups are O(1)
+ *  rather than a walk of the entire list with a strcmp per setting.
+ */
+static stress_setting_t *setting_hash[STRESS_SETTING_HASH_SIZE];
+static const struct stress_stressor_info *setting_limit_proc;
+static size_t setting_limit_count;	/* setting_count when limit cached */
+static size_t setting_limit;		/* list index lookups stop at */
+static bool setting_limit_valid;
 
 /*
  *  stress_settings_free()
@@ -70,6 +90,9 @@ void stress_settings_free(void)
 	}
 	setting_head = NULL;
 	setting_tail = NULL;
+	setting_count = 0;
+	setting_limit_valid = false;
+	(void)shim_memset(setting_hash, 0, sizeof(setting_hash));
 }
 
 static void stress_settings_show_setting(const stress_setting_t *setting)
@@ -176,6 +199,7 @@ static int stress_set_setting_generic(
 	const bool global)
 {
 	stress_setting_t *setting;
+	uint32_t hash;
 
 	if (!value) {
 		(void)fprintf(stderr, "invalid setting '%s' value address (null)\n", name);
@@ -265,6 +289,11 @@ static int stress_set_setting_generic(
 		setting_head = setting;
 	}
 	setting_tail = setting;
+	setting->index = setting_count++;
+
+	hash = stress_hash_fnv1a(name) % STRESS_SETTING_HASH_SIZE;
+	setting->hash_next = setting_hash[hash];
+	setting_hash[hash] = setting;
 
 	return 0;
 err:
@@ -299,102 +328,116 @@ int stress_set_setting_global(
 
 
 /*
- *  stress_get_setting()
- *	get an existing setting
+ *  stress_get_setting_limit()
+ *	settings of the current stressor are looked up in the setting
+ *	list up to (but not including) the first non-global setting of
+ *	another stressor that follows the current stressor's settings,
+ *	find and cache this list index for the current stressor
  */
-bool stress_get_setting(const char *name, void *value)
+static size_t stress_get_setting_limit(void)
 {
-	stress_setting_t *setting;
-	bool set = false;
+	const stress_setting_t *setting;
 	bool found = false;
 
+	if (setting_limit_valid &&
+	    (setting_limit_proc == g_stressor_current) &&
+	    (setting_limit_count == setting_count))
+		return setting_limit;
+
+	setting_limit = setting_count;
 	for (setting = setting_head; setting; setting = setting->next) {
 		if (setting->proc == g_stressor_current)
 			found = true;
-		if (found && ((setting->proc != g_stressor_current) && (!setting->global)))
+		if (found && ((setting->proc != g_stressor_current) && (!setting->global))) {
+			setting_limit = setting->index;
 			break;
+		}
+	}
+	setting_limit_proc = g_stressor_current;
+	setting_limit_count = setting_count;
+	setting_limit_valid = true;
+
+	return setting_limit;
+}
 
-		if (!strcmp(setting->name, name)) {
-			switch (setting->type_id) {
-			case TYPE_ID_UINT8:
-				set = true;
-				*(uint8_t *)value = setting->u.uint8;
-				break;
-			case TYPE_ID_INT8:
-				set = true;
-				*(int8_t *)value = setting->u.int8;
-				break;
-			case TYPE_ID_UINT16:
-				set = true;
-				*(uint16_t *)value = setting->u.uint16;
-				break;
-			case TYPE_ID_INT16:
-				set = true;
-				*(int16_t *)value = setting->u.int16;
-				break;
-			case TYPE_ID_UINT32:
-				set = true;
-				*(uint32_t *)value = setting->u.uint32;
-				break;
-			case TYPE_ID_INT32:
-				set = true;
-				*(int32_t *)value = setting->u.int32;
-				break;
-			case TYPE_ID_UINT64:
-				set = true;
-				*(uint64_t *)value = setting->u.uint64;
-				break;
-			case TYPE_ID_INT64:
-				set = true;
-				*(int64_t *)value = setting->u.int64;
-				break;
-			case TYPE_ID_SIZE_T:
-				set = true;
-				*(size_t *)value = setting->u.size;
-				break;
-			case TYPE_ID_SSIZE_T:
-				set = true;
-				*(ssize_t *)value = setting->u.ssize;
-				break;
-			case TYPE_ID_UINT:
-				set = true;
-				*(unsigned int *)value = setting->u.uint;
-				break;
-			case TYPE_ID_INT:
-				set = true;
-				*(int *)value = setting->u.sint;
-				break;
-			case TYPE_ID_ULONG:
-				set = true;
-				*(unsigned long  *)value = setting->u.ulong;
-				break;
-			case TYPE_ID_LONG:
-				set = true;
-				*(long *)value = setting->u.slong;
-				break;
-			case TYPE_ID_OFF_T:
-				set = true;
-				*(long  *)value = setting->u.off;
-				break;
-			case TYPE_ID_STR:
-				set = true;
-				*(const char **)value = setting->u.str;
-				break;
-			case TYPE_ID_BOOL:
-				set = true;
-				*(bool *)value = setting->u.boolean;
-				break;
-			case TYPE_ID_UNDEFINED:
-			default:
-				set = true;
-				break;
-			}
+/*
+ *  stress_get_setting()
+ *	get an existing setting, if a setting is set more than
+ *	once the most recent setting is used
+ */
+bool stress_get_setting(const char *name, void *value)
+{
+	const stress_setting_t *setting;
+	const uint32_t hash = stress_hash_fnv1a(name) % STRESS_SETTING_HASH_SIZE;
+	const size_t limit = stress_get_setting_limit();
+
+	for (setting = setting_hash[hash]; setting; setting = setting->hash_next) {
+		if ((setting->index < limit) && !strcmp(setting->name, name))
+			break;
+	}
+	if (!setting)
+		return false;
+
+	switch (setting->type_id) {
+	case TYPE_ID_UINT8:
+		*(uint8_t *)value = setting->u.uint8;
+		break;
+	case TYPE_ID_INT8:
+		*(int8_t *)value = setting->u.int8;
+		break;
+	case TYPE_ID_UINT16:
+		*(uint16_t *)value = setting->u.uint16;
+		break;
+	case TYPE_ID_INT16:
+		*(int16_t *)value = setting->u.int16;
+		break;
+	case TYPE_ID_UINT32:
+		*(uint32_t *)value = setting->u.uint32;
+		break;
+	case TYPE_ID_INT32:
+		*(int32_t *)value = setting->u.int32;
+		break;
+	case TYPE_ID_UINT64:
+		*(uint64_t *)value = setting->u.uint64;
+		break;
+	case TYPE_ID_INT64:
+		*(int64_t *)value = setting->u.int64;
+		break;
+	case TYPE_ID_SIZE_T:
+		*(size_t *)value = setting->u.size;
+		break;
+	case TYPE_ID_SSIZE_T:
+		*(ssize_t *)value = setting->u.ssize;
+		break;
+	case TYPE_ID_UINT:
+		*(unsigned int *)value = setting->u.uint;
+		break;
+	case TYPE_ID_INT:
+		*(int *)value = setting->u.sint;
+		break;
+	case TYPE_ID_ULONG:
+		*(unsigned long  *)value = setting->u.ulong;
+		break;
+	case TYPE_ID_LONG:
+		*(long *)value = setting->u.slong;
+		break;
+	case TYPE_ID_OFF_T:
+		*(long  *)value = setting->u.off;
+		break;
+	case TYPE_ID_STR:
+		*(const char **)value = setting->u.str;
+		break;
+	case TYPE_ID_BOOL:
+		*(bool *)value = setting->u.boolean;
+		break;
+	case TYPE_ID_UNDEFINED:
+	default:
+		break;
+	}
 #if defined(DEBUG_SETTINGS)
-			stress_settings_show_setting(setting);
+	stress_settings_show_setting(setting);
 #endif
-		}
-	}
-	return set;
+	return true;
 }
 
 /*
@@ -2808,3 +2808,24 @@ int shim_mseal(void *addr, size_t len, unsigned long flags)
 	return shim_enosys(0, addr, len, flags);
 #endif
 }
+
+/*
+ *  shim_cachestat()
+ *	shim wrapper for the Linux 6.5 cachestat system call
+ */
+int shim_cachestat(
+	int fd,
+	struct shim_cachestat_range *cstat_range,
+	struct shim_cachestat *cstat,
+	unsigned int flags)
+{
+#if defined(__NR_cachestat) &&	\
+    defined(HAVE_SYSCALL)
+	return (int)syscall(__NR_cachestat, (unsigned long)fd,
+		(unsigned long)cstat_range,
+		(unsigned long)cstat,
+		(unsigned long)flags);
+#else
+	return shim_enosys(0, fd, cstat_range, cstat, flags);
+#endif
+}
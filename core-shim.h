@@ -276,6 +276,20 @@ struct shim_ustat {
 	char	f_fpack[6];
 };
 
+/* cachestat shims */
+struct shim_cachestat_range {
+	uint64_t off;
+	uint64_t len;
+};
+
+struct shim_cachestat {
+	uint64_t nr_cache;
+	uint64_t nr_dirty;
+	uint64_t nr_writeback;
+	uint64_t nr_evicted;
+	uint64_t nr_recently_evicted;
+};
+
 /* waitid/pidfd shims */
 #if !defined(P_PIDFD)
 #define P_PIDFD		(3)
@@ -470,5 +484,7 @@ extern int shim_lstat(const char *pathname, struct stat *statbuf);
 extern int shim_stat(const char *pathname, struct stat *statbuf);
 extern unsigned char shim_dirent_type(const char *path, const struct dirent *d);
 extern int shim_mseal(void *addr, size_t len, unsigned long flags);
+extern int shim_cachestat(int fd, struct shim_cachestat_range *cstat_range,
+	struct shim_cachestat *cstat, unsigned int flags);
 
 #endif
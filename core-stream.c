@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-stream.h"
+
+/*
+ *  Events are streamed as they occur, one JSON object per line
+ *  (JSON Lines) and/or one CSV row per event value. Each record is
+ *  written with a single write() to a file opened with O_APPEND so
+ *  that records from the periodic stats process and the main process
+ *  do not interleave and partial runs still produce usable data.
+ */
+#define STRESS_STREAM_BUF_SIZE	(16384)
+
+static int stream_json_fd = -1;
+static int stream_csv_fd = -1;
+
+/*
+ *  stress_stream_open_file()
+ *	open a stream file for appending
+ */
+static int stress_stream_open_file(const char *filename)
+{
+	int fd;
+
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0)
+		pr_err("cannot open stream output file %s, errno=%d (%s)\n",
+			filename, errno, strerror(errno));
+	return fd;
+}
+
+/*
+ *  stress_stream_write()
+ *	write a buffer in one go, retry on EINTR
+ */
+static void stress_stream_write(const int fd, const char *buf, const size_t len)
+{
+	ssize_t ret;
+
+	do {
+		ret = write(fd, buf, len);
+	} while ((ret < 0) && (errno == EINTR));
+}
+
+/*
+ *  stress_stream_open()
+ *	open the --json and --csv stream output files
+ */
+void stress_stream_open(void)
+{
+	char *filename;
+
+	filename = NULL;
+	if (stress_get_setting("json", &filename) && filename)
+		stream_json_fd = stress_stream_open_file(filename);
+
+	filename = NULL;
+	if (stress_get_setting("csv", &filename) && filename) {
+		static const char header[] =
+			"time,run-time,event,stressor,instance,name,value\n";
+
+		stream_csv_fd = stress_stream_open_file(filename);
+		if (stream_csv_fd >= 0)
+			stress_stream_write(stream_csv_fd, header, sizeof(header) - 1);
+	}
+}
+
+/*
+ *  stress_stream_close()
+ *	close the stream output files
+ */
+void stress_stream_close(void)
+{
+	if (stream_json_fd >= 0) {
+		(void)close(stream_json_fd);
+		stream_json_fd = -1;
+	}
+	if (stream_csv_fd >= 0) {
+		(void)close(stream_csv_fd);
+		stream_csv_fd = -1;
+	}
+}
+
+/*
+ *  stress_stream_enabled()
+ *	return true if events are being streamed
+ */
+bool stress_stream_enabled(void)
+{
+	return (stream_json_fd >= 0) || (stream_csv_fd >= 0);
+}
+
+/*
+ *  stress_stream_str()
+ *	append string str to buf, quoted for JSON (csv = false)
+ *	or CSV (csv = true), returns new length or len if full
+ */
+static size_t stress_stream_str(
+	char *buf,
+	size_t len,
+	const size_t size,
+	const char *str,
+	const bool csv)
+{
+	const char *ptr;
+	const size_t start = len;
+
+	if (len + 2 >= size)
+		return start;
+	buf[len++] = '"';
+	for (ptr = str; *ptr; ptr++) {
+		const unsigned char ch = (unsigned char)*ptr;
+
+		if (len + 8 >= size)
+			return start;
+		if (csv) {
+			if (ch == '"')
+				buf[len++] = '"';
+			buf[len++] = (char)ch;
+		} else if ((ch == '"') || (ch == '\\')) {
+			buf[len++] = '\\';
+			buf[len++] = (char)ch;
+		} else if (ch < 0x20) {
+			len += (size_t)snprintf(buf + len, size - len, "\\u%4.4x", ch);
+		} else {
+			buf[len++] = (char)ch;
+		}
+	}
+	buf[len++] = '"';
+	buf[len] = '\0';
+	return len;
+}
+
+/*
+ *  stress_stream_value()
+ *	append a value to buf, non-finite values are null (JSON)
+ *	or empty (CSV)
+ */
+static size_t stress_stream_value(
+	char *buf,
+	size_t len,
+	const size_t size,
+	const double value,
+	const bool csv)
+{
+	int n;
+
+	if (isfinite(value))
+		n = snprintf(buf + len, size - len, "%.15g", value);
+	else
+		n = snprintf(buf + len, size - len, "%s", csv ? "" : "null");
+	if ((n < 0) || (len + (size_t)n >= size))
+		return len;
+	return len + (size_t)n;
+}
+
+static size_t stress_stream_printf(char *buf, const size_t len,
+	const size_t size, const char *fmt, ...) FORMAT(printf, 4, 5);
+
+/*
+ *  stress_stream_printf()
+ *	append formatted text to buf, returns new length or len
+ *	if the text does not fit
+ */
+static size_t stress_stream_printf(
+	char *buf,
+	const size_t len,
+	const size_t size,
+	const char *fmt, ...)
+{
+	va_list ap;
+	int n;
+
+	if (len >= size)
+		return len;
+	va_start(ap, fmt);
+	n = vsnprintf(buf + len, size - len, fmt, ap);
+	va_end(ap);
+	if ((n < 0) || (len + (size_t)n >= size)) {
+		buf[len] = '\0';
+		return len;
+	}
+	return len + (size_t)n;
+}
+
+/*
+ *  stress_stream_json()
+ *	write an event as a JSON object on a single line
+ */
+static void stress_stream_json(
+	const double now,
+	const double run_time,
+	const char *event,
+	const char *stressor,
+	const int32_t instance,
+	const stress_stream_item_t *items,
+	const size_t n_items)
+{
+	static char buf[STRESS_STREAM_BUF_SIZE];
+	/* reserve space for the trailing "}}\n" */
+	const size_t size = sizeof(buf) - 3;
+	size_t i, len;
+
+	len = stress_stream_printf(buf, 0, size, "{\"time\":%.6f,\"run-time\":%.6f,\"event\":",
+		now, run_time);
+	len = stress_stream_str(buf, len, size, event, false);
+	len = stress_stream_printf(buf, len, size, ",\"stressor\":");
+	if (stressor)
+		len = stress_stream_str(buf, len, size, stressor, false);
+	else
+		len = stress_stream_printf(buf, len, size, "null");
+	if (instance >= 0)
+		len = stress_stream_printf(buf, len, size, ",\"instance\":%" PRId32 ",\"values\":{", instance);
+	else
+		len = stress_stream_printf(buf, len, size, ",\"instance\":null,\"values\":{");
+
+	for (i = 0; (i < n_items) && (len + 256 < size); i++) {
+		if (i > 0)
+			buf[len++] = ',';
+		len = stress_stream_str(buf, len, size, items[i].name, false);
+		buf[len++] = ':';
+		len = stress_stream_value(buf, len, size, items[i].value, false);
+	}
+	buf[len++] = '}';
+	buf[len++] = '}';
+	buf[len++] = '\n';
+
+	stress_stream_write(stream_json_fd, buf, len);
+}
+
+/*
+ *  stress_stream_csv()
+ *	write an event as CSV rows, one row per value
+ */
+static void stress_stream_csv(
+	const double now,
+	const double run_time,
+	const char *event,
+	const char *stressor,
+	const int32_t instance,
+	const stress_stream_item_t *items,
+	const size_t n_items)
+{
+	static char buf[STRESS_STREAM_BUF_SIZE];
+	char prefix[256];
+	const size_t size = sizeof(buf) - 1;
+	size_t i, len, prefix_len;
+
+	prefix_len = (size_t)snprintf(prefix, sizeof(prefix), "%.6f,%.6f,", now, run_time);
+	prefix_len = stress_stream_str(prefix, prefix_len, sizeof(prefix), event, true);
+	prefix[prefix_len++] = ',';
+	if (stressor)
+		prefix_len = stress_stream_str(prefix, prefix_len, sizeof(prefix), stressor, true);
+	prefix[prefix_len++] = ',';
+	if (instance >= 0)
+		prefix_len += (size_t)snprintf(prefix + prefix_len, sizeof(prefix) - prefix_len, "%" PRId32, instance);
+	prefix[prefix_len++] = ',';
+	prefix[prefix_len] = '\0';
+
+	if (n_items == 0) {
+		len = (size_t)snprintf(buf, size, "%s,\n", prefix);
+		stress_stream_write(stream_csv_fd, buf, len);
+		return;
+	}
+
+	for (len = 0, i = 0; i < n_items; i++) {
+		if (len + prefix_len + 128 >= size)
+			break;
+		(void)shim_memcpy(buf + len, prefix, prefix_len);
+		len += prefix_len;
+		len = stress_stream_str(buf, len, size, items[i].name, true);
+		buf[len++] = ',';
+		len = stress_stream_value(buf, len, size, items[i].value, true);
+		buf[len++] = '\n';
+	}
+	stress_stream_write(stream_csv_fd, buf, len);
+}
+
+/*
+ *  stress_stream_event()
+ *	stream an event, stressor may be NULL and instance may
+ *	be -1 for events that are not specific to a stressor
+ *	or stressor instance
+ */
+void stress_stream_event(
+	const char *event,
+	const char *stressor,
+	const int32_t instance,
+	const stress_stream_item_t *items,
+	const size_t n_items)
+{
+	double now, run_time;
+
+	if (!stress_stream_enabled())
+		return;
+
+	now = stress_time_now();
+	run_time = (g_shared && (g_shared->time_started > 0.0)) ?
+		now - g_shared->time_started : 0.0;
+
+	if (stream_json_fd >= 0)
+		stress_stream_json(now, run_time, event, stressor, instance, items, n_items);
+	if (stream_csv_fd >= 0)
+		stress_stream_csv(now, run_time, event, stressor, instance, items, n_items);
+}
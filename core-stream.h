@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef CORE_STREAM_H
+#define CORE_STREAM_H
+
+#include "stress-ng.h"
+
+/* a named value of a streamed event */
+typedef struct {
+	const char *name;		/* value name */
+	double value;			/* value */
+} stress_stream_item_t;
+
+extern void stress_stream_open(void);
+extern void stress_stream_close(void);
+extern bool stress_stream_enabled(void);
+extern void stress_stream_event(const char *event, const char *stressor,
+	const int32_t instance, const stress_stream_item_t *items,
+	const size_t n_items);
+
+#endif
@@ -87,6 +87,7 @@
 	MACRO(fanotify)		\
 	MACRO(far_branch)	\
 	MACRO(fault)		\
+	MACRO(fault_latency)	\
 	MACRO(fcntl)		\
 	MACRO(fd_fork)		\
 	MACRO(fiemap)		\
@@ -165,6 +166,7 @@
 	MACRO(memfd)		\
 	MACRO(memhotplug)	\
 	MACRO(memrate)		\
+	MACRO(memscale)		\
 	MACRO(memthrash)	\
 	MACRO(mergesort)	\
 	MACRO(metamix)		\
@@ -314,6 +316,7 @@
 	MACRO(timer)		\
 	MACRO(timerfd)		\
 	MACRO(time_warp)	\
+	MACRO(tlb_reach)	\
 	MACRO(tlb_shootdown)	\
 	MACRO(tmpfs)		\
 	MACRO(touch)		\
@@ -357,6 +360,7 @@
 	MACRO(xattr)		\
 	MACRO(yield)		\
 	MACRO(zero)		\
+	MACRO(zerocopy)	\
 	MACRO(zlib)		\
 	MACRO(zombie)
 
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2024      Colin Ian King
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-killpid.h"
+#include "core-throttle.h"
+
+#define STRESS_THROTTLE_WAIT_NS		(1000000ULL)	/* 1 ms stressor wait */
+#define STRESS_THROTTLE_TICK_NS		(10000000ULL)	/* 10 ms bucket refill */
+#define STRESS_THROTTLE_DEPTH		(0.05)		/* bucket depth in secs */
+#define STRESS_THROTTLE_LOAD_PERIOD	(1.0)		/* load measurement period */
+#define STRESS_THROTTLE_RATE_MIN	(0.1)		/* min bogo-ops/sec/instance */
+
+/*
+ *  Each stressor instance has a bogo-op limit in the shared stats
+ *  that acts as a token bucket. stress_continue() stalls an instance
+ *  once its bogo-op counter reaches the limit and a controller process
+ *  refills the buckets at the allowed rate. With --throttle-ops the rate
+ *  is the target bogo-ops/sec of each stressor shared over its instances,
+ *  with --throttle-load the rates are scaled up or down every second
+ *  according to the measured system CPU utilization.
+ */
+typedef struct {
+	stress_stats_t *stats;		/* instance stats */
+	double rate;			/* allowed bogo-ops per second */
+	double limit;			/* bogo-op limit (fractional) */
+	uint64_t last_ops;		/* bogo-ops at last load period */
+} stress_throttle_t;
+
+static uint64_t throttle_ops = 0;	/* target bogo-ops/sec per stressor */
+static uint32_t throttle_load = 0;	/* target CPU utilization % */
+static pid_t throttle_pid = -1;		/* controller pid */
+
+/*
+ *  stress_set_throttle_ops()
+ *	parse --throttle-ops option
+ */
+int stress_set_throttle_ops(const char *const opt)
+{
+	throttle_ops = stress_get_uint64(opt);
+	stress_check_range("throttle-ops", throttle_ops, 1, UINT64_MAX);
+	if (throttle_load) {
+		(void)fprintf(stderr, "throttle-ops and throttle-load cannot be used together\n");
+		_exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
+/*
+ *  stress_set_throttle_load()
+ *	parse --throttle-load option
+ */
+int stress_set_throttle_load(const char *const opt)
+{
+	throttle_load = stress_get_uint32(opt);
+	stress_check_range("throttle-load", (uint64_t)throttle_load, 1, 100);
+	if (throttle_ops) {
+		(void)fprintf(stderr, "throttle-ops and throttle-load cannot be used together\n");
+		_exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
+/*
+ *  stress_throttle_enabled()
+ *	return true if stressors are throttled
+ */
+bool stress_throttle_enabled(void)
+{
+	return (throttle_ops > 0) || (throttle_load > 0);
+}
+
+/*
+ *  stress_throttle_wait()
+ *	called from stress_continue() if throttling is enabled,
+ *	wait until the bogo-op limit is raised above the bogo-op
+ *	counter by the controller
+ */
+void stress_throttle_wait(stress_args_t *args)
+{
+	while ((stress_bogo_get(args) >= *(const volatile uint64_t *)args->throttle_ops) &&
+	       stress_continue_flag())
+		(void)shim_nanosleep_uint64(STRESS_THROTTLE_WAIT_NS);
+}
+
+/*
+ *  stress_throttle_init()
+ *	set the initial bogo-op limit of an instance before it is
+ *	forked, --throttle-load instances start unthrottled so that
+ *	their full rate can be measured
+ */
+void stress_throttle_init(stress_stats_t *stats)
+{
+	stats->throttle_ops = throttle_load ? UINT64_MAX : 1;
+}
+
+/*
+ *  stress_throttle_cpu_busy()
+ *	get busy and total CPU jiffies from /proc/stat,
+ *	returns -1 if not available
+ */
+static int stress_throttle_cpu_busy(uint64_t *busy, uint64_t *total)
+{
+#if defined(__linux__)
+	FILE *fp;
+	uint64_t user, nice, sys, idle, iowait, irq, softirq, steal;
+	int ret = -1;
+
+	fp = fopen("/proc/stat", "r");
+	if (!fp)
+		return -1;
+	if (fscanf(fp, "cpu %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+		   " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+		   &user, &nice, &sys, &idle, &iowait, &irq, &softirq, &steal) == 8) {
+		*busy = user + nice + sys + irq + softirq + steal;
+		*total = *busy + idle + iowait;
+		ret = 0;
+	}
+	(void)fclose(fp);
+	return ret;
+#else
+	(void)busy;
+	(void)total;
+
+	return -1;
+#endif
+}
+
+/*
+ *  stress_throttle_load_adjust()
+ *	scale the allowed rates of all the instances by the ratio
+ *	of the target to the measured CPU utilization
+ */
+static void stress_throttle_load_adjust(
+	stress_throttle_t *throttles,
+	const size_t n,
+	const double utilization,
+	const double period,
+	const bool first)
+{
+	size_t i;
+	double scale;
+
+	if (utilization <= 0.0)
+		return;
+	scale = (double)throttle_load / utilization;
+	/* damp the step size to avoid oscillation */
+	scale = sqrt(scale);
+	if (scale < 0.5)
+		scale = 0.5;
+	else if (scale > 2.0)
+		scale = 2.0;
+
+	for (i = 0; i < n; i++) {
+		stress_throttle_t *t = &throttles[i];
+		const uint64_t ops = t->stats->args.ci.counter;
+		const double achieved = (double)(ops - t->last_ops) / period;
+
+		t->last_ops = ops;
+		if (first) {
+			/* first period is unthrottled, start from the full rate */
+			t->rate = achieved;
+			t->limit = (double)ops;
+		} else if ((scale > 1.0) && (achieved < t->rate * 0.5)) {
+			/* cannot reach the current rate, don't raise it any further */
+			continue;
+		}
+		t->rate *= scale;
+		if (t->rate < STRESS_THROTTLE_RATE_MIN)
+			t->rate = STRESS_THROTTLE_RATE_MIN;
+	}
+}
+
+/*
+ *  stress_throttle_controller()
+ *	refill the token buckets of all instances at their allowed
+ *	rates and adjust the rates to meet the target CPU load
+ */
+static void NORETURN stress_throttle_controller(stress_throttle_t *throttles, const size_t n)
+{
+	double t_last, t_load;
+	uint64_t busy_last = 0, total_last = 0;
+	bool load_ok = false, first = true;
+
+	stress_parent_died_alarm();
+	stress_set_proc_state_str("throttle", "periodic");
+
+	if (throttle_load) {
+		load_ok = (stress_throttle_cpu_busy(&busy_last, &total_last) == 0);
+		if (!load_ok)
+			pr_inf("throttle: cannot read CPU utilization, --throttle-load disabled\n");
+	}
+
+	t_last = stress_time_now();
+	t_load = t_last;
+
+	while (stress_continue_flag()) {
+		const double t_now = stress_time_now();
+		const double dt = t_now - t_last;
+		size_t i;
+
+		t_last = t_now;
+		if (load_ok && (t_now - t_load >= STRESS_THROTTLE_LOAD_PERIOD)) {
+			uint64_t busy, total;
+
+			if (stress_throttle_cpu_busy(&busy, &total) == 0) {
+				const double utilization = (total > total_last) ?
+					100.0 * (double)(busy - busy_last) / (double)(total - total_last) : 0.0;
+
+				stress_throttle_load_adjust(throttles, n, utilization, t_now - t_load, first);
+				first = false;
+				busy_last = busy;
+				total_last = total;
+			}
+			t_load = t_now;
+		}
+
+		if (throttle_ops || (load_ok && !first)) {
+			for (i = 0; i < n; i++) {
+				stress_throttle_t *t = &throttles[i];
+				const double depth = (double)t->stats->args.ci.counter +
+					((t->rate * STRESS_THROTTLE_DEPTH > 1.0) ?
+					 t->rate * STRESS_THROTTLE_DEPTH : 1.0);
+
+				t->limit += t->rate * dt;
+				if (t->limit > depth)
+					t->limit = depth;
+				*(volatile uint64_t *)&t->stats->throttle_ops = (uint64_t)t->limit;
+			}
+		}
+		(void)shim_nanosleep_uint64(STRESS_THROTTLE_TICK_NS);
+	}
+	_exit(0);
+}
+
+/*
+ *  stress_throttle_start()
+ *	start the throttle controller process
+ */
+void stress_throttle_start(stress_stressor_t *stressors_list)
+{
+	stress_stressor_t *ss;
+	stress_throttle_t *throttles;
+	size_t n = 0;
+
+	if (!stress_throttle_enabled())
+		return;
+
+	for (ss = stressors_list; ss; ss = ss->next) {
+		if (!ss->ignore.run && !ss->ignore.permute)
+			n += (size_t)ss->num_instances;
+	}
+	if (n == 0)
+		return;
+	throttles = calloc(n, sizeof(*throttles));
+	if (!throttles) {
+		pr_inf("throttle: cannot allocate throttle state, stressors are not throttled\n");
+		goto unthrottle;
+	}
+
+	n = 0;
+	for (ss = stressors_list; ss; ss = ss->next) {
+		int32_t j;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		for (j = 0; j < ss->num_instances; j++) {
+			stress_throttle_t *t = &throttles[n++];
+
+			t->stats = ss->stats[j];
+			t->rate = throttle_ops ?
+				(double)throttle_ops / (double)ss->num_instances : 0.0;
+			t->limit = (double)t->stats->args.ci.counter;
+			t->last_ops = t->stats->args.ci.counter;
+		}
+	}
+
+	throttle_pid = fork();
+	if (throttle_pid == 0)
+		stress_throttle_controller(throttles, n);
+	free(throttles);
+	if (throttle_pid > 0)
+		return;
+	pr_inf("throttle: cannot fork controller process, errno=%d (%s), "
+		"stressors are not throttled\n", errno, strerror(errno));
+
+unthrottle:
+	for (ss = stressors_list; ss; ss = ss->next) {
+		int32_t j;
+
+		if (ss->ignore.run || ss->ignore.permute)
+			continue;
+		for (j = 0; j < ss->num_instances; j++)
+			*(volatile uint64_t *)&ss->stats[j]->throttle_ops = UINT64_MAX;
+	}
+}
+
+/*
+ *  stress_throttle_stop()
+ *	stop the throttle controller process
+ */
+void stress_throttle_stop(void)
+{
+	if (throttle_pid > 0) {
+		(void)stress_kill_pid_wait(throttle_pid, NULL);
+		throttle_pid = -1;
+	}
+}
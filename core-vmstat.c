@@ -21,6 +21,7 @@
 #include "core-builtin.h"
 #include "core-killpid.h"
 #include "core-pragma.h"
+#include "core-stream.h"
 #include "core-thermal-zone.h"
 #include "core-vmstat.h"
 
@@ -1107,6 +1108,67 @@ static void stress_get_cpu_ghz(
 }
 #endif
 
+/*
+ *  stress_vmstat_stream_therm()
+ *	stream CPU frequencies, load averages and thermal
+ *	zone temperatures as a thermalstat event
+ */
+static void stress_vmstat_stream_therm(
+	const size_t tz_num,
+	const double avg_ghz,
+	const double min_ghz,
+	const double max_ghz)
+{
+	stress_stream_item_t *items;
+	char (*names)[64];
+	double min1, min5, min15;
+	size_t n = 0;
+#if defined(__linux__)
+	stress_tz_info_t *tz_info;
+#endif
+
+	items = calloc(tz_num + 6, sizeof(*items));
+	if (!items)
+		return;
+	names = calloc(tz_num + 1, sizeof(*names));
+	if (!names) {
+		free(items);
+		return;
+	}
+
+	if (avg_ghz > 0.0) {
+		items[n].name = "avg-ghz";
+		items[n++].value = avg_ghz;
+		items[n].name = "min-ghz";
+		items[n++].value = min_ghz;
+		items[n].name = "max-ghz";
+		items[n++].value = max_ghz;
+	}
+	if (stress_get_load_avg(&min1, &min5, &min15) == 0) {
+		items[n].name = "load-avg-1";
+		items[n++].value = min1;
+		items[n].name = "load-avg-5";
+		items[n++].value = min5;
+		items[n].name = "load-avg-15";
+		items[n++].value = min15;
+	}
+#if defined(__linux__)
+	{
+		size_t i;
+
+		for (i = 0, tz_info = g_shared->tz_info; tz_info && (i < tz_num); tz_info = tz_info->next, i++) {
+			(void)snprintf(names[i], sizeof(names[i]), "%s-%" PRIu32,
+				tz_info->type, tz_info->type_instance);
+			items[n].name = names[i];
+			items[n++].value = stress_get_tz_info(tz_info);
+		}
+	}
+#endif
+	stress_stream_event("thermalstat", NULL, -1, items, n);
+	free(names);
+	free(items);
+}
+
 /*
  *  stress_vmstat_start()
  *	start vmstat statistics (1 per second)
@@ -1255,6 +1317,30 @@ void stress_vmstat_start(void)
 				percent * (double)vmstat.stolen_time);
 			pr_block_end();
 
+			if (stress_stream_enabled()) {
+				const stress_stream_item_t items[] = {
+					{ "r",		(double)vmstat.procs_running },
+					{ "b",		(double)vmstat.procs_blocked },
+					{ "swpd",	(double)vmstat.swap_used },
+					{ "free",	(double)vmstat.memory_free },
+					{ "buff",	(double)vmstat.memory_buff },
+					{ "cache",	(double)(vmstat.memory_cached + vmstat.memory_reclaimable) },
+					{ "si",		(double)vmstat.swap_in / (double)vmstat_delay },
+					{ "so",		(double)vmstat.swap_out / (double)vmstat_delay },
+					{ "bi",		(double)vmstat.block_in / (double)vmstat_delay },
+					{ "bo",		(double)vmstat.block_out / (double)vmstat_delay },
+					{ "in",		(double)vmstat.interrupt / (double)vmstat_delay },
+					{ "cs",		(double)vmstat.context_switch / (double)vmstat_delay },
+					{ "us",		percent * (double)vmstat.user_time },
+					{ "sy",		percent * (double)vmstat.system_time },
+					{ "id",		percent * (double)vmstat.idle_time },
+					{ "wa",		percent * (double)vmstat.wait_time },
+					{ "st",		percent * (double)vmstat.stolen_time },
+				};
+
+				stress_stream_event("vmstat", NULL, -1, items, SIZEOF_ARRAY(items));
+			}
+
 			vmstat_count++;
 			if (vmstat_count >= 25)
 				vmstat_count = 0;
@@ -1307,6 +1393,9 @@ void stress_vmstat_start(void)
 				pr_block_end();
 				free(therms);
 
+				if (stress_stream_enabled())
+					stress_vmstat_stream_therm(tz_num, avg_ghz, min_ghz, max_ghz);
+
 				thermalstat_count++;
 				if (thermalstat_count >= 25)
 					thermalstat_count = 0;
@@ -1336,6 +1425,20 @@ void stress_vmstat_start(void)
 				(double)iostat.discard_io * clk_scale);
 			pr_block_end();
 
+			if (stress_stream_enabled()) {
+				const stress_stream_item_t items[] = {
+					{ "inflight",		(double)iostat.in_flight * clk_scale },
+					{ "read-kb-per-sec",	(double)(iostat.read_sectors >> 1) * clk_scale },
+					{ "write-kb-per-sec",	(double)(iostat.write_sectors >> 1) * clk_scale },
+					{ "discard-kb-per-sec",	(double)(iostat.discard_sectors >> 1) * clk_scale },
+					{ "reads-per-sec",	(double)iostat.read_io * clk_scale },
+					{ "writes-per-sec",	(double)iostat.write_io * clk_scale },
+					{ "discards-per-sec",	(double)iostat.discard_io * clk_scale },
+				};
+
+				stress_stream_event("iostat", NULL, -1, items, SIZEOF_ARRAY(items));
+			}
+
 			iostat_count++;
 			if (iostat_count >= 25)
 				iostat_count = 0;
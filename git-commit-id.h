@@ -0,0 +1 @@
+#define STRESS_GIT_COMMIT_ID "8275efc3e28998283fcf1bfe4b3b08200e947fed"
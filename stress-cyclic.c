@@ -21,12 +21,12 @@
 #include "core-builtin.h"
 #include "core-capabilities.h"
 #include "core-killpid.h"
+#include "core-latency.h"
 
 #include <sched.h>
 
 #define DEFAULT_DELAY_NS	(100000)
 #define MAX_SAMPLES		(100000000)
-#define DEFAULT_SAMPLES		(10000)
 #define MAX_BUCKETS		(250)
 
 typedef struct {
@@ -38,16 +38,13 @@ typedef struct {
 typedef struct {
 	int64_t		min_ns;		/* min latency */
 	int64_t		max_ns;		/* max latency */
-	int64_t		*latencies;	/* latency samples */
-	size_t		latencies_size;	/* size of latencies allocation */
-	size_t		cyclic_samples;	/* number of latency samples */
-	size_t		index;		/* index into latencies */
-	size_t		index_reqd;	/* theoretic size of index required for the run */
+	uint64_t	samples;	/* number of latency samples */
 	int32_t		min_prio;	/* min priority allowed */
 	int32_t		max_prio;	/* max priority allowed */
 	double		ns;		/* total nanosecond latency */
+	double		ns_sq;		/* total of squared nanosecond latencies */
 	double		latency_mean;	/* average latency */
-	int64_t		latency_mode;	/* first mode */
+	uint64_t	latency_mode;	/* mode, lowest latency of most common bucket */
 	double		std_dev;	/* standard deviation */
 } stress_rt_stats_t;
 
@@ -65,7 +62,7 @@ static const stress_help_t help[] = {
 	{ NULL,	"cyclic-ops N",		"stop after N cyclic timing cycles" },
 	{ NULL,	"cyclic-policy P",	"used rr or fifo scheduling policy" },
 	{ NULL,	"cyclic-prio N",	"real time scheduling priority 1..100" },
-	{ NULL, "cyclic-samples N",	"number of latency samples to take" },
+	{ NULL, "cyclic-samples N",	"deprecated, all latency samples are recorded" },
 	{ NULL,	"cyclic-sleep N",	"sleep time of real time timer in nanosecs" },
 	{ NULL,	NULL,			NULL }
 };
@@ -143,7 +140,30 @@ static int stress_set_cyclic_samples(const char *opt)
     (defined(HAVE_CLOCK_GETTIME) && defined(HAVE_NANOSLEEP)) ||		\
     (defined(HAVE_CLOCK_GETTIME) && defined(HAVE_PSELECT)) ||		\
     (defined(HAVE_CLOCK_GETTIME))
+/*
+ *  stress_cyclic_account()
+ *	account a latency sample, early wakeups are
+ *	recorded in the latency histogram as zero ns
+ */
+static void stress_cyclic_account(
+	stress_args_t *args,
+	stress_rt_stats_t *rt_stats,
+	const int64_t delta_ns)
+{
+	const double ns = (double)delta_ns;
+
+	stress_latency_add(args->latency, (delta_ns > 0) ? (uint64_t)delta_ns : 0);
+	if (rt_stats->min_ns > delta_ns)
+		rt_stats->min_ns = delta_ns;
+	if (rt_stats->max_ns < delta_ns)
+		rt_stats->max_ns = delta_ns;
+	rt_stats->samples++;
+	rt_stats->ns += ns;
+	rt_stats->ns_sq += ns * ns;
+}
+
 static void stress_cyclic_stats(
+	stress_args_t *args,
 	stress_rt_stats_t *rt_stats,
 	const uint64_t cyclic_sleep,
 	const struct timespec *t1,
@@ -155,11 +175,7 @@ static void stress_cyclic_stats(
 		   (t2->tv_nsec - t1->tv_nsec);
 	delta_ns -= cyclic_sleep;
 
-	if (rt_stats->index < rt_stats->cyclic_samples)
-		rt_stats->latencies[rt_stats->index++] = delta_ns;
-	rt_stats->index_reqd++;
-
-	rt_stats->ns += (double)delta_ns;
+	stress_cyclic_account(args, rt_stats, delta_ns);
 }
 #else
 	UNEXPECTED
@@ -179,15 +195,13 @@ static int stress_cyclic_clock_nanosleep(
 	struct timespec t1, t2, t, trem;
 	int ret;
 
-	(void)args;
-
 	t.tv_sec = cyclic_sleep / STRESS_NANOSECOND;
 	t.tv_nsec = cyclic_sleep % STRESS_NANOSECOND;
 	(void)clock_gettime(CLOCK_REALTIME, &t1);
 	ret = clock_nanosleep(CLOCK_REALTIME, 0, &t, &trem);
 	(void)clock_gettime(CLOCK_REALTIME, &t2);
 	if (ret == 0)
-		stress_cyclic_stats(rt_stats, cyclic_sleep, &t1, &t2);
+		stress_cyclic_stats(args, rt_stats, cyclic_sleep, &t1, &t2);
 	return 0;
 }
 #else
@@ -208,15 +222,13 @@ static int stress_cyclic_posix_nanosleep(
 	struct timespec t1, t2, t, trem;
 	int ret;
 
-	(void)args;
-
 	t.tv_sec = cyclic_sleep / STRESS_NANOSECOND;
 	t.tv_nsec = cyclic_sleep % STRESS_NANOSECOND;
 	(void)clock_gettime(CLOCK_REALTIME, &t1);
 	ret = nanosleep(&t, &trem);
 	(void)clock_gettime(CLOCK_REALTIME, &t2);
 	if (ret == 0)
-		stress_cyclic_stats(rt_stats, cyclic_sleep, &t1, &t2);
+		stress_cyclic_stats(args, rt_stats, cyclic_sleep, &t1, &t2);
 	return 0;
 }
 #else
@@ -235,8 +247,6 @@ static int stress_cyclic_poll(
 {
 	struct timespec t1, t2;
 
-	(void)args;
-
 	/* find nearest point to clock roll over */
 	(void)clock_gettime(CLOCK_REALTIME, &t1);
 	for (;;) {
@@ -256,11 +266,7 @@ static int stress_cyclic_poll(
 		if (delta_ns >= (int64_t)cyclic_sleep) {
 			delta_ns -= cyclic_sleep;
 
-			if (rt_stats->index < rt_stats->cyclic_samples)
-				rt_stats->latencies[rt_stats->index++] = delta_ns;
-			rt_stats->index_reqd++;
-
-			rt_stats->ns += (double)delta_ns;
+			stress_cyclic_account(args, rt_stats, delta_ns);
 			break;
 		}
 	}
@@ -284,15 +290,13 @@ static int stress_cyclic_pselect(
 	struct timespec t1, t2, t;
 	int ret;
 
-	(void)args;
-
 	t.tv_sec = cyclic_sleep / STRESS_NANOSECOND;
 	t.tv_nsec = cyclic_sleep % STRESS_NANOSECOND;
 	(void)clock_gettime(CLOCK_REALTIME, &t1);
 	ret = pselect(0, NULL, NULL,NULL, &t, NULL);
 	(void)clock_gettime(CLOCK_REALTIME, &t2);
 	if (ret == 0)
-		stress_cyclic_stats(rt_stats, cyclic_sleep, &t1, &t2);
+		stress_cyclic_stats(args, rt_stats, cyclic_sleep, &t1, &t2);
 	return 0;
 }
 #else
@@ -356,11 +360,7 @@ static int stress_cyclic_itimer(
 		(itimer_time.tv_nsec - t1.tv_nsec);
 	delta_ns -= cyclic_sleep;
 
-	if (rt_stats->index < rt_stats->cyclic_samples)
-		rt_stats->latencies[rt_stats->index++] = delta_ns;
-	rt_stats->index_reqd++;
-
-	rt_stats->ns += (double)delta_ns;
+	stress_cyclic_account(args, rt_stats, delta_ns);
 
 	(void)timer_delete(timerid);
 
@@ -391,13 +391,11 @@ static int stress_cyclic_usleep(
 	const useconds_t usecs = (useconds_t)cyclic_sleep / 1000;
 	int ret;
 
-	(void)args;
-
 	(void)clock_gettime(CLOCK_REALTIME, &t1);
 	ret = usleep(usecs);
 	(void)clock_gettime(CLOCK_REALTIME, &t2);
 	if (ret == 0)
-		stress_cyclic_stats(rt_stats, cyclic_sleep, &t1, &t2);
+		stress_cyclic_stats(args, rt_stats, cyclic_sleep, &t1, &t2);
 	return 0;
 }
 #else
@@ -418,73 +416,24 @@ static void NORETURN MLOCKED_TEXT stress_rlimit_handler(int signum)
 	siglongjmp(jmp_env, 1);
 }
 
-/*
- *  stress_cyclic_cmp()
- *	sort latencies into order, least first
- */
-static int stress_cyclic_cmp(const void *p1, const void *p2)
-{
-	const int64_t *i1 = (const int64_t *)p1;
-	const int64_t *i2 = (const int64_t *)p2;
-
-	if (*i1 > *i2)
-		return 1;
-	else if (*i1 < *i2)
-		return -1;
-	return 0;
-}
-
 /*
  *  stress_rt_stats()
  *	compute statistics on gathered latencies
  */
-static void stress_rt_stats(stress_rt_stats_t *rt_stats)
+static void stress_rt_stats(stress_args_t *args, stress_rt_stats_t *rt_stats)
 {
-	size_t i;
-	size_t n = 0, best_n = 0;
-	int64_t current;
-	double variance = 0.0;
-
 	rt_stats->latency_mean = 0.0;
 	rt_stats->latency_mode = 0;
+	rt_stats->std_dev = 0.0;
 
-	for (i = 0; i < rt_stats->index; i++) {
-		const int64_t ns = rt_stats->latencies[i];
-
-		if (ns > rt_stats->max_ns)
-			rt_stats->max_ns = ns;
-		if (ns < rt_stats->min_ns)
-			rt_stats->min_ns = ns;
+	if (rt_stats->samples) {
+		const double n = (double)rt_stats->samples;
+		double variance;
 
-		rt_stats->latency_mean += (double)ns;
-	}
-	if (rt_stats->index)
-		rt_stats->latency_mean /= (double)rt_stats->index;
-
-	qsort(rt_stats->latencies, rt_stats->index, sizeof(*(rt_stats->latencies)), stress_cyclic_cmp);
-
-	current = rt_stats->latency_mode = rt_stats->latencies[0];
-
-	for (i = 0; i < rt_stats->index; i++) {
-		const int64_t ns = rt_stats->latencies[i];
-		double diff;
-
-		if (ns == current) {
-			n++;
-			if (n > best_n) {
-				rt_stats->latency_mode = current;
-				best_n = n;
-			}
-		} else {
-			current = ns;
-			n = 0;
-		}
-		diff = ((double)ns - rt_stats->latency_mean);
-		variance += (diff * diff);
-	}
-	if (rt_stats->index) {
-		variance /= (double)rt_stats->index;
-		rt_stats->std_dev = sqrt(variance);
+		rt_stats->latency_mean = rt_stats->ns / n;
+		rt_stats->latency_mode = stress_latency_mode(args->latency);
+		variance = (rt_stats->ns_sq / n) - (rt_stats->latency_mean * rt_stats->latency_mean);
+		rt_stats->std_dev = (variance > 0.0) ? sqrt(variance) : 0.0;
 	}
 }
 
@@ -552,7 +501,7 @@ static int stress_set_cyclic_method(const char *name)
  *	show real time distribution
  */
 static void stress_rt_dist(
-	const char *name,
+	stress_args_t *args,
 	stress_rt_stats_t *rt_stats,
 	const int64_t cyclic_dist)
 {
@@ -560,7 +509,9 @@ static void stress_rt_dist(
 		((ssize_t)rt_stats->max_ns / (ssize_t)cyclic_dist) + 1 : 1;
 	const ssize_t dist_size = STRESS_MINIMUM(MAX_BUCKETS, dist_max_size);
 	const ssize_t dist_min = STRESS_MINIMUM(5, dist_max_size);
+	const char *name = args->name;
 	ssize_t i, n;
+	size_t j;
 	int64_t *dist;
 
 	if (!cyclic_dist)
@@ -572,11 +523,12 @@ static void stress_rt_dist(
 		return;
 	}
 
-	for (i = 0; i < (ssize_t)rt_stats->index; i++) {
-		const int64_t lat = rt_stats->latencies[i] / cyclic_dist;
+	/* Histogram buckets are attributed to their lowest latency */
+	for (j = 0; j < STRESS_LATENCY_BUCKETS; j++) {
+		const int64_t lat = (int64_t)stress_latency_bucket_ns(j) / cyclic_dist;
 
 		if (lat < (int64_t)dist_size)
-			dist[lat]++;
+			dist[lat] += (int64_t)args->latency->buckets[j];
 	}
 
 	for (n = dist_size; n >= 1; n--) {
@@ -636,7 +588,6 @@ static int stress_cyclic(stress_args_t *args)
 	uint64_t cyclic_sleep = DEFAULT_DELAY_NS;
 	uint64_t cyclic_dist = 0;
 	int32_t cyclic_prio = INT32_MAX;
-	size_t cyclic_samples = DEFAULT_SAMPLES;
 	int policy, rc = EXIT_SUCCESS;
 	size_t cyclic_policy = 0;
 	size_t cyclic_method = 0;
@@ -651,7 +602,6 @@ static int stress_cyclic(stress_args_t *args)
 	(void)stress_get_setting("cyclic-method", &cyclic_method);
 	(void)stress_get_setting("cyclic-policy", &cyclic_policy);
 	(void)stress_get_setting("cyclic-prio", &cyclic_prio);
-	(void)stress_get_setting("cyclic-samples", &cyclic_samples);
 	(void)stress_get_setting("cyclic-sleep", &cyclic_sleep);
 
 	func = cyclic_methods[cyclic_method].func;
@@ -685,21 +635,10 @@ static int stress_cyclic(stress_args_t *args)
 			args->name, errno, strerror(errno));
 		return EXIT_NO_RESOURCE;
 	}
-	rt_stats->cyclic_samples = cyclic_samples;
-	rt_stats->latencies_size = cyclic_samples * sizeof(*rt_stats->latencies);
-	rt_stats->latencies = (int64_t *)stress_mmap_populate(NULL,
-						rt_stats->latencies_size,
-						PROT_READ | PROT_WRITE,
-						MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-	if (rt_stats->latencies == MAP_FAILED) {
-		pr_inf_skip("%s: mmap of %zd samples failed: %d (%s)\n",
-			args->name, cyclic_samples, errno, strerror(errno));
-		(void)munmap((void *)rt_stats, size);
-		return EXIT_NO_RESOURCE;
-	}
 	rt_stats->min_ns = INT64_MAX;
 	rt_stats->max_ns = INT64_MIN;
 	rt_stats->ns = 0.0;
+	rt_stats->ns_sq = 0.0;
 #if defined(HAVE_SCHED_GET_PRIORITY_MIN)
 	rt_stats->min_prio = sched_get_priority_min(policy);
 #else
@@ -732,7 +671,6 @@ again:
 			goto finish;
 		pr_inf("%s: cannot fork, errno=%d (%s)\n",
 			args->name, errno, strerror(errno));
-		(void)munmap((void *)rt_stats->latencies, rt_stats->latencies_size);
 		(void)munmap((void *)rt_stats, size);
 		return EXIT_NO_RESOURCE;
 	} else if (pid == 0) {
@@ -828,7 +766,6 @@ tidy_ok:
 		ncrc = EXIT_SUCCESS;
 tidy:
 		(void)fflush(stdout);
-		(void)munmap((void *)rt_stats->latencies, rt_stats->latencies_size);
 		(void)munmap((void *)rt_stats, size);
 		_exit(ncrc);
 	} else {
@@ -839,10 +776,10 @@ tidy:
 		(void)stress_kill_pid_wait(pid, NULL);
 	}
 
-	stress_rt_stats(rt_stats);
+	stress_rt_stats(args, rt_stats);
 
 	if (args->instance == 0) {
-		if (rt_stats->index) {
+		if (rt_stats->samples) {
 			size_t i;
 
 			static const double percentiles[] = {
@@ -858,12 +795,12 @@ tidy:
 			};
 
 			pr_block_begin();
-			pr_inf("%s: sched %s: %" PRIu64 " ns delay, %zd samples\n",
+			pr_inf("%s: sched %s: %" PRIu64 " ns delay, %" PRIu64 " samples\n",
 				args->name,
 				policies[cyclic_policy].name,
 				cyclic_sleep,
-				rt_stats->index);
-			pr_inf( "%s:   mean: %.2f ns, mode: %" PRId64 " ns\n",
+				rt_stats->samples);
+			pr_inf( "%s:   mean: %.2f ns, mode: %" PRIu64 " ns\n",
 				args->name,
 				rt_stats->latency_mean,
 				rt_stats->latency_mode);
@@ -875,17 +812,12 @@ tidy:
 
 			pr_inf("%s: latency percentiles:\n", args->name);
 			for (i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
-				size_t j = (size_t)(((double)rt_stats->index * percentiles[i]) / 100.0);
-				pr_inf("%s:   %5.2f%%: %10" PRId64 " ns\n",
+				pr_inf("%s:   %5.2f%%: %10" PRIu64 " ns\n",
 					args->name,
 					percentiles[i],
-					rt_stats->latencies[j]);
+					stress_latency_percentile(args->latency, percentiles[i]));
 			}
-			stress_rt_dist(args->name, rt_stats, (int64_t)cyclic_dist);
-
-			if (rt_stats->index < rt_stats->index_reqd)
-				pr_inf("%s: Note: --cyclic-samples needed to be %zd to capture all the data for this run\n",
-					args->name, rt_stats->index_reqd);
+			stress_rt_dist(args, rt_stats, (int64_t)cyclic_dist);
 			pr_block_end();
 		} else {
 			pr_inf("%s: %10s: no latency information available\n",
@@ -897,7 +829,6 @@ tidy:
 finish:
 	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
 
-	(void)munmap((void *)rt_stats->latencies, rt_stats->latencies_size);
 	(void)munmap((void *)rt_stats, size);
 
 	return rc;
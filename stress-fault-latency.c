@@ -0,0 +1,654 @@
+/*
+ * Copyright (C) 2024      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-latency.h"
+#include "core-mincore.h"
+#include "core-mmap.h"
+#include "core-pthread.h"
+
+#if defined(HAVE_LINUX_USERFAULTFD_H)
+#include <linux/userfaultfd.h>
+#endif
+
+#if defined(HAVE_POLL_H)
+#include <poll.h>
+#endif
+
+#define MIN_FAULT_LATENCY_BYTES		(1 * MB)
+#define MAX_FAULT_LATENCY_BYTES		(MAX_MEM_LIMIT)
+#define DEFAULT_FAULT_LATENCY_BYTES	(16 * MB)
+
+#define FAULT_LATENCY_AROUND	(64 * KB)	/* default fault_around_bytes */
+#define FAULT_LATENCY_THP_MAX	(64)		/* max THP faults per round */
+
+#define FAULT_LATENCY_ANON	(0)		/* anonymous first touch */
+#define FAULT_LATENCY_MINOR	(1)		/* file backed, in the page cache */
+#define FAULT_LATENCY_MAJOR	(2)		/* file backed, evicted from the page cache */
+#define FAULT_LATENCY_THP	(3)		/* transparent huge page first touch */
+#define FAULT_LATENCY_COLLAPSE	(4)		/* MADV_COLLAPSE of a THP sized range */
+#define FAULT_LATENCY_UFFD	(5)		/* userfaultfd round trip */
+#define FAULT_LATENCY_KINDS	(6)
+
+#if defined(__NR_userfaultfd) &&		\
+    defined(HAVE_LINUX_USERFAULTFD_H) &&	\
+    defined(HAVE_POLL_H) &&			\
+    defined(HAVE_LIB_PTHREAD) &&		\
+    defined(UFFDIO_API) &&			\
+    defined(UFFDIO_COPY)
+#define HAVE_FAULT_LATENCY_UFFD
+#endif
+
+#if !defined(UFFD_USER_MODE_ONLY)
+#define UFFD_USER_MODE_ONLY	(1)
+#endif
+
+static const stress_help_t help[] = {
+	{ NULL,	"fault-latency N",	"start N workers that measure the cost of page faults" },
+	{ NULL,	"fault-latency-bytes N","size of the regions to fault in" },
+	{ NULL,	"fault-latency-ops N",	"stop after N rounds of page faults of each kind" },
+	{ NULL,	NULL,			NULL }
+};
+
+static const char * const fault_latency_kinds[FAULT_LATENCY_KINDS] = {
+	"anon",
+	"file-minor",
+	"file-major",
+	"thp",
+	"thp-collapse",
+	"userfaultfd",
+};
+
+typedef struct {
+	stress_args_t *args;
+	size_t page_size;		/* base page size */
+	size_t thp_size;		/* transparent huge page size */
+	size_t size;			/* region size in bytes */
+	int fd;				/* file for file backed faults */
+	bool skip[FAULT_LATENCY_KINDS];	/* fault kinds that cannot be measured */
+	stress_latency_t lat[FAULT_LATENCY_KINDS];
+} stress_fault_latency_t;
+
+#if defined(HAVE_FAULT_LATENCY_UFFD)
+/* userfaultfd fault handler thread state */
+typedef struct {
+	int fd;				/* userfaultfd */
+	size_t page_size;		/* page size */
+	uint8_t *page;			/* page to copy into faulting pages */
+	volatile bool handling;		/* keep handling faults */
+	bool failed;			/* a fault could not be handled */
+} stress_fault_latency_uffd_t;
+#endif
+
+static int stress_set_fault_latency_bytes(const char *opt)
+{
+	size_t fault_latency_bytes;
+
+	fault_latency_bytes = (size_t)stress_get_uint64_byte_memory(opt, 1);
+	stress_check_range_bytes("fault-latency-bytes", fault_latency_bytes,
+		MIN_FAULT_LATENCY_BYTES, MAX_FAULT_LATENCY_BYTES);
+	return stress_set_setting("fault-latency-bytes", TYPE_ID_SIZE_T, &fault_latency_bytes);
+}
+
+/*
+ *  stress_fault_latency_skip()
+ *	stop measuring a kind of fault, instance 0 logs why
+ */
+static void stress_fault_latency_skip(
+	stress_fault_latency_t *ctx,
+	const int kind,
+	const char *reason)
+{
+	ctx->skip[kind] = true;
+	if (ctx->args->instance == 0)
+		pr_inf("%s: %s faults cannot be measured, %s\n",
+			ctx->args->name, fault_latency_kinds[kind], reason);
+}
+
+/*
+ *  stress_fault_latency_add()
+ *	add a fault latency to the fault kind histogram and
+ *	to the per-instance latency histogram
+ */
+static inline void stress_fault_latency_add(
+	stress_fault_latency_t *ctx,
+	const int kind,
+	const uint64_t ns)
+{
+	stress_latency_add(&ctx->lat[kind], ns);
+	stress_latency_record(ctx->args, ns);
+}
+
+/*
+ *  stress_fault_latency_write()
+ *	write to a page and return the time taken in nanoseconds
+ */
+static inline uint64_t stress_fault_latency_write(volatile uint8_t *ptr)
+{
+	const uint64_t t = stress_latency_now();
+
+	*ptr = 0xa5;
+	return stress_latency_now() - t;
+}
+
+/*
+ *  stress_fault_latency_read()
+ *	read from a page and return the time taken in nanoseconds
+ */
+static inline uint64_t stress_fault_latency_read(volatile uint8_t *ptr)
+{
+	const uint64_t t = stress_latency_now();
+
+	(void)*ptr;
+	return stress_latency_now() - t;
+}
+
+/*
+ *  stress_fault_latency_anon()
+ *	first touch of anonymous base pages
+ */
+static void stress_fault_latency_anon(stress_fault_latency_t *ctx)
+{
+	uint8_t *buf, *ptr;
+	const uint8_t *end;
+
+	buf = (uint8_t *)mmap(NULL, ctx->size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED)
+		return;
+#if defined(MADV_NOHUGEPAGE)
+	(void)madvise((void *)buf, ctx->size, MADV_NOHUGEPAGE);
+#endif
+	end = buf + ctx->size;
+	for (ptr = buf; (ptr < end) && stress_continue_flag(); ptr += ctx->page_size)
+		stress_fault_latency_add(ctx, FAULT_LATENCY_ANON,
+			stress_fault_latency_write(ptr));
+	(void)munmap((void *)buf, ctx->size);
+}
+
+/*
+ *  stress_fault_latency_file_create()
+ *	create the file for file backed faults, returns false
+ *	if it cannot be created
+ */
+static bool stress_fault_latency_file_create(stress_fault_latency_t *ctx)
+{
+	char filename[PATH_MAX];
+	uint8_t *page;
+	off_t off;
+
+	(void)stress_temp_filename_args(ctx->args, filename, sizeof(filename), stress_mwc32());
+	ctx->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if (ctx->fd < 0)
+		return false;
+	(void)shim_unlink(filename);
+
+	page = (uint8_t *)malloc(ctx->page_size);
+	if (!page)
+		goto err;
+	stress_rndbuf(page, ctx->page_size);
+	for (off = 0; off < (off_t)ctx->size; off += (off_t)ctx->page_size) {
+		if (pwrite(ctx->fd, page, ctx->page_size, off) != (ssize_t)ctx->page_size) {
+			free(page);
+			goto err;
+		}
+	}
+	free(page);
+	(void)shim_fdatasync(ctx->fd);
+	return true;
+err:
+	(void)close(ctx->fd);
+	ctx->fd = -1;
+	return false;
+}
+
+/*
+ *  stress_fault_latency_minor()
+ *	read faults on file pages that are in the page cache, the
+ *	kernel maps the cached pages around a faulting page, so one
+ *	page per fault around window is touched
+ */
+static void stress_fault_latency_minor(stress_fault_latency_t *ctx)
+{
+	uint8_t *buf, *ptr;
+	const uint8_t *end;
+	const size_t stride = STRESS_MAXIMUM(ctx->page_size, (size_t)FAULT_LATENCY_AROUND);
+
+	buf = (uint8_t *)mmap(NULL, ctx->size, PROT_READ, MAP_SHARED, ctx->fd, 0);
+	if (buf == MAP_FAILED)
+		return;
+	/* make sure the pages are cached */
+	(void)stress_mincore_touch_pages_interruptible((void *)buf, ctx->size);
+	(void)munmap((void *)buf, ctx->size);
+
+	buf = (uint8_t *)mmap(NULL, ctx->size, PROT_READ, MAP_SHARED, ctx->fd, 0);
+	if (buf == MAP_FAILED)
+		return;
+	end = buf + ctx->size;
+	for (ptr = buf; (ptr < end) && stress_continue_flag(); ptr += stride)
+		stress_fault_latency_add(ctx, FAULT_LATENCY_MINOR,
+			stress_fault_latency_read(ptr));
+	(void)munmap((void *)buf, ctx->size);
+}
+
+/*
+ *  stress_fault_latency_major()
+ *	read faults on file pages that have been evicted from the
+ *	page cache, readahead is disabled and pages that are still
+ *	cached when they are touched are not counted
+ */
+static void stress_fault_latency_major(stress_fault_latency_t *ctx)
+{
+#if defined(HAVE_POSIX_FADVISE) &&	\
+    defined(POSIX_FADV_DONTNEED) &&	\
+    defined(MADV_RANDOM)
+	uint8_t *buf, *ptr;
+	const uint8_t *end;
+	uint64_t faults = 0, cached = 0;
+
+	(void)shim_fdatasync(ctx->fd);
+	(void)posix_fadvise(ctx->fd, 0, (off_t)ctx->size, POSIX_FADV_DONTNEED);
+
+	buf = (uint8_t *)mmap(NULL, ctx->size, PROT_READ, MAP_SHARED, ctx->fd, 0);
+	if (buf == MAP_FAILED)
+		return;
+	(void)madvise((void *)buf, ctx->size, MADV_RANDOM);
+	end = buf + ctx->size;
+	for (ptr = buf; (ptr < end) && stress_continue_flag(); ptr += ctx->page_size) {
+		unsigned char vec = 0;
+
+		if ((shim_mincore((void *)ptr, ctx->page_size, &vec) == 0) && (vec & 1)) {
+			cached++;
+			continue;
+		}
+		stress_fault_latency_add(ctx, FAULT_LATENCY_MAJOR,
+			stress_fault_latency_read(ptr));
+		faults++;
+	}
+	(void)munmap((void *)buf, ctx->size);
+
+	if (!faults && cached)
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_MAJOR,
+			"the file pages cannot be evicted from the page cache");
+#else
+	stress_fault_latency_skip(ctx, FAULT_LATENCY_MAJOR,
+		"posix_fadvise or MADV_RANDOM is not available");
+#endif
+}
+
+/*
+ *  stress_fault_latency_thp_mmap()
+ *	map n transparent huge page aligned regions, returns the
+ *	aligned start and the mapping in *map and *map_size
+ */
+static uint8_t *stress_fault_latency_thp_mmap(
+	stress_fault_latency_t *ctx,
+	const size_t n,
+	void **map,
+	size_t *map_size)
+{
+	uintptr_t addr;
+
+	*map_size = (n + 1) * ctx->thp_size;
+	*map = mmap(NULL, *map_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (*map == MAP_FAILED)
+		return NULL;
+	addr = ((uintptr_t)*map + ctx->thp_size - 1) & ~(uintptr_t)(ctx->thp_size - 1);
+	return (uint8_t *)addr;
+}
+
+/*
+ *  stress_fault_latency_thp()
+ *	first touch of transparent huge pages, the latencies are only
+ *	counted if the region is backed by transparent huge pages
+ */
+static void stress_fault_latency_thp(stress_fault_latency_t *ctx)
+{
+#if defined(MADV_HUGEPAGE)
+	const size_t n = STRESS_MINIMUM(STRESS_MAXIMUM(ctx->size / ctx->thp_size, (size_t)2),
+					(size_t)FAULT_LATENCY_THP_MAX);
+	uint64_t ns[FAULT_LATENCY_THP_MAX];
+	uint8_t *buf;
+	void *map;
+	size_t map_size, i;
+
+	buf = stress_fault_latency_thp_mmap(ctx, n, &map, &map_size);
+	if (!buf)
+		return;
+	if (madvise((void *)buf, n * ctx->thp_size, MADV_HUGEPAGE) < 0) {
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_THP,
+			"transparent huge pages are not available");
+		(void)munmap(map, map_size);
+		return;
+	}
+	for (i = 0; (i < n) && stress_continue_flag(); i++)
+		ns[i] = stress_fault_latency_write(buf + (i * ctx->thp_size));
+
+	if (stress_mmap_page_size((void *)buf, i * ctx->thp_size) != ctx->thp_size) {
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_THP,
+			"the faults are not backed by transparent huge pages");
+	} else {
+		size_t j;
+
+		for (j = 0; j < i; j++)
+			stress_fault_latency_add(ctx, FAULT_LATENCY_THP, ns[j]);
+	}
+	(void)munmap(map, map_size);
+#else
+	stress_fault_latency_skip(ctx, FAULT_LATENCY_THP, "MADV_HUGEPAGE is not available");
+#endif
+}
+
+/*
+ *  stress_fault_latency_collapse()
+ *	time MADV_COLLAPSE of transparent huge page sized ranges
+ *	that were faulted in as base pages
+ */
+static void stress_fault_latency_collapse(stress_fault_latency_t *ctx)
+{
+#if defined(MADV_COLLAPSE) &&		\
+    defined(MADV_HUGEPAGE) &&		\
+    defined(MADV_NOHUGEPAGE)
+	const size_t n = STRESS_MINIMUM(STRESS_MAXIMUM(ctx->size / ctx->thp_size, (size_t)2),
+					(size_t)FAULT_LATENCY_THP_MAX);
+	uint8_t *buf;
+	void *map;
+	size_t map_size, i;
+
+	buf = stress_fault_latency_thp_mmap(ctx, n, &map, &map_size);
+	if (!buf)
+		return;
+	/* fault in base pages and then allow them to be collapsed */
+	(void)madvise((void *)buf, n * ctx->thp_size, MADV_NOHUGEPAGE);
+	stress_mmap_set_light(buf, n * ctx->thp_size, ctx->page_size);
+	(void)madvise((void *)buf, n * ctx->thp_size, MADV_HUGEPAGE);
+
+	for (i = 0; (i < n) && stress_continue_flag(); i++) {
+		const uint64_t t = stress_latency_now();
+
+		if (madvise((void *)(buf + (i * ctx->thp_size)), ctx->thp_size, MADV_COLLAPSE) < 0) {
+			if ((errno == EINVAL) || (errno == ENOSYS) || (errno == EPERM))
+				stress_fault_latency_skip(ctx, FAULT_LATENCY_COLLAPSE,
+					"MADV_COLLAPSE is not supported");
+			break;
+		}
+		stress_fault_latency_add(ctx, FAULT_LATENCY_COLLAPSE, stress_latency_now() - t);
+	}
+	(void)munmap(map, map_size);
+#else
+	stress_fault_latency_skip(ctx, FAULT_LATENCY_COLLAPSE, "MADV_COLLAPSE is not available");
+#endif
+}
+
+#if defined(HAVE_FAULT_LATENCY_UFFD)
+/*
+ *  stress_fault_latency_uffd_handler()
+ *	resolve missing page faults by copying in a page
+ */
+static void *stress_fault_latency_uffd_handler(void *arg)
+{
+	static void *nowt = NULL;
+	stress_fault_latency_uffd_t *uffd = (stress_fault_latency_uffd_t *)arg;
+
+	while (uffd->handling) {
+		struct pollfd fds;
+		struct uffd_msg msg;
+		struct uffdio_copy copy;
+
+		fds.fd = uffd->fd;
+		fds.events = POLLIN;
+		fds.revents = 0;
+		if (poll(&fds, 1, 10) <= 0)
+			continue;
+		if (read(uffd->fd, &msg, sizeof(msg)) != (ssize_t)sizeof(msg))
+			continue;
+		if (msg.event != UFFD_EVENT_PAGEFAULT)
+			continue;
+
+		copy.dst = (uintptr_t)msg.arg.pagefault.address & ~(uintptr_t)(uffd->page_size - 1);
+		copy.src = (uintptr_t)uffd->page;
+		copy.len = uffd->page_size;
+		copy.mode = 0;
+		copy.copy = 0;
+		if ((ioctl(uffd->fd, UFFDIO_COPY, &copy) < 0) && (errno != EEXIST)) {
+			uffd->failed = true;
+			break;
+		}
+	}
+	return &nowt;
+}
+
+/*
+ *  stress_fault_latency_uffd_open()
+ *	open a userfaultfd, fall back to user mode only faults if
+ *	unprivileged userfaultfd is not allowed
+ */
+static int stress_fault_latency_uffd_open(void)
+{
+	struct uffdio_api api;
+	int fd;
+
+	fd = shim_userfaultfd(O_CLOEXEC | O_NONBLOCK);
+	if ((fd < 0) && (errno == EPERM))
+		fd = shim_userfaultfd(O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+	if (fd < 0)
+		return -1;
+
+	(void)shim_memset(&api, 0, sizeof(api));
+	api.api = UFFD_API;
+	if (ioctl(fd, UFFDIO_API, &api) < 0) {
+		(void)close(fd);
+		return -1;
+	}
+	return fd;
+}
+#endif
+
+/*
+ *  stress_fault_latency_uffd()
+ *	time the round trip of missing page faults that are
+ *	resolved by a userfaultfd handler thread
+ */
+static void stress_fault_latency_uffd(stress_fault_latency_t *ctx)
+{
+#if defined(HAVE_FAULT_LATENCY_UFFD)
+	stress_fault_latency_uffd_t uffd;
+	struct uffdio_register reg;
+	pthread_t pthread;
+	uint8_t *buf, *ptr;
+	const uint8_t *end;
+	int ret;
+
+	uffd.fd = stress_fault_latency_uffd_open();
+	if (uffd.fd < 0) {
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_UFFD,
+			"userfaultfd is not available or not permitted");
+		return;
+	}
+	uffd.page_size = ctx->page_size;
+	uffd.handling = true;
+	uffd.failed = false;
+	uffd.page = (uint8_t *)mmap(NULL, ctx->page_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (uffd.page == MAP_FAILED)
+		goto close_fd;
+	(void)shim_memset(uffd.page, 0xa5, ctx->page_size);
+
+	buf = (uint8_t *)mmap(NULL, ctx->size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED)
+		goto unmap_page;
+
+	(void)shim_memset(&reg, 0, sizeof(reg));
+	reg.range.start = (uintptr_t)buf;
+	reg.range.len = ctx->size;
+	reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+	if (ioctl(uffd.fd, UFFDIO_REGISTER, &reg) < 0) {
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_UFFD,
+			"userfaultfd cannot register missing page faults");
+		goto unmap_buf;
+	}
+
+	ret = pthread_create(&pthread, NULL, stress_fault_latency_uffd_handler, (void *)&uffd);
+	if (ret) {
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_UFFD,
+			"cannot create the fault handler thread");
+		goto unmap_buf;
+	}
+
+	end = buf + ctx->size;
+	for (ptr = buf; (ptr < end) && !uffd.failed && stress_continue_flag(); ptr += ctx->page_size)
+		stress_fault_latency_add(ctx, FAULT_LATENCY_UFFD,
+			stress_fault_latency_read(ptr));
+
+	uffd.handling = false;
+	(void)pthread_join(pthread, NULL);
+	if (uffd.failed)
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_UFFD,
+			"UFFDIO_COPY failed");
+
+unmap_buf:
+	(void)munmap((void *)buf, ctx->size);
+unmap_page:
+	(void)munmap((void *)uffd.page, ctx->page_size);
+close_fd:
+	(void)close(uffd.fd);
+#else
+	stress_fault_latency_skip(ctx, FAULT_LATENCY_UFFD, "userfaultfd is not available");
+#endif
+}
+
+/*
+ *  stress_fault_latency_report()
+ *	log the latency percentiles of each kind of fault, the
+ *	mean, median and 99th percentile are added to the metrics
+ */
+static void stress_fault_latency_report(stress_fault_latency_t *ctx)
+{
+	stress_args_t *args = ctx->args;
+	size_t idx = 0;
+	int i;
+
+	if (args->instance == 0)
+		pr_inf("%s: %12s %10s %10s %10s %10s %10s %10s\n", args->name,
+			"fault", "samples", "mean (ns)", "p50 (ns)", "p99 (ns)",
+			"p99.9 (ns)", "max (ns)");
+
+	for (i = 0; i < FAULT_LATENCY_KINDS; i++) {
+		const stress_latency_t *lat = &ctx->lat[i];
+		const uint64_t p50 = stress_latency_percentile(lat, 50.0);
+		const uint64_t p99 = stress_latency_percentile(lat, 99.0);
+		double mean;
+		char tmp[64];
+
+		if (!lat->count)
+			continue;
+		mean = lat->total_ns / (double)lat->count;
+		if (args->instance == 0)
+			pr_inf("%s: %12s %10" PRIu64 " %10.1f %10" PRIu64 " %10" PRIu64
+				" %10" PRIu64 " %10" PRIu64 "\n", args->name,
+				fault_latency_kinds[i], lat->count, mean, p50, p99,
+				stress_latency_percentile(lat, 99.9), lat->max_ns);
+
+		(void)snprintf(tmp, sizeof(tmp), "%s fault mean latency (ns)", fault_latency_kinds[i]);
+		stress_metrics_set(args, idx++, tmp, mean, STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%s fault p50 latency (ns)", fault_latency_kinds[i]);
+		stress_metrics_set(args, idx++, tmp, (double)p50, STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%s fault p99 latency (ns)", fault_latency_kinds[i]);
+		stress_metrics_set(args, idx++, tmp, (double)p99, STRESS_GEOMETRIC_MEAN);
+	}
+}
+
+/*
+ *  stress_fault_latency()
+ *	measure the latency of individual page faults
+ */
+static int stress_fault_latency(stress_args_t *args)
+{
+	stress_fault_latency_t *ctx;
+	size_t fault_latency_bytes = DEFAULT_FAULT_LATENCY_BYTES;
+	int i, ret;
+
+	(void)stress_get_setting("fault-latency-bytes", &fault_latency_bytes);
+
+	ctx = (stress_fault_latency_t *)calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		pr_inf_skip("%s: cannot allocate latency histograms, skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+	}
+	ctx->args = args;
+	ctx->page_size = args->page_size;
+	ctx->thp_size = stress_mmap_thp_size();
+	ctx->size = fault_latency_bytes & ~(args->page_size - 1);
+	ctx->fd = -1;
+	for (i = 0; i < FAULT_LATENCY_KINDS; i++)
+		stress_latency_init(&ctx->lat[i]);
+
+	ret = stress_temp_dir_mk_args(args);
+	if (ret < 0) {
+		free(ctx);
+		return stress_exit_status(-ret);
+	}
+	if (!stress_fault_latency_file_create(ctx)) {
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_MINOR, "the file cannot be created");
+		stress_fault_latency_skip(ctx, FAULT_LATENCY_MAJOR, "the file cannot be created");
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	do {
+		if (!ctx->skip[FAULT_LATENCY_ANON])
+			stress_fault_latency_anon(ctx);
+		if (!ctx->skip[FAULT_LATENCY_MINOR])
+			stress_fault_latency_minor(ctx);
+		if (!ctx->skip[FAULT_LATENCY_MAJOR])
+			stress_fault_latency_major(ctx);
+		if (!ctx->skip[FAULT_LATENCY_THP])
+			stress_fault_latency_thp(ctx);
+		if (!ctx->skip[FAULT_LATENCY_COLLAPSE])
+			stress_fault_latency_collapse(ctx);
+		if (!ctx->skip[FAULT_LATENCY_UFFD])
+			stress_fault_latency_uffd(ctx);
+		stress_bogo_inc(args);
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_fault_latency_report(ctx);
+
+	if (ctx->fd >= 0)
+		(void)close(ctx->fd);
+	(void)stress_temp_dir_rm_args(args);
+	free(ctx);
+
+	return EXIT_SUCCESS;
+}
+
+static const stress_opt_set_func_t opt_set_funcs[] = {
+	{ OPT_fault_latency_bytes,	stress_set_fault_latency_bytes },
+	{ 0,				NULL }
+};
+
+stressor_info_t stress_fault_latency_info = {
+	.stressor = stress_fault_latency,
+	.class = CLASS_VM | CLASS_OS,
+	.opt_set_funcs = opt_set_funcs,
+	.help = help
+};
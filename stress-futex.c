@@ -20,6 +20,7 @@
 #include "stress-ng.h"
 #include "core-affinity.h"
 #include "core-builtin.h"
+#include "core-latency.h"
 
 #if defined(HAVE_LINUX_FUTEX_H)
 #include <linux/futex.h>
@@ -135,11 +136,13 @@ again:
 		/* send alarm to waiter process */
 		(void)shim_kill(pid, SIGALRM);
 		(void)shim_waitpid(pid, &status, 0);
+		stress_latency_metrics(args, 0);
 
 		pr_dbg("%s: futex timeouts: %" PRIu64 "\n",
 			args->name, *timeout);
 	} else {
 		uint64_t threshold = THRESHOLD;
+		const bool latency = stress_latency_enabled();
 
 		(void)stress_change_cpu(args, parent_cpu);
 		stress_parent_died_alarm();
@@ -148,11 +151,14 @@ again:
 		do {
 			/* Small timeout to force rapid timer wakeups */
 			int ret;
+			uint64_t t = 0;
 
 			/* Break early before potential long wait */
 			if (!stress_continue_flag())
 				break;
 
+			if (latency)
+				t = stress_latency_now();
 			ret = stress_futex_wait(futex, 0, 5000);
 
 			/* timeout, re-do, stress on stupid fast polling */
@@ -174,6 +180,8 @@ again:
 						rc = EXIT_FAILURE;
 					}
 				}
+				if (latency)
+					stress_latency_record(args, stress_latency_now() - t);
 				stress_bogo_inc(args);
 			}
 		} while (stress_continue(args));
@@ -20,6 +20,9 @@
 #include "stress-ng.h"
 #include "core-attribute.h"
 #include "core-builtin.h"
+#include "core-io-engine.h"
+#include "core-latency.h"
+#include "core-mincore.h"
 #include "core-pragma.h"
 #include "core-target-clones.h"
 
@@ -72,6 +75,19 @@
 #define HDD_OPT_FDATASYNC	(0x00800000)
 #define HDD_OPT_SYNCFS		(0x01000000)
 
+/* job mode */
+#define HDD_JOB_BS_MAX		(16)		/* max block sizes in --hdd-bs */
+#define HDD_JOB_DEPTH_DEFAULT	(16)
+#define HDD_JOB_DEPTH_MAX	(256)
+#define HDD_JOB_RWMIX_DEFAULT	(50)
+#define HDD_JOB_ZIPF_MAX_TERMS	(10000000)	/* cap zipf zeta(n) summation */
+
+#define HDD_CACHE_SAMPLE	(64)		/* sample page cache every 64th read */
+
+#define HDD_DIST_UNIFORM	(0)
+#define HDD_DIST_ZIPF		(1)
+#define HDD_DIST_PARETO		(2)
+
 typedef struct {
 	const char *opt;	/* User option */
 	const int flag;		/* HDD_OPT_ flag */
@@ -80,11 +96,49 @@ typedef struct {
 	const int oflag;	/* open O_* flags */
 } stress_hdd_opts_t;
 
+/*
+ *  job mode weighted block size
+ */
+typedef struct {
+	uint64_t size;		/* block size in bytes */
+	uint32_t weight;	/* relative weight */
+} stress_hdd_bs_t;
+
+/*
+ *  job mode block size mix, from --hdd-bs
+ */
+typedef struct {
+	stress_hdd_bs_t bs[HDD_JOB_BS_MAX];
+	size_t n;		/* number of block sizes */
+	uint32_t total;		/* sum of weights */
+	uint64_t min_size;	/* smallest block size */
+	uint64_t max_size;	/* largest block size */
+} stress_hdd_bs_mix_t;
+
+/*
+ *  job mode offset distribution, from --hdd-dist
+ */
+typedef struct {
+	int type;		/* HDD_DIST_* */
+	double param;		/* zipf theta or pareto h */
+	uint64_t n;		/* number of offsets */
+	uint64_t rand_off;	/* offset of the hot spot */
+	double zetan;		/* zipf zeta(n, theta) */
+	double zeta2;		/* zipf zeta(2, theta) */
+	double pareto_pow;	/* pareto exponent */
+} stress_hdd_dist_t;
+
 static const stress_help_t help[] = {
 	{ "d N","hdd N",		"start N workers spinning on write()/unlink()" },
+	{ NULL,	"hdd-bs list",		"job mode weighted block sizes, e.g. 4k:50,64k:30,128k:20" },
 	{ NULL,	"hdd-bytes N",		"write N bytes per hdd worker (default is 1GB)" },
+	{ NULL,	"hdd-dist D",		"job mode offsets: uniform, zipf[:theta] or pareto[:h]" },
+	{ NULL,	"hdd-iodepth N",	"job mode requests in flight for async I/O engines" },
+	{ NULL,	"hdd-iops N",		"job mode rate limit of N I/Os per second" },
+	{ NULL,	"hdd-job",		"run a read/write mix job through the --io-engine" },
 	{ NULL,	"hdd-ops N",		"stop after N hdd bogo operations" },
 	{ NULL,	"hdd-opts list",	"specify list of various stressor options" },
+	{ NULL,	"hdd-rwmix N",		"job mode percentage of I/Os that are reads" },
 	{ NULL,	"hdd-write-size N",	"set the default write size to N bytes" },
 	{ NULL, NULL,			NULL }
 };
@@ -179,6 +233,145 @@ static int stress_set_hdd_write_size(const char *opt)
 	return stress_set_setting("hdd-write-size", TYPE_ID_UINT64, &hdd_write_size);
 }
 
+/*
+ *  stress_hdd_bs_parse()
+ *	parse a size[:weight],... block size mix, returns 0 if valid
+ */
+static int stress_hdd_bs_parse(const char *opt, stress_hdd_bs_mix_t *mix)
+{
+	char *str, *ptr, *token;
+
+	(void)shim_memset(mix, 0, sizeof(*mix));
+	str = stress_const_optdup(opt);
+	if (!str)
+		return -1;
+
+	for (ptr = str; (token = strtok(ptr, ",")) != NULL; ptr = NULL) {
+		char *colon = strchr(token, ':');
+		stress_hdd_bs_t *bs = &mix->bs[mix->n];
+
+		if (mix->n >= HDD_JOB_BS_MAX) {
+			(void)fprintf(stderr, "hdd-bs allows no more than %d block sizes\n",
+				HDD_JOB_BS_MAX);
+			free(str);
+			return -1;
+		}
+		bs->weight = 1;
+		if (colon) {
+			*colon = '\0';
+			bs->weight = stress_get_uint32(colon + 1);
+		}
+		bs->size = stress_get_uint64_byte(token);
+		if ((bs->size < 512) || (bs->size > MAX_HDD_WRITE_SIZE) || (bs->size & 511)) {
+			(void)fprintf(stderr, "hdd-bs block size '%s' must be a multiple of "
+				"512 bytes from 512 bytes to 4MB\n", token);
+			free(str);
+			return -1;
+		}
+		if (bs->weight == 0)
+			continue;
+		if ((mix->n == 0) || (bs->size < mix->min_size))
+			mix->min_size = bs->size;
+		if (bs->size > mix->max_size)
+			mix->max_size = bs->size;
+		mix->total += bs->weight;
+		mix->n++;
+	}
+	free(str);
+	if (mix->n == 0) {
+		(void)fprintf(stderr, "hdd-bs requires at least one block size with a non-zero weight\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int stress_set_hdd_bs(const char *opt)
+{
+	stress_hdd_bs_mix_t mix;
+
+	if (stress_hdd_bs_parse(opt, &mix) < 0)
+		return -1;
+	return stress_set_setting("hdd-bs", TYPE_ID_STR, opt);
+}
+
+/*
+ *  stress_hdd_dist_parse()
+ *	parse uniform, zipf[:theta] or pareto[:h], returns 0 if valid
+ */
+static int stress_hdd_dist_parse(const char *opt, stress_hdd_dist_t *dist)
+{
+	const char *colon = strchr(opt, ':');
+	const size_t len = colon ? (size_t)(colon - opt) : strlen(opt);
+
+	(void)shim_memset(dist, 0, sizeof(*dist));
+	if ((len == 7) && !strncmp(opt, "uniform", len)) {
+		dist->type = HDD_DIST_UNIFORM;
+		if (!colon)
+			return 0;
+	} else if ((len == 4) && !strncmp(opt, "zipf", len)) {
+		dist->type = HDD_DIST_ZIPF;
+		dist->param = 1.2;
+		if (colon)
+			dist->param = atof(colon + 1);
+		if ((dist->param > 0.0) && (dist->param != 1.0))
+			return 0;
+		(void)fprintf(stderr, "hdd-dist zipf theta must be greater than 0.0 and not 1.0\n");
+		return -1;
+	} else if ((len == 6) && !strncmp(opt, "pareto", len)) {
+		dist->type = HDD_DIST_PARETO;
+		dist->param = 0.2;
+		if (colon)
+			dist->param = atof(colon + 1);
+		if ((dist->param > 0.0) && (dist->param < 1.0))
+			return 0;
+		(void)fprintf(stderr, "hdd-dist pareto h must be between 0.0 and 1.0\n");
+		return -1;
+	}
+	(void)fprintf(stderr, "invalid hdd-dist '%s', allowed distributions are: "
+		"uniform zipf[:theta] pareto[:h]\n", opt);
+	return -1;
+}
+
+static int stress_set_hdd_dist(const char *opt)
+{
+	stress_hdd_dist_t dist;
+
+	if (stress_hdd_dist_parse(opt, &dist) < 0)
+		return -1;
+	return stress_set_setting("hdd-dist", TYPE_ID_STR, opt);
+}
+
+static int stress_set_hdd_iodepth(const char *opt)
+{
+	uint32_t hdd_iodepth;
+
+	hdd_iodepth = stress_get_uint32(opt);
+	stress_check_range("hdd-iodepth", (uint64_t)hdd_iodepth, 1, HDD_JOB_DEPTH_MAX);
+	return stress_set_setting("hdd-iodepth", TYPE_ID_UINT32, &hdd_iodepth);
+}
+
+static int stress_set_hdd_iops(const char *opt)
+{
+	uint64_t hdd_iops;
+
+	hdd_iops = stress_get_uint64(opt);
+	return stress_set_setting("hdd-iops", TYPE_ID_UINT64, &hdd_iops);
+}
+
+static int stress_set_hdd_job(const char *opt)
+{
+	return stress_set_setting_true("hdd-job", opt);
+}
+
+static int stress_set_hdd_rwmix(const char *opt)
+{
+	uint32_t hdd_rwmix;
+
+	hdd_rwmix = stress_get_uint32(opt);
+	stress_check_range("hdd-rwmix", (uint64_t)hdd_rwmix, 0, 100);
+	return stress_set_setting("hdd-rwmix", TYPE_ID_UINT32, &hdd_rwmix);
+}
+
 #if defined(HAVE_FUTIMES)
 static void stress_hdd_utimes(const int fd)
 {
@@ -657,6 +850,518 @@ static void OPTIMIZE3 TARGET_CLONES hdd_fill_buf(
 	}
 }
 
+/*
+ *  stress_hdd_rnd_double()
+ *	uniformly distributed random double in the range [0.0, 1.0)
+ */
+static inline double stress_hdd_rnd_double(void)
+{
+	return (double)(stress_mwc64() >> 11) / 9007199254740992.0;	/* 2^53 */
+}
+
+/*
+ *  stress_hdd_dist_init()
+ *	set up an offset distribution over n offsets, the zipf
+ *	and pareto hot spots start at a random offset
+ */
+static void stress_hdd_dist_init(stress_hdd_dist_t *dist, const uint64_t n)
+{
+	dist->n = n;
+	dist->rand_off = stress_mwc64modn(n);
+
+	switch (dist->type) {
+	case HDD_DIST_ZIPF:
+		{
+			const uint64_t terms = STRESS_MINIMUM(n, HDD_JOB_ZIPF_MAX_TERMS);
+			uint64_t i;
+
+			dist->zetan = 0.0;
+			for (i = 1; i <= terms; i++)
+				dist->zetan += 1.0 / pow((double)i, dist->param);
+			dist->zeta2 = 1.0 + 1.0 / pow(2.0, dist->param);
+		}
+		break;
+	case HDD_DIST_PARETO:
+		dist->pareto_pow = log(dist->param) / log(1.0 - dist->param);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ *  stress_hdd_dist_next()
+ *	next offset index, zipf uses the Gray et al. quick zipf
+ *	generator and pareto the inverse power method
+ */
+static uint64_t stress_hdd_dist_next(const stress_hdd_dist_t *dist)
+{
+	const double n = (double)dist->n;
+	double u;
+	uint64_t val;
+
+	switch (dist->type) {
+	case HDD_DIST_ZIPF:
+		{
+			const double theta = dist->param;
+			const double alpha = 1.0 / (1.0 - theta);
+			const double eta = (1.0 - pow(2.0 / n, 1.0 - theta)) /
+					   (1.0 - dist->zeta2 / dist->zetan);
+			double uz;
+
+			u = stress_hdd_rnd_double();
+			uz = u * dist->zetan;
+			if (uz < 1.0)
+				val = 0;
+			else if (uz < 1.0 + pow(0.5, theta))
+				val = 1;
+			else
+				val = (uint64_t)(n * pow(eta * u - eta + 1.0, alpha));
+		}
+		break;
+	case HDD_DIST_PARETO:
+		u = stress_hdd_rnd_double();
+		val = (uint64_t)(n * pow(u, dist->pareto_pow));
+		break;
+	default:
+		return stress_mwc64modn(dist->n);
+	}
+	return (val + dist->rand_off) % dist->n;
+}
+
+/*
+ *  stress_hdd_bs_next()
+ *	pick a block size by weight
+ */
+static uint64_t stress_hdd_bs_next(const stress_hdd_bs_mix_t *mix)
+{
+	uint32_t r = stress_mwc32modn(mix->total);
+	size_t i;
+
+	for (i = 0; i < mix->n - 1; i++) {
+		if (r < mix->bs[i].weight)
+			break;
+		r -= mix->bs[i].weight;
+	}
+	return mix->bs[i].size;
+}
+
+/*
+ *  page cache statistics, reads are sampled for page cache
+ *  hits and misses, writeback is measured over the write phases
+ */
+typedef struct {
+	uint64_t reads;		/* reads seen, for sampling */
+	uint64_t hits;		/* sampled reads with all pages in the page cache */
+	uint64_t misses;	/* sampled reads with pages not in the page cache */
+	uint64_t written;	/* pages written back during the write phases */
+	double wb_duration;	/* duration of the measured write phases */
+} stress_hdd_cache_t;
+
+/*
+ *  stress_hdd_cache_read()
+ *	sample if the data about to be read is in the page cache
+ */
+static void stress_hdd_cache_read(
+	const int fd,
+	const uint64_t offset,
+	const size_t size,
+	stress_hdd_cache_t *cache)
+{
+	stress_page_cache_stat_t pcstat;
+
+	if ((cache->reads++ % HDD_CACHE_SAMPLE) != 0)
+		return;
+	if (stress_page_cache_stat(fd, (off_t)offset, (off_t)size, &pcstat) < 0)
+		return;
+	if (pcstat.cached >= pcstat.pages)
+		cache->hits++;
+	else
+		cache->misses++;
+}
+
+/*
+ *  stress_hdd_cache_writeback()
+ *	the file is truncated before it is written, so at the end
+ *	of the write phase all the pages in the page cache have been
+ *	dirtied and the clean or evicted pages have been written back
+ */
+static void stress_hdd_cache_writeback(
+	const int fd,
+	const off_t size,
+	const double duration,
+	stress_hdd_cache_t *cache)
+{
+	stress_page_cache_stat_t pcstat;
+	uint64_t clean;
+
+	if (size <= 0)
+		return;
+	if (stress_page_cache_stat(fd, 0, size, &pcstat) < 0)
+		return;
+	/* dirty and writeback page counts need cachestat() */
+	if (!pcstat.cachestat)
+		return;
+	clean = pcstat.cached + pcstat.evicted;
+	clean = (clean > pcstat.dirty + pcstat.writeback) ?
+		clean - (pcstat.dirty + pcstat.writeback) : 0;
+	cache->written += clean;
+	cache->wb_duration += duration;
+}
+
+/*
+ *  stress_hdd_cache_metrics()
+ *	add page cache hit and writeback metrics from index idx
+ */
+static void stress_hdd_cache_metrics(
+	stress_args_t *args,
+	const stress_hdd_cache_t *cache,
+	const size_t idx)
+{
+	const uint64_t samples = cache->hits + cache->misses;
+	double rate;
+
+	if (samples > 0) {
+		rate = 100.0 * (double)cache->hits / (double)samples;
+		stress_metrics_set(args, idx, "% page cache hits on sampled reads",
+			rate, STRESS_GEOMETRIC_MEAN);
+	}
+	if (cache->wb_duration > 0.0) {
+		rate = ((double)cache->written * (double)args->page_size) /
+			cache->wb_duration;
+		stress_metrics_set(args, idx + 1, "MB/sec dirty page writeback",
+			rate / (double)MB, STRESS_HARMONIC_MEAN);
+	}
+}
+
+/*
+ *  job mode per direction statistics
+ */
+typedef struct {
+	uint64_t ios;		/* completed I/Os */
+	uint64_t bytes;		/* bytes transferred */
+	stress_latency_t lat;	/* submit to completion latency */
+} stress_hdd_job_stats_t;
+
+/*
+ *  stress_hdd_job_layout()
+ *	write out the whole file so reads hit allocated blocks
+ */
+static int stress_hdd_job_layout(
+	stress_args_t *args,
+	const int fd,
+	const uint64_t file_size)
+{
+	const size_t chunk = MB;
+	uint64_t offset;
+	uint8_t *buf;
+	int rc = EXIT_SUCCESS;
+
+#if defined(HAVE_POSIX_MEMALIGN)
+	if (posix_memalign((void **)&buf, BUF_ALIGNMENT, chunk) || !buf) {
+		pr_inf_skip("%s: cannot allocate layout buffer, skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+	}
+#else
+	buf = NULL;
+	pr_inf_skip("%s: job mode requires posix_memalign, skipping stressor\n", args->name);
+	return EXIT_NOT_IMPLEMENTED;
+#endif
+	stress_rndbuf(buf, chunk);
+
+	for (offset = 0; (offset < file_size) && stress_continue_flag(); offset += chunk) {
+		const size_t sz = (size_t)STRESS_MINIMUM((uint64_t)chunk, file_size - offset);
+
+		if (pwrite(fd, buf, sz, (off_t)offset) != (ssize_t)sz) {
+			if ((errno == ENOSPC) || (errno == EDQUOT)) {
+				pr_inf_skip("%s: out of space laying out %" PRIu64
+					"MB job file, skipping stressor\n",
+					args->name, (uint64_t)(file_size / MB));
+				rc = EXIT_NO_RESOURCE;
+			} else {
+				pr_fail("%s: write failed laying out job file, errno=%d (%s)\n",
+					args->name, errno, strerror(errno));
+				rc = EXIT_FAILURE;
+			}
+			break;
+		}
+	}
+	free(buf);
+	return rc;
+}
+
+/*
+ *  stress_hdd_job_report()
+ *	report per direction IOPS, MB/s and latency percentiles
+ */
+static void stress_hdd_job_report(
+	stress_args_t *args,
+	const stress_hdd_job_stats_t stats[2],
+	const stress_hdd_cache_t *cache,
+	const double duration)
+{
+	static const char * const dir_names[2] = { "read", "write" };
+	size_t i, idx = 0;
+
+	for (i = 0; i < 2; i++) {
+		const stress_hdd_job_stats_t *st = &stats[i];
+		const double iops = (duration > 0.0) ? (double)st->ios / duration : 0.0;
+		const double mb_rate = (duration > 0.0) ? ((double)st->bytes / duration) / (double)MB : 0.0;
+		const double p50 = (double)stress_latency_percentile(&st->lat, 50.0) / 1000.0;
+		const double p99 = (double)stress_latency_percentile(&st->lat, 99.0) / 1000.0;
+		const double p999 = (double)stress_latency_percentile(&st->lat, 99.9) / 1000.0;
+		char tmp[64];
+
+		if (st->ios == 0)
+			continue;
+		if (args->instance == 0)
+			pr_inf("%s: %-5s %10.0f IOPS %10.2f MB/s, latency p50 %.2f, "
+				"p99 %.2f, p99.9 %.2f usecs\n", args->name,
+				dir_names[i], iops, mb_rate, p50, p99, p999);
+
+		(void)snprintf(tmp, sizeof(tmp), "%s IOPS", dir_names[i]);
+		stress_metrics_set(args, idx++, tmp, iops, STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%s MB per sec", dir_names[i]);
+		stress_metrics_set(args, idx++, tmp, mb_rate, STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%s usec p50 latency", dir_names[i]);
+		stress_metrics_set(args, idx++, tmp, p50, STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%s usec p99 latency", dir_names[i]);
+		stress_metrics_set(args, idx++, tmp, p99, STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%s usec p99.9 latency", dir_names[i]);
+		stress_metrics_set(args, idx++, tmp, p999, STRESS_GEOMETRIC_MEAN);
+	}
+	stress_hdd_cache_metrics(args, cache, idx);
+}
+
+/*
+ *  stress_hdd_job()
+ *	fio style job, keep up to iodepth reads and writes in flight
+ *	through the --io-engine back-end with a read/write mix,
+ *	weighted block sizes and an offset distribution, optionally
+ *	rate limited, and report IOPS, MB/s and latency percentiles
+ */
+static int stress_hdd_job(
+	stress_args_t *args,
+	const uint64_t hdd_bytes,
+	const int hdd_oflags)
+{
+	stress_hdd_bs_mix_t mix;
+	stress_hdd_dist_t dist;
+	stress_io_engine_t engine;
+	stress_hdd_job_stats_t stats[2];
+	stress_hdd_cache_t cache;
+	stress_io_req_t *reqs, **submit, **done;
+	uint32_t *free_slots, n_free, i;
+	uint32_t hdd_rwmix = HDD_JOB_RWMIX_DEFAULT;
+	uint32_t hdd_iodepth = HDD_JOB_DEPTH_DEFAULT;
+	uint64_t hdd_iops = 0, align, file_size, issued = 0;
+	char *hdd_bs = NULL, *hdd_dist = NULL;
+	char filename[PATH_MAX];
+	uint8_t *bufs = NULL;
+	int fd, ret, rc = EXIT_SUCCESS;
+	double t_start, duration;
+
+	(void)stress_get_setting("hdd-bs", &hdd_bs);
+	(void)stress_get_setting("hdd-dist", &hdd_dist);
+	(void)stress_get_setting("hdd-iodepth", &hdd_iodepth);
+	(void)stress_get_setting("hdd-iops", &hdd_iops);
+	(void)stress_get_setting("hdd-rwmix", &hdd_rwmix);
+
+	/* options have been validated when they were set */
+	if (stress_hdd_bs_parse(hdd_bs ? hdd_bs : "4k", &mix) < 0)
+		return EXIT_FAILURE;
+	if (stress_hdd_dist_parse(hdd_dist ? hdd_dist : "uniform", &dist) < 0)
+		return EXIT_FAILURE;
+
+	/* offsets are aligned to 4K, or 512 bytes if smaller blocks are used */
+	align = (mix.min_size & (BUF_ALIGNMENT - 1)) ? 512 : BUF_ALIGNMENT;
+	file_size = hdd_bytes & ~(align - 1);
+	if (file_size < mix.max_size) {
+		file_size = (mix.max_size + align - 1) & ~(align - 1);
+		pr_inf("%s: increasing file size to largest block size of %"
+			PRIu64 " bytes\n", args->name, file_size);
+	}
+	stress_hdd_dist_init(&dist, ((file_size - mix.max_size) / align) + 1);
+	(void)shim_memset(stats, 0, sizeof(stats));
+	(void)shim_memset(&cache, 0, sizeof(cache));
+	stress_latency_init(&stats[0].lat);
+	stress_latency_init(&stats[1].lat);
+
+	reqs = (stress_io_req_t *)calloc((size_t)hdd_iodepth, sizeof(*reqs));
+	submit = (stress_io_req_t **)calloc((size_t)hdd_iodepth, sizeof(*submit));
+	done = (stress_io_req_t **)calloc((size_t)hdd_iodepth, sizeof(*done));
+	free_slots = (uint32_t *)calloc((size_t)hdd_iodepth, sizeof(*free_slots));
+	if (!reqs || !submit || !done || !free_slots) {
+		pr_inf_skip("%s: cannot allocate %" PRIu32 " I/O requests, "
+			"skipping stressor\n", args->name, hdd_iodepth);
+		rc = EXIT_NO_RESOURCE;
+		goto free_reqs;
+	}
+#if defined(HAVE_POSIX_MEMALIGN)
+	if (posix_memalign((void **)&bufs, BUF_ALIGNMENT, (size_t)(hdd_iodepth * mix.max_size)) || !bufs) {
+		bufs = NULL;
+		pr_inf_skip("%s: cannot allocate %" PRIu32 " I/O buffers of %" PRIu64
+			" bytes, skipping stressor\n", args->name, hdd_iodepth, mix.max_size);
+		rc = EXIT_NO_RESOURCE;
+		goto free_reqs;
+	}
+#else
+	pr_inf_skip("%s: job mode requires posix_memalign, skipping stressor\n", args->name);
+	rc = EXIT_NOT_IMPLEMENTED;
+	goto free_reqs;
+#endif
+	stress_rndbuf(bufs, (size_t)(hdd_iodepth * mix.max_size));
+	for (i = 0; i < hdd_iodepth; i++) {
+		reqs[i].buf = bufs + (i * mix.max_size);
+		reqs[i].slot = i;
+		free_slots[i] = i;
+	}
+
+	ret = stress_temp_dir_mk_args(args);
+	if (ret < 0) {
+		rc = stress_exit_status(-ret);
+		goto free_reqs;
+	}
+	(void)stress_temp_filename_args(args,
+		filename, sizeof(filename), stress_mwc32());
+	fd = open(filename, O_CREAT | O_RDWR | O_TRUNC | hdd_oflags, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		rc = stress_exit_status(errno);
+		pr_fail("%s: open on %s failed, errno=%d (%s)\n",
+			args->name, filename, errno, strerror(errno));
+		goto rm_dir;
+	}
+	(void)shim_unlink(filename);
+
+	rc = stress_hdd_job_layout(args, fd, file_size);
+	if (rc != EXIT_SUCCESS)
+		goto close_fd;
+	rc = stress_io_engine_open(args, &engine, fd, hdd_iodepth);
+	if (rc != EXIT_SUCCESS)
+		goto close_fd;
+	/* synchronous engines lower the depth to 1 */
+	n_free = engine.depth;
+
+	if (args->instance == 0)
+		pr_inf("%s: %s engine, %" PRIu32 "%% reads, iodepth %" PRIu32
+			", %s block sizes, %s offsets, %" PRIu64 "MB file\n",
+			args->name, stress_io_engine_name(), hdd_rwmix, engine.depth,
+			hdd_bs ? hdd_bs : "4k", hdd_dist ? hdd_dist : "uniform",
+			(uint64_t)(file_size / MB));
+
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	t_start = stress_time_now();
+	do {
+		uint32_t n = 0, min_reap;
+
+		while (n_free > 0) {
+			stress_io_req_t *req;
+
+			if (hdd_iops) {
+				const double due = t_start + ((double)issued / (double)hdd_iops);
+				const double now = stress_time_now();
+
+				if (now < due) {
+					/* reap what is in flight before sleeping */
+					if ((n > 0) || (engine.inflight > 0))
+						break;
+					(void)shim_nanosleep_uint64((uint64_t)((due - now) * STRESS_DBL_NANOSECOND));
+					if (!stress_continue(args))
+						break;
+				}
+			}
+			req = &reqs[free_slots[--n_free]];
+			req->write = (stress_mwc32modn(100) >= hdd_rwmix);
+			req->size = (size_t)stress_hdd_bs_next(&mix);
+			req->offset = stress_hdd_dist_next(&dist) * align;
+			if (req->offset + req->size > file_size)
+				req->offset = file_size - req->size;
+			if (!req->write)
+				stress_hdd_cache_read(fd, req->offset, req->size, &cache);
+			req->start_ns = stress_latency_now();
+			submit[n++] = req;
+			issued++;
+		}
+
+		ret = stress_io_engine_submit(&engine, submit, n);
+		if (UNLIKELY(ret < 0)) {
+			if ((errno != EAGAIN) && (errno != EINTR)) {
+				pr_fail("%s: %s engine submit failed, errno=%d (%s)\n",
+					args->name, stress_io_engine_name(), errno, strerror(errno));
+				rc = EXIT_FAILURE;
+				break;
+			}
+			ret = 0;
+		}
+		/* put back requests that were not submitted */
+		for (i = (uint32_t)ret; i < n; i++) {
+			free_slots[n_free++] = submit[i]->slot;
+			issued--;
+		}
+
+		/* wait for a completion if no more requests can be issued */
+		min_reap = ((n_free == 0) || (ret == 0)) ? 1 : 0;
+		ret = stress_io_engine_reap(&engine, done, min_reap, engine.depth);
+		if (UNLIKELY(ret < 0)) {
+			if (errno == EINTR)
+				continue;
+			pr_fail("%s: %s engine reap failed, errno=%d (%s)\n",
+				args->name, stress_io_engine_name(), errno, strerror(errno));
+			rc = EXIT_FAILURE;
+			break;
+		}
+		if (ret > 0) {
+			const uint64_t now = stress_latency_now();
+
+			for (i = 0; i < (uint32_t)ret; i++) {
+				stress_io_req_t *req = done[i];
+				stress_hdd_job_stats_t *st = &stats[req->write ? 1 : 0];
+				const uint64_t ns = now - req->start_ns;
+
+				if (UNLIKELY(req->res < 0)) {
+					pr_fail("%s: %s of %zu bytes at offset %" PRIu64
+						" failed, errno=%d (%s)\n", args->name,
+						req->write ? "write" : "read", req->size,
+						req->offset, (int)-req->res, strerror((int)-req->res));
+					rc = EXIT_FAILURE;
+				} else {
+					st->bytes += (uint64_t)req->res;
+				}
+				st->ios++;
+				stress_latency_add(&st->lat, ns);
+				stress_latency_record(args, ns);
+				free_slots[n_free++] = req->slot;
+			}
+			stress_bogo_add(args, (uint64_t)ret);
+		}
+	} while ((rc == EXIT_SUCCESS) && stress_continue(args));
+	duration = stress_time_now() - t_start;
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	stress_hdd_job_report(args, stats, &cache, duration);
+
+	/* drain in-flight requests before the buffers go away */
+	while (engine.inflight > 0) {
+		if ((stress_io_engine_reap(&engine, done, 1, engine.depth) < 0) &&
+		    (errno != EINTR))
+			break;
+	}
+	stress_io_engine_close(&engine);
+close_fd:
+	(void)close(fd);
+rm_dir:
+	(void)stress_temp_dir_rm_args(args);
+free_reqs:
+	free(bufs);
+	free(free_slots);
+	free(done);
+	free(submit);
+	free(reqs);
+
+	return rc;
+}
+
 /*
  *  stress_hdd
  *	stress I/O via writes
@@ -675,11 +1380,12 @@ static int stress_hdd(stress_args_t *args)
 	const uint32_t instance = args->instance;
 	int hdd_flags = 0, hdd_oflags = 0;
 	int flags, fadvise_flags;
-	bool opts_set = false;
+	bool opts_set = false, hdd_job = false;
 	double hdd_read_bytes = 0.0, hdd_read_duration = 0.0;
 	double hdd_write_bytes = 0.0, hdd_write_duration = 0.0;
 	double hdd_rdwr_bytes, hdd_rdwr_duration;
 	double rate;
+	stress_hdd_cache_t cache;
 
 	(void)stress_get_setting("hdd-flags", &hdd_flags);
 	(void)stress_get_setting("hdd-oflags", &hdd_oflags);
@@ -699,6 +1405,10 @@ static int stress_hdd(stress_args_t *args)
 	if (hdd_bytes < MIN_HDD_WRITE_SIZE)
 		hdd_bytes = MIN_HDD_WRITE_SIZE;
 
+	(void)stress_get_setting("hdd-job", &hdd_job);
+	if (hdd_job)
+		return stress_hdd_job(args, hdd_bytes, hdd_oflags);
+
 	if (!stress_get_setting("hdd-write-size", &hdd_write_size)) {
 		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
 			hdd_write_size = MAX_HDD_WRITE_SIZE;
@@ -768,6 +1478,7 @@ static int stress_hdd(stress_args_t *args)
 	buf = (uint8_t *)stress_align_address(alloc_buf, BUF_ALIGNMENT);
 #endif
 	(void)shim_memset(buf, stress_mwc8(), hdd_write_size);
+	(void)shim_memset(&cache, 0, sizeof(cache));
 	(void)stress_temp_filename_args(args,
 		filename, sizeof(filename), stress_mwc32());
 
@@ -778,6 +1489,7 @@ static int stress_hdd(stress_args_t *args)
 		struct stat statbuf;
 		uint64_t hdd_bytes_max = 0;
 		const char *fs_type;
+		double t_write;
 
 		/*
 		 * aggressive option with no other option enables
@@ -857,6 +1569,8 @@ static int stress_hdd(stress_args_t *args)
 		stress_hdd_invalid_write(fd, buf);
 		stress_hdd_invalid_read(fd, buf);
 
+		t_write = stress_time_now();
+
 		/* Random Write */
 		if (hdd_flags & HDD_OPT_WR_RND) {
 			const uint32_t w = stress_mwc32();
@@ -934,6 +1648,12 @@ seq_wr_retry:
 			(void)close(fd);
 			continue;
 		}
+#if defined(O_DIRECT)
+		/* direct I/O bypasses the page cache */
+		if (!(flags & O_DIRECT))
+#endif
+			stress_hdd_cache_writeback(fd, statbuf.st_size,
+				stress_time_now() - t_write, &cache);
 
 		/* Sequential Read */
 		if (hdd_flags & HDD_OPT_RD_SEQ) {
@@ -946,6 +1666,7 @@ seq_rd_retry:
 					(void)close(fd);
 					goto yielded;
 				}
+				stress_hdd_cache_read(fd, i, (size_t)hdd_write_size, &cache);
 				ret = stress_hdd_read(fd, buf, (off_t)i,
 					hdd_write_size, hdd_flags,
 					&hdd_read_bytes, &hdd_read_duration);
@@ -1019,6 +1740,7 @@ rnd_rd_retry:
 					(void)close(fd);
 					goto yielded;
 				}
+				stress_hdd_cache_read(fd, offset, (size_t)hdd_write_size, &cache);
 				ret = stress_hdd_read(fd, buf, (off_t)offset,
 					hdd_write_size, hdd_flags,
 					&hdd_read_bytes, &hdd_read_duration);
@@ -1087,6 +1809,7 @@ finish:
 	rate = (hdd_rdwr_duration > 0.0) ? hdd_rdwr_bytes / hdd_rdwr_duration : 0.0;
 	stress_metrics_set(args, 2, "MB/sec read/write combined rate",
 		rate / (double)MB, STRESS_HARMONIC_MEAN);
+	stress_hdd_cache_metrics(args, &cache, 3);
 
 	free(alloc_buf);
 	(void)stress_temp_dir_rm_args(args);
@@ -1094,8 +1817,14 @@ finish:
 }
 
 static const stress_opt_set_func_t opt_set_funcs[] = {
+	{ OPT_hdd_bs,		stress_set_hdd_bs },
 	{ OPT_hdd_bytes,	stress_set_hdd_bytes },
+	{ OPT_hdd_dist,		stress_set_hdd_dist },
+	{ OPT_hdd_iodepth,	stress_set_hdd_iodepth },
+	{ OPT_hdd_iops,		stress_set_hdd_iops },
+	{ OPT_hdd_job,		stress_set_hdd_job },
 	{ OPT_hdd_opts,		stress_set_hdd_opts },
+	{ OPT_hdd_rwmix,	stress_set_hdd_rwmix },
 	{ OPT_hdd_write_size,	stress_set_hdd_write_size },
 	{ 0,			NULL },
 };
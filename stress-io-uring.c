@@ -19,6 +19,7 @@
  */
 #include "stress-ng.h"
 #include "core-builtin.h"
+#include "core-latency.h"
 #include "core-out-of-memory.h"
 #include "io-uring.h"
 
@@ -38,13 +39,40 @@
 #define O_DSYNC		(0)
 #endif
 
+#define IO_URING_PERF_FILE_SIZE		(64 * MB)
+#define IO_URING_PERF_QD_DEFAULT	(32)
+#define IO_URING_PERF_BATCH_DEFAULT	(8)
+#define IO_URING_PERF_BS_DEFAULT	(4 * KB)
+
 static const stress_help_t help[] = {
 	{ NULL,	"io-uring N",		"start N workers that issue io-uring I/O requests" },
+	{ NULL,	"io-uring-batch N",	"submit and reap perf mode I/O in batches of N" },
+	{ NULL,	"io-uring-bs N",	"perf mode I/O block size" },
 	{ NULL, "io-uring-entries N",	"specify number if io-uring ring entries" },
 	{ NULL,	"io-uring-ops N",	"stop after N bogo io-uring I/O requests" },
+	{ NULL,	"io-uring-perf",	"measure IOPS, MB/s and latency using fixed buffers and files" },
+	{ NULL,	"io-uring-qd N",	"keep N I/O requests in flight in perf mode" },
+	{ NULL,	"io-uring-rw M",	"perf mode I/O pattern: randread, randwrite, read or write" },
+	{ NULL,	"io-uring-sqpoll",	"use a kernel submission queue polling thread in perf mode" },
 	{ NULL,	NULL,			NULL }
 };
 
+/*
+ *  perf mode I/O patterns
+ */
+typedef struct {
+	const char *name;	/* pattern name */
+	const bool write;	/* true = write, false = read */
+	const bool random;	/* true = random offsets, false = sequential */
+} stress_io_uring_rw_t;
+
+static const stress_io_uring_rw_t io_uring_rws[] = {
+	{ "randread",	false,	true },
+	{ "randwrite",	true,	true },
+	{ "read",	false,	false },
+	{ "write",	true,	false },
+};
+
 static int stress_set_io_uring_entries(const char *opt)
 {
         uint32_t io_uring_entries;
@@ -54,8 +82,70 @@ static int stress_set_io_uring_entries(const char *opt)
         return stress_set_setting("io-uring-entries", TYPE_ID_UINT32, &io_uring_entries);
 }
 
+static int stress_set_io_uring_batch(const char *opt)
+{
+	uint32_t io_uring_batch;
+
+	io_uring_batch = stress_get_uint32(opt);
+	stress_check_range("io-uring-batch", (uint64_t)io_uring_batch, 1, 4096);
+	return stress_set_setting("io-uring-batch", TYPE_ID_UINT32, &io_uring_batch);
+}
+
+static int stress_set_io_uring_bs(const char *opt)
+{
+	uint64_t io_uring_bs;
+
+	io_uring_bs = stress_get_uint64_byte(opt);
+	stress_check_range_bytes("io-uring-bs", io_uring_bs, 512, MB);
+	if (io_uring_bs & 511) {
+		(void)fprintf(stderr, "io-uring-bs must be a multiple of 512 bytes\n");
+		return -1;
+	}
+	return stress_set_setting("io-uring-bs", TYPE_ID_UINT64, &io_uring_bs);
+}
+
+static int stress_set_io_uring_perf(const char *opt)
+{
+	return stress_set_setting_true("io-uring-perf", opt);
+}
+
+static int stress_set_io_uring_qd(const char *opt)
+{
+	uint32_t io_uring_qd;
+
+	io_uring_qd = stress_get_uint32(opt);
+	stress_check_range("io-uring-qd", (uint64_t)io_uring_qd, 1, 4096);
+	return stress_set_setting("io-uring-qd", TYPE_ID_UINT32, &io_uring_qd);
+}
+
+static int stress_set_io_uring_rw(const char *opt)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(io_uring_rws); i++) {
+		if (!strcmp(opt, io_uring_rws[i].name))
+			return stress_set_setting("io-uring-rw", TYPE_ID_SIZE_T, &i);
+	}
+	(void)fprintf(stderr, "invalid io-uring-rw '%s', allowed patterns are:", opt);
+	for (i = 0; i < SIZEOF_ARRAY(io_uring_rws); i++)
+		(void)fprintf(stderr, " %s", io_uring_rws[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+static int stress_set_io_uring_sqpoll(const char *opt)
+{
+	return stress_set_setting_true("io-uring-sqpoll", opt);
+}
+
 static const stress_opt_set_func_t opt_set_funcs[] = {
+	{ OPT_io_uring_batch,	stress_set_io_uring_batch },
+	{ OPT_io_uring_bs,	stress_set_io_uring_bs },
 	{ OPT_io_uring_entries,	stress_set_io_uring_entries },
+	{ OPT_io_uring_perf,	stress_set_io_uring_perf },
+	{ OPT_io_uring_qd,	stress_set_io_uring_qd },
+	{ OPT_io_uring_rw,	stress_set_io_uring_rw },
+	{ OPT_io_uring_sqpoll,	stress_set_io_uring_sqpoll },
 	{ 0,			NULL },
 };
 
@@ -82,6 +172,16 @@ static const stress_opt_set_func_t opt_set_funcs[] = {
      defined(HAVE_IORING_OP_GETXATTR) || \
      defined(HAVE_IORING_OP_SYNC_FILE_RANGE))
 
+#if defined(IORING_SETUP_COOP_TASKRUN) && 	\
+    defined(IORING_SETUP_DEFER_TASKRUN) &&	\
+    defined(IORING_SETUP_SINGLE_ISSUER)
+#define IO_URING_SETUP_FLAGS	(IORING_SETUP_COOP_TASKRUN | 	\
+				 IORING_SETUP_DEFER_TASKRUN |	\
+				 IORING_SETUP_SINGLE_ISSUER)
+#else
+#define IO_URING_SETUP_FLAGS	(0)
+#endif
+
 /*
  *  io uring file info
  */
@@ -134,6 +234,7 @@ typedef struct {
 	size_t cq_size;
 	size_t sqes_size;
 	size_t sqes_entries;
+	bool latency;
 } stress_io_uring_submit_t;
 
 typedef struct {
@@ -212,6 +313,7 @@ static void stress_io_uring_unmap_iovecs(stress_io_uring_file_t *io_uring_file)
 static int stress_setup_io_uring(
 	stress_args_t *args,
 	const uint32_t io_uring_entries,
+	const uint32_t io_uring_flags,
 	stress_io_uring_submit_t *submit)
 {
 	stress_uring_io_sq_ring_t *sring = &submit->sq_ring;
@@ -219,10 +321,11 @@ static int stress_setup_io_uring(
 	struct io_uring_params p;
 
 	(void)shim_memset(&p, 0, sizeof(p));
-#if defined(IORING_SETUP_COOP_TASKRUN) && 	\
-    defined(IORING_SETUP_DEFER_TASKRUN) &&	\
-    defined(IORING_SETUP_SINGLE_ISSUER)
-	p.flags = IORING_SETUP_COOP_TASKRUN | IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+	p.flags = io_uring_flags;
+#if defined(IORING_SETUP_SQPOLL)
+	/* keep the kernel polling thread awake for 1 second when idle */
+	if (io_uring_flags & IORING_SETUP_SQPOLL)
+		p.sq_thread_idle = 1000;
 #endif
 
 	/*
@@ -243,6 +346,11 @@ static int stress_setup_io_uring(
 				args->name);
 			return EXIT_NO_RESOURCE;
 		}
+		if (errno == EPERM) {
+			pr_inf_skip("%s: io-uring setup not permitted, skipping stressor\n",
+				args->name);
+			return EXIT_NO_RESOURCE;
+		}
 		if (errno == EINVAL) {
 			pr_inf_skip("%s: io-uring failed, EINVAL, possibly %"
 				PRIu32 " io-uring-entries too large, "
@@ -438,6 +546,7 @@ static int stress_io_uring_submit(
 	unsigned index = 0, tail = 0, next_tail = 0;
 	struct io_uring_sqe *sqe;
 	int ret;
+	uint64_t t = 0;
 
 	next_tail = tail = *sring->tail;
 	next_tail++;
@@ -465,6 +574,8 @@ static int stress_io_uring_submit(
 retry:
 	if (!stress_continue(args))
 		return EXIT_NO_RESOURCE;
+	if (submit->latency)
+		t = stress_latency_now();
 	ret = shim_io_uring_enter(submit->io_uring_fd, 1,
 		1, IORING_ENTER_GETEVENTS);
 	if (UNLIKELY(ret < 0)) {
@@ -483,6 +594,9 @@ retry:
 			user_data->supported = false;
 		return EXIT_FAILURE;
 	}
+	/* submit and wait for one completion */
+	if (submit->latency)
+		stress_latency_record(args, stress_latency_now() - t);
 	stress_bogo_inc(args);
 	return EXIT_SUCCESS;
 }
@@ -1077,6 +1191,474 @@ static const char *stress_io_uring_opcode_name(const uint8_t opcode)
 	return "unknown";
 }
 
+/*
+ *  IORING_REGISTER_BUFFERS and IORING_REGISTER_FILES are enums that
+ *  arrived with the fixed buffer opcodes, so check for those instead
+ */
+#if defined(__NR_io_uring_register) &&		\
+    defined(IOSQE_FIXED_FILE) &&		\
+    defined(HAVE_IORING_OP_READ_FIXED) &&	\
+    defined(HAVE_IORING_OP_WRITE_FIXED)
+#define HAVE_IO_URING_PERF
+
+/*
+ *  io uring perf mode state, each of the qd slots has a
+ *  registered buffer and a submit timestamp
+ */
+typedef struct {
+	stress_io_uring_submit_t submit;	/* io-uring rings */
+	const stress_io_uring_rw_t *rw;		/* I/O pattern */
+	struct iovec *iovecs;		/* registered buffers, one per slot */
+	uint64_t *start_ns;		/* per slot submit time */
+	uint32_t *free_slots;		/* stack of idle slots */
+	uint32_t n_free;		/* number of idle slots */
+	uint8_t *buf;			/* buffer backing the iovecs */
+	size_t buf_size;		/* size of buf */
+	uint64_t bs;			/* block size */
+	uint64_t blocks;		/* file size in blocks */
+	uint64_t next_block;		/* next sequential block */
+	uint64_t ios;			/* completed I/Os */
+	bool sqpoll;			/* true if kernel polls the SQ */
+	stress_latency_t lat;		/* completion latencies */
+} stress_io_uring_perf_t;
+
+/*
+ *  shim_io_uring_register
+ *	wrapper for io_uring_register()
+ */
+static inline int shim_io_uring_register(
+	int fd,
+	unsigned int opcode,
+	void *arg,
+	unsigned int nr_args)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/*
+ *  stress_io_uring_perf_prep()
+ *	queue up to n fixed buffer, fixed file read or write
+ *	requests on idle slots, returns number queued
+ */
+static uint32_t stress_io_uring_perf_prep(
+	stress_io_uring_perf_t *perf,
+	const uint32_t n)
+{
+	stress_uring_io_sq_ring_t *sring = &perf->submit.sq_ring;
+	const unsigned mask = *sring->ring_mask;
+	const uint8_t opcode = perf->rw->write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+	const uint64_t now = stress_latency_now();
+	unsigned tail = *sring->tail;
+	uint32_t i;
+
+	for (i = 0; (i < n) && (perf->n_free > 0); i++) {
+		const uint32_t slot = perf->free_slots[--perf->n_free];
+		const unsigned index = tail & mask;
+		struct io_uring_sqe *sqe = &perf->submit.sqes_mmap[index];
+		uint64_t block;
+
+		if (perf->rw->random) {
+			block = stress_mwc64modn(perf->blocks);
+		} else {
+			block = perf->next_block++;
+			if (perf->next_block >= perf->blocks)
+				perf->next_block = 0;
+		}
+
+		(void)shim_memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode = opcode;
+		sqe->flags = IOSQE_FIXED_FILE;
+		sqe->fd = 0;	/* index of the registered file */
+		sqe->off = block * perf->bs;
+		sqe->addr = (uintptr_t)perf->iovecs[slot].iov_base;
+		sqe->len = (uint32_t)perf->bs;
+		sqe->buf_index = (uint16_t)slot;
+		sqe->user_data = (uint64_t)slot;
+
+		sring->array[index] = index;
+		perf->start_ns[slot] = now;
+		tail++;
+	}
+	stress_asm_mb();
+	*sring->tail = tail;
+	stress_asm_mb();
+
+	return i;
+}
+
+/*
+ *  stress_io_uring_perf_reap()
+ *	reap all available completions, record the submit to
+ *	completion latency and return the slots to the idle stack
+ */
+static int stress_io_uring_perf_reap(
+	stress_args_t *args,
+	stress_io_uring_perf_t *perf,
+	uint32_t *inflight)
+{
+	stress_uring_io_cq_ring_t *cring = &perf->submit.cq_ring;
+	const uint64_t now = stress_latency_now();
+	unsigned head = *cring->head;
+	uint32_t reaped = 0;
+	int rc = EXIT_SUCCESS;
+
+	for (;;) {
+		const struct io_uring_cqe *cqe;
+		uint32_t slot;
+		uint64_t ns;
+
+		stress_asm_mb();
+		if (head == *cring->tail)
+			break;
+
+		cqe = &cring->cqes[head & *cring->ring_mask];
+		slot = (uint32_t)cqe->user_data;
+		if (UNLIKELY(cqe->res < 0)) {
+			pr_fail("%s: %s completion failed, error=%d (%s)\n",
+				args->name, perf->rw->name,
+				-cqe->res, strerror(-cqe->res));
+			rc = EXIT_FAILURE;
+		} else if (UNLIKELY((uint64_t)cqe->res != perf->bs)) {
+			pr_fail("%s: %s completion transferred %d bytes, expected %" PRIu64 " bytes\n",
+				args->name, perf->rw->name, cqe->res, perf->bs);
+			rc = EXIT_FAILURE;
+		}
+		ns = now - perf->start_ns[slot];
+		stress_latency_add(&perf->lat, ns);
+		stress_latency_record(args, ns);
+		perf->free_slots[perf->n_free++] = slot;
+		head++;
+		reaped++;
+	}
+	*cring->head = head;
+	stress_asm_mb();
+
+	*inflight -= reaped;
+	perf->ios += reaped;
+	stress_bogo_add(args, (uint64_t)reaped);
+
+	return rc;
+}
+
+/*
+ *  stress_io_uring_perf_enter()
+ *	submit n queued requests and wait for min_complete
+ *	completions, with SQPOLL the kernel thread picks up the
+ *	requests so only wake it or wait for completions
+ */
+static int stress_io_uring_perf_enter(
+	stress_io_uring_perf_t *perf,
+	const uint32_t n,
+	const uint32_t min_complete)
+{
+	unsigned int flags = IORING_ENTER_GETEVENTS;
+
+#if defined(IORING_SETUP_SQPOLL) &&	\
+    defined(IORING_SQ_NEED_WAKEUP) &&	\
+    defined(IORING_ENTER_SQ_WAKEUP)
+	if (perf->sqpoll) {
+		flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+		stress_asm_mb();
+		if (*perf->submit.sq_ring.flags & IORING_SQ_NEED_WAKEUP)
+			flags |= IORING_ENTER_SQ_WAKEUP;
+		if (!flags)
+			return 0;
+	}
+#endif
+	return shim_io_uring_enter(perf->submit.io_uring_fd, n, min_complete, flags);
+}
+
+/*
+ *  stress_io_uring_perf_file()
+ *	create and fill the perf mode file, try O_DIRECT first
+ *	and fall back to buffered I/O if the file system does
+ *	not support it
+ */
+static int stress_io_uring_perf_file(
+	stress_args_t *args,
+	const char *filename,
+	const uint64_t file_size,
+	bool *direct)
+{
+	const size_t chunk = MB;
+	uint8_t *buf;
+	int fd;
+
+	buf = (uint8_t *)stress_mmap_populate(NULL, chunk, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu byte file fill buffer, errno=%d (%s), "
+			"skipping stressor\n", args->name, chunk, errno, strerror(errno));
+		return -EXIT_NO_RESOURCE;
+	}
+	stress_rndbuf(buf, chunk);
+
+#if defined(O_DIRECT)
+	*direct = true;
+#else
+	*direct = false;
+#endif
+	for (;;) {
+		uint64_t offset;
+		int flags = O_CREAT | O_RDWR;
+
+#if defined(O_DIRECT)
+		if (*direct)
+			flags |= O_DIRECT;
+#endif
+		fd = open(filename, flags, S_IRUSR | S_IWUSR);
+		if (fd < 0) {
+			if (*direct && (errno == EINVAL)) {
+				*direct = false;
+				continue;
+			}
+			pr_fail("%s: open on %s failed, errno=%d (%s)\n",
+				args->name, filename, errno, strerror(errno));
+			fd = -stress_exit_status(errno);
+			break;
+		}
+
+		for (offset = 0; offset < file_size; offset += chunk) {
+			if (pwrite(fd, buf, chunk, (off_t)offset) != (ssize_t)chunk)
+				break;
+		}
+		if (offset >= file_size)
+			break;
+
+		/* O_DIRECT may have alignment constraints, so retry buffered */
+		if (*direct && (errno == EINVAL)) {
+			(void)close(fd);
+			(void)shim_unlink(filename);
+			*direct = false;
+			continue;
+		}
+		if ((errno == ENOSPC) || (errno == EDQUOT)) {
+			pr_inf_skip("%s: out of space writing %" PRIu64 "MB file, "
+				"skipping stressor\n", args->name, (uint64_t)(file_size / MB));
+			(void)close(fd);
+			fd = -EXIT_NO_RESOURCE;
+			break;
+		}
+		pr_fail("%s: write to %s failed, errno=%d (%s)\n",
+			args->name, filename, errno, strerror(errno));
+		(void)close(fd);
+		fd = -EXIT_FAILURE;
+		break;
+	}
+	(void)munmap((void *)buf, chunk);
+
+	if ((fd >= 0) && !*direct) {
+		/* drop the file from the page cache so reads hit the device */
+		(void)shim_fsync(fd);
+#if defined(HAVE_POSIX_FADVISE) &&	\
+    defined(POSIX_FADV_DONTNEED)
+		(void)posix_fadvise(fd, 0, (off_t)file_size, POSIX_FADV_DONTNEED);
+#endif
+	}
+	return fd;
+}
+
+/*
+ *  stress_io_uring_perf_report()
+ *	report IOPS, MB/s and completion latency percentiles
+ */
+static void stress_io_uring_perf_report(
+	stress_args_t *args,
+	const stress_io_uring_perf_t *perf,
+	const uint32_t qd,
+	const uint32_t batch,
+	const bool direct,
+	const double duration)
+{
+	const double iops = (duration > 0.0) ? (double)perf->ios / duration : 0.0;
+	const double mb_rate = (iops * (double)perf->bs) / (double)MB;
+	const double p50 = (double)stress_latency_percentile(&perf->lat, 50.0) / 1000.0;
+	const double p99 = (double)stress_latency_percentile(&perf->lat, 99.0) / 1000.0;
+	const double p999 = (double)stress_latency_percentile(&perf->lat, 99.9) / 1000.0;
+
+	if (args->instance == 0) {
+		pr_inf("%s: %s, %" PRIu64 " byte blocks, queue depth %" PRIu32
+			", batch %" PRIu32 "%s%s\n", args->name, perf->rw->name,
+			perf->bs, qd, batch, direct ? ", O_DIRECT" : ", buffered",
+			perf->sqpoll ? ", SQPOLL" : "");
+		pr_inf("%s: %.0f IOPS, %.2f MB/s, completion latency p50 %.2f, "
+			"p99 %.2f, p99.9 %.2f usecs\n", args->name,
+			iops, mb_rate, p50, p99, p999);
+	}
+	stress_metrics_set(args, 0, "IOPS", iops, STRESS_GEOMETRIC_MEAN);
+	stress_metrics_set(args, 1, "MB per sec", mb_rate, STRESS_GEOMETRIC_MEAN);
+	stress_metrics_set(args, 2, "usec p50 completion latency", p50, STRESS_GEOMETRIC_MEAN);
+	stress_metrics_set(args, 3, "usec p99 completion latency", p99, STRESS_GEOMETRIC_MEAN);
+	stress_metrics_set(args, 4, "usec p99.9 completion latency", p999, STRESS_GEOMETRIC_MEAN);
+}
+
+/*
+ *  stress_io_uring_perf()
+ *	throughput mode, keep qd fixed buffer reads or writes in
+ *	flight on a registered O_DIRECT file, submitting and reaping
+ *	in batches, and measure IOPS, MB/s and completion latency
+ */
+static int stress_io_uring_perf(stress_args_t *args)
+{
+	stress_io_uring_perf_t perf;
+	char filename[PATH_MAX];
+	uint32_t qd = IO_URING_PERF_QD_DEFAULT;
+	uint32_t batch = IO_URING_PERF_BATCH_DEFAULT;
+	uint32_t flags = IO_URING_SETUP_FLAGS;
+	uint32_t i, inflight = 0;
+	size_t io_uring_rw = 0;
+	bool sqpoll = false, direct = false;
+	int fd, ret, rc = EXIT_SUCCESS;
+	double t_start, duration;
+
+	(void)shim_memset(&perf, 0, sizeof(perf));
+	perf.submit.io_uring_fd = -1;
+	perf.bs = IO_URING_PERF_BS_DEFAULT;
+
+	(void)stress_get_setting("io-uring-batch", &batch);
+	(void)stress_get_setting("io-uring-bs", &perf.bs);
+	(void)stress_get_setting("io-uring-qd", &qd);
+	(void)stress_get_setting("io-uring-rw", &io_uring_rw);
+	(void)stress_get_setting("io-uring-sqpoll", &sqpoll);
+
+	if (batch > qd)
+		batch = qd;
+	perf.rw = &io_uring_rws[io_uring_rw];
+	perf.blocks = IO_URING_PERF_FILE_SIZE / perf.bs;
+	stress_latency_init(&perf.lat);
+
+	if (sqpoll) {
+#if defined(IORING_SETUP_SQPOLL) &&	\
+    defined(IORING_SQ_NEED_WAKEUP) &&	\
+    defined(IORING_ENTER_SQ_WAKEUP)
+		flags = IORING_SETUP_SQPOLL;
+		perf.sqpoll = true;
+#else
+		if (args->instance == 0)
+			pr_inf("%s: io-uring-sqpoll not supported, ignoring option\n", args->name);
+#endif
+	}
+
+	perf.buf_size = (size_t)qd * (size_t)perf.bs;
+	perf.buf = (uint8_t *)stress_mmap_populate(NULL, perf.buf_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (perf.buf == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu byte I/O buffer, errno=%d (%s), "
+			"skipping stressor\n", args->name, perf.buf_size,
+			errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	stress_rndbuf(perf.buf, perf.buf_size);
+
+	perf.iovecs = (struct iovec *)calloc((size_t)qd, sizeof(*perf.iovecs));
+	perf.start_ns = (uint64_t *)calloc((size_t)qd, sizeof(*perf.start_ns));
+	perf.free_slots = (uint32_t *)calloc((size_t)qd, sizeof(*perf.free_slots));
+	if (!perf.iovecs || !perf.start_ns || !perf.free_slots) {
+		pr_inf_skip("%s: cannot allocate %" PRIu32 " I/O slots, "
+			"skipping stressor\n", args->name, qd);
+		rc = EXIT_NO_RESOURCE;
+		goto free_slots;
+	}
+	for (i = 0; i < qd; i++) {
+		perf.iovecs[i].iov_base = (void *)(perf.buf + ((size_t)i * perf.bs));
+		perf.iovecs[i].iov_len = (size_t)perf.bs;
+		perf.free_slots[i] = qd - 1 - i;
+	}
+	perf.n_free = qd;
+
+	ret = stress_temp_dir_mk_args(args);
+	if (ret < 0) {
+		rc = stress_exit_status(-ret);
+		goto free_slots;
+	}
+	(void)stress_temp_filename_args(args,
+		filename, sizeof(filename), stress_mwc32());
+
+	fd = stress_io_uring_perf_file(args, filename, IO_URING_PERF_FILE_SIZE, &direct);
+	if (fd < 0) {
+		rc = -fd;
+		goto unlink;
+	}
+
+	rc = stress_setup_io_uring(args, qd, flags, &perf.submit);
+	if (rc != EXIT_SUCCESS)
+		goto close_fd;
+
+	if (shim_io_uring_register(perf.submit.io_uring_fd, IORING_REGISTER_BUFFERS,
+				   perf.iovecs, qd) < 0) {
+		pr_inf_skip("%s: cannot register %" PRIu32 " io-uring buffers, "
+			"errno=%d (%s), skipping stressor\n",
+			args->name, qd, errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto close_ring;
+	}
+	if (shim_io_uring_register(perf.submit.io_uring_fd, IORING_REGISTER_FILES,
+				   &fd, 1) < 0) {
+		pr_inf_skip("%s: cannot register io-uring file, errno=%d (%s), "
+			"skipping stressor\n", args->name, errno, strerror(errno));
+		rc = EXIT_NO_RESOURCE;
+		goto close_ring;
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	t_start = stress_time_now();
+	do {
+		const uint32_t n = stress_io_uring_perf_prep(&perf, batch);
+		uint32_t min_complete;
+
+		inflight += n;
+		/* wait for a batch of completions when there is no room for another batch */
+		min_complete = (perf.n_free < batch) ? STRESS_MINIMUM(batch, inflight) : 0;
+		ret = stress_io_uring_perf_enter(&perf, n, min_complete);
+		if (UNLIKELY(ret < 0)) {
+			if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY)) {
+				if (stress_io_uring_perf_reap(args, &perf, &inflight) != EXIT_SUCCESS) {
+					rc = EXIT_FAILURE;
+					break;
+				}
+				continue;
+			}
+			pr_fail("%s: io_uring_enter failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			rc = EXIT_FAILURE;
+			break;
+		}
+		if (stress_io_uring_perf_reap(args, &perf, &inflight) != EXIT_SUCCESS) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+	} while (stress_continue(args));
+	duration = stress_time_now() - t_start;
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	if (rc == EXIT_SUCCESS)
+		stress_io_uring_perf_report(args, &perf, qd, batch, direct, duration);
+
+	/* drain in-flight requests before the buffers go away */
+	while (inflight > 0) {
+		if (stress_io_uring_perf_enter(&perf, 0, inflight) < 0)
+			break;
+		(void)stress_io_uring_perf_reap(args, &perf, &inflight);
+	}
+
+close_ring:
+	stress_close_io_uring(&perf.submit);
+close_fd:
+	(void)close(fd);
+unlink:
+	(void)shim_unlink(filename);
+	(void)stress_temp_dir_rm_args(args);
+free_slots:
+	free(perf.free_slots);
+	free(perf.start_ns);
+	free(perf.iovecs);
+	(void)munmap((void *)perf.buf, perf.buf_size);
+
+	return rc;
+}
+#endif
+
 /*
  *  stress_io_uring
  *	stress asynchronous I/O
@@ -1095,9 +1677,23 @@ static int stress_io_uring_child(stress_args_t *args, void *context)
 	uint32_t io_uring_entries;
 	stress_io_uring_user_data_t user_data[SIZEOF_ARRAY(stress_io_uring_setups)];
 	const int32_t cpus = stress_get_processors_online();
+	bool io_uring_perf = false;
 
 	(void)context;
 
+	(void)stress_get_setting("io-uring-perf", &io_uring_perf);
+	if (io_uring_perf) {
+#if defined(HAVE_IO_URING_PERF)
+		return stress_io_uring_perf(args);
+#else
+		if (args->instance == 0)
+			pr_inf_skip("%s: io-uring-perf requires io-uring fixed buffer "
+				"and registered file support, skipping stressor\n",
+				args->name);
+		return EXIT_NOT_IMPLEMENTED;
+#endif
+	}
+
 	/* Minor tweaking based on empirical testing */
 	if (cpus > 128)
 		io_uring_entries = 22;
@@ -1112,6 +1708,7 @@ static int stress_io_uring_child(stress_args_t *args, void *context)
 
 	(void)shim_memset(&submit, 0, sizeof(submit));
 	(void)shim_memset(&io_uring_file, 0, sizeof(io_uring_file));
+	submit.latency = stress_latency_enabled();
 
 	io_uring_file.fd_dup = fileno(stdin);
 	io_uring_file.file_size = file_size;
@@ -1160,7 +1757,7 @@ static int stress_io_uring_child(stress_args_t *args, void *context)
 
 	io_uring_file.filename = filename;
 
-	rc = stress_setup_io_uring(args, io_uring_entries, &submit);
+	rc = stress_setup_io_uring(args, io_uring_entries, IO_URING_SETUP_FLAGS, &submit);
 	if (rc != EXIT_SUCCESS)
 		goto clean;
 
@@ -1213,6 +1810,7 @@ static int stress_io_uring_child(stress_args_t *args, void *context)
 				(void)stress_read_fdinfo(self, submit.io_uring_fd);
 		}
 	} while (stress_continue(args));
+	stress_latency_metrics(args, 0);
 
 	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
 #if defined(HAVE_IORING_OP_ASYNC_CANCEL)
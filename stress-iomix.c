@@ -19,7 +19,9 @@
  */
 #include "stress-ng.h"
 #include "core-builtin.h"
+#include "core-io-engine.h"
 #include "core-killpid.h"
+#include "core-mincore.h"
 #include "core-put.h"
 
 #if defined(HAVE_LINUX_FS_H)
@@ -33,6 +35,8 @@
 #define MAX_IOMIX_BYTES		(MAX_FILE_LIMIT)
 #define DEFAULT_IOMIX_BYTES	(1 * GB)
 
+#define IOMIX_ENGINE_DEPTH	(32)
+
 typedef void (*stress_iomix_func)(stress_args_t *args, const int fd, const char *fs_type, const off_t iomix_bytes);
 
 static const stress_help_t help[] = {
@@ -188,6 +192,82 @@ static void stress_iomix_wr_seq_bursts(
 	} while (stress_bogo_inc_lock(args, counter_lock, false));
 }
 
+/*
+ *  stress_iomix_rnd_engine_bursts()
+ *	bursty random reads or writes submitted in batches
+ *	using the --io-engine selected I/O engine
+ */
+static void stress_iomix_rnd_engine_bursts(
+	stress_args_t *args,
+	const int fd,
+	const char *fs_type,
+	const off_t iomix_bytes,
+	const bool is_write)
+{
+	stress_io_engine_t engine;
+	stress_io_req_t reqs[IOMIX_ENGINE_DEPTH];
+	stress_io_req_t *reqps[IOMIX_ENGINE_DEPTH];
+	char buffers[IOMIX_ENGINE_DEPTH][512];
+
+	if (stress_io_engine_open(args, &engine, fd, IOMIX_ENGINE_DEPTH) != EXIT_SUCCESS)
+		return;
+
+	do {
+		const int n = stress_mwc8();
+		int i;
+
+		for (i = 0; i < n; i += IOMIX_ENGINE_DEPTH) {
+			const uint32_t batch = (uint32_t)STRESS_MINIMUM(n - i, IOMIX_ENGINE_DEPTH);
+			uint32_t j;
+
+			for (j = 0; j < batch; j++) {
+				stress_io_req_t *req = &reqs[j];
+
+				req->buf = (void *)buffers[j];
+				req->offset = (uint64_t)stress_iomix_rnd_offset(iomix_bytes);
+				req->size = 1 + (stress_mwc32() & (sizeof(buffers[j]) - 1));
+				req->write = is_write;
+				if (is_write)
+					stress_rndbuf(buffers[j], req->size);
+				else
+					stress_iomix_fadvise_random_dontneed(fd,
+						(off_t)req->offset, (off_t)req->size);
+				reqps[j] = req;
+			}
+
+			if (stress_io_engine_batch(&engine, reqps, batch) < 0) {
+				if (errno == EINTR)
+					break;
+				pr_fail("%s: %s I/O engine failed, errno=%d (%s)%s\n",
+					args->name, stress_io_engine_name(),
+					errno, strerror(errno), fs_type);
+				goto close_engine;
+			}
+			for (j = 0; j < batch; j++) {
+				const ssize_t res = reqs[j].res;
+
+				/* mmap engine writes fault on immutable files, -EFAULT */
+				if ((res < 0) && (res != -EINTR) && (res != -ECANCELED) &&
+				    (!is_write || ((res != -EPERM) && (res != -ENOSPC) &&
+						   (res != -EFAULT)))) {
+					pr_fail("%s: %s failed, errno=%d (%s)%s\n",
+						args->name, is_write ? "write" : "read",
+						(int)-res, strerror((int)-res), fs_type);
+					goto close_engine;
+				}
+				if (!stress_bogo_inc_lock(args, counter_lock, true))
+					goto close_engine;
+			}
+			if (is_write)
+				stress_iomix_fsync_min_1Hz(fd);
+		}
+		shim_usleep(is_write ? stress_mwc32modn(2000000) : 3000000);
+	} while (stress_bogo_inc_lock(args, counter_lock, false));
+
+close_engine:
+	stress_io_engine_close(&engine);
+}
+
 /*
  *  stress_iomix_wr_rnd_bursts()
  *	bursty random writes
@@ -204,6 +284,11 @@ static void stress_iomix_wr_rnd_bursts(
 #else
 	UNEXPECTED
 #endif
+	if (stress_io_engine_selected()) {
+		stress_iomix_rnd_engine_bursts(args, fd, fs_type, iomix_bytes, true);
+		return;
+	}
+
 	do {
 		const int n = stress_mwc8();
 		int i;
@@ -357,6 +442,11 @@ static void stress_iomix_rd_rnd_bursts(
 	const char *fs_type,
 	const off_t iomix_bytes)
 {
+	if (stress_io_engine_selected()) {
+		stress_iomix_rnd_engine_bursts(args, fd, fs_type, iomix_bytes, false);
+		return;
+	}
+
 	do {
 		const int n = stress_mwc8();
 		int i;
@@ -930,40 +1020,10 @@ static void stress_iomix_sendfile(
 }
 #endif
 
-#if defined(__linux__) &&	\
-    defined(__NR_cachestat)
-struct shim_cachestat_range {
-	uint64_t off;
-	uint64_t len;
-};
-
-struct shim_cachestat {
-	uint64_t nr_cache;
-	uint64_t nr_dirty;
-	uint64_t nr_writeback;
-	uint64_t nr_evicted;
-	uint64_t nr_recently_evicted;
-};
-
-/*
- *  shim_cachestat
- *	wrapper for cachestat system call
- */
-static inline int shim_cachestat(
-	int fd,
-	struct shim_cachestat_range *cstat_range,
-	struct shim_cachestat *cstat,
-	unsigned int flags)
-{
-	return (int)syscall(__NR_cachestat, (unsigned long)fd,
-			(unsigned long)cstat_range,
-			(unsigned long)cstat,
-			(unsigned long)flags);
-}
-
 /*
  *  stress_iomix_cachestat()
- *	various periodic cache statistics calls (linux only)
+ *	various periodic cache statistics calls and about once a
+ *	second sample how much of the file is in the page cache
  */
 static void stress_iomix_cachestat(
 	stress_args_t *args,
@@ -971,12 +1031,34 @@ static void stress_iomix_cachestat(
 	const char *fs_type,
 	const off_t iomix_bytes)
 {
+	double cached = 0.0, dirty = 0.0;
+	uint64_t samples = 0, dirty_samples = 0;
+	uint32_t count = 0;
+
 	(void)fs_type;
-	(void)iomix_bytes;
 
 	do {
 		struct stat buf;
 
+		if ((count++ % 20) == 0) {
+			stress_page_cache_stat_t pcstat;
+
+			if ((stress_page_cache_stat(fd, 0, iomix_bytes, &pcstat) == 0) &&
+			    (pcstat.pages > 0)) {
+				cached += 100.0 * (double)pcstat.cached / (double)pcstat.pages;
+				samples++;
+				stress_metrics_set(args, 0, "% file pages in page cache",
+					cached / (double)samples, STRESS_GEOMETRIC_MEAN);
+				if (pcstat.cachestat) {
+					dirty += 100.0 * (double)(pcstat.dirty + pcstat.writeback) /
+						(double)pcstat.pages;
+					dirty_samples++;
+					stress_metrics_set(args, 1, "% file pages dirty or under writeback",
+						dirty / (double)dirty_samples, STRESS_GEOMETRIC_MEAN);
+				}
+			}
+		}
+
 		if (shim_fstat(fd, &buf) == 0) {
 			struct shim_cachestat_range cstat_range;
 			struct shim_cachestat cstat;
@@ -1004,7 +1086,6 @@ static void stress_iomix_cachestat(
 		(void)shim_usleep(50000);
 	} while (stress_bogo_inc_lock(args, counter_lock, true));
 }
-#endif
 
 static stress_iomix_func iomix_funcs[] = {
 	stress_iomix_wr_seq_bursts,
@@ -1036,10 +1117,7 @@ static stress_iomix_func iomix_funcs[] = {
     defined(HAVE_SENDFILE)
 	stress_iomix_sendfile,
 #endif
-#if defined(__linux__) &&	\
-    defined(__NR_cachestat)
 	stress_iomix_cachestat,
-#endif
 };
 
 /*
@@ -19,6 +19,7 @@
  */
 #include "stress-ng.h"
 #include "core-builtin.h"
+#include "core-mmap.h"
 #include "core-pragma.h"
 #include "core-put.h"
 #include "core-target-clones.h"
@@ -874,10 +875,6 @@ static inline int stress_matrix_3d_exercise(
 	matrix_3d_ptr_t a, b = NULL, r = NULL, s = NULL;
 	register size_t i, j;
 	const stress_matrix_3d_type_t v = 65535 / (stress_matrix_3d_type_t)((uint64_t)~0);
-	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
-#if defined(MAP_POPULATE)
-	flags |= MAP_POPULATE;
-#endif
 
 	method_all_index = 1;
 	current_method = matrix_3d_methods[matrix_3d_method].name;
@@ -887,27 +884,27 @@ static inline int stress_matrix_3d_exercise(
 		matrix_3d_metrics[i].count = 0.0;
 	}
 
-	a = (matrix_3d_ptr_t)stress_mmap_populate(NULL, matrix_3d_mmap_size,
-		PROT_READ | PROT_WRITE, flags, -1, 0);
+	a = (matrix_3d_ptr_t)stress_mmap_buffer(args->name, args->instance,
+		&matrix_3d_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 	if (a == MAP_FAILED) {
 		pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 		goto tidy_ret;
 	}
-	b = (matrix_3d_ptr_t)stress_mmap_populate(NULL, matrix_3d_mmap_size,
-		PROT_READ | PROT_WRITE, flags, -1, 0);
+	b = (matrix_3d_ptr_t)stress_mmap_buffer(args->name, args->instance,
+		&matrix_3d_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 	if (b == MAP_FAILED) {
 		pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 		goto tidy_a;
 	}
-	r = (matrix_3d_ptr_t)stress_mmap_populate(NULL, matrix_3d_mmap_size,
-		PROT_READ | PROT_WRITE, flags, -1, 0);
+	r = (matrix_3d_ptr_t)stress_mmap_buffer(args->name, args->instance,
+		&matrix_3d_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 	if (r == MAP_FAILED) {
 		pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 		goto tidy_b;
 	}
 	if (verify) {
-		s = (matrix_3d_ptr_t)stress_mmap_populate(NULL, matrix_3d_mmap_size,
-			PROT_READ | PROT_WRITE, flags, -1, 0);
+		s = (matrix_3d_ptr_t)stress_mmap_buffer(args->name, args->instance,
+			&matrix_3d_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 		if (s == MAP_FAILED) {
 			pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 			goto tidy_r;
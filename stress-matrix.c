@@ -19,6 +19,7 @@
  */
 #include "stress-ng.h"
 #include "core-builtin.h"
+#include "core-mmap.h"
 #include "core-pragma.h"
 #include "core-put.h"
 #include "core-target-clones.h"
@@ -887,7 +888,7 @@ static inline int stress_matrix_exercise(
 
 	int ret = EXIT_NO_RESOURCE;
 	const size_t matrix_size = sizeof(stress_matrix_type_t) * n * n;
-	const size_t matrix_mmap_size = round_up(args->page_size, matrix_size);
+	size_t matrix_mmap_size = round_up(args->page_size, matrix_size);
 	const size_t num_matrix_methods = SIZEOF_ARRAY(matrix_methods);
 	const stress_matrix_func_t func = matrix_methods[matrix_method].func[matrix_yx];
 	const bool verify = !!(g_opt_flags & OPT_FLAGS_VERIFY);
@@ -895,10 +896,6 @@ static inline int stress_matrix_exercise(
 	matrix_ptr_t a, b = NULL, r = NULL, s = NULL;
 	register size_t i, j;
 	const stress_matrix_type_t v = 65535 / (stress_matrix_type_t)((uint64_t)~0);
-	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
-#if defined(MAP_POPULATE)
-	flags |= MAP_POPULATE;
-#endif
 	method_all_index = 1;
 
 	current_method = matrix_methods[matrix_method].name;
@@ -908,27 +905,27 @@ static inline int stress_matrix_exercise(
 		matrix_metrics[i].count = 0.0;
 	}
 
-	a = (matrix_ptr_t)stress_mmap_populate(NULL, matrix_mmap_size,
-		PROT_READ | PROT_WRITE, flags, -1, 0);
+	a = (matrix_ptr_t)stress_mmap_buffer(args->name, args->instance,
+		&matrix_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 	if (a == MAP_FAILED) {
 		pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 		goto tidy_ret;
 	}
-	b = (matrix_ptr_t)stress_mmap_populate(NULL, matrix_mmap_size,
-		PROT_READ | PROT_WRITE, flags, -1, 0);
+	b = (matrix_ptr_t)stress_mmap_buffer(args->name, args->instance,
+		&matrix_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 	if (b == MAP_FAILED) {
 		pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 		goto tidy_a;
 	}
-	r = (matrix_ptr_t)stress_mmap_populate(NULL, matrix_mmap_size,
-		PROT_READ | PROT_WRITE, flags, -1, 0);
+	r = (matrix_ptr_t)stress_mmap_buffer(args->name, args->instance,
+		&matrix_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 	if (r == MAP_FAILED) {
 		pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 		goto tidy_b;
 	}
 	if (verify) {
-		s = (matrix_ptr_t)stress_mmap_populate(NULL, matrix_mmap_size,
-			PROT_READ | PROT_WRITE, flags, -1, 0);
+		s = (matrix_ptr_t)stress_mmap_buffer(args->name, args->instance,
+			&matrix_mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
 		if (s == MAP_FAILED) {
 			pr_fail("%s: matrix allocation failed, out of memory\n", args->name);
 			goto tidy_r;
@@ -19,17 +19,44 @@
  */
 #include "stress-ng.h"
 #include "core-builtin.h"
+#include "core-cpu.h"
+#include "core-mmap.h"
 #include "core-target-clones.h"
 
+#if defined(HAVE_COMPILER_MUSL)
+#undef HAVE_IMMINTRIN_H
+#endif
+
+#if defined(HAVE_IMMINTRIN_H)
+#include <immintrin.h>
+#endif
+
+#if defined(HAVE_IMMINTRIN_H) &&	\
+    defined(STRESS_ARCH_X86_64) &&	\
+    (defined(HAVE_COMPILER_GCC) ||	\
+     defined(HAVE_COMPILER_CLANG) ||	\
+     defined(HAVE_COMPILER_ICX)) &&	\
+    !defined(HAVE_COMPILER_ICC)
+#define HAVE_MEMCPY_SIMD
+#define TARGET_AVX2		__attribute__ ((target("avx2")))
+#define TARGET_AVX512F		__attribute__ ((target("avx512f")))
+#endif
+
 #define ALIGN_SIZE	(64)
 #define MEMCPY_MEMSIZE	(2048)
 #define MEMCPY_LOOPS	(1024)
 
+#define MEMCPY_SWEEP_MIN	(8)		/* smallest sweep copy size */
+#define MEMCPY_SWEEP_MAX	(64 * MB)	/* largest sweep copy size */
+#define MEMCPY_SWEEP_SIZES	(24)		/* 8B..64MB in powers of 2 */
+#define MEMCPY_SWEEP_TIME	(0.002)		/* min seconds per measurement */
+#define MEMCPY_SWEEP_CLASSES	(5)		/* size classes in the metrics */
 
 static const stress_help_t help[] = {
 	{ NULL,	"memcpy N",	   "start N workers performing memory copies" },
-	{ NULL,	"memcpy-method M", "set memcpy method (M = all, libc, builtin, naive..)" },
+	{ NULL,	"memcpy-method M", "set memcpy method (M = all, libc, builtin, naive.., avx2..)" },
 	{ NULL,	"memcpy-ops N",	   "stop after N memcpy bogo operations" },
+	{ NULL,	"memcpy-sweep",	   "measure GB/s over copy sizes and misalignments" },
 	{ NULL,	NULL,		   NULL }
 };
 
@@ -38,12 +65,26 @@ static char *s_method_name = "";
 
 typedef void (*stress_memcpy_func)(uint8_t *str1, uint8_t *str2, uint8_t *str3);
 
+typedef void * (*memcpy_func_t)(void *dest, const void *src, size_t n);
+
 typedef struct {
 	const char *name;
 	const stress_memcpy_func func;
+	const memcpy_func_t copy;	/* copy used by --memcpy-sweep, NULL if not swept */
+	bool (*capable)(void);		/* CPU support check, NULL if always supported */
 } stress_memcpy_method_info_t;
 
-typedef void * (*memcpy_func_t)(void *dest, const void *src, size_t n);
+/* sweep source and destination misalignments */
+typedef struct {
+	const size_t src;		/* source offset from a 64 byte boundary */
+	const size_t dst;		/* destination offset from a 64 byte boundary */
+} stress_memcpy_align_t;
+
+/* sweep size classes in the metrics */
+typedef struct {
+	const char *name;		/* size class name */
+	const size_t max;		/* largest size in the class */
+} stress_memcpy_class_t;
 typedef void * (*memmove_func_t)(void *dest, const void *src, size_t n);
 
 typedef void * (*memcpy_check_func_t)(memcpy_func_t func, void *dest, const void *src, size_t n);
@@ -241,48 +282,266 @@ STRESS_MEMCPY_NAIVE("naive_o1", stress_memcpy_naive_o1, test_naive_memcpy_o1, te
 STRESS_MEMCPY_NAIVE("naive_o2", stress_memcpy_naive_o2, test_naive_memcpy_o2, test_naive_memmove_o2)
 STRESS_MEMCPY_NAIVE("naive_o3", stress_memcpy_naive_o3, test_naive_memcpy_o3, test_naive_memmove_o3)
 
+#if defined(HAVE_ASM_X86_REP_MOVSB) &&	\
+    !defined(__ILP32__)
+/*
+ *  test_rep_movsb_memcpy()
+ *	copy with the x86 rep movsb string instruction, fast on
+ *	CPUs with enhanced rep movsb (ERMS) and fast short rep mov
+ */
+static NOINLINE void *test_rep_movsb_memcpy(void *dest, const void *src, size_t n)
+{
+	void *d = dest;
+	const void *s = src;
+
+	__asm__ __volatile__(
+		"rep movsb\n"
+		: "+D" (d),
+		  "+S" (s),
+		  "+c" (n)
+		:
+		: "memory");
+	return dest;
+}
+
+STRESS_MEMCPY_NAIVE("rep_movsb", stress_memcpy_rep_movsb, test_rep_movsb_memcpy, memmove)
+#endif
+
+#if defined(HAVE_MEMCPY_SIMD)
+/*
+ *  test_avx2_memcpy()
+ *	copy with unaligned 256 bit loads and stores, the tail
+ *	is copied with an overlapping store
+ */
+static NOINLINE TARGET_AVX2 void *test_avx2_memcpy(void *dest, const void *src, size_t n)
+{
+	register uint8_t *d = (uint8_t *)dest;
+	register const uint8_t *s = (const uint8_t *)src;
+
+	if (n < 32) {
+		if (n >= 16) {
+			const __m128i v0 = _mm_loadu_si128((const __m128i *)s);
+			const __m128i v1 = _mm_loadu_si128((const __m128i *)(s + n - 16));
+
+			_mm_storeu_si128((__m128i *)d, v0);
+			_mm_storeu_si128((__m128i *)(d + n - 16), v1);
+			return dest;
+		}
+		while (n--)
+			*(d++) = *(s++);
+		return dest;
+	} else {
+		const __m256i tail = _mm256_loadu_si256((const __m256i *)(s + n - 32));
+		uint8_t *d_tail = d + n - 32;
+
+		while (n >= 128) {
+			const __m256i v0 = _mm256_loadu_si256((const __m256i *)(s + 0));
+			const __m256i v1 = _mm256_loadu_si256((const __m256i *)(s + 32));
+			const __m256i v2 = _mm256_loadu_si256((const __m256i *)(s + 64));
+			const __m256i v3 = _mm256_loadu_si256((const __m256i *)(s + 96));
+
+			_mm256_storeu_si256((__m256i *)(d + 0), v0);
+			_mm256_storeu_si256((__m256i *)(d + 32), v1);
+			_mm256_storeu_si256((__m256i *)(d + 64), v2);
+			_mm256_storeu_si256((__m256i *)(d + 96), v3);
+			d += 128;
+			s += 128;
+			n -= 128;
+		}
+		while (n >= 32) {
+			_mm256_storeu_si256((__m256i *)d, _mm256_loadu_si256((const __m256i *)s));
+			d += 32;
+			s += 32;
+			n -= 32;
+		}
+		_mm256_storeu_si256((__m256i *)d_tail, tail);
+	}
+	return dest;
+}
+
+/*
+ *  test_avx512_memcpy()
+ *	copy with unaligned 512 bit loads and stores, the tail
+ *	is copied with an overlapping store, copies of less than
+ *	64 bytes use the AVX2 copy
+ */
+static NOINLINE TARGET_AVX512F void *test_avx512_memcpy(void *dest, const void *src, size_t n)
+{
+	register uint8_t *d = (uint8_t *)dest;
+	register const uint8_t *s = (const uint8_t *)src;
+	__m512i tail;
+	uint8_t *d_tail;
+
+	if (n < 64)
+		return test_avx2_memcpy(dest, src, n);
+
+	tail = _mm512_loadu_si512((const void *)(s + n - 64));
+	d_tail = d + n - 64;
+	while (n >= 256) {
+		const __m512i v0 = _mm512_loadu_si512((const void *)(s + 0));
+		const __m512i v1 = _mm512_loadu_si512((const void *)(s + 64));
+		const __m512i v2 = _mm512_loadu_si512((const void *)(s + 128));
+		const __m512i v3 = _mm512_loadu_si512((const void *)(s + 192));
+
+		_mm512_storeu_si512((void *)(d + 0), v0);
+		_mm512_storeu_si512((void *)(d + 64), v1);
+		_mm512_storeu_si512((void *)(d + 128), v2);
+		_mm512_storeu_si512((void *)(d + 192), v3);
+		d += 256;
+		s += 256;
+		n -= 256;
+	}
+	while (n >= 64) {
+		_mm512_storeu_si512((void *)d, _mm512_loadu_si512((const void *)s));
+		d += 64;
+		s += 64;
+		n -= 64;
+	}
+	_mm512_storeu_si512((void *)d_tail, tail);
+
+	return dest;
+}
+
+/*
+ *  test_nt_memcpy()
+ *	copy with non-temporal 128 bit stores that bypass the
+ *	cache, the destination is 16 byte aligned with byte copies
+ */
+static NOINLINE void *test_nt_memcpy(void *dest, const void *src, size_t n)
+{
+	register uint8_t *d = (uint8_t *)dest;
+	register const uint8_t *s = (const uint8_t *)src;
+
+	while (n && ((uintptr_t)d & 15)) {
+		*(d++) = *(s++);
+		n--;
+	}
+	while (n >= 64) {
+		const __m128i v0 = _mm_loadu_si128((const __m128i *)(s + 0));
+		const __m128i v1 = _mm_loadu_si128((const __m128i *)(s + 16));
+		const __m128i v2 = _mm_loadu_si128((const __m128i *)(s + 32));
+		const __m128i v3 = _mm_loadu_si128((const __m128i *)(s + 48));
+
+		_mm_stream_si128((__m128i *)(d + 0), v0);
+		_mm_stream_si128((__m128i *)(d + 16), v1);
+		_mm_stream_si128((__m128i *)(d + 32), v2);
+		_mm_stream_si128((__m128i *)(d + 48), v3);
+		d += 64;
+		s += 64;
+		n -= 64;
+	}
+	while (n >= 16) {
+		_mm_stream_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+		d += 16;
+		s += 16;
+		n -= 16;
+	}
+	while (n--)
+		*(d++) = *(s++);
+	_mm_sfence();
+
+	return dest;
+}
+
+STRESS_MEMCPY_NAIVE("avx2", stress_memcpy_avx2, test_avx2_memcpy, memmove)
+STRESS_MEMCPY_NAIVE("avx512", stress_memcpy_avx512, test_avx512_memcpy, memmove)
+STRESS_MEMCPY_NAIVE("nt", stress_memcpy_nt, test_nt_memcpy, memmove)
+#endif
+
+static stress_memcpy_func stress_memcpy_all_funcs[9];
+static size_t stress_memcpy_all_n;
+
+/*
+ *  stress_memcpy_all_init()
+ *	set up the methods rotated through by the "all" method,
+ *	leaving out methods the CPU does not support
+ */
+static void stress_memcpy_all_init(void)
+{
+	size_t n = 0;
+
+	stress_memcpy_all_funcs[n++] = stress_memcpy_libc;
+	stress_memcpy_all_funcs[n++] = stress_memcpy_builtin;
+	stress_memcpy_all_funcs[n++] = stress_memcpy_naive;
+	stress_memcpy_all_funcs[n++] = stress_memcpy_naive_o0;
+	stress_memcpy_all_funcs[n++] = stress_memcpy_naive_o3;
+#if defined(HAVE_ASM_X86_REP_MOVSB) &&	\
+    !defined(__ILP32__)
+	stress_memcpy_all_funcs[n++] = stress_memcpy_rep_movsb;
+#endif
+#if defined(HAVE_MEMCPY_SIMD)
+	if (stress_cpu_x86_has_avx2())
+		stress_memcpy_all_funcs[n++] = stress_memcpy_avx2;
+	if (stress_cpu_x86_has_avx512_f())
+		stress_memcpy_all_funcs[n++] = stress_memcpy_avx512;
+	stress_memcpy_all_funcs[n++] = stress_memcpy_nt;
+#endif
+	stress_memcpy_all_n = n;
+}
+
 static NOINLINE void stress_memcpy_all(
 	uint8_t *str1,
 	uint8_t *str2,
 	uint8_t *str3)
 {
-	static int whence;
-
-	switch (whence) {
-	case 0:
-		whence++;
-		stress_memcpy_libc(str1, str2, str3);
-		return;
-	case 1:
-		whence++;
-		stress_memcpy_builtin(str1, str2, str3);
-		return;
-	case 2:
-		whence++;
-		stress_memcpy_naive(str1, str2, str3);
-		return;
-	case 3:
-		whence++;
-		stress_memcpy_naive_o0(str1, str2, str3);
-		return;
-	default:
-		stress_memcpy_naive_o3(str1, str2, str3);
+	static size_t whence;
+
+	stress_memcpy_all_funcs[whence](str1, str2, str3);
+	whence++;
+	if (whence >= stress_memcpy_all_n)
 		whence = 0;
-		return;
-	}
 }
 
 static const stress_memcpy_method_info_t stress_memcpy_methods[] = {
-	{ "all",	stress_memcpy_all },
-	{ "libc",	stress_memcpy_libc },
-	{ "builtin",	stress_memcpy_builtin },
-	{ "naive",      stress_memcpy_naive },
-	{ "naive_o0",	stress_memcpy_naive_o0 },
-	{ "naive_o1",	stress_memcpy_naive_o1 },
-	{ "naive_o2",	stress_memcpy_naive_o2 },
-	{ "naive_o3",	stress_memcpy_naive_o3 },
+	{ "all",	stress_memcpy_all,	NULL,	NULL },
+	{ "libc",	stress_memcpy_libc,	memcpy,	NULL },
+#if defined(HAVE_BUILTIN_MEMCPY) &&	\
+    defined(HAVE_BUILTIN_MEMMOVE)
+	{ "builtin",	stress_memcpy_builtin,	stress_builtin_memcpy_wrapper,	NULL },
+#else
+	{ "builtin",	stress_memcpy_builtin,	NULL,	NULL },
+#endif
+	{ "naive",      stress_memcpy_naive,	NULL,	NULL },
+	{ "naive_o0",	stress_memcpy_naive_o0,	NULL,	NULL },
+	{ "naive_o1",	stress_memcpy_naive_o1,	NULL,	NULL },
+	{ "naive_o2",	stress_memcpy_naive_o2,	NULL,	NULL },
+	{ "naive_o3",	stress_memcpy_naive_o3,	NULL,	NULL },
+#if defined(HAVE_ASM_X86_REP_MOVSB) &&	\
+    !defined(__ILP32__)
+	{ "rep_movsb",	stress_memcpy_rep_movsb, test_rep_movsb_memcpy,	NULL },
+#endif
+#if defined(HAVE_MEMCPY_SIMD)
+	{ "avx2",	stress_memcpy_avx2,	test_avx2_memcpy,	stress_cpu_x86_has_avx2 },
+	{ "avx512",	stress_memcpy_avx512,	test_avx512_memcpy,	stress_cpu_x86_has_avx512_f },
+	{ "nt",		stress_memcpy_nt,	test_nt_memcpy,		NULL },
+#endif
+};
+
+/* sweep misalignments, aligned first */
+static const stress_memcpy_align_t stress_memcpy_aligns[] = {
+	{ 0,	0 },
+	{ 1,	0 },
+	{ 0,	1 },
+	{ 3,	5 },
+};
+
+static const stress_memcpy_class_t stress_memcpy_classes[MEMCPY_SWEEP_CLASSES] = {
+	{ "8B-64B",	64 },
+	{ "128B-1K",	KB },
+	{ "2K-32K",	32 * KB },
+	{ "64K-1M",	MB },
+	{ "2M-64M",	64 * MB },
 };
 
+#define MEMCPY_METHODS	SIZEOF_ARRAY(stress_memcpy_methods)
+#define MEMCPY_ALIGNS	SIZEOF_ARRAY(stress_memcpy_aligns)
+
+/* sweep results, bytes copied and time taken */
+typedef struct {
+	double bytes[MEMCPY_ALIGNS][MEMCPY_SWEEP_SIZES][MEMCPY_METHODS];
+	double duration[MEMCPY_ALIGNS][MEMCPY_SWEEP_SIZES][MEMCPY_METHODS];
+} stress_memcpy_sweep_t;
+
 /*
  *  stress_set_memcpy_method()
  *      set default memcpy stress method
@@ -312,6 +571,269 @@ static void stress_memcpy_set_default(void)
 	stress_set_memcpy_method("all");
 }
 
+/*
+ *  stress_set_memcpy_sweep()
+ *	enable the copy size and misalignment sweep
+ */
+static int stress_set_memcpy_sweep(const char *opt)
+{
+	return stress_set_setting_true("memcpy-sweep", opt);
+}
+
+/*
+ *  stress_memcpy_method_usable()
+ *	return true if a method can be swept on this CPU
+ */
+static bool stress_memcpy_method_usable(const stress_memcpy_method_info_t *method)
+{
+	if (!method->copy)
+		return false;
+	return method->capable ? method->capable() : true;
+}
+
+/*
+ *  stress_memcpy_sweep_rate()
+ *	copy size bytes, doubling the number of copies until the
+ *	copies take at least MEMCPY_SWEEP_TIME, returns the duration
+ *	and the number of bytes copied in bytes
+ */
+static double stress_memcpy_sweep_rate(
+	const memcpy_func_t copy,
+	uint8_t *dst,
+	const uint8_t *src,
+	const size_t size,
+	double *bytes)
+{
+	uint32_t loops = 1;
+	double duration;
+
+	for (;;) {
+		const double t = stress_time_now();
+		register uint32_t i;
+
+		for (i = 0; i < loops; i++)
+			(void)copy(dst, src, size);
+		duration = stress_time_now() - t;
+		if ((duration >= MEMCPY_SWEEP_TIME) || (loops >= (1U << 30)))
+			break;
+		loops <<= 1;
+	}
+	*bytes = (double)size * (double)loops;
+
+	return duration;
+}
+
+/*
+ *  stress_memcpy_sweep()
+ *	measure the copy rate of each method over copy sizes of
+ *	8 bytes to 64MB for each of the source and destination
+ *	misalignments, returns false on a copy verification failure
+ */
+static bool stress_memcpy_sweep(
+	stress_args_t *args,
+	uint8_t *src,
+	uint8_t *dst,
+	stress_memcpy_sweep_t *sweep)
+{
+	size_t i, j, k;
+
+	for (i = 0; i < MEMCPY_ALIGNS; i++) {
+		uint8_t *s = src + stress_memcpy_aligns[i].src;
+		uint8_t *d = dst + stress_memcpy_aligns[i].dst;
+
+		for (j = 0; j < MEMCPY_SWEEP_SIZES; j++) {
+			const size_t size = (size_t)MEMCPY_SWEEP_MIN << j;
+
+			for (k = 0; k < MEMCPY_METHODS; k++) {
+				const stress_memcpy_method_info_t *method = &stress_memcpy_methods[k];
+				double bytes;
+
+				if (!stress_continue(args))
+					return true;
+				if (!stress_memcpy_method_usable(method))
+					continue;
+
+				sweep->duration[i][j][k] +=
+					stress_memcpy_sweep_rate(method->copy, d, s, size, &bytes);
+				sweep->bytes[i][j][k] += bytes;
+
+				if ((g_opt_flags & OPT_FLAGS_VERIFY) && shim_memcmp(d, s, size)) {
+					pr_fail("%s: %s: %zu byte copy content is different than expected\n",
+						args->name, method->name, size);
+					return false;
+				}
+				(void)shim_memset(d, 0, size);
+			}
+		}
+	}
+	return true;
+}
+
+/*
+ *  stress_memcpy_sweep_gbs()
+ *	GB/s of a sweep measurement, 0 if not measured
+ */
+static inline double stress_memcpy_sweep_gbs(
+	const stress_memcpy_sweep_t *sweep,
+	const size_t align,
+	const size_t size,
+	const size_t method)
+{
+	const double duration = sweep->duration[align][size][method];
+
+	return (duration > 0.0) ? (sweep->bytes[align][size][method] / duration) / (double)GB : 0.0;
+}
+
+/*
+ *  stress_memcpy_sweep_report()
+ *	log a GB/s table for each misalignment and the sizes where
+ *	the fastest method changes, the mean aligned GB/s of each
+ *	method in each size class are added to the metrics
+ */
+static void stress_memcpy_sweep_report(
+	stress_args_t *args,
+	const stress_memcpy_sweep_t *sweep)
+{
+	char hdr[256], line[256], str[16];
+	size_t i, j, k, c, idx = 0, len;
+
+	if (args->instance == 0) {
+		len = (size_t)snprintf(hdr, sizeof(hdr), "%8s", "size");
+		for (k = 0; k < MEMCPY_METHODS; k++) {
+			if (stress_memcpy_method_usable(&stress_memcpy_methods[k]))
+				len += (size_t)snprintf(hdr + len, sizeof(hdr) - len, " %9s",
+					stress_memcpy_methods[k].name);
+		}
+		(void)snprintf(hdr + len, sizeof(hdr) - len, "  %s", "fastest");
+
+		for (i = 0; i < MEMCPY_ALIGNS; i++) {
+			const char *prev_best = NULL;
+			size_t from = 0;
+
+			pr_inf("%s: GB/s, source +%zu, destination +%zu bytes from 64 byte alignment:\n",
+				args->name, stress_memcpy_aligns[i].src, stress_memcpy_aligns[i].dst);
+			pr_inf("%s: %s\n", args->name, hdr);
+			for (j = 0; j < MEMCPY_SWEEP_SIZES; j++) {
+				const char *best = NULL;
+				double best_gbs = 0.0;
+
+				len = (size_t)snprintf(line, sizeof(line), "%8s",
+					stress_uint64_to_str(str, sizeof(str), (uint64_t)MEMCPY_SWEEP_MIN << j));
+				for (k = 0; k < MEMCPY_METHODS; k++) {
+					double gbs;
+
+					if (!stress_memcpy_method_usable(&stress_memcpy_methods[k]))
+						continue;
+					gbs = stress_memcpy_sweep_gbs(sweep, i, j, k);
+					len += (size_t)snprintf(line + len, sizeof(line) - len, " %9.2f", gbs);
+					if (gbs > best_gbs) {
+						best_gbs = gbs;
+						best = stress_memcpy_methods[k].name;
+					}
+				}
+				(void)snprintf(line + len, sizeof(line) - len, "  %s", best ? best : "-");
+				pr_inf("%s: %s\n", args->name, line);
+
+				/* log the size ranges each method is the fastest over */
+				if (prev_best && best && strcmp(prev_best, best)) {
+					char from_str[16];
+
+					pr_inf("%s: +%zu/+%zu: %s is fastest from %s to %s\n",
+						args->name, stress_memcpy_aligns[i].src,
+						stress_memcpy_aligns[i].dst, prev_best,
+						stress_uint64_to_str(from_str, sizeof(from_str),
+							(uint64_t)MEMCPY_SWEEP_MIN << from),
+						stress_uint64_to_str(str, sizeof(str),
+							(uint64_t)MEMCPY_SWEEP_MIN << (j - 1)));
+					from = j;
+				}
+				if (best)
+					prev_best = best;
+			}
+			if (prev_best) {
+				char from_str[16];
+
+				pr_inf("%s: +%zu/+%zu: %s is fastest from %s to %s\n",
+					args->name, stress_memcpy_aligns[i].src,
+					stress_memcpy_aligns[i].dst, prev_best,
+					stress_uint64_to_str(from_str, sizeof(from_str),
+						(uint64_t)MEMCPY_SWEEP_MIN << from),
+					stress_uint64_to_str(str, sizeof(str),
+						(uint64_t)MEMCPY_SWEEP_MIN << (MEMCPY_SWEEP_SIZES - 1)));
+			}
+		}
+	}
+
+	for (k = 0; k < MEMCPY_METHODS; k++) {
+		if (!stress_memcpy_method_usable(&stress_memcpy_methods[k]))
+			continue;
+		for (j = 0, c = 0; c < MEMCPY_SWEEP_CLASSES; c++) {
+			double total = 0.0;
+			size_t n = 0;
+			char tmp[64];
+
+			for (; (j < MEMCPY_SWEEP_SIZES) &&
+			       (((size_t)MEMCPY_SWEEP_MIN << j) <= stress_memcpy_classes[c].max); j++) {
+				total += stress_memcpy_sweep_gbs(sweep, 0, j, k);
+				n++;
+			}
+			if (!n || (idx >= STRESS_MISC_METRICS_MAX))
+				continue;
+			(void)snprintf(tmp, sizeof(tmp), "%s GB/s %s copies",
+				stress_memcpy_methods[k].name, stress_memcpy_classes[c].name);
+			stress_metrics_set(args, idx++, tmp, total / (double)n, STRESS_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_memcpy_sweeps()
+ *	sweep copy sizes and misalignments until the stressor ends
+ */
+static int stress_memcpy_sweeps(stress_args_t *args)
+{
+	const size_t size = MEMCPY_SWEEP_MAX + (2 * ALIGN_SIZE);
+	size_t buf_size = 2 * size;
+	stress_memcpy_sweep_t *sweep;
+	uint8_t *buf;
+	int rc = EXIT_SUCCESS;
+
+	sweep = calloc(1, sizeof(*sweep));
+	if (!sweep) {
+		pr_inf_skip("%s: cannot allocate sweep results, skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+	}
+	buf = (uint8_t *)stress_mmap_buffer(args->name, args->instance, &buf_size,
+				PROT_READ | PROT_WRITE, MAP_PRIVATE);
+	if (buf == MAP_FAILED) {
+		pr_inf_skip("%s: cannot allocate %zu byte sweep buffer, skipping stressor\n",
+			args->name, 2 * size);
+		free(sweep);
+		return EXIT_NO_RESOURCE;
+	}
+	stress_rndbuf(buf, size);
+	(void)shim_memset(buf + size, 0, size);
+
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	do {
+		if (!stress_memcpy_sweep(args, buf, buf + size, sweep)) {
+			rc = EXIT_FAILURE;
+			break;
+		}
+		stress_bogo_inc(args);
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_memcpy_sweep_report(args, sweep);
+
+	(void)munmap((void *)buf, buf_size);
+	free(sweep);
+
+	return rc;
+}
+
 /*
  *  stress_memcpy()
  *	stress memory copies
@@ -320,12 +842,26 @@ static int stress_memcpy(stress_args_t *args)
 {
 	uint8_t *buf, *str1, *str2, *str3;
 	size_t memcpy_method = 0;
+	size_t buf_size = 3 * MEMCPY_MEMSIZE;
 	stress_memcpy_func func;
+	bool memcpy_sweep = false;
+
+	(void)stress_get_setting("memcpy-sweep", &memcpy_sweep);
+	if (memcpy_sweep)
+		return stress_memcpy_sweeps(args);
+
+	(void)stress_get_setting("memcpy-method", &memcpy_method);
+	if (stress_memcpy_methods[memcpy_method].capable &&
+	    !stress_memcpy_methods[memcpy_method].capable()) {
+		if (args->instance == 0)
+			pr_inf_skip("%s: memcpy-method '%s' is not supported by this CPU, skipping stressor\n",
+				args->name, stress_memcpy_methods[memcpy_method].name);
+		return EXIT_NO_RESOURCE;
+	}
 
 	memcpy_okay = true;
-	buf = (uint8_t *)stress_mmap_populate(NULL, 3 * MEMCPY_MEMSIZE,
-				PROT_READ | PROT_WRITE,
-				MAP_ANONYMOUS | MAP_PRIVATE, -1 , 0);
+	buf = (uint8_t *)stress_mmap_buffer(args->name, args->instance, &buf_size,
+				PROT_READ | PROT_WRITE, MAP_PRIVATE);
 
 	if (buf == MAP_FAILED) {
 		pr_inf("%s: cannot allocate %d sized buffer\n", args->name, MEMCPY_MEMSIZE * 3);
@@ -345,7 +881,7 @@ static int stress_memcpy(stress_args_t *args)
 		memmove_check = memmove_no_check_func;
 	}
 
-	(void)stress_get_setting("memcpy-method", &memcpy_method);
+	stress_memcpy_all_init();
 	func = stress_memcpy_methods[memcpy_method].func;
 	stress_rndbuf(str3, ALIGN_SIZE);
 	stress_set_proc_state(args->name, STRESS_STATE_RUN);
@@ -357,13 +893,14 @@ static int stress_memcpy(stress_args_t *args)
 
 	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
 
-	(void)munmap((void *)buf, MEMCPY_MEMSIZE * 3);
+	(void)munmap((void *)buf, buf_size);
 
 	return EXIT_SUCCESS;
 }
 
 static const stress_opt_set_func_t opt_set_funcs[] = {
 	{ OPT_memcpy_method,	stress_set_memcpy_method },
+	{ OPT_memcpy_sweep,	stress_set_memcpy_sweep },
 	{ 0,			NULL }
 };
 
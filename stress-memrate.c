@@ -19,13 +19,35 @@
  */
 #include "stress-ng.h"
 #include "core-builtin.h"
+#include "core-cpu.h"
 #include "core-cpu-cache.h"
+#include "core-killpid.h"
 #include "core-madvise.h"
+#include "core-mmap.h"
 #include "core-nt-store.h"
 #include "core-out-of-memory.h"
 #include "core-target-clones.h"
 #include "core-vecmath.h"
 
+#if defined(HAVE_COMPILER_MUSL)
+#undef HAVE_IMMINTRIN_H
+#endif
+
+#if defined(HAVE_IMMINTRIN_H)
+#include <immintrin.h>
+#endif
+
+#if defined(HAVE_IMMINTRIN_H) &&	\
+    defined(STRESS_ARCH_X86_64) &&	\
+    (defined(HAVE_COMPILER_GCC) ||	\
+     defined(HAVE_COMPILER_CLANG) ||	\
+     defined(HAVE_COMPILER_ICX)) &&	\
+    !defined(HAVE_COMPILER_ICC)
+#define HAVE_MEMRATE_SIMD
+#define TARGET_AVX2		__attribute__ ((target("avx2")))
+#define TARGET_AVX512F		__attribute__ ((target("avx512f")))
+#endif
+
 #define MR_RD			(0)
 #define MR_WR			(1)
 
@@ -34,13 +56,37 @@
 #define DEFAULT_MEMRATE_BYTES   (256 * MB)
 #define STRESS_MEMRATE_PF_OFFSET (2 * KB)
 
+#define MR_LAT_OFF		(0)	/* no latency measurements */
+#define MR_LAT_IDLE		(1)	/* latency on an idle memory bus */
+#define MR_LAT_LOADED		(2)	/* latency with a bandwidth load */
+
+#define MR_LAT_L1		(0)
+#define MR_LAT_L2		(1)
+#define MR_LAT_LLC		(2)
+#define MR_LAT_DRAM		(3)
+#define MR_LAT_LEVELS		(4)
+
+#define MR_LAT_LOADS		(1U << 20)	/* pointer chase loads per level */
+#define MR_LAT_DRAM_MIN		(32 * MB)	/* minimum DRAM working set */
+
+#define MR_SWEEP_MIN		(4 * KB)	/* smallest sweep working set */
+#define MR_SWEEP_MAX_SIZES	(64)		/* max sweep working set sizes */
+#define MR_SWEEP_LLC_SCALE	(4)		/* sweep up to 4 x LLC size */
+#define MR_SWEEP_MIN_TIME	(0.002)		/* min time per method and size */
+#define MR_SWEEP_KNEE_DROP	(0.80)		/* < 80% of plateau is a knee */
+#define MR_SWEEP_FLAT		(0.95)		/* >= 95% of previous is flat */
+#define MR_SWEEP_KNEES_MAX	(4)		/* max knees reported */
+
 #define STRESS_PTR_MINIMUM(a, b)	STRESS_MINIMUM((uintptr_t)a, (uintptr_t)b)
 
 static const stress_help_t help[] = {
 	{ NULL,	"memrate N",		"start N workers exercised memory read/writes" },
 	{ NULL,	"memrate-bytes N",	"size of memory buffer being exercised" },
+	{ NULL,	"memrate-latency M",	"measure pointer chase latency, M = idle or loaded" },
+	{ NULL,	"memrate-method M",	"select memrate method M, default is all" },
 	{ NULL,	"memrate-ops N",	"stop after N memrate bogo operations" },
 	{ NULL,	"memrate-rd-mbs N",	"read rate from buffer in megabytes per second" },
+	{ NULL,	"memrate-sweep",	"sweep working set sizes and detect cache size knees" },
 	{ NULL,	"memrate-wr-mbs N",	"write rate to buffer in megabytes per second" },
 	{ NULL,	"memrate-flush",	"flush cache before each iteration" },
 	{ NULL,	NULL,			NULL }
@@ -61,25 +107,57 @@ typedef struct {
 	bool		valid;
 } stress_memrate_stats_t;
 
+typedef struct {
+	double		duration;	/* time spent chasing pointers */
+	double		loads;		/* number of pointer chase loads */
+	size_t		size;		/* working set size in bytes */
+} stress_memrate_latency_t;
+
 typedef struct {
 	stress_memrate_stats_t *stats;
+	stress_memrate_latency_t *latency;
+	stress_memrate_stats_t *sweep;	/* [sweep_sizes][memrate_items] stats */
+	size_t sweep_sizes[MR_SWEEP_MAX_SIZES];
+	size_t n_sweep_sizes;
 	uint64_t memrate_bytes;
 	uint64_t memrate_rd_mbs;
 	uint64_t memrate_wr_mbs;
 	void *start;
 	void *end;
 	bool memrate_flush;
+	bool memrate_sweep;
+	int memrate_latency;
+	size_t memrate_method;		/* method index, memrate_items = all */
+	pid_t generator_pid;
 } stress_memrate_context_t;
 
 typedef uint64_t (*stress_memrate_func_t)(const stress_memrate_context_t *context, bool *valid);
 
 typedef struct {
 	const char 	*name;
-	const int	rdwr;
-	const stress_memrate_func_t	func;
-	const stress_memrate_func_t	func_rate;
+	int		rdwr;
+	stress_memrate_func_t	func;
+	stress_memrate_func_t	func_rate;
+	bool		(*capable)(void);	/* NULL if always usable */
 } stress_memrate_info_t;
 
+typedef struct {
+	const char	*name;
+	const int	mode;
+} stress_memrate_latency_info_t;
+
+static const stress_memrate_latency_info_t memrate_latency_info[] = {
+	{ "idle",	MR_LAT_IDLE },
+	{ "loaded",	MR_LAT_LOADED },
+	{ NULL,		MR_LAT_OFF },
+};
+
+static const char * const memrate_latency_levels[MR_LAT_LEVELS] = {
+	"L1", "L2", "LLC", "DRAM"
+};
+
+static void * volatile memrate_chase_sink;
+
 static int stress_set_memrate_bytes(const char *opt)
 {
 	uint64_t memrate_bytes;
@@ -90,6 +168,26 @@ static int stress_set_memrate_bytes(const char *opt)
 	return stress_set_setting("memrate-bytes", TYPE_ID_UINT64, &memrate_bytes);
 }
 
+static int stress_set_memrate_latency(const char *opt)
+{
+	const stress_memrate_latency_info_t *info;
+
+	for (info = memrate_latency_info; info->name; info++) {
+		if (!strcmp(opt, info->name))
+			return stress_set_setting("memrate-latency", TYPE_ID_INT, &info->mode);
+	}
+	(void)fprintf(stderr, "invalid memrate-latency mode '%s', allowed modes are:", opt);
+	for (info = memrate_latency_info; info->name; info++)
+		(void)fprintf(stderr, " %s", info->name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+static int stress_set_memrate_sweep(const char *opt)
+{
+	return stress_set_setting_true("memrate-sweep", opt);
+}
+
 static int stress_set_memrate_rd_mbs(const char *opt)
 {
 	uint64_t memrate_rd_mbs;
@@ -879,68 +977,353 @@ STRESS_MEMRATE_WRITE_RATE(16, uint16_t)
 STRESS_MEMRATE_WRITE(8, uint8_t)
 STRESS_MEMRATE_WRITE_RATE(8, uint8_t)
 
+#if defined(HAVE_MEMRATE_SIMD)
+static volatile uint64_t memrate_simd_sink;
+
+/*
+ *  stress_memrate_simd_rate()
+ *	run a full speed simd method over 1MB or smaller chunks
+ *	of the buffer, sleeping between chunks to limit the rate
+ *	to mbs MB per second
+ */
+static uint64_t OPTIMIZE3 stress_memrate_simd_rate(
+	const stress_memrate_context_t *context,
+	bool *valid,
+	const stress_memrate_func_t func,
+	const uint64_t mbs)
+{
+	stress_memrate_context_t chunk = *context;
+	const uint64_t loops = stress_memrate_loops(context, KB);
+	const size_t chunk_size = (size_t)STRESS_MINIMUM(loops * KB, MB);
+	uint8_t *ptr, *end = (uint8_t *)context->end;
+	uint64_t kbytes = 0;
+	double t1, total_dur = 0.0;
+
+	t1 = stress_time_now();
+	for (ptr = (uint8_t *)context->start; ptr < end; ptr += chunk_size) {
+		double t2, dur_remainder;
+
+		chunk.start = (void *)ptr;
+		chunk.end = (void *)STRESS_PTR_MINIMUM(ptr + chunk_size, end);
+		kbytes += func(&chunk, valid);
+		if (!*valid)
+			return 0;
+
+		t2 = stress_time_now();
+		total_dur += (double)((uint8_t *)chunk.end - ptr) / (MB * (double)mbs);
+		dur_remainder = total_dur - (t2 - t1);
+
+		if (dur_remainder >= 0.0) {
+			struct timespec t;
+			time_t sec = (time_t)dur_remainder;
+
+			t.tv_sec = sec;
+			t.tv_nsec = (long)((dur_remainder -
+				(double)sec) *
+				STRESS_NANOSECOND);
+			(void)nanosleep(&t, NULL);
+		}
+	}
+	return kbytes;
+}
+
+static uint64_t TARGET_AVX2 OPTIMIZE3 stress_memrate_read256avx2(
+	const stress_memrate_context_t *context,
+	bool *valid)
+{
+	register __m256i *ptr;
+	__m256i *start = (__m256i *)context->start;
+	const __m256i *end = (__m256i *)context->end;
+	__m256i v0, v1, v2, v3;
+
+	v0 = _mm256_setzero_si256();
+	v1 = v0;
+	v2 = v0;
+	v3 = v0;
+	for (ptr = start; ptr < end; ptr += 8) {
+		v0 = _mm256_xor_si256(v0, _mm256_load_si256(ptr + 0));
+		v1 = _mm256_xor_si256(v1, _mm256_load_si256(ptr + 1));
+		v2 = _mm256_xor_si256(v2, _mm256_load_si256(ptr + 2));
+		v3 = _mm256_xor_si256(v3, _mm256_load_si256(ptr + 3));
+		v0 = _mm256_xor_si256(v0, _mm256_load_si256(ptr + 4));
+		v1 = _mm256_xor_si256(v1, _mm256_load_si256(ptr + 5));
+		v2 = _mm256_xor_si256(v2, _mm256_load_si256(ptr + 6));
+		v3 = _mm256_xor_si256(v3, _mm256_load_si256(ptr + 7));
+	}
+	v0 = _mm256_xor_si256(_mm256_xor_si256(v0, v1), _mm256_xor_si256(v2, v3));
+	memrate_simd_sink = (uint64_t)_mm256_extract_epi64(v0, 0);
+
+	*valid = true;
+	return ((uintptr_t)ptr - (uintptr_t)start) / KB;
+}
+
+static uint64_t TARGET_AVX2 OPTIMIZE3 stress_memrate_write256avx2(
+	const stress_memrate_context_t *context,
+	bool *valid)
+{
+	register __m256i *ptr;
+	__m256i *start = (__m256i *)context->start;
+	const __m256i *end = (__m256i *)context->end;
+	const __m256i v = _mm256_set1_epi8((char)0xaa);
+
+	for (ptr = start; ptr < end; ptr += 8) {
+		_mm256_store_si256(ptr + 0, v);
+		_mm256_store_si256(ptr + 1, v);
+		_mm256_store_si256(ptr + 2, v);
+		_mm256_store_si256(ptr + 3, v);
+		_mm256_store_si256(ptr + 4, v);
+		_mm256_store_si256(ptr + 5, v);
+		_mm256_store_si256(ptr + 6, v);
+		_mm256_store_si256(ptr + 7, v);
+	}
+
+	*valid = true;
+	return ((uintptr_t)ptr - (uintptr_t)start) / KB;
+}
+
+static uint64_t TARGET_AVX2 OPTIMIZE3 stress_memrate_write256avx2nt(
+	const stress_memrate_context_t *context,
+	bool *valid)
+{
+	register __m256i *ptr;
+	__m256i *start = (__m256i *)context->start;
+	const __m256i *end = (__m256i *)context->end;
+	const __m256i v = _mm256_set1_epi8((char)0xaa);
+
+	for (ptr = start; ptr < end; ptr += 8) {
+		_mm256_stream_si256(ptr + 0, v);
+		_mm256_stream_si256(ptr + 1, v);
+		_mm256_stream_si256(ptr + 2, v);
+		_mm256_stream_si256(ptr + 3, v);
+		_mm256_stream_si256(ptr + 4, v);
+		_mm256_stream_si256(ptr + 5, v);
+		_mm256_stream_si256(ptr + 6, v);
+		_mm256_stream_si256(ptr + 7, v);
+	}
+	_mm_sfence();
+
+	*valid = true;
+	return ((uintptr_t)ptr - (uintptr_t)start) / KB;
+}
+
+static uint64_t TARGET_AVX512F OPTIMIZE3 stress_memrate_read512avx512(
+	const stress_memrate_context_t *context,
+	bool *valid)
+{
+	register __m512i *ptr;
+	__m512i *start = (__m512i *)context->start;
+	const __m512i *end = (__m512i *)context->end;
+	__m512i v0, v1, v2, v3;
+
+	v0 = _mm512_setzero_si512();
+	v1 = v0;
+	v2 = v0;
+	v3 = v0;
+	for (ptr = start; ptr < end; ptr += 8) {
+		v0 = _mm512_xor_si512(v0, _mm512_load_si512((void *)(ptr + 0)));
+		v1 = _mm512_xor_si512(v1, _mm512_load_si512((void *)(ptr + 1)));
+		v2 = _mm512_xor_si512(v2, _mm512_load_si512((void *)(ptr + 2)));
+		v3 = _mm512_xor_si512(v3, _mm512_load_si512((void *)(ptr + 3)));
+		v0 = _mm512_xor_si512(v0, _mm512_load_si512((void *)(ptr + 4)));
+		v1 = _mm512_xor_si512(v1, _mm512_load_si512((void *)(ptr + 5)));
+		v2 = _mm512_xor_si512(v2, _mm512_load_si512((void *)(ptr + 6)));
+		v3 = _mm512_xor_si512(v3, _mm512_load_si512((void *)(ptr + 7)));
+	}
+	v0 = _mm512_xor_si512(_mm512_xor_si512(v0, v1), _mm512_xor_si512(v2, v3));
+	memrate_simd_sink = (uint64_t)_mm512_reduce_or_epi64(v0);
+
+	*valid = true;
+	return ((uintptr_t)ptr - (uintptr_t)start) / KB;
+}
+
+static uint64_t TARGET_AVX512F OPTIMIZE3 stress_memrate_write512avx512(
+	const stress_memrate_context_t *context,
+	bool *valid)
+{
+	register __m512i *ptr;
+	__m512i *start = (__m512i *)context->start;
+	const __m512i *end = (__m512i *)context->end;
+	const __m512i v = _mm512_set1_epi32((int)0xaaaaaaaa);
+
+	for (ptr = start; ptr < end; ptr += 8) {
+		_mm512_store_si512((void *)(ptr + 0), v);
+		_mm512_store_si512((void *)(ptr + 1), v);
+		_mm512_store_si512((void *)(ptr + 2), v);
+		_mm512_store_si512((void *)(ptr + 3), v);
+		_mm512_store_si512((void *)(ptr + 4), v);
+		_mm512_store_si512((void *)(ptr + 5), v);
+		_mm512_store_si512((void *)(ptr + 6), v);
+		_mm512_store_si512((void *)(ptr + 7), v);
+	}
+
+	*valid = true;
+	return ((uintptr_t)ptr - (uintptr_t)start) / KB;
+}
+
+static uint64_t TARGET_AVX512F OPTIMIZE3 stress_memrate_write512avx512nt(
+	const stress_memrate_context_t *context,
+	bool *valid)
+{
+	register __m512i *ptr;
+	__m512i *start = (__m512i *)context->start;
+	const __m512i *end = (__m512i *)context->end;
+	const __m512i v = _mm512_set1_epi32((int)0xaaaaaaaa);
+
+	for (ptr = start; ptr < end; ptr += 8) {
+		_mm512_stream_si512((void *)(ptr + 0), v);
+		_mm512_stream_si512((void *)(ptr + 1), v);
+		_mm512_stream_si512((void *)(ptr + 2), v);
+		_mm512_stream_si512((void *)(ptr + 3), v);
+		_mm512_stream_si512((void *)(ptr + 4), v);
+		_mm512_stream_si512((void *)(ptr + 5), v);
+		_mm512_stream_si512((void *)(ptr + 6), v);
+		_mm512_stream_si512((void *)(ptr + 7), v);
+	}
+	_mm_sfence();
+
+	*valid = true;
+	return ((uintptr_t)ptr - (uintptr_t)start) / KB;
+}
+
+#define STRESS_MEMRATE_SIMD_RATE(name, mbs)			\
+static uint64_t stress_memrate_##name##_rate(			\
+	const stress_memrate_context_t *context,		\
+	bool *valid)						\
+{								\
+	return stress_memrate_simd_rate(context, valid,		\
+		stress_memrate_##name, context->mbs);		\
+}
+
+STRESS_MEMRATE_SIMD_RATE(read256avx2, memrate_rd_mbs)
+STRESS_MEMRATE_SIMD_RATE(write256avx2, memrate_wr_mbs)
+STRESS_MEMRATE_SIMD_RATE(write256avx2nt, memrate_wr_mbs)
+STRESS_MEMRATE_SIMD_RATE(read512avx512, memrate_rd_mbs)
+STRESS_MEMRATE_SIMD_RATE(write512avx512, memrate_wr_mbs)
+STRESS_MEMRATE_SIMD_RATE(write512avx512nt, memrate_wr_mbs)
+#endif
+
 static stress_memrate_info_t memrate_info[] = {
+#if defined(HAVE_MEMRATE_SIMD)
+	{ "write512avx512nt", MR_WR, stress_memrate_write512avx512nt, stress_memrate_write512avx512nt_rate, stress_cpu_x86_has_avx512_f },
+	{ "write512avx512", MR_WR, stress_memrate_write512avx512, stress_memrate_write512avx512_rate, stress_cpu_x86_has_avx512_f },
+	{ "write256avx2nt", MR_WR, stress_memrate_write256avx2nt, stress_memrate_write256avx2nt_rate, stress_cpu_x86_has_avx2 },
+	{ "write256avx2", MR_WR, stress_memrate_write256avx2,	stress_memrate_write256avx2_rate, stress_cpu_x86_has_avx2 },
+#endif
 #if defined(HAVE_ASM_X86_REP_STOSQ) &&	\
     !defined(__ILP32__)
-	{ "write64stoq", MR_WR,	stress_memrate_write_stos64,	stress_memrate_write_stos_rate64 },
+	{ "write64stoq", MR_WR,	stress_memrate_write_stos64,	stress_memrate_write_stos_rate64, NULL },
 #endif
 #if defined(HAVE_ASM_X86_REP_STOSD) &&	\
     !defined(__ILP32__)
-	{ "write32stow",MR_WR,	stress_memrate_write_stos32,	stress_memrate_write_stos_rate32 },
+	{ "write32stow",MR_WR,	stress_memrate_write_stos32,	stress_memrate_write_stos_rate32, NULL },
 #endif
 #if defined(HAVE_ASM_X86_REP_STOSW) &&	\
     !defined(__ILP32__)
-	{ "write16stod",MR_WR,	stress_memrate_write_stos16,	stress_memrate_write_stos_rate16 },
+	{ "write16stod",MR_WR,	stress_memrate_write_stos16,	stress_memrate_write_stos_rate16, NULL },
 #endif
 #if defined(HAVE_ASM_X86_REP_STOSB) &&	\
     !defined(__ILP32__)
-	{ "write8stob",	MR_WR,	stress_memrate_write_stos8,	stress_memrate_write_stos_rate8 },
+	{ "write8stob",	MR_WR,	stress_memrate_write_stos8,	stress_memrate_write_stos_rate8, NULL },
 #endif
 #if defined(HAVE_NT_STORE128)
-	{ "write128nt",	MR_WR, stress_memrate_write_nt128,	stress_memrate_write_nt_rate128 },
+	{ "write128nt",	MR_WR, stress_memrate_write_nt128,	stress_memrate_write_nt_rate128, NULL },
 #endif
 #if defined(HAVE_NT_STORE64)
-	{ "write64nt",	MR_WR, stress_memrate_write_nt64,	stress_memrate_write_nt_rate64 },
+	{ "write64nt",	MR_WR, stress_memrate_write_nt64,	stress_memrate_write_nt_rate64, NULL },
 #endif
 #if defined(HAVE_NT_STORE32)
-	{ "write32nt",	MR_WR, stress_memrate_write_nt32,	stress_memrate_write_nt_rate32 },
+	{ "write32nt",	MR_WR, stress_memrate_write_nt32,	stress_memrate_write_nt_rate32, NULL },
 #endif
 #if defined(HAVE_VECMATH)
-	{ "write1024",	MR_WR, stress_memrate_write1024,	stress_memrate_write_rate1024 },
-	{ "write512",	MR_WR, stress_memrate_write512,		stress_memrate_write_rate512 },
-	{ "write256",	MR_WR, stress_memrate_write256,		stress_memrate_write_rate256 },
-	{ "write128",	MR_WR, stress_memrate_write128,		stress_memrate_write_rate128 },
+	{ "write1024",	MR_WR, stress_memrate_write1024,	stress_memrate_write_rate1024, NULL },
+	{ "write512",	MR_WR, stress_memrate_write512,		stress_memrate_write_rate512, NULL },
+	{ "write256",	MR_WR, stress_memrate_write256,		stress_memrate_write_rate256, NULL },
+	{ "write128",	MR_WR, stress_memrate_write128,		stress_memrate_write_rate128, NULL },
 #endif
 #if defined(HAVE_INT128_T) && !defined(HAVE_VECMATH)
-	{ "write128",	MR_WR, stress_memrate_write128,		stress_memrate_write_rate128 },
+	{ "write128",	MR_WR, stress_memrate_write128,		stress_memrate_write_rate128, NULL },
+#endif
+	{ "write64",	MR_WR, stress_memrate_write64,		stress_memrate_write_rate64, NULL },
+	{ "write32",	MR_WR, stress_memrate_write32,		stress_memrate_write_rate32, NULL },
+	{ "write16",	MR_WR, stress_memrate_write16,		stress_memrate_write_rate16, NULL },
+	{ "write8",	MR_WR, stress_memrate_write8,		stress_memrate_write_rate8, NULL },
+	{ "memset",	MR_WR, stress_memrate_memset,		stress_memrate_memset_rate, NULL },
+#if defined(HAVE_MEMRATE_SIMD)
+	{ "read512avx512", MR_RD, stress_memrate_read512avx512,	stress_memrate_read512avx512_rate, stress_cpu_x86_has_avx512_f },
+	{ "read256avx2", MR_RD, stress_memrate_read256avx2,	stress_memrate_read256avx2_rate, stress_cpu_x86_has_avx2 },
 #endif
-	{ "write64",	MR_WR, stress_memrate_write64,		stress_memrate_write_rate64 },
-	{ "write32",	MR_WR, stress_memrate_write32,		stress_memrate_write_rate32 },
-	{ "write16",	MR_WR, stress_memrate_write16,		stress_memrate_write_rate16 },
-	{ "write8",	MR_WR, stress_memrate_write8,		stress_memrate_write_rate8 },
-	{ "memset",	MR_WR, stress_memrate_memset,		stress_memrate_memset_rate },
 #if defined(HAVE_BUILTIN_PREFETCH)
 #if defined(HAVE_INT128_T)
-	{ "read128pf",	MR_RD, stress_memrate_read128pf,	stress_memrate_read_rate128pf },
+	{ "read128pf",	MR_RD, stress_memrate_read128pf,	stress_memrate_read_rate128pf, NULL },
 #endif
-	{ "read64pf",	MR_RD, stress_memrate_read64pf,		stress_memrate_read_rate64pf },
+	{ "read64pf",	MR_RD, stress_memrate_read64pf,		stress_memrate_read_rate64pf, NULL },
 #endif
 #if defined(HAVE_VECMATH)
-	{ "read1024",	MR_RD, stress_memrate_read1024,		stress_memrate_read_rate1024 },
-	{ "read512",	MR_RD, stress_memrate_read512,		stress_memrate_read_rate512 },
-	{ "read256",	MR_RD, stress_memrate_read256,		stress_memrate_read_rate256 },
-	{ "read128",	MR_RD, stress_memrate_read128,		stress_memrate_read_rate128 },
+	{ "read1024",	MR_RD, stress_memrate_read1024,		stress_memrate_read_rate1024, NULL },
+	{ "read512",	MR_RD, stress_memrate_read512,		stress_memrate_read_rate512, NULL },
+	{ "read256",	MR_RD, stress_memrate_read256,		stress_memrate_read_rate256, NULL },
+	{ "read128",	MR_RD, stress_memrate_read128,		stress_memrate_read_rate128, NULL },
 #endif
 #if defined(HAVE_INT128_T) && !defined(HAVE_VECMATH)
-	{ "read128",	MR_RD, stress_memrate_read128,		stress_memrate_read_rate128 },
+	{ "read128",	MR_RD, stress_memrate_read128,		stress_memrate_read_rate128, NULL },
 #endif
-	{ "read64",	MR_RD, stress_memrate_read64,		stress_memrate_read_rate64 },
-	{ "read32",	MR_RD, stress_memrate_read32,		stress_memrate_read_rate32 },
-	{ "read16",	MR_RD, stress_memrate_read16,		stress_memrate_read_rate16 },
-	{ "read8",	MR_RD, stress_memrate_read8,		stress_memrate_read_rate8 },
+	{ "read64",	MR_RD, stress_memrate_read64,		stress_memrate_read_rate64, NULL },
+	{ "read32",	MR_RD, stress_memrate_read32,		stress_memrate_read_rate32, NULL },
+	{ "read16",	MR_RD, stress_memrate_read16,		stress_memrate_read_rate16, NULL },
+	{ "read8",	MR_RD, stress_memrate_read8,		stress_memrate_read_rate8, NULL },
 };
 
-static const size_t memrate_items = SIZEOF_ARRAY(memrate_info);
+static size_t memrate_items = SIZEOF_ARRAY(memrate_info);
+
+static int stress_set_memrate_method(const char *opt)
+{
+	size_t i;
+
+	if (!strcmp(opt, "all"))
+		return stress_set_setting("memrate-method", TYPE_ID_SIZE_T, &memrate_items);
+	for (i = 0; i < memrate_items; i++) {
+		if (!strcmp(opt, memrate_info[i].name))
+			return stress_set_setting("memrate-method", TYPE_ID_SIZE_T, &i);
+	}
+	(void)fprintf(stderr, "invalid memrate-method '%s', allowed methods are: all", opt);
+	for (i = 0; i < memrate_items; i++)
+		(void)fprintf(stderr, " %s", memrate_info[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+/*
+ *  stress_memrate_capable()
+ *	drop the methods the CPU does not support from the method
+ *	table so that the kernels themselves need no feature checks,
+ *	remap the --memrate-method index to the compacted table,
+ *	returns false if the selected method is not supported
+ */
+static bool stress_memrate_capable(stress_args_t *args, stress_memrate_context_t *context)
+{
+	const char *selected = (context->memrate_method < memrate_items) ?
+		memrate_info[context->memrate_method].name : NULL;
+	size_t i, n = 0;
+
+	for (i = 0; i < memrate_items; i++) {
+		if (memrate_info[i].capable && !memrate_info[i].capable()) {
+			if (selected && !strcmp(selected, memrate_info[i].name)) {
+				if (args->instance == 0)
+					pr_inf_skip("%s: memrate-method %s is not supported by this CPU, "
+						"skipping stressor\n", args->name, selected);
+				return false;
+			}
+			continue;
+		}
+		if (selected && !strcmp(selected, memrate_info[i].name))
+			context->memrate_method = n;
+		memrate_info[n++] = memrate_info[i];
+	}
+	if (!selected)
+		context->memrate_method = n;
+	memrate_items = n;
+	return true;
+}
 
 static void OPTIMIZE3 stress_memrate_init_data(
 	void *start,
@@ -952,11 +1335,26 @@ static void OPTIMIZE3 stress_memrate_init_data(
 		*ptr = stress_mwc32();
 }
 
-static inline void *stress_memrate_mmap(stress_args_t *args, uint64_t sz)
+/*
+ *  stress_memrate_mmap()
+ *	mmap a buffer of *sz bytes, *sz is updated to the size
+ *	mapped when --page-size rounds it up to the page size
+ */
+static inline void *stress_memrate_mmap(stress_args_t *args, size_t *sz)
 {
 	void *ptr;
 
-	ptr = stress_mmap_populate(NULL, (size_t)sz, PROT_READ | PROT_WRITE,
+	if (stress_page_size_enabled()) {
+		ptr = stress_mmap_buffer(args->name, args->instance, sz,
+				PROT_READ | PROT_WRITE, MAP_PRIVATE);
+		if (ptr == MAP_FAILED)
+			pr_err("%s: cannot allocate %zu K\n", args->name, *sz / 1024);
+		else
+			(void)stress_madvise_mergeable(ptr, *sz);
+		return ptr;
+	}
+
+	ptr = stress_mmap_populate(NULL, *sz, PROT_READ | PROT_WRITE,
 #if defined(HAVE_MADVISE)
 		MAP_PRIVATE |
 #else
@@ -965,16 +1363,16 @@ static inline void *stress_memrate_mmap(stress_args_t *args, uint64_t sz)
 		MAP_ANONYMOUS, -1, 0);
 	/* Coverity Scan believes NULL can be returned, doh */
 	if (!ptr || (ptr == MAP_FAILED)) {
-		pr_err("%s: cannot allocate %" PRIu64 " K\n",
-			args->name, sz / 1024);
+		pr_err("%s: cannot allocate %zu K\n",
+			args->name, *sz / 1024);
 		ptr = MAP_FAILED;
 	} else {
 #if defined(HAVE_MADVISE) &&	\
     defined(MADV_HUGEPAGE)
 
-		VOID_RET(int, madvise(ptr, sz, MADV_HUGEPAGE));
+		VOID_RET(int, madvise(ptr, *sz, MADV_HUGEPAGE));
 #endif
-		(void)stress_madvise_mergeable(ptr, sz);
+		(void)stress_madvise_mergeable(ptr, *sz);
 	}
 	return ptr;
 }
@@ -991,14 +1389,456 @@ static inline uint64_t stress_memrate_dispatch(
 	return info->func_rate(context, valid);
 }
 
+/*
+ *  stress_memrate_method()
+ *	exercise memory with memrate method i and account the rate
+ */
+static void stress_memrate_method(stress_memrate_context_t *context, const size_t i)
+{
+	double t1, t2;
+	uint64_t kbytes;
+	const stress_memrate_info_t *info = &memrate_info[i];
+	bool valid = false;
+
+	if ((context->memrate_method < memrate_items) &&
+	    (context->memrate_method != i))
+		return;
+	if (context->memrate_flush)
+		stress_memrate_flush(context);
+	t1 = stress_time_now();
+	kbytes = stress_memrate_dispatch(info, context, &valid);
+	context->stats[i].kbytes += (double)kbytes;
+	t2 = stress_time_now();
+	context->stats[i].duration += (t2 - t1);
+	context->stats[i].valid = valid;
+}
+
+/*
+ *  stress_memrate_latency_sizes()
+ *	determine the pointer chase working set sizes, half of each
+ *	cache level so the chain stays resident and several times the
+ *	LLC size for DRAM, a size of zero skips the level
+ */
+static void stress_memrate_latency_sizes(size_t sizes[MR_LAT_LEVELS], size_t *line_size)
+{
+	size_t l1, l2, llc, l1_line, l2_line, llc_line;
+
+	stress_cpu_cache_get_level_size(1, &l1, &l1_line);
+	stress_cpu_cache_get_level_size(2, &l2, &l2_line);
+	stress_cpu_cache_get_llc_size(&llc, &llc_line);
+
+	if (!l1)
+		l1 = 32 * KB;
+	if (!llc)
+		llc = 4 * MB;
+
+	*line_size = l1_line ? l1_line : 64;
+	sizes[MR_LAT_L1] = l1 / 2;
+	sizes[MR_LAT_L2] = (l2 > l1) ? l2 / 2 : 0;
+	sizes[MR_LAT_LLC] = ((llc > l2) && (llc > l1)) ? llc / 2 : 0;
+	sizes[MR_LAT_DRAM] = STRESS_MAXIMUM(llc * 8, MR_LAT_DRAM_MIN);
+}
+
+/*
+ *  stress_memrate_chase_init()
+ *	link the cache lines of a buffer into a single randomly
+ *	ordered cycle (Sattolo's algorithm) so that each load depends
+ *	on the previous one and hardware prefetching is defeated
+ */
+static int stress_memrate_chase_init(void *buf, const size_t size, const size_t line_size)
+{
+	const size_t n = size / line_size;
+	size_t i, *perm;
+
+	perm = calloc(n, sizeof(*perm));
+	if (!perm)
+		return -1;
+	for (i = 0; i < n; i++)
+		perm[i] = i;
+	for (i = n - 1; i > 0; i--) {
+		const size_t j = (size_t)stress_mwc64modn((uint64_t)i);
+		const size_t tmp = perm[i];
+
+		perm[i] = perm[j];
+		perm[j] = tmp;
+	}
+	for (i = 0; i < n; i++) {
+		void **line = (void **)((uintptr_t)buf + (i * line_size));
+
+		*line = (void *)((uintptr_t)buf + (perm[i] * line_size));
+	}
+	free(perm);
+	return 0;
+}
+
+/*
+ *  stress_memrate_chase()
+ *	follow a pointer chain for loads loads, return duration
+ */
+static double OPTIMIZE3 stress_memrate_chase(void *start, const uint32_t loads)
+{
+	register void **ptr = (void **)start;
+	register uint32_t i;
+	double t1, t2;
+
+	t1 = stress_time_now();
+	for (i = 0; i < loads; i += 16) {
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+	}
+	t2 = stress_time_now();
+	memrate_chase_sink = (void *)ptr;
+
+	return t2 - t1;
+}
+
+/*
+ *  stress_memrate_generator()
+ *	bandwidth load generator for --memrate-latency loaded,
+ *	runs the memrate methods at the --memrate-rd-mbs and
+ *	--memrate-wr-mbs rates until the stressor is stopped
+ *	or killed by the parent
+ */
+static void NORETURN stress_memrate_generator(stress_memrate_context_t *context)
+{
+	stress_parent_died_alarm();
+	stress_set_proc_state_str("memrate", "generator");
+
+	if (sigsetjmp(jmpbuf, 1) != 0)
+		_exit(0);
+
+	while (stress_continue_flag()) {
+		size_t i;
+
+		for (i = 0; (i < memrate_items) && stress_continue_flag(); i++)
+			stress_memrate_method(context, i);
+	}
+	_exit(0);
+}
+
+/*
+ *  stress_memrate_latency_chase()
+ *	chase the pointer chains of each working set until the
+ *	stressor is stopped
+ */
+static void stress_memrate_latency_chase(
+	stress_args_t *args,
+	stress_memrate_context_t *context,
+	void *bufs[MR_LAT_LEVELS],
+	const size_t sizes[MR_LAT_LEVELS],
+	const size_t line_size)
+{
+	if (sigsetjmp(jmpbuf, 1) != 0)
+		return;
+
+	do {
+		int i;
+
+		for (i = 0; i < MR_LAT_LEVELS; i++) {
+			if (bufs[i] == MAP_FAILED)
+				continue;
+			/* warm up the caches and TLB before timing */
+			(void)stress_memrate_chase(bufs[i],
+				(uint32_t)STRESS_MINIMUM(sizes[i] / line_size, MR_LAT_LOADS));
+			context->latency[i].duration += stress_memrate_chase(bufs[i], MR_LAT_LOADS);
+			context->latency[i].loads += (double)MR_LAT_LOADS;
+			if (!stress_continue(args))
+				break;
+		}
+		stress_bogo_inc(args);
+	} while (stress_continue(args));
+}
+
+/*
+ *  stress_memrate_latency()
+ *	measure pointer chase latency at the L1, L2, LLC and DRAM
+ *	working set sizes, optionally while a bandwidth generator
+ *	process loads the memory bus
+ */
+static int stress_memrate_latency(stress_args_t *args, stress_memrate_context_t *context)
+{
+	void *bufs[MR_LAT_LEVELS];
+	size_t sizes[MR_LAT_LEVELS], map_sizes[MR_LAT_LEVELS], line_size;
+	int i, rc = EXIT_SUCCESS;
+
+	stress_memrate_latency_sizes(sizes, &line_size);
+	for (i = 0; i < MR_LAT_LEVELS; i++) {
+		bufs[i] = MAP_FAILED;
+		map_sizes[i] = 0;
+		context->latency[i].size = sizes[i];
+	}
+	for (i = 0; i < MR_LAT_LEVELS; i++) {
+		if (!sizes[i])
+			continue;
+		map_sizes[i] = sizes[i];
+		bufs[i] = stress_memrate_mmap(args, &map_sizes[i]);
+		if (bufs[i] == MAP_FAILED) {
+			rc = EXIT_NO_RESOURCE;
+			goto tidy;
+		}
+		if (stress_memrate_chase_init(bufs[i], sizes[i], line_size) < 0) {
+			pr_inf_skip("%s: cannot allocate pointer chase index, skipping stressor\n",
+				args->name);
+			rc = EXIT_NO_RESOURCE;
+			goto tidy;
+		}
+	}
+
+	if (context->memrate_latency == MR_LAT_LOADED) {
+		context->generator_pid = fork();
+		if (context->generator_pid < 0) {
+			pr_inf_skip("%s: cannot fork bandwidth generator, errno=%d (%s), "
+				"skipping stressor\n", args->name, errno, strerror(errno));
+			rc = EXIT_NO_RESOURCE;
+			goto tidy;
+		} else if (context->generator_pid == 0) {
+			stress_memrate_generator(context);
+		}
+	}
+
+	stress_memrate_latency_chase(args, context, bufs, sizes, line_size);
+
+tidy:
+	if (context->generator_pid > 0) {
+		(void)stress_kill_pid_wait(context->generator_pid, NULL);
+		context->generator_pid = -1;
+	}
+	for (i = 0; i < MR_LAT_LEVELS; i++) {
+		if (bufs[i] != MAP_FAILED)
+			(void)munmap(bufs[i], map_sizes[i]);
+	}
+	return rc;
+}
+
+/*
+ *  stress_memrate_sweep_sizes()
+ *	geometric working set sizes from 4K to several times the
+ *	LLC size in alternate x1.5 and x4/3 steps (4K, 6K, 8K, 12K..)
+ *	returns the largest size
+ */
+static size_t stress_memrate_sweep_sizes(stress_memrate_context_t *context)
+{
+	size_t llc, line_size, max_size, size;
+
+	stress_cpu_cache_get_llc_size(&llc, &line_size);
+	if (!llc)
+		llc = 4 * MB;
+	max_size = llc * MR_SWEEP_LLC_SCALE;
+
+	context->n_sweep_sizes = 0;
+	for (size = MR_SWEEP_MIN; context->n_sweep_sizes < MR_SWEEP_MAX_SIZES; ) {
+		context->sweep_sizes[context->n_sweep_sizes++] = size;
+		if (size >= max_size)
+			break;
+		/* 2^n -> 1.5 * 2^n -> 2^(n+1) */
+		size = (size & (size - 1)) ? (size & (size - 1)) << 1 : size + (size >> 1);
+	}
+	return context->sweep_sizes[context->n_sweep_sizes - 1];
+}
+
+/*
+ *  stress_memrate_sweep()
+ *	run all the memrate methods at full speed at each of the
+ *	sweep working set sizes, small sizes are repeated to get
+ *	at least MR_SWEEP_MIN_TIME of measurement
+ */
+static void stress_memrate_sweep(stress_args_t *args, stress_memrate_context_t *context)
+{
+	stress_memrate_context_t sweep_context = *context;
+	size_t i, j;
+
+	for (i = 0; i < context->n_sweep_sizes; i++) {
+		const size_t size = context->sweep_sizes[i];
+
+		sweep_context.memrate_bytes = size;
+		sweep_context.end = (void *)((uint8_t *)context->start + size);
+
+		for (j = 0; j < memrate_items; j++) {
+			stress_memrate_stats_t *stats = &context->sweep[(i * memrate_items) + j];
+			const stress_memrate_info_t *info = &memrate_info[j];
+			double t1, t2;
+			uint64_t kbytes = 0;
+			bool valid = false;
+
+			if ((context->memrate_method < memrate_items) &&
+			    (context->memrate_method != j))
+				continue;
+			if (context->memrate_flush)
+				stress_memrate_flush(&sweep_context);
+			t1 = stress_time_now();
+			do {
+				kbytes += info->func(&sweep_context, &valid);
+				t2 = stress_time_now();
+			} while (t2 - t1 < MR_SWEEP_MIN_TIME);
+			stats->kbytes += (double)kbytes;
+			stats->duration += t2 - t1;
+			stats->valid = valid;
+
+			if (!stress_continue(args))
+				return;
+		}
+	}
+}
+
+/*
+ *  stress_memrate_sweep_rate()
+ *	MB per sec of method j at sweep size i, 0.0 if not measured
+ */
+static double stress_memrate_sweep_rate(
+	const stress_memrate_context_t *context,
+	const size_t i,
+	const size_t j)
+{
+	const stress_memrate_stats_t *stats = &context->sweep[(i * memrate_items) + j];
+
+	if (!stats->valid || (stats->duration <= 0.0))
+		return 0.0;
+	return stats->kbytes / (stats->duration * KB);
+}
+
+/*
+ *  stress_memrate_sweep_knees()
+ *	find the working set sizes where the bandwidth of method j
+ *	drops off a plateau; a knee is a drop below MR_SWEEP_KNEE_DROP
+ *	of the plateau and the next plateau starts once the bandwidth
+ *	flattens out again, returns the number of knees found
+ */
+static size_t stress_memrate_sweep_knees(
+	const stress_memrate_context_t *context,
+	const size_t j,
+	size_t knees[MR_SWEEP_KNEES_MAX])
+{
+	size_t i, n = 0;
+	double plateau = stress_memrate_sweep_rate(context, 0, j);
+	double prev = plateau;
+	bool transition = false;
+
+	for (i = 1; (i < context->n_sweep_sizes) && (n < MR_SWEEP_KNEES_MAX); i++) {
+		const double rate = stress_memrate_sweep_rate(context, i, j);
+
+		if (rate <= 0.0)
+			break;
+		if (transition) {
+			if (rate >= prev * MR_SWEEP_FLAT) {
+				transition = false;
+				plateau = rate;
+			}
+		} else if (rate < plateau * MR_SWEEP_KNEE_DROP) {
+			knees[n++] = context->sweep_sizes[i - 1];
+			transition = true;
+		} else if (rate > plateau) {
+			plateau = rate;
+		}
+		prev = rate;
+	}
+	return n;
+}
+
+/*
+ *  stress_memrate_sweep_report()
+ *	log the sweep table and cache knees and add the knees
+ *	to the metrics, the knees are detected on the read64 and
+ *	write64 methods as these are available on all systems, or
+ *	on the --memrate-method method if one is selected
+ */
+static void stress_memrate_sweep_report(stress_args_t *args, const stress_memrate_context_t *context)
+{
+	size_t i, j, rd64 = 0, wr64 = 0, idx = memrate_items + MR_LAT_LEVELS;
+	size_t knees[MR_SWEEP_KNEES_MAX], n_knees;
+
+	for (j = 0; j < memrate_items; j++) {
+		if (!strcmp(memrate_info[j].name, "read64"))
+			rd64 = j;
+		else if (!strcmp(memrate_info[j].name, "write64"))
+			wr64 = j;
+	}
+	if (context->memrate_method < memrate_items) {
+		if (memrate_info[context->memrate_method].rdwr == MR_RD)
+			rd64 = context->memrate_method;
+		else
+			wr64 = context->memrate_method;
+	}
+
+	if (args->instance == 0) {
+		char rd_hdr[32], wr_hdr[32];
+
+		(void)snprintf(rd_hdr, sizeof(rd_hdr), "%s MB/s", memrate_info[rd64].name);
+		(void)snprintf(wr_hdr, sizeof(wr_hdr), "%s MB/s", memrate_info[wr64].name);
+		pr_inf("%s: %10s %12s %12s %12s %-10s %12s %-10s\n", args->name,
+			"size", rd_hdr, wr_hdr,
+			"best rd MB/s", "method", "best wr MB/s", "method");
+		for (i = 0; i < context->n_sweep_sizes; i++) {
+			double best_rd = 0.0, best_wr = 0.0;
+			size_t best_rd_j = rd64, best_wr_j = wr64;
+
+			for (j = 0; j < memrate_items; j++) {
+				const double rate = stress_memrate_sweep_rate(context, i, j);
+
+				if ((memrate_info[j].rdwr == MR_RD) && (rate > best_rd)) {
+					best_rd = rate;
+					best_rd_j = j;
+				} else if ((memrate_info[j].rdwr == MR_WR) && (rate > best_wr)) {
+					best_wr = rate;
+					best_wr_j = j;
+				}
+				pr_dbg("%s: sweep %zuK %s %.2f MB per sec\n", args->name,
+					(size_t)(context->sweep_sizes[i] / KB), memrate_info[j].name, rate);
+			}
+			pr_inf("%s: %9zuK %12.2f %12.2f %12.2f %-10s %12.2f %-10s\n", args->name,
+				(size_t)(context->sweep_sizes[i] / KB),
+				stress_memrate_sweep_rate(context, i, rd64),
+				stress_memrate_sweep_rate(context, i, wr64),
+				best_rd, memrate_info[best_rd_j].name,
+				best_wr, memrate_info[best_wr_j].name);
+		}
+	}
+
+	n_knees = stress_memrate_sweep_knees(context, rd64, knees);
+	for (i = 0; i < n_knees; i++) {
+		char tmp[64];
+
+		if (args->instance == 0)
+			pr_inf("%s: read bandwidth knee %zu at a %zuK working set\n",
+				args->name, i + 1, (size_t)(knees[i] / KB));
+		(void)snprintf(tmp, sizeof(tmp), "read knee %zu working set K", i + 1);
+		stress_metrics_set(args, idx++, tmp, (double)knees[i] / KB, STRESS_GEOMETRIC_MEAN);
+	}
+	n_knees = stress_memrate_sweep_knees(context, wr64, knees);
+	for (i = 0; i < n_knees; i++) {
+		char tmp[64];
+
+		if (args->instance == 0)
+			pr_inf("%s: write bandwidth knee %zu at a %zuK working set\n",
+				args->name, i + 1, (size_t)(knees[i] / KB));
+		(void)snprintf(tmp, sizeof(tmp), "write knee %zu working set K", i + 1);
+		stress_metrics_set(args, idx++, tmp, (double)knees[i] / KB, STRESS_GEOMETRIC_MEAN);
+	}
+}
+
 static int stress_memrate_child(stress_args_t *args, void *ctxt)
 {
 	stress_memrate_context_t *context = (stress_memrate_context_t *)ctxt;
 	void *buffer, *buffer_end;
+	size_t mmap_size = (size_t)context->memrate_bytes;
+	int rc = EXIT_SUCCESS;
 
 	stress_catch_sigill();
 
-	buffer = stress_memrate_mmap(args, context->memrate_bytes);
+	buffer = stress_memrate_mmap(args, &mmap_size);
 	if (buffer == MAP_FAILED)
 		return EXIT_NO_RESOURCE;
 
@@ -1008,30 +1848,29 @@ static int stress_memrate_child(stress_args_t *args, void *ctxt)
 	context->start = buffer;
 	context->end = buffer_end;
 
-	if (sigsetjmp(jmpbuf, 1) != 0)
+	if (stress_sighandler(args->name, SIGALRM, stress_memrate_alarm_handler, NULL) < 0) {
+		(void)munmap((void *)buffer, mmap_size);
+		return EXIT_NO_RESOURCE;
+	}
+
+	if (context->memrate_latency != MR_LAT_OFF) {
+		rc = stress_memrate_latency(args, context);
 		goto tidy;
+	}
 
-	if (stress_sighandler(args->name, SIGALRM, stress_memrate_alarm_handler, NULL) < 0)
-		return EXIT_NO_RESOURCE;
+	if (sigsetjmp(jmpbuf, 1) != 0)
+		goto tidy;
 
 	do {
 		size_t i;
 
+		if (context->memrate_sweep) {
+			stress_memrate_sweep(args, context);
+			stress_bogo_inc(args);
+			continue;
+		}
 		for (i = 0; i < memrate_items; i++) {
-			double t1, t2;
-			uint64_t kbytes;
-			const stress_memrate_info_t *info = &memrate_info[i];
-			bool valid = false;
-
-			if (context->memrate_flush)
-				stress_memrate_flush(context);
-			t1 = stress_time_now();
-			kbytes = stress_memrate_dispatch(info, context, &valid);
-			context->stats[i].kbytes += (double)kbytes;
-			t2 = stress_time_now();
-			context->stats[i].duration += (t2 - t1);
-			context->stats[i].valid = valid;
-
+			stress_memrate_method(context, i);
 			if (!stress_continue(args))
 				break;
 		}
@@ -1039,8 +1878,8 @@ static int stress_memrate_child(stress_args_t *args, void *ctxt)
 	} while (stress_continue(args));
 
 tidy:
-	(void)munmap((void *)buffer, context->memrate_bytes);
-	return EXIT_SUCCESS;
+	(void)munmap((void *)buffer, mmap_size);
+	return rc;
 }
 
 /*
@@ -1057,13 +1896,36 @@ static int stress_memrate(stress_args_t *args)
 	context.memrate_rd_mbs = ~0ULL;
 	context.memrate_wr_mbs = ~0ULL;
 	context.memrate_flush = false;
+	context.memrate_latency = MR_LAT_OFF;
+	context.memrate_sweep = false;
+	context.memrate_method = memrate_items;
+	context.n_sweep_sizes = 0;
+	context.generator_pid = -1;
 
 	(void)stress_get_setting("memrate-bytes", &context.memrate_bytes);
 	(void)stress_get_setting("memrate-flush", &context.memrate_flush);
+	(void)stress_get_setting("memrate-latency", &context.memrate_latency);
+	(void)stress_get_setting("memrate-sweep", &context.memrate_sweep);
+	(void)stress_get_setting("memrate-method", &context.memrate_method);
+	if (context.memrate_sweep) {
+		if (context.memrate_latency != MR_LAT_OFF) {
+			if (args->instance == 0)
+				pr_inf("%s: --memrate-sweep cannot be used with --memrate-latency, "
+					"disabling sweep\n", args->name);
+			context.memrate_sweep = false;
+		} else {
+			/* the buffer only needs to be as large as the biggest sweep size */
+			context.memrate_bytes = (uint64_t)stress_memrate_sweep_sizes(&context);
+		}
+	}
 	(void)stress_get_setting("memrate-rd-mbs", &context.memrate_rd_mbs);
 	(void)stress_get_setting("memrate-wr-mbs", &context.memrate_wr_mbs);
+	if (!stress_memrate_capable(args, &context))
+		return EXIT_NO_RESOURCE;
 
-	stats_size = memrate_items * sizeof(*context.stats);
+	stats_size = (memrate_items * sizeof(*context.stats)) +
+		(MR_LAT_LEVELS * sizeof(*context.latency)) +
+		(context.n_sweep_sizes * memrate_items * sizeof(*context.sweep));
 	stats_size = (stats_size + args->page_size - 1) & ~(args->page_size - 1);
 
 	context.stats = (stress_memrate_stats_t *)stress_mmap_populate(NULL, stats_size,
@@ -1078,6 +1940,18 @@ static int stress_memrate(stress_args_t *args)
 		context.stats[i].kbytes = 0.0;
 		context.stats[i].valid = false;
 	}
+	context.latency = (stress_memrate_latency_t *)&context.stats[memrate_items];
+	for (i = 0; i < MR_LAT_LEVELS; i++) {
+		context.latency[i].duration = 0.0;
+		context.latency[i].loads = 0.0;
+		context.latency[i].size = 0;
+	}
+	context.sweep = (stress_memrate_stats_t *)&context.latency[MR_LAT_LEVELS];
+	for (i = 0; i < context.n_sweep_sizes * memrate_items; i++) {
+		context.sweep[i].duration = 0.0;
+		context.sweep[i].kbytes = 0.0;
+		context.sweep[i].valid = false;
+	}
 
 	context.memrate_bytes = (context.memrate_bytes + 1023) & ~(1023ULL);
 	if (args->instance == 0) {
@@ -1089,6 +1963,17 @@ static int stress_memrate(stress_args_t *args)
 		}
 		if (!context.memrate_flush)
 			pr_inf("%s: cache flushing can be enabled with --memrate-flush option\n", args->name);
+		if (context.memrate_latency == MR_LAT_LOADED)
+			pr_inf("%s: measuring pointer chase latency with a bandwidth generator "
+				"loading memory\n", args->name);
+		else if (context.memrate_latency == MR_LAT_IDLE)
+			pr_inf("%s: measuring pointer chase latency, memory rates are not exercised\n",
+				args->name);
+		if (context.memrate_sweep)
+			pr_inf("%s: sweeping %zu working set sizes from %zuK to %zuK\n",
+				args->name, context.n_sweep_sizes,
+				(size_t)(context.sweep_sizes[0] / KB),
+				(size_t)(context.sweep_sizes[context.n_sweep_sizes - 1] / KB));
 	}
 
 	stress_set_proc_state(args->name, STRESS_STATE_RUN);
@@ -1113,6 +1998,22 @@ static int stress_memrate(stress_args_t *args)
 				args->name, memrate_info[i].name);
 		}
 	}
+	for (i = 0; i < MR_LAT_LEVELS; i++) {
+		const stress_memrate_latency_t *latency = &context.latency[i];
+		char tmp[64];
+
+		if (latency->loads <= 0.0)
+			continue;
+		(void)snprintf(tmp, sizeof(tmp), "%s %s%zuK set ns per load",
+			memrate_latency_levels[i],
+			(context.memrate_latency == MR_LAT_LOADED) ? "loaded " : "",
+			(size_t)(latency->size / KB));
+		stress_metrics_set(args, memrate_items + i, tmp,
+			(latency->duration * STRESS_DBL_NANOSECOND) / latency->loads,
+			STRESS_GEOMETRIC_MEAN);
+	}
+	if (context.memrate_sweep)
+		stress_memrate_sweep_report(args, &context);
 	pr_block_end();
 
 	(void)munmap((void *)context.stats, stats_size);
@@ -1123,7 +2024,10 @@ static int stress_memrate(stress_args_t *args)
 static const stress_opt_set_func_t opt_set_funcs[] = {
 	{ OPT_memrate_bytes,	stress_set_memrate_bytes },
 	{ OPT_memrate_flush,	stress_set_memrate_flush },
+	{ OPT_memrate_latency,	stress_set_memrate_latency },
+	{ OPT_memrate_method,	stress_set_memrate_method },
 	{ OPT_memrate_rd_mbs,	stress_set_memrate_rd_mbs },
+	{ OPT_memrate_sweep,	stress_set_memrate_sweep },
 	{ OPT_memrate_wr_mbs,	stress_set_memrate_wr_mbs },
 	{ 0,			NULL }
 };
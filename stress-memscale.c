@@ -0,0 +1,480 @@
+/*
+ * Copyright (C) 2024      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-affinity.h"
+#include "core-asm-generic.h"
+#include "core-builtin.h"
+#include "core-cpu-cache.h"
+#include "core-killpid.h"
+#include "core-mmap.h"
+
+#define MIN_MEMSCALE_BYTES	(1 * MB)
+#define MAX_MEMSCALE_BYTES	(MAX_MEM_LIMIT)
+#define DEFAULT_MEMSCALE_BYTES	(64 * MB)
+
+#define MEMSCALE_STEPS_MAX	(32)		/* max core count steps */
+#define MEMSCALE_STEP_TIME	(1.0)		/* seconds per step */
+#define MEMSCALE_READY_TIME	(30.0)		/* max wait for children to be ready */
+#define MEMSCALE_SATURATED	(1.10)		/* under 10% gain is saturation */
+
+static const stress_help_t help[] = {
+	{ NULL,	"memscale N",		"start N workers that measure bandwidth scaling over cores" },
+	{ NULL,	"memscale-bytes N",	"size of the buffer used by each pinned instance" },
+	{ NULL,	"memscale-kernel K",	"memory kernel to scale: triad, read64 or memcpy" },
+	{ NULL,	"memscale-ops N",	"stop after N bandwidth scaling sweeps" },
+	{ NULL,	NULL,			NULL }
+};
+
+typedef uint64_t (*stress_memscale_func_t)(void *buf, const size_t size);
+
+typedef struct {
+	const char *name;		/* kernel name */
+	const stress_memscale_func_t func;	/* kernel, returns bytes moved */
+} stress_memscale_kernel_t;
+
+/* per pinned instance results, shared with the parent */
+typedef struct {
+	double bytes;			/* bytes moved */
+	double duration;		/* time moving them */
+	bool ready;			/* buffer is allocated and touched */
+	bool failed;			/* could not pin or allocate */
+} stress_memscale_child_t;
+
+/* shared between the parent and the pinned instances */
+typedef struct {
+	volatile double start;		/* step start time, 0 = not started */
+	volatile double end;		/* step end time */
+	volatile bool reported;		/* buffer backing has been reported */
+	stress_memscale_child_t child[];
+} stress_memscale_shared_t;
+
+/* per core count step results */
+typedef struct {
+	int cores;			/* pinned instances */
+	double aggregate;		/* sum of GB/s over all sweeps */
+	double per_instance;		/* sum of mean GB/s per instance over all sweeps */
+	uint64_t sweeps;		/* sweeps measured */
+} stress_memscale_step_t;
+
+static volatile uint64_t memscale_sink;
+
+/*
+ *  stress_memscale_triad()
+ *	stream triad, a[i] = b[i] + q * c[i]
+ */
+static uint64_t OPTIMIZE3 stress_memscale_triad(void *buf, const size_t size)
+{
+	const size_t n = size / (3 * sizeof(double));
+	double *RESTRICT a = (double *)buf;
+	const double *RESTRICT b = a + n;
+	const double *RESTRICT c = b + n;
+	const double q = 3.0;
+	register size_t i;
+
+	for (i = 0; i < n; i++)
+		a[i] = b[i] + q * c[i];
+
+	return (uint64_t)(n * 3 * sizeof(double));
+}
+
+/*
+ *  stress_memscale_read64()
+ *	read the buffer 64 bits at a time
+ */
+static uint64_t OPTIMIZE3 stress_memscale_read64(void *buf, const size_t size)
+{
+	const uint64_t *ptr = (const uint64_t *)buf;
+	const uint64_t *end = ptr + (size / sizeof(uint64_t));
+	register uint64_t v0 = 0, v1 = 0, v2 = 0, v3 = 0;
+
+	while (ptr < end - 7) {
+		v0 += ptr[0] ^ ptr[4];
+		v1 += ptr[1] ^ ptr[5];
+		v2 += ptr[2] ^ ptr[6];
+		v3 += ptr[3] ^ ptr[7];
+		ptr += 8;
+	}
+	memscale_sink = v0 + v1 + v2 + v3;
+
+	return (uint64_t)(size & ~(size_t)63);
+}
+
+/*
+ *  stress_memscale_memcpy()
+ *	libc memcpy of one half of the buffer to the other half,
+ *	the bytes moved are the bytes read plus the bytes written
+ */
+static uint64_t stress_memscale_memcpy(void *buf, const size_t size)
+{
+	const size_t half = size / 2;
+
+	(void)memcpy(buf, (uint8_t *)buf + half, half);
+
+	return (uint64_t)(half * 2);
+}
+
+static const stress_memscale_kernel_t memscale_kernels[] = {
+	{ "triad",	stress_memscale_triad },
+	{ "read64",	stress_memscale_read64 },
+	{ "memcpy",	stress_memscale_memcpy },
+};
+
+static int stress_set_memscale_bytes(const char *opt)
+{
+	uint64_t memscale_bytes;
+
+	memscale_bytes = stress_get_uint64_byte(opt);
+	stress_check_range_bytes("memscale-bytes", memscale_bytes,
+		MIN_MEMSCALE_BYTES, MAX_MEMSCALE_BYTES);
+	return stress_set_setting("memscale-bytes", TYPE_ID_UINT64, &memscale_bytes);
+}
+
+static int stress_set_memscale_kernel(const char *opt)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(memscale_kernels); i++) {
+		if (!strcmp(opt, memscale_kernels[i].name))
+			return stress_set_setting("memscale-kernel", TYPE_ID_SIZE_T, &i);
+	}
+	(void)fprintf(stderr, "invalid memscale-kernel '%s', allowed kernels are:", opt);
+	for (i = 0; i < SIZEOF_ARRAY(memscale_kernels); i++)
+		(void)fprintf(stderr, " %s", memscale_kernels[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+/*
+ *  stress_memscale_child()
+ *	pin to a CPU, allocate and touch the buffer, wait for the
+ *	step to start and then run the kernel until the step ends
+ */
+static void NORETURN stress_memscale_child(
+	stress_args_t *args,
+	stress_memscale_shared_t *shared,
+	const int idx,
+	const int cpu,
+	const size_t memscale_bytes,
+	const stress_memscale_func_t func)
+{
+	stress_memscale_child_t *child = &shared->child[idx];
+	/* only the first child of the first step reports the buffer backing */
+	const uint32_t instance = ((idx == 0) && !shared->reported) ?
+		args->instance : UINT32_MAX;
+	size_t mmap_size = memscale_bytes;
+	double t1, t2, bytes = 0.0;
+	void *buf;
+
+	stress_parent_died_alarm();
+
+	if (stress_affinity_pin(cpu) < 0) {
+		pr_dbg("%s: cannot pin to CPU %d, errno=%d (%s)\n",
+			args->name, cpu, errno, strerror(errno));
+		child->failed = true;
+		child->ready = true;
+		_exit(EXIT_NO_RESOURCE);
+	}
+	buf = stress_mmap_buffer(args->name, instance, &mmap_size,
+		PROT_READ | PROT_WRITE, MAP_PRIVATE);
+	if (buf == MAP_FAILED) {
+		pr_dbg("%s: cannot mmap %zuK buffer on CPU %d, errno=%d (%s)\n",
+			args->name, mmap_size / 1024, cpu, errno, strerror(errno));
+		child->failed = true;
+		child->ready = true;
+		_exit(EXIT_NO_RESOURCE);
+	}
+	if (idx == 0)
+		shared->reported = true;
+	(void)shim_memset(buf, idx + 1, mmap_size);
+	/* warm up */
+	(void)func(buf, memscale_bytes);
+	child->ready = true;
+
+	while ((shared->start <= 0.0) && stress_continue_flag())
+		(void)shim_usleep(100);
+	/* start is written after end, so end is valid once start is seen */
+	stress_asm_mb();
+
+	t1 = stress_time_now();
+	t2 = t1;
+	while ((t2 < shared->end) && stress_continue_flag()) {
+		bytes += (double)func(buf, memscale_bytes);
+		t2 = stress_time_now();
+	}
+	child->bytes = bytes;
+	child->duration = t2 - t1;
+
+	(void)munmap(buf, mmap_size);
+	_exit(EXIT_SUCCESS);
+}
+
+/*
+ *  stress_memscale_step()
+ *	run the kernel on cores pinned instances at the same time,
+ *	returns false if the step could not be measured
+ */
+static bool stress_memscale_step(
+	stress_args_t *args,
+	stress_memscale_shared_t *shared,
+	const int *cpus,
+	const int cores,
+	const size_t memscale_bytes,
+	const stress_memscale_func_t func,
+	stress_memscale_step_t *step)
+{
+	pid_t *pids;
+	int i, started = 0, ready;
+	bool ok = true;
+	double t, aggregate = 0.0;
+
+	pids = calloc((size_t)cores, sizeof(*pids));
+	if (!pids)
+		return false;
+
+	shared->start = 0.0;
+	shared->end = 0.0;
+	(void)shim_memset(shared->child, 0, (size_t)cores * sizeof(shared->child[0]));
+
+	for (i = 0; i < cores; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0) {
+			pr_inf("%s: fork failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+			ok = false;
+			break;
+		} else if (pids[i] == 0) {
+			stress_memscale_child(args, shared, i, cpus[i], memscale_bytes, func);
+		}
+		started++;
+	}
+
+	/* wait for all the instances to be pinned and touched */
+	t = stress_time_now();
+	do {
+		for (ready = 0, i = 0; i < started; i++) {
+			if (shared->child[i].failed)
+				ok = false;
+			ready += shared->child[i].ready;
+		}
+		if (ready == started)
+			break;
+		(void)shim_usleep(1000);
+	} while (ok && stress_continue(args) &&
+		 (stress_time_now() - t < MEMSCALE_READY_TIME));
+
+	if (ok && (ready == started) && stress_continue(args)) {
+		t = stress_time_now();
+		shared->end = t + MEMSCALE_STEP_TIME;
+		stress_asm_mb();
+		shared->start = t;
+	} else {
+		ok = false;
+	}
+
+	for (i = 0; i < started; i++) {
+		if (ok) {
+			int status;
+
+			(void)shim_waitpid(pids[i], &status, 0);
+		} else {
+			(void)stress_kill_pid_wait(pids[i], NULL);
+		}
+	}
+	free(pids);
+	if (!ok || !stress_continue(args))
+		return false;
+
+	for (i = 0; i < cores; i++) {
+		const stress_memscale_child_t *child = &shared->child[i];
+
+		if ((child->duration <= 0.0) || (child->bytes <= 0.0))
+			return false;
+		aggregate += (child->bytes / child->duration) / (double)GB;
+	}
+	step->cores = cores;
+	step->aggregate += aggregate;
+	step->per_instance += aggregate / (double)cores;
+	step->sweeps++;
+
+	return true;
+}
+
+/*
+ *  stress_memscale_report()
+ *	log the bandwidth vs core count curve, the instance 0 log
+ *	has the full table, the steps are added to the metrics
+ */
+static void stress_memscale_report(
+	stress_args_t *args,
+	const stress_memscale_step_t *steps,
+	const size_t n_steps,
+	const char *kernel)
+{
+	double base = 0.0, prev = 0.0;
+	int saturated = 0;
+	size_t i, idx = 0;
+	char tmp[64];
+
+	if (!n_steps || !steps[0].sweeps)
+		return;
+
+	pr_inf("%s: %s kernel: %6s %14s %14s %11s\n", args->name, kernel,
+		"cores", "aggregate GB/s", "per-inst GB/s", "efficiency");
+	for (i = 0; i < n_steps; i++) {
+		const stress_memscale_step_t *step = &steps[i];
+		double aggregate, per_instance;
+
+		if (!step->sweeps)
+			break;
+		aggregate = step->aggregate / (double)step->sweeps;
+		per_instance = step->per_instance / (double)step->sweeps;
+		if (i == 0)
+			base = per_instance;
+		else if (!saturated && (aggregate < prev * MEMSCALE_SATURATED))
+			saturated = steps[i - 1].cores;
+		prev = aggregate;
+
+		pr_inf("%s: %s kernel: %6d %14.3f %14.3f %10.1f%%\n", args->name, kernel,
+			step->cores, aggregate, per_instance,
+			(base > 0.0) ? 100.0 * per_instance / base : 0.0);
+
+		if (idx + 3 <= STRESS_MISC_METRICS_MAX) {
+			(void)snprintf(tmp, sizeof(tmp), "%d cores aggregate GB/s", step->cores);
+			stress_metrics_set(args, idx++, tmp, aggregate, STRESS_GEOMETRIC_MEAN);
+			(void)snprintf(tmp, sizeof(tmp), "%d cores per-instance GB/s", step->cores);
+			stress_metrics_set(args, idx++, tmp, per_instance, STRESS_GEOMETRIC_MEAN);
+		}
+	}
+	if (saturated)
+		pr_inf("%s: %s kernel: bandwidth saturates at %d cores\n",
+			args->name, kernel, saturated);
+	else
+		pr_inf("%s: %s kernel: bandwidth did not saturate\n", args->name, kernel);
+	stress_metrics_set(args, idx, "cores at bandwidth saturation",
+		(double)saturated, STRESS_GEOMETRIC_MEAN);
+}
+
+/*
+ *  stress_memscale()
+ *	measure the memory bandwidth of a kernel running on
+ *	1, 2, 4.. N cores at the same time, one pinned instance
+ *	per physical core first and then the SMT siblings
+ */
+static int stress_memscale(stress_args_t *args)
+{
+	uint64_t memscale_bytes = 0;
+	size_t memscale_kernel = 0, shared_size, n_steps = 0, i;
+	size_t llc_size = 0, cache_line_size = 0;
+	stress_memscale_shared_t *shared;
+	stress_memscale_step_t steps[MEMSCALE_STEPS_MAX];
+	int32_t max_cpus;
+	int *cpus, n_cpus, cores;
+	int rc = EXIT_SUCCESS;
+
+	if (args->instance > 0) {
+		pr_inf_skip("%s: only instance 0 runs the scaling harness, skipping instance %" PRIu32 "\n",
+			args->name, args->instance);
+		return EXIT_NO_RESOURCE;
+	}
+
+	(void)stress_get_setting("memscale-kernel", &memscale_kernel);
+	if (!stress_get_setting("memscale-bytes", &memscale_bytes)) {
+		stress_cpu_cache_get_llc_size(&llc_size, &cache_line_size);
+		memscale_bytes = STRESS_MAXIMUM((uint64_t)DEFAULT_MEMSCALE_BYTES, (uint64_t)llc_size * 4);
+	}
+	memscale_bytes &= ~(uint64_t)4095;
+
+	max_cpus = stress_get_processors_configured();
+	if (max_cpus < 1)
+		max_cpus = 1;
+	cpus = calloc((size_t)max_cpus, sizeof(*cpus));
+	if (!cpus) {
+		pr_inf_skip("%s: cannot allocate CPU list, skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+	}
+	n_cpus = stress_affinity_cpus_by_core(cpus, (int)max_cpus);
+	if (n_cpus < 1) {
+		pr_inf_skip("%s: cannot determine the CPUs to pin to, skipping stressor\n", args->name);
+		free(cpus);
+		return EXIT_NO_RESOURCE;
+	}
+
+	shared_size = sizeof(*shared) + ((size_t)n_cpus * sizeof(shared->child[0]));
+	shared = (stress_memscale_shared_t *)mmap(NULL, shared_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu bytes of shared state, skipping stressor\n",
+			args->name, shared_size);
+		free(cpus);
+		return EXIT_NO_RESOURCE;
+	}
+
+	(void)shim_memset(steps, 0, sizeof(steps));
+	for (cores = 1; (n_steps < MEMSCALE_STEPS_MAX); cores *= 2) {
+		steps[n_steps++].cores = STRESS_MINIMUM(cores, n_cpus);
+		if (cores >= n_cpus)
+			break;
+	}
+	pr_dbg("%s: %s kernel, %" PRIu64 "K per instance, %zu steps up to %d CPUs\n",
+		args->name, memscale_kernels[memscale_kernel].name,
+		memscale_bytes / 1024, n_steps, n_cpus);
+
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	do {
+		for (i = 0; (i < n_steps) && stress_continue(args); i++) {
+			if (!stress_memscale_step(args, shared, cpus, steps[i].cores,
+						  (size_t)memscale_bytes,
+						  memscale_kernels[memscale_kernel].func, &steps[i]))
+				break;
+		}
+		if (!steps[0].sweeps) {
+			if (stress_continue(args)) {
+				pr_inf_skip("%s: cannot run the %s kernel on pinned instances, skipping stressor\n",
+					args->name, memscale_kernels[memscale_kernel].name);
+				rc = EXIT_NO_RESOURCE;
+			}
+			break;
+		}
+		if (i == n_steps)
+			stress_bogo_inc(args);
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	stress_memscale_report(args, steps, n_steps, memscale_kernels[memscale_kernel].name);
+
+	(void)munmap((void *)shared, shared_size);
+	free(cpus);
+
+	return rc;
+}
+
+static const stress_opt_set_func_t opt_set_funcs[] = {
+	{ OPT_memscale_bytes,	stress_set_memscale_bytes },
+	{ OPT_memscale_kernel,	stress_set_memscale_kernel },
+	{ 0,			NULL }
+};
+
+stressor_info_t stress_memscale_info = {
+	.stressor = stress_memscale,
+	.class = CLASS_MEMORY,
+	.opt_set_funcs = opt_set_funcs,
+	.help = help
+};
@@ -23,6 +23,7 @@
 #include "core-builtin.h"
 #include "core-cpu-cache.h"
 #include "core-madvise.h"
+#include "core-mmap.h"
 #include "core-nt-store.h"
 #include "core-numa.h"
 #include "core-out-of-memory.h"
@@ -836,6 +837,7 @@ static int stress_memthrash_child(stress_args_t *args, void *ctxt)
 	const uint32_t max_threads = context->max_threads;
 	uint32_t i;
 	int ret;
+	size_t mem_size = MEM_SIZE;
 	stress_pthread_info_t *pthread_info;
 
 	pthread_info = calloc(max_threads, sizeof(*pthread_info));
@@ -849,8 +851,9 @@ static int stress_memthrash_child(stress_args_t *args, void *ctxt)
 
 
 mmap_retry:
-	mem = stress_mmap_populate(NULL, MEM_SIZE, PROT_READ | PROT_WRITE,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	mem_size = MEM_SIZE;
+	mem = stress_mmap_buffer(args->name, args->instance, &mem_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE);
 	if (mem == MAP_FAILED) {
 		if (!stress_continue_flag()) {
 			pr_dbg("%s: mmap failed: %d %s\n",
@@ -863,7 +866,7 @@ mmap_retry:
 			goto reap_mem;
 		goto mmap_retry;
 	}
-	(void)stress_madvise_mergeable(mem, MEM_SIZE);
+	(void)stress_madvise_mergeable(mem, mem_size);
 
 	for (i = 0; i < max_threads; i++) {
 		pthread_info[i].ret = pthread_create(&pthread_info[i].pthread,
@@ -898,7 +901,7 @@ reap:
 		}
 	}
 reap_mem:
-	(void)munmap(mem, MEM_SIZE);
+	(void)munmap(mem, mem_size);
 	free(pthread_info);
 
 	return EXIT_SUCCESS;
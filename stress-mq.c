@@ -21,6 +21,7 @@
 #include "core-affinity.h"
 #include "core-builtin.h"
 #include "core-killpid.h"
+#include "core-latency.h"
 
 #if defined(HAVE_MQUEUE_H)
 #include <mqueue.h>
@@ -429,6 +430,7 @@ again:
 		stress_msg_t ALIGN64 msg;
 		uint64_t values[PRIOS_MAX];
 		uint64_t i = 0;
+		const bool latency = stress_latency_enabled();
 
 		/* Parent */
 		(void)shim_memset(&msg, 0, sizeof(msg));
@@ -436,6 +438,7 @@ again:
 
 		do {
 			int ret;
+			uint64_t t = 0;
 			const unsigned int prio = stress_mwc8modn(PRIOS_MAX);
 			const uint64_t timed = (msg.value & 1);
 
@@ -464,6 +467,8 @@ again:
 			/*
 			 * toggle between timedsend and send
 			 */
+			if (latency)
+				t = stress_latency_now();
 			if (do_timed && (timed))
 				ret = mq_timedsend(mq, (char *)&msg, sizeof(msg), prio, &abs_timeout);
 			else
@@ -478,6 +483,8 @@ again:
 				}
 				break;
 			}
+			if (latency)
+				stress_latency_record(args, stress_latency_now() - t);
 
 			if (!(i & 1023)) {
 				if (do_timed && (timed)) {
@@ -509,6 +516,7 @@ again:
 		} while (stress_continue(args));
 
 		(void)stress_kill_pid_wait(pid, NULL);
+		stress_latency_metrics(args, 0);
 		if (mq_close(mq) < 0) {
 			pr_fail("%s: mq_close failed, errno=%d (%s)\n",
 				args->name, errno, strerror(errno));
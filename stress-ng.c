@@ -23,28 +23,37 @@
 #include "core-bitops.h"
 #include "core-builtin.h"
 #include "core-clocksource.h"
+#include "core-compare.h"
 #include "core-cpuidle.h"
 #include "core-config-check.h"
 #include "core-ftrace.h"
 #include "core-hash.h"
 #include "core-ignite-cpu.h"
 #include "core-interrupts.h"
+#include "core-interval.h"
+#include "core-io-engine.h"
 #include "core-io-priority.h"
 #include "core-job.h"
 #include "core-klog.h"
+#include "core-latency.h"
 #include "core-limit.h"
 #include "core-mlock.h"
+#include "core-mmap.h"
 #include "core-numa.h"
 #include "core-opts.h"
 #include "core-out-of-memory.h"
+#include "core-per-cpu.h"
 #include "core-perf.h"
 #include "core-pragma.h"
+#include "core-prefork.h"
 #include "core-shared-heap.h"
 #include "core-smart.h"
+#include "core-stream.h"
 #include "core-stressors.h"
 #include "core-syslog.h"
 #include "core-thermal-zone.h"
 #include "core-thrash.h"
+#include "core-throttle.h"
 #include "core-vmstat.h"
 
 #include <sched.h>
@@ -140,6 +149,7 @@ static const stress_opt_flag_t opt_flags[] = {
 	{ OPT_keep_name, 	OPT_FLAGS_KEEP_NAME },
 	{ OPT_klog_check,	OPT_FLAGS_KLOG_CHECK },
 	{ OPT_ksm,		OPT_FLAGS_KSM },
+	{ OPT_latency,		OPT_FLAGS_LATENCY | OPT_FLAGS_METRICS | OPT_FLAGS_PR_METRICS },
 	{ OPT_log_brief,	OPT_FLAGS_LOG_BRIEF },
 	{ OPT_log_lockless,	OPT_FLAGS_LOG_LOCKLESS },
 	{ OPT_maximize,		OPT_FLAGS_MAXIMIZE },
@@ -152,10 +162,12 @@ static const stress_opt_flag_t opt_flags[] = {
 	{ OPT_oom_avoid,	OPT_FLAGS_OOM_AVOID },
 	{ OPT_page_in,		OPT_FLAGS_MMAP_MINCORE },
 	{ OPT_pathological,	OPT_FLAGS_PATHOLOGICAL },
+	{ OPT_per_cpu,		OPT_FLAGS_PER_CPU | OPT_FLAGS_METRICS | OPT_FLAGS_PR_METRICS },
 #if defined(STRESS_PERF_STATS) && 	\
     defined(HAVE_LINUX_PERF_EVENT_H)
 	{ OPT_perf_stats,	OPT_FLAGS_PERF_STATS },
 #endif
+	{ OPT_prefork,		OPT_FLAGS_PREFORK },
 	{ OPT_progress,		OPT_FLAGS_PROGRESS },
 	{ OPT_settings,		OPT_FLAGS_SETTINGS },
 	{ OPT_skip_silent,	OPT_FLAGS_SKIP_SILENT },
@@ -164,6 +176,7 @@ static const stress_opt_flag_t opt_flags[] = {
 	{ OPT_sock_nodelay,	OPT_FLAGS_SOCKET_NODELAY },
 	{ OPT_stderr,		OPT_FLAGS_STDERR },
 	{ OPT_stdout,		OPT_FLAGS_STDOUT },
+	{ OPT_sync_start,	OPT_FLAGS_SYNC_START | OPT_FLAGS_PREFORK },
 #if defined(HAVE_SYSLOG_H)
 	{ OPT_syslog,		OPT_FLAGS_SYSLOG },
 #endif
@@ -297,19 +310,28 @@ static const stress_help_t help_generic[] = {
 	{ "b N",	"backoff N",		"wait of N microseconds before work starts" },
 	{ NULL,		"change-cpu",		"force child processes to use different CPU to that of parent" },
 	{ NULL,		"class name",		"specify a class of stressors, use with --sequential" },
+	{ NULL,		"compare file",		"compare throughput against the metrics in a baseline YAML file" },
+	{ NULL,		"compare-runs N",	"run stressors N times when comparing against a baseline" },
+	{ NULL,		"compare-tolerance P",	"fail if throughput regresses by more than P percent" },
+	{ NULL,		"csv file",		"stream run events and metrics to a CSV file" },
 	{ "n",		"dry-run",		"do not run" },
 	{ NULL,		"ftrace",		"enable kernel function call tracing" },
 	{ "h",		"help",			"show help" },
 	{ NULL,		"ignite-cpu",		"alter kernel controls to make CPU run hot" },
 	{ NULL,		"interrupts",		"check for error interrupts" },
+	{ NULL,		"interval S",		"sample bogo-op throughput of each stressor every S seconds" },
+	{ NULL,		"interval-csv file",	"stream per interval bogo-op throughput to a CSV file" },
+	{ NULL,		"io-engine E",		"I/O back-end: sync, psync, libaio, io_uring or mmap" },
 	{ NULL,		"ionice-class C",	"specify ionice class (idle, besteffort, realtime)" },
 	{ NULL,		"ionice-level L",	"specify ionice level (0 max, 7 min)" },
 	{ NULL,		"iostate S",		"show I/O statistics every S seconds" },
 	{ "j",		"job jobfile",		"run the named jobfile" },
+	{ NULL,		"json file",		"stream run events and metrics to a JSON Lines file" },
 	{ NULL,		"keep-files",		"do not remove files or directories" },
 	{ "k",		"keep-name",		"keep stress worker names to be 'stress-ng'" },
 	{ NULL,		"klog-check",		"check kernel message log for errors" },
 	{ NULL,		"ksm",			"enable kernel samepage merging" },
+	{ NULL,		"latency",		"record per operation latencies and show percentiles in the metrics" },
 	{ NULL,		"log-brief",		"less verbose log messages" },
 	{ NULL,		"log-file filename",	"log messages to a log file" },
 	{ NULL,		"log-lockless",		"log messages without message locking" },
@@ -326,13 +348,16 @@ static const stress_help_t help_generic[] = {
 	{ NULL,		"oom-avoid-bytes N",	"Number of bytes free to stop further memory allocations" },
 	{ NULL,		"oomable",		"Do not respawn a stressor if it gets OOM'd" },
 	{ NULL,		"page-in",		"touch allocated pages that are not in core" },
+	{ NULL,		"page-size P",		"back large memory stressor buffers with 4k, thp, 2m or 1g pages" },
 	{ NULL,		"parallel N",		"synonym for 'all N'" },
 	{ NULL,		"pathological",		"enable stressors that are known to hang a machine" },
+	{ NULL,		"per-cpu",		"show bogo-ops per CPU and per NUMA node in the metrics" },
 #if defined(STRESS_PERF_STATS) &&	\
     defined(HAVE_LINUX_PERF_EVENT_H)
 	{ NULL,		"perf",			"display perf statistics" },
 #endif
 	{ NULL,		"permute N",		"run permutations of stressors with N stressors per permutation" },
+	{ NULL,		"prefork",		"fork and set up all stressors before releasing them together" },
 	{ "q",		"quiet",		"quiet output" },
 	{ "r",		"random N",		"start N random workers" },
 	{ NULL,		"sched type",		"set scheduler type" },
@@ -350,6 +375,7 @@ static const stress_help_t help_generic[] = {
 	{ NULL,		"stderr",		"all output to stderr" },
 	{ NULL,		"stdout",		"all output to stdout (now the default)" },
 	{ NULL,		"stressors",		"show available stress tests" },
+	{ NULL,		"sync-start",		"release stressors together and measure over a common window" },
 #if defined(HAVE_SYSLOG_H)
 	{ NULL,		"syslog",		"log messages to the syslog" },
 #endif
@@ -357,6 +383,8 @@ static const stress_help_t help_generic[] = {
 	{ NULL,		"temp-path path",	"specify path for temporary directories and files" },
 	{ NULL,		"thermalstat S",	"show CPU and thermal load stats every S seconds" },
 	{ NULL,		"thrash",		"force all pages in causing swap thrashing" },
+	{ NULL,		"throttle-load P",	"throttle stressors to keep CPU utilization at P percent" },
+	{ NULL,		"throttle-ops N",	"throttle each stressor to N bogo-ops per second" },
 	{ "t N",	"timeout T",		"timeout after T seconds" },
 	{ NULL,		"timer-slack N",	"set slack slack to N nanoseconds, 0 for default" },
 	{ NULL,		"times",		"show run time summary at end of the run" },
@@ -1101,6 +1129,18 @@ wexit_status_default:
 			stress_kill_stressors(SIGALRM, true);
 		}
 
+		if (stress_stream_enabled()) {
+			const stress_stream_item_t items[] = {
+				{ "pid",		(double)ret },
+				{ "exit-status",	(double)wexit_status },
+				{ "signalled",		WIFSIGNALED(status) ? 1.0 : 0.0 },
+				{ "bogo-ops",		(double)stats->args.ci.counter },
+				{ "duration",		stats->duration },
+			};
+
+			stress_stream_event("stressor-stop", stressor_name,
+				(int32_t)stats->args.instance, items, SIZEOF_ARRAY(items));
+		}
 		stress_stressor_finished(&stats->pid);
 		pr_dbg("%s: [%d] terminated (%s)\n",
 			stressor_name, ret,
@@ -1141,6 +1181,14 @@ static void stress_wait_stressors(
 #else
 	(void)ticks_per_sec;
 #endif
+	/*
+	 *  Periodically snapshot the bogo-op counters from
+	 *  the shared stats while the stressors are running
+	 */
+	if (stress_interval_enabled())
+		stress_interval_wait(stressors_list);
+	else if (g_opt_flags & OPT_FLAGS_SYNC_START)
+		stress_sync_start_window(stressors_list);
 	for (ss = stressors_list; ss; ss = ss->next) {
 		int32_t j;
 
@@ -1437,13 +1485,19 @@ static int MLOCKED_TEXT stress_run_child(
 	if (g_opt_flags & OPT_FLAGS_PERF_STATS)
 		(void)stress_perf_open(&stats->sp);
 #endif
-	(void)shim_usleep((useconds_t)(backoff * started_instances));
+	if (g_opt_flags & OPT_FLAGS_SYNC_START)
+		stress_sync_start_init(stats);
+	else if (g_opt_flags & OPT_FLAGS_PREFORK)
+		stress_prefork_wait(stats);
+	else
+		(void)shim_usleep((useconds_t)(backoff * started_instances));
 #if defined(STRESS_PERF_STATS) &&	\
     defined(HAVE_LINUX_PERF_EVENT_H)
 	if (g_opt_flags & OPT_FLAGS_PERF_STATS)
 		(void)stress_perf_enable(&stats->sp);
 #endif
-	stress_yield_sleep_ms();
+	if (!(g_opt_flags & OPT_FLAGS_PREFORK))
+		stress_yield_sleep_ms();
 	stats->start = stress_time_now();
 	if (g_opt_timeout)
 		(void)alarm((unsigned int)g_opt_timeout);
@@ -1457,12 +1511,16 @@ static int MLOCKED_TEXT stress_run_child(
 		stats->args.time_end = stress_time_now() + (double)g_opt_timeout,
 		stats->args.mapped = &g_shared->mapped,
 		stats->args.metrics = &stats->metrics,
+		stats->args.latency = &stats->latency,
+		stats->args.per_cpu = stats->per_cpu,
+		stats->args.throttle_ops = stress_throttle_enabled() ? &stats->throttle_ops : NULL,
 		stats->args.info = g_stressor_current->stressor->info;
 		stats->args.ci.counter = 0;
 
 		stress_set_oom_adjustment(&stats->args, false);
 
 		(void)shim_memset(*checksum, 0, sizeof(**checksum));
+		stress_latency_init(&stats->latency);
 		stats->start = stress_time_now();
 		rc = g_stressor_current->stressor->info->stressor(&stats->args);
 		stress_block_signals();
@@ -1553,6 +1611,8 @@ static int MLOCKED_TEXT stress_run_child(
 			name, stress_duration_to_str(run_duration, true));
 	}
 child_exit:
+	/* Don't hold up the release of other pre-forked instances */
+	stress_prefork_ready(stats);
 	/*
 	 *  We used to free allocations on the heap, but
 	 *  the child is going to _exit() soon so it's
@@ -1602,6 +1662,7 @@ static void MLOCKED_TEXT stress_run(
 	(void)stress_get_setting("backoff", &backoff);
 	(void)stress_get_setting("ionice-class", &ionice_class);
 	(void)stress_get_setting("ionice-level", &ionice_level);
+	stress_prefork_reset();
 
 	/*
 	 *  Work through the list of stressors to run
@@ -1628,6 +1689,13 @@ static void MLOCKED_TEXT stress_run(
 				goto abort;
 #endif
 			stats->pid = -1;
+			stats->prefork_ready = false;
+			stats->completed = false;
+			stats->sync_ops = 0;
+			stats->sync_duration = 0.0;
+			if (stats->per_cpu)
+				(void)shim_memset(stats->per_cpu, 0, sizeof(*stats->per_cpu));
+			stress_throttle_init(stats);
 			stats->args.ci.counter_ready = true;
 			stats->args.ci.counter = 0;
 			stats->checksum = *checksum;
@@ -1661,6 +1729,13 @@ again:
 					stats->signalled = false;
 					started_instances++;
 					stress_ftrace_add_pid(pid);
+					if (stress_stream_enabled()) {
+						const stress_stream_item_t item = { "pid", (double)pid };
+						char munged[64];
+
+						(void)stress_munge_underscore(munged, g_stressor_current->stressor->name, sizeof(munged));
+						stress_stream_event("stressor-start", munged, j, &item, 1);
+					}
 				}
 
 				/* Forced early abort during startup? */
@@ -1686,6 +1761,9 @@ abort:
 wait_for_stressors:
 	if (!handler_set)
 		(void)stress_set_handler("stress-ng", false);
+	if (g_opt_flags & OPT_FLAGS_PREFORK)
+		stress_prefork_release(stressors_list);
+	stress_throttle_start(stressors_list);
 	if (g_opt_flags & OPT_FLAGS_IGNITE_CPU)
 		stress_ignite_cpu_start();
 #if STRESS_FORCE_TIMEOUT_ALL
@@ -1693,6 +1771,7 @@ wait_for_stressors:
 		(void)alarm((unsigned int)g_opt_timeout);
 #endif
 	stress_wait_stressors(ticks_per_sec, stressors_list, success, resource_success, metrics_success);
+	stress_throttle_stop();
 	time_finish = stress_time_now();
 
 	*duration += time_finish - time_start;
@@ -1919,12 +1998,30 @@ static char *stess_description_yamlify(const char *description)
 	return yamlified;
 }
 
+/*
+ *  stress_metrics_stream_item()
+ *	add a named metric to the streamed metrics items
+ */
+static inline void stress_metrics_stream_item(
+	stress_stream_item_t *items,
+	size_t *n_items,
+	const char *name,
+	const double value)
+{
+	items[*n_items].name = name;
+	items[*n_items].value = value;
+	(*n_items)++;
+}
+
 /*
  *  stress_metrics_dump()
  *	output metrics
  */
 static void stress_metrics_dump(FILE *yaml)
 {
+	static stress_stream_item_t items[STRESS_MISC_METRICS_MAX + 8];
+	static char item_names[STRESS_MISC_METRICS_MAX][40];
+	size_t n_items;
 	stress_stressor_t *ss;
 	const stress_metrics_item_t *item;
 	const char *description;
@@ -2077,6 +2174,16 @@ static void stress_metrics_dump(FILE *yaml)
 			pr_yaml(yaml, "      max-rss: %ld\n", maxrss);
 		}
 
+		n_items = 0;
+		stress_metrics_stream_item(items, &n_items, "bogo-ops", (double)c_total);
+		stress_metrics_stream_item(items, &n_items, "bogo-ops-per-second-usr-sys-time", bogo_rate);
+		stress_metrics_stream_item(items, &n_items, "bogo-ops-per-second-real-time", bogo_rate_r_time);
+		stress_metrics_stream_item(items, &n_items, "wall-clock-time", r_total);
+		stress_metrics_stream_item(items, &n_items, "user-time", u_time);
+		stress_metrics_stream_item(items, &n_items, "system-time", s_time);
+		stress_metrics_stream_item(items, &n_items, "cpu-usage-per-instance", cpu_usage);
+		stress_metrics_stream_item(items, &n_items, "max-rss", (double)maxrss);
+
 		for (i = 0; i < SIZEOF_ARRAY(ss->stats[0]->metrics.items); i++) {
 			item = &ss->stats[0]->metrics.items[i];
 			description = item->description;
@@ -2090,15 +2197,21 @@ static void stress_metrics_dump(FILE *yaml)
 
 					total += stats->metrics.items[i].value;
 				}
-				metric = ss->completed_instances ? total / ss->completed_instances : 0.0;
+				if (item->mean_type == STRESS_MERGED_VALUE)
+					metric = item->value;
+				else
+					metric = ss->completed_instances ? total / ss->completed_instances : 0.0;
 				if (g_opt_flags & OPT_FLAGS_SN) {
 					pr_yaml(yaml, "      %s: %e\n", stess_description_yamlify(description), metric);
 				} else {
 					pr_yaml(yaml, "      %s: %f\n", stess_description_yamlify(description), metric);
 				}
+				(void)shim_strscpy(item_names[i], stess_description_yamlify(description), sizeof(item_names[i]));
+				stress_metrics_stream_item(items, &n_items, item_names[i], metric);
 			}
 		}
 		pr_yaml(yaml, "\n");
+		stress_stream_event("metrics", munged, -1, items, n_items);
 	}
 
 	if (misc_metrics && !(g_opt_flags & OPT_FLAGS_METRICS_BRIEF)) {
@@ -2200,6 +2313,17 @@ static void stress_metrics_dump(FILE *yaml)
 								ss->completed_instances, plural);
 						}
 						break;
+					case STRESS_MERGED_VALUE:
+						if (g_opt_flags & OPT_FLAGS_SN) {
+							pr_metrics("%-13s %13.2e %s (merged from %" PRIu32 " instance%s)\n",
+								munged, item->value, description,
+								ss->completed_instances, plural);
+						} else {
+							pr_metrics("%-13s %13.2f %s (merged from %" PRIu32 " instance%s)\n",
+								munged, item->value, description,
+								ss->completed_instances, plural);
+						}
+						break;
 					}
 				}
 			}
@@ -2462,6 +2586,22 @@ STRESS_PRAGMA_POP
 	(void)shim_memset(g_shared->checksum.checksums, 0, sz);
 	g_shared->checksum.length = sz;
 
+	/*
+	 *  Per CPU bogo-ops are only mapped when --per-cpu is used
+	 */
+	if (g_opt_flags & OPT_FLAGS_PER_CPU) {
+		len = sizeof(stress_per_cpu_t) * (size_t)num_procs;
+		sz = (len + page_size) & ~(page_size - 1);
+		g_shared->per_cpu.per_cpus = (stress_per_cpu_t *)mmap(NULL, sz,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+		if (g_shared->per_cpu.per_cpus == MAP_FAILED) {
+			pr_err("cannot mmap per CPU bogo-ops, errno=%d (%s)\n",
+				errno, strerror(errno));
+			goto err_unmap_checksums;
+		}
+		g_shared->per_cpu.length = sz;
+	}
+
 	/*
 	 *  mmap some pages for testing invalid arguments in
 	 *  various stressors, get the allocations done early
@@ -2470,7 +2610,7 @@ STRESS_PRAGMA_POP
 	 */
 	g_shared->mapped.page_none = stress_map_page(PROT_NONE, "PROT_NONE", page_size);
 	if (g_shared->mapped.page_none == MAP_FAILED)
-		goto err_unmap_checksums;
+		goto err_unmap_per_cpus;
 	g_shared->mapped.page_ro = stress_map_page(PROT_READ, "PROT_READ", page_size);
 	if (g_shared->mapped.page_ro == MAP_FAILED)
 		goto err_unmap_page_none;
@@ -2483,6 +2623,9 @@ err_unmap_page_ro:
 	(void)munmap((void *)g_shared->mapped.page_ro, page_size);
 err_unmap_page_none:
 	(void)munmap((void *)g_shared->mapped.page_none, page_size);
+err_unmap_per_cpus:
+	if (g_shared->per_cpu.per_cpus)
+		(void)munmap((void *)g_shared->per_cpu.per_cpus, g_shared->per_cpu.length);
 err_unmap_checksums:
 	(void)munmap((void *)g_shared->checksum.checksums, g_shared->checksum.length);
 err_unmap_shared:
@@ -2515,6 +2658,8 @@ void stress_shared_unmap(void)
 	(void)munmap((void *)g_shared->mapped.page_wo, page_size);
 	(void)munmap((void *)g_shared->mapped.page_ro, page_size);
 	(void)munmap((void *)g_shared->mapped.page_none, page_size);
+	if (g_shared->per_cpu.per_cpus)
+		(void)munmap((void *)g_shared->per_cpu.per_cpus, g_shared->per_cpu.length);
 	(void)munmap((void *)g_shared->checksum.checksums, g_shared->checksum.length);
 	(void)munmap((void *)g_shared, g_shared->length);
 }
@@ -2768,6 +2913,7 @@ static inline void stress_setup_stats_buffers(void)
 {
 	stress_stressor_t *ss;
 	stress_stats_t *stats = g_shared->stats;
+	stress_per_cpu_t *per_cpu = g_shared->per_cpu.per_cpus;
 
 	for (ss = stressors_head; ss; ss = ss->next) {
 		int32_t i;
@@ -2779,6 +2925,7 @@ static inline void stress_setup_stats_buffers(void)
 			size_t j;
 
 			ss->stats[i] = stats;
+			stats->per_cpu = per_cpu ? per_cpu++ : NULL;
 			for (j = 0; j < SIZEOF_ARRAY(stats->metrics.items); j++) {
 				stats->metrics.items[j].value = 0.0;
 				stats->metrics.items[j].description = NULL;
@@ -3025,6 +3172,17 @@ next_opt:
 				stress_enable_classes(u32);
 			}
 			break;
+		case OPT_compare:
+			stress_set_setting_global("compare", TYPE_ID_STR, (void *)optarg);
+			break;
+		case OPT_compare_runs:
+			if (stress_set_compare_runs(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_compare_tolerance:
+			if (stress_set_compare_tolerance(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
 		case OPT_config:
 			printf("config:\n%s", stress_config);
 			exit(EXIT_SUCCESS);
@@ -3034,6 +3192,13 @@ next_opt:
 		case OPT_help:
 			stress_usage();
 			break;
+		case OPT_interval:
+			if (stress_set_interval(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_interval_csv:
+			stress_set_setting_global("interval-csv", TYPE_ID_STR, (void *)optarg);
+			break;
 		case OPT_ionice_class:
 			i32 = stress_get_opt_ionice_class(optarg);
 			stress_set_setting("ionice-class", TYPE_ID_INT32, &i32);
@@ -3150,6 +3315,22 @@ next_opt:
 			if (stress_set_temp_path(optarg) < 0)
 				exit(EXIT_FAILURE);
 			break;
+		case OPT_page_size:
+			if (stress_set_page_size(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_io_engine:
+			if (stress_set_io_engine(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_throttle_load:
+			if (stress_set_throttle_load(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_throttle_ops:
+			if (stress_set_throttle_ops(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
 		case OPT_timeout:
 			g_opt_timeout = stress_get_uint64_time(optarg);
 			break;
@@ -3181,6 +3362,12 @@ next_opt:
 		case OPT_yaml:
 			stress_set_setting_global("yaml", TYPE_ID_STR, (void *)optarg);
 			break;
+		case OPT_csv:
+			stress_set_setting_global("csv", TYPE_ID_STR, (void *)optarg);
+			break;
+		case OPT_json:
+			stress_set_setting_global("json", TYPE_ID_STR, (void *)optarg);
+			break;
 		default:
 			if (!jobmode)
 				(void)printf("Unknown option (%d)\n",c);
@@ -3487,7 +3674,7 @@ int main(int argc, char **argv, char **envp)
 	int32_t ionice_class = UNDEFINED;	/* ionice class */
 	int32_t ionice_level = UNDEFINED;	/* ionice level */
 	size_t i;
-	uint32_t class = 0;
+	uint32_t class = 0, run;
 	const uint32_t cpus_online = (uint32_t)stress_get_processors_online();
 	const uint32_t cpus_configured = (uint32_t)stress_get_processors_configured();
 	int ret;
@@ -3567,6 +3754,14 @@ int main(int argc, char **argv, char **envp)
 		goto exit_stressors_free;
 	}
 
+	/*
+	 *  Load in baseline metrics to compare against
+	 */
+	if (stress_compare_load() < 0) {
+		ret = EXIT_FAILURE;
+		goto exit_stressors_free;
+	}
+
 	/*
 	 *  Sanity check minimize/maximize options
 	 */
@@ -3607,6 +3802,17 @@ int main(int argc, char **argv, char **envp)
 		goto exit_stressors_free;
 	}
 
+	/*
+	 *  Sanity check --interval and --sync-start, both sample the
+	 *  bogo-op counters of the running stressors from the parent
+	 */
+	if ((g_opt_flags & OPT_FLAGS_SYNC_START) && stress_interval_enabled()) {
+		(void)fprintf(stderr, "cannot invoke mutually exclusive "
+			"--interval and --sync-start options together\n");
+		ret = EXIT_FAILURE;
+		goto exit_stressors_free;
+	}
+
 	/*
 	 *  Sanity check --with option
 	 */
@@ -3825,6 +4031,9 @@ int main(int argc, char **argv, char **envp)
 	if (g_opt_flags & OPT_FLAGS_THRASH)
 		stress_thrash_start();
 
+	stress_stream_open();
+	stress_stream_event("run-start", NULL, -1, NULL, 0);
+
 	stress_vmstat_start();
 	stress_smart_start();
 	stress_klog_start();
@@ -3833,12 +4042,24 @@ int main(int argc, char **argv, char **envp)
 	if (g_opt_flags & OPT_FLAGS_METRICS)
 		stress_config_check();
 
-	if (g_opt_flags & OPT_FLAGS_SEQUENTIAL) {
-		stress_run_sequential(ticks_per_sec, &duration, &success, &resource_success, &metrics_success);
-	} else if (g_opt_flags & OPT_FLAGS_PERMUTE) {
-		stress_run_permute(ticks_per_sec, &duration, &success, &resource_success, &metrics_success);
-	} else {
-		stress_run_parallel(ticks_per_sec, &duration, &success, &resource_success, &metrics_success);
+	/*
+	 *  Runs are repeated when comparing against a baseline
+	 */
+	for (run = 0; run < stress_compare_runs(); run++) {
+		if (run > 0) {
+			if (!stress_continue_flag())
+				break;
+			pr_inf("compare: starting run %" PRIu32 " of %" PRIu32 "\n",
+				run + 1, stress_compare_runs());
+		}
+		if (g_opt_flags & OPT_FLAGS_SEQUENTIAL) {
+			stress_run_sequential(ticks_per_sec, &duration, &success, &resource_success, &metrics_success);
+		} else if (g_opt_flags & OPT_FLAGS_PERMUTE) {
+			stress_run_permute(ticks_per_sec, &duration, &success, &resource_success, &metrics_success);
+		} else {
+			stress_run_parallel(ticks_per_sec, &duration, &success, &resource_success, &metrics_success);
+		}
+		stress_compare_sample(stressors_head);
 	}
 
 	stress_clocksource_check();
@@ -3853,14 +4074,41 @@ int main(int argc, char **argv, char **envp)
 	yaml = stress_yaml_open(yaml_filename);
 
 	/*
-	 *  Dump metrics
+	 *  Dump metrics, latency metrics are from the merged histograms
 	 */
-	if (g_opt_flags & OPT_FLAGS_METRICS)
+	if (g_opt_flags & OPT_FLAGS_LATENCY)
+		stress_latency_metrics_merge(stressors_head);
+	if (g_opt_flags & OPT_FLAGS_METRICS) {
 		stress_metrics_dump(yaml);
+	} else if (stress_stream_enabled()) {
+		/* stream the metrics events without printing the metrics */
+		const uint64_t pr_metrics_flag = g_opt_flags & OPT_FLAGS_PR_METRICS;
+
+		g_opt_flags &= ~OPT_FLAGS_PR_METRICS;
+		stress_metrics_dump(NULL);
+		g_opt_flags |= pr_metrics_flag;
+	}
+
+	if (g_opt_flags & OPT_FLAGS_PER_CPU)
+		stress_per_cpu_dump(yaml, stressors_head);
 
 	if (g_opt_flags & OPT_FLAGS_INTERRUPTS)
 		stress_interrupts_dump(yaml, stressors_head);
 
+	if (stress_interval_enabled())
+		stress_interval_dump(yaml, stressors_head);
+
+	if (g_opt_flags & OPT_FLAGS_SYNC_START)
+		stress_sync_start_dump(yaml, stressors_head);
+
+	stress_latency_dump(yaml, stressors_head);
+
+	/*
+	 *  Throughput regressions against a baseline fail the run
+	 */
+	if (stress_compare_dump(yaml, stressors_head))
+		success = false;
+
 #if defined(STRESS_PERF_STATS) &&	\
     defined(HAVE_LINUX_PERF_EVENT_H)
 	/*
@@ -3891,6 +4139,15 @@ int main(int argc, char **argv, char **envp)
 	stress_ftrace_stop();
 	stress_ftrace_free();
 
+	if (stress_stream_enabled()) {
+		const stress_stream_item_t items[] = {
+			{ "duration",	duration },
+			{ "success",	success ? 1.0 : 0.0 },
+		};
+
+		stress_stream_event("run-stop", NULL, -1, items, SIZEOF_ARRAY(items));
+	}
+
 	pr_inf("%s run completed in %s\n",
 		success ? "successful" : "unsuccessful",
 		stress_duration_to_str(duration, true));
@@ -3909,6 +4166,8 @@ int main(int argc, char **argv, char **envp)
 
 	stress_shared_heap_deinit();
 	stress_stressors_deinit();
+	stress_interval_free();
+	stress_compare_free();
 	stress_stressors_free();
 	stress_cpuidle_free();
 	stress_cache_free();
@@ -3922,6 +4181,7 @@ int main(int argc, char **argv, char **envp)
 	shim_closelog();
 	pr_closelog();
 	stress_yaml_close(yaml);
+	stress_stream_close();
 
 	/*
 	 *  Done!
@@ -3951,6 +4211,7 @@ exit_logging_close:
 	pr_closelog();
 
 exit_stressors_free:
+	stress_compare_free();
 	stress_stressors_free();
 
 exit_settings_free:
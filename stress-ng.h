@@ -194,6 +194,31 @@ typedef struct {
 	stress_metrics_item_t items[STRESS_MISC_METRICS_MAX];
 } stress_metrics_data_t;
 
+/*
+ *  Per stressor log-linear latency histogram, 2^SUB_BITS linear
+ *  sub-buckets per power of 2 nanoseconds, values < 2^MAX_SHIFT ns
+ */
+#define STRESS_LATENCY_SUB_BITS			(4)
+#define STRESS_LATENCY_SUB_BUCKETS		(1U << STRESS_LATENCY_SUB_BITS)
+#define STRESS_LATENCY_MAX_SHIFT		(36)
+#define STRESS_LATENCY_BUCKETS			\
+	((STRESS_LATENCY_MAX_SHIFT - STRESS_LATENCY_SUB_BITS + 1) << STRESS_LATENCY_SUB_BITS)
+
+typedef struct {
+	uint64_t count;			/* number of latencies recorded */
+	uint64_t min_ns;		/* minimum latency */
+	uint64_t max_ns;		/* maximum latency */
+	double total_ns;		/* total of latencies */
+	ssize_t metrics_idx;		/* first latency metric index, -1 = none */
+	uint64_t buckets[STRESS_LATENCY_BUCKETS]; /* latency histogram */
+} stress_latency_t;
+
+#define STRESS_PER_CPU_MAX	(1024)	/* maximum number of CPUs tracked by --per-cpu */
+
+typedef struct {
+	uint64_t ops[STRESS_PER_CPU_MAX]; /* bogo-ops on each CPU */
+} stress_per_cpu_t;
+
 /* stressor args */
 typedef struct {
 	const char *name;		/* stressor name */
@@ -206,6 +231,9 @@ typedef struct {
 	double time_end;		/* when to end */
 	stress_mapped_t *mapped;	/* mmap'd pages, addr of g_shared mapped */
 	stress_metrics_data_t *metrics;	/* misc per stressor metrics */
+	stress_latency_t *latency;	/* per stressor latency histogram */
+	stress_per_cpu_t *per_cpu;	/* per CPU bogo-ops, NULL if not enabled */
+	const uint64_t *throttle_ops;	/* throttle bogo-op limit, NULL if not enabled */
 	const struct stressor_info *info; /* stressor info */
 } stress_args_t;
 
@@ -531,6 +559,10 @@ typedef struct stress_stats {
 	bool sigalarmed;		/* set true if signalled with SIGALRM */
 	bool signalled;			/* set true if signalled with a kill */
 	bool completed;			/* true if stressor completed */
+	bool prefork_ready;		/* true if --prefork instance is ready */
+	uint64_t sync_ops;		/* --sync-start bogo-ops in common window */
+	double sync_duration;		/* --sync-start common window duration */
+	uint64_t throttle_ops;		/* --throttle-* bogo-op limit */
 #if defined(STRESS_PERF_STATS)
 	stress_perf_t sp;		/* perf counters */
 #endif
@@ -540,6 +572,8 @@ typedef struct stress_stats {
 	stress_checksum_t *checksum;	/* pointer to checksum data */
 	stress_interrupts_t interrupts[STRESS_INTERRUPTS_MAX];
 	stress_metrics_data_t metrics;	/* misc metrics */
+	stress_latency_t latency;	/* latency histogram */
+	stress_per_cpu_t *per_cpu;	/* per CPU bogo-ops, NULL if not enabled */
 	double rusage_utime;		/* rusage user time */
 	double rusage_stime;		/* rusage system time */
 	double rusage_utime_total;	/* rusage user time */
@@ -585,6 +619,7 @@ typedef struct {
 	struct {
 		uint8_t	*buffer;	/* Shared memory cache buffer */
 		uint64_t size;		/* buffer size in bytes */
+		size_t mmap_size;	/* buffer size mapped */
 		uint16_t level;		/* 1=L1, 2=L2, 3=L3 */
 		uint16_t padding1;	/* alignment padding */
 		uint32_t ways;		/* cache ways size */
@@ -633,6 +668,10 @@ typedef struct {
 		stress_checksum_t *checksums;	/* per stressor counter checksum */
 		size_t	length;		/* size of checksums mapping */
 	} checksum;
+	struct {
+		stress_per_cpu_t *per_cpus;	/* per stressor per CPU bogo-ops, --per-cpu only */
+		size_t	length;		/* size of per_cpus mapping */
+	} per_cpu;
 	struct {
 		uint8_t allocated[65536 / sizeof(uint8_t)];	/* allocation bitmap */
 		void *lock;		/* lock for allocator */
@@ -640,6 +679,10 @@ typedef struct {
 	struct {
 		uint32_t ready;		/* incremented when rawsock stressor is ready */
 	} rawsock;
+	struct {
+		uint32_t release ALIGNED(4);	/* futex, non-zero to release --prefork instances */
+		double time_released;	/* time instances were released */
+	} prefork;
 	stress_stats_t stats[];		/* Shared statistics */
 } stress_shared_t;
 
@@ -681,6 +724,9 @@ static inline void ALWAYS_INLINE OPTIMIZE3 stress_continue_set_flag(const bool s
 	g_stress_continue_flag = setting;
 }
 
+extern void stress_per_cpu_add(stress_per_cpu_t *per_cpu, const uint64_t inc);
+extern void stress_throttle_wait(stress_args_t *args);
+
 /*
  *  stress_bogo_add()
  *	add inc to the stessor bogo ops counter
@@ -691,6 +737,8 @@ static inline void ALWAYS_INLINE OPTIMIZE3 stress_continue_set_flag(const bool s
  */
 static inline void ALWAYS_INLINE OPTIMIZE3 stress_bogo_add(stress_args_t *args, const uint64_t inc)
 {
+	if (UNLIKELY(args->per_cpu != NULL))
+		stress_per_cpu_add(args->per_cpu, inc);
 	args->ci.counter_ready = false;
 	stress_asm_mb();
 	args->ci.counter += inc;
@@ -708,6 +756,8 @@ static inline void ALWAYS_INLINE OPTIMIZE3 stress_bogo_add(stress_args_t *args,
  */
 static inline void ALWAYS_INLINE OPTIMIZE3 stress_bogo_inc(stress_args_t *args)
 {
+	if (UNLIKELY(args->per_cpu != NULL))
+		stress_per_cpu_add(args->per_cpu, 1);
 	args->ci.counter_ready = false;
 	stress_asm_mb();
 	args->ci.counter++;
@@ -734,6 +784,8 @@ static inline uint64_t ALWAYS_INLINE OPTIMIZE3 stress_bogo_get(stress_args_t *ar
  */
 static inline void ALWAYS_INLINE OPTIMIZE3 stress_bogo_set(stress_args_t *args, const uint64_t val)
 {
+	if (UNLIKELY(args->per_cpu != NULL) && (val > args->ci.counter))
+		stress_per_cpu_add(args->per_cpu, val - args->ci.counter);
 	args->ci.counter_ready = false;
 	stress_asm_mb();
 	args->ci.counter = val;
@@ -760,6 +812,8 @@ static inline bool ALWAYS_INLINE OPTIMIZE3 stress_continue(stress_args_t *args)
 {
 	if (UNLIKELY(!g_stress_continue_flag))
 		return false;
+	if (UNLIKELY(args->throttle_ops != NULL))
+		stress_throttle_wait(args);
 	if (LIKELY(args->max_ops == 0))
 		return true;
 	return stress_bogo_get(args) < args->max_ops;
@@ -811,6 +865,7 @@ static inline bool stress_bogo_inc_lock(stress_args_t *args, void *lock, const b
 
 #define STRESS_GEOMETRIC_MEAN	(1)
 #define STRESS_HARMONIC_MEAN	(2)
+#define STRESS_MERGED_VALUE	(3)	/* same value set for all instances by the parent */
 
 extern WARN_UNUSED int stress_parse_opts(int argc, char **argv, const bool jobmode);
 extern void stress_shared_readonly(void);
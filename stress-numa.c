@@ -23,6 +23,7 @@
 #include "core-capabilities.h"
 #include "core-madvise.h"
 #include "core-mmap.h"
+#include "core-pthread.h"
 
 #if defined(HAVE_LINUX_MEMPOLICY_H)
 #include <linux/mempolicy.h>
@@ -35,6 +36,7 @@
 static const stress_help_t help[] = {
 	{ NULL,	"numa N",		"start N workers stressing NUMA interfaces" },
 	{ NULL,	"numa-bytes N",		"size of memory region to be exercised" },
+	{ NULL,	"numa-migrate",		"measure page migration rates and latencies" },
 	{ NULL,	"numa-ops N",		"stop after N NUMA bogo operations" },
 	{ NULL,	"numa-shuffle-addr",	"shuffle page addresses to move to numa nodes" },
 	{ NULL,	"numa-shuffle-node",	"shuffle numa nodes on numa pages moves" },
@@ -51,6 +53,11 @@ static int stress_set_numa_bytes(const char *opt)
 	return stress_set_setting("numa-bytes", TYPE_ID_SIZE_T, &numa_bytes);
 }
 
+static int stress_set_numa_migrate(const char *opt)
+{
+	return stress_set_setting_true("numa-migrate", opt);
+}
+
 static int stress_set_numa_shuffle_addr(const char *opt)
 {
 	return stress_set_setting_true("numa-shuffle-addr", opt);
@@ -63,6 +70,7 @@ static int stress_set_numa_shuffle_node(const char *opt)
 
 static const stress_opt_set_func_t opt_set_funcs[] = {
 	{ OPT_numa_bytes,		stress_set_numa_bytes },
+	{ OPT_numa_migrate,		stress_set_numa_migrate },
 	{ OPT_numa_shuffle_addr,	stress_set_numa_shuffle_addr },
 	{ OPT_numa_shuffle_node,	stress_set_numa_shuffle_node },
 };
@@ -313,6 +321,312 @@ static inline void stress_set_numa_array(void *array, uint8_t val, size_t nmemb,
 	(void)shim_memset(array, val, n);
 }
 
+/* --numa-migrate move_pages() batch sizes in pages */
+static const size_t numa_migrate_batches[] = {
+	1, 4, 16, 64, 256, 1024, 4096, 16384, 65536
+};
+
+#define NUMA_MIGRATE_BATCHES	SIZEOF_ARRAY(numa_migrate_batches)
+#define NUMA_MIGRATE_IDLE	(0)	/* buffer is not being written */
+#define NUMA_MIGRATE_WRITTEN	(1)	/* buffer is concurrently written */
+#define NUMA_MIGRATE_MODES	(2)
+#define NUMA_MIGRATE_TIME	(0.25)	/* seconds per batch size */
+
+/* per batch size migration results */
+typedef struct {
+	double calls;			/* move_pages() calls */
+	double duration;		/* time in move_pages() */
+	double migrated;		/* pages migrated */
+	double max_latency;		/* slowest move_pages() call */
+} stress_numa_migrate_t;
+
+/* buffer to migrate */
+typedef struct {
+	uint8_t *buf;			/* buffer */
+	size_t num_pages;		/* buffer size in pages */
+	size_t page_size;		/* page size */
+	void **pages;			/* move_pages() page addresses */
+	int *dest_nodes;		/* move_pages() destination nodes */
+	int *status;			/* move_pages() status */
+	volatile bool writing;		/* writer thread keeps writing */
+} stress_numa_buffer_t;
+
+static const char * const numa_migrate_modes[NUMA_MIGRATE_MODES] = {
+	"idle",
+	"written",
+};
+
+#if defined(HAVE_LIB_PTHREAD)
+/*
+ *  stress_numa_writer()
+ *	write to each page of the buffer until told to stop
+ */
+static void *stress_numa_writer(void *arg)
+{
+	static void *nowt = NULL;
+	stress_numa_buffer_t *b = (stress_numa_buffer_t *)arg;
+	uint64_t val = 0;
+
+	while (b->writing) {
+		volatile uint8_t *ptr;
+		const uint8_t *end = b->buf + (b->num_pages * b->page_size);
+
+		for (ptr = b->buf; b->writing && (ptr < end); ptr += b->page_size)
+			*(volatile uint64_t *)ptr = val;
+		val++;
+	}
+	return &nowt;
+}
+#endif
+
+/*
+ *  stress_numa_migrate_move()
+ *	move count pages from page offset to node, returns the
+ *	number of pages that ended up on the node or -1 on error
+ */
+static long stress_numa_migrate_move(
+	stress_args_t *args,
+	stress_numa_buffer_t *b,
+	const size_t offset,
+	const size_t count,
+	const int node)
+{
+	size_t i;
+	long lret, migrated = 0;
+
+	for (i = 0; i < count; i++) {
+		b->pages[i] = b->buf + ((offset + i) * b->page_size);
+		b->dest_nodes[i] = node;
+		b->status[i] = -1;
+	}
+	lret = shim_move_pages(args->pid, count, b->pages, b->dest_nodes,
+		b->status, MPOL_MF_MOVE);
+	if (lret < 0)
+		return -1;
+	for (i = 0; i < count; i++)
+		migrated += (b->status[i] == node);
+	return migrated;
+}
+
+/*
+ *  stress_numa_migrate_batch()
+ *	migrate the buffer between two nodes in batches of batch pages
+ *	for NUMA_MIGRATE_TIME seconds
+ */
+static int stress_numa_migrate_batch(
+	stress_args_t *args,
+	stress_numa_buffer_t *b,
+	const size_t batch,
+	const int node_a,
+	const int node_b,
+	stress_numa_migrate_t *result)
+{
+	size_t offset;
+	int node = node_b;
+	double t_end;
+
+	/* start with all the pages on node a */
+	for (offset = 0; offset < b->num_pages; offset += batch) {
+		const size_t count = STRESS_MINIMUM(batch, b->num_pages - offset);
+
+		if (stress_numa_migrate_move(args, b, offset, count, node_a) < 0)
+			goto err;
+	}
+
+	t_end = stress_time_now() + NUMA_MIGRATE_TIME;
+	offset = 0;
+	do {
+		double t1, t2;
+		long migrated;
+
+		t1 = stress_time_now();
+		migrated = stress_numa_migrate_move(args, b, offset, batch, node);
+		t2 = stress_time_now();
+		if (migrated < 0)
+			goto err;
+
+		result->calls += 1.0;
+		result->duration += t2 - t1;
+		result->migrated += (double)migrated;
+		if (result->max_latency < t2 - t1)
+			result->max_latency = t2 - t1;
+
+		/* ping-pong the whole buffer between the two nodes */
+		offset += batch;
+		if (offset + batch > b->num_pages) {
+			offset = 0;
+			node = (node == node_a) ? node_b : node_a;
+		}
+	} while (stress_continue(args) && (stress_time_now() < t_end));
+
+	return EXIT_SUCCESS;
+err:
+	if (errno == ENOSYS) {
+		pr_inf_skip("%s: move_pages is not implemented, skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+	}
+	pr_fail("%s: move_pages of %zu pages failed, errno=%d (%s)\n",
+		args->name, batch, errno, strerror(errno));
+	return EXIT_FAILURE;
+}
+
+/*
+ *  stress_numa_migrate_mode()
+ *	measure all the batch sizes for an idle or written buffer
+ */
+static int stress_numa_migrate_mode(
+	stress_args_t *args,
+	stress_numa_buffer_t *b,
+	const int mode,
+	const int node_a,
+	const int node_b,
+	stress_numa_migrate_t *results)
+{
+	size_t i;
+	int rc = EXIT_SUCCESS;
+#if defined(HAVE_LIB_PTHREAD)
+	pthread_t pthread;
+	int ret = -1;
+
+	if (mode == NUMA_MIGRATE_WRITTEN) {
+		b->writing = true;
+		ret = pthread_create(&pthread, NULL, stress_numa_writer, (void *)b);
+		if (ret) {
+			if (args->instance == 0)
+				pr_inf("%s: cannot create writer thread, errno=%d (%s), "
+					"skipping written buffer migrations\n",
+					args->name, ret, strerror(ret));
+			return EXIT_SUCCESS;
+		}
+	}
+#else
+	if (mode == NUMA_MIGRATE_WRITTEN)
+		return EXIT_SUCCESS;
+#endif
+
+	for (i = 0; (i < NUMA_MIGRATE_BATCHES) && stress_continue(args); i++) {
+		if (numa_migrate_batches[i] > b->num_pages)
+			break;
+		rc = stress_numa_migrate_batch(args, b, numa_migrate_batches[i],
+			node_a, node_b, &results[i]);
+		if (rc != EXIT_SUCCESS)
+			break;
+	}
+
+#if defined(HAVE_LIB_PTHREAD)
+	if (ret == 0) {
+		b->writing = false;
+		(void)pthread_join(pthread, NULL);
+	}
+#endif
+	return rc;
+}
+
+/*
+ *  stress_numa_migrate_report()
+ *	log the migration rates and latencies, the instance 0 log has
+ *	the full table, the rates are added to the metrics
+ */
+static void stress_numa_migrate_report(
+	stress_args_t *args,
+	const size_t page_size,
+	stress_numa_migrate_t results[NUMA_MIGRATE_MODES][NUMA_MIGRATE_BATCHES])
+{
+	size_t i, j, idx = 0;
+	char tmp[64];
+
+	if (args->instance == 0)
+		pr_inf("%s: %8s %11s %10s %12s %10s %10s %12s\n", args->name,
+			"buffer", "batch pages", "calls", "pages/sec", "MB/s",
+			"usec/call", "max usec/call");
+	for (i = 0; i < NUMA_MIGRATE_MODES; i++) {
+		for (j = 0; j < NUMA_MIGRATE_BATCHES; j++) {
+			const stress_numa_migrate_t *r = &results[i][j];
+			double rate, mb_rate, latency;
+
+			if ((r->calls <= 0.0) || (r->duration <= 0.0))
+				continue;
+			rate = r->migrated / r->duration;
+			mb_rate = (rate * (double)page_size) / (double)MB;
+			latency = (r->duration * STRESS_DBL_MICROSECOND) / r->calls;
+
+			if (args->instance == 0)
+				pr_inf("%s: %8s %11zu %10.0f %12.1f %10.2f %10.2f %12.2f\n",
+					args->name, numa_migrate_modes[i], numa_migrate_batches[j],
+					r->calls, rate, mb_rate, latency,
+					r->max_latency * STRESS_DBL_MICROSECOND);
+
+			(void)snprintf(tmp, sizeof(tmp), "%s %zu page moves pages per sec",
+				numa_migrate_modes[i], numa_migrate_batches[j]);
+			stress_metrics_set(args, idx++, tmp, rate, STRESS_GEOMETRIC_MEAN);
+			(void)snprintf(tmp, sizeof(tmp), "%s %zu page moves MB per sec",
+				numa_migrate_modes[i], numa_migrate_batches[j]);
+			stress_metrics_set(args, idx++, tmp, mb_rate, STRESS_GEOMETRIC_MEAN);
+			(void)snprintf(tmp, sizeof(tmp), "%s %zu page moves usec per call",
+				numa_migrate_modes[i], numa_migrate_batches[j]);
+			stress_metrics_set(args, idx++, tmp, latency, STRESS_GEOMETRIC_MEAN);
+		}
+	}
+}
+
+/*
+ *  stress_numa_migrate()
+ *	measure the move_pages() page migration rate and per call
+ *	latency for batch sizes of 1 to 64K pages between two nodes
+ *	for an idle buffer and a buffer that is being written
+ */
+static int stress_numa_migrate(
+	stress_args_t *args,
+	uint8_t *buf,
+	const size_t num_pages,
+	const stress_node_t *n,
+	const long numa_nodes,
+	void **pages,
+	int *dest_nodes,
+	int *status)
+{
+	static stress_numa_migrate_t results[NUMA_MIGRATE_MODES][NUMA_MIGRATE_BATCHES];
+	stress_numa_buffer_t b;
+	const int node_a = (int)n->node_id;
+	const int node_b = (int)n->next->node_id;
+	int rc = EXIT_SUCCESS;
+
+	if (numa_nodes < 2) {
+		if (args->instance == 0)
+			pr_inf_skip("%s: migration measurements need at least 2 NUMA nodes, "
+				"skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+	}
+	if ((args->instance == 0) &&
+	    (num_pages < numa_migrate_batches[NUMA_MIGRATE_BATCHES - 1]))
+		pr_inf("%s: %zu page buffer, batches larger than this are not measured, "
+			"use --numa-bytes to measure up to %zu page batches\n",
+			args->name, num_pages, numa_migrate_batches[NUMA_MIGRATE_BATCHES - 1]);
+
+	b.buf = buf;
+	b.num_pages = num_pages;
+	b.page_size = args->page_size;
+	b.pages = pages;
+	b.dest_nodes = dest_nodes;
+	b.status = status;
+	b.writing = false;
+	(void)shim_memset(results, 0, sizeof(results));
+
+	do {
+		int mode;
+
+		for (mode = 0; (mode < NUMA_MIGRATE_MODES) && (rc == EXIT_SUCCESS); mode++)
+			rc = stress_numa_migrate_mode(args, &b, mode, node_a, node_b, results[mode]);
+		if (rc != EXIT_SUCCESS)
+			break;
+		stress_bogo_inc(args);
+	} while (stress_continue(args));
+
+	stress_numa_migrate_report(args, b.page_size, results);
+
+	return rc;
+}
+
 /*
  *  stress_numa()
  *	stress the Linux NUMA interfaces
@@ -331,13 +645,14 @@ static int stress_numa(stress_args_t *args)
 	void **pages;
 	size_t mask_elements, k;
 	unsigned long *node_mask, *old_node_mask;
-	bool numa_shuffle_addr, numa_shuffle_node;
+	bool numa_shuffle_addr = false, numa_shuffle_node = false, numa_migrate = false;
 	stress_numa_stats_t stats_begin, stats_end;
 	double t, duration, rate;
 
 	(void)stress_get_setting("numa-bytes", &numa_bytes);
 	(void)stress_get_setting("numa-shuffle-addr", &numa_shuffle_addr);
 	(void)stress_get_setting("numa-shuffle-node", &numa_shuffle_node);
+	(void)stress_get_setting("numa-migrate", &numa_migrate);
 
 	if (numa_bytes == 0) {
 		numa_bytes = DEFAULT_NUMA_MMAP_BYTES;
@@ -422,6 +737,12 @@ static int stress_numa(stress_args_t *args)
 	stress_numa_stats_read(&stats_begin);
 	stress_set_proc_state(args->name, STRESS_STATE_RUN);
 
+	if (numa_migrate) {
+		rc = stress_numa_migrate(args, buf, num_pages, n, numa_nodes,
+			pages, dest_nodes, status);
+		goto err;
+	}
+
 	k = 0;
 	t = stress_time_now();
 	do {
@@ -20,6 +20,7 @@
 #include "stress-ng.h"
 #include "core-affinity.h"
 #include "core-builtin.h"
+#include "core-latency.h"
 
 static const stress_help_t help[] = {
 	{ "p N", "pipe N",		"start N workers exercising pipe I/O" },
@@ -377,10 +378,14 @@ static int stress_pipe_write_generic(
 {
 	int rc = 0;
 	register uint64_t bytes = 0;
+	const bool latency = stress_latency_enabled();
 
 	do {
 		register ssize_t ret;
+		uint64_t t = 0;
 
+		if (latency)
+			t = stress_latency_now();
 		ret = write(fd, buf, pipe_data_size);
 		if (UNLIKELY(ret <= 0)) {
 			if ((errno == EAGAIN) || (errno == EINTR))
@@ -395,6 +400,8 @@ static int stress_pipe_write_generic(
 			}
 			continue;
 		}
+		if (latency)
+			stress_latency_record(args, stress_latency_now() - t);
 		stress_bogo_inc(args);
 		bytes += ret;
 	} while (stress_continue(args));
@@ -418,11 +425,15 @@ static int stress_pipe_write_generic_verify(
 	int rc = 0;
 	register uint32_t *const buf32 = (uint32_t *)buf;
 	register uint64_t bytes = 0;
+	const bool latency = stress_latency_enabled();
 
 	do {
 		register ssize_t ret;
+		uint64_t t = 0;
 
 		*buf32 = val++;
+		if (latency)
+			t = stress_latency_now();
 		ret = write(fd, buf, pipe_data_size);
 		if (UNLIKELY(ret <= 0)) {
 			if ((errno == EAGAIN) || (errno == EINTR))
@@ -437,6 +448,8 @@ static int stress_pipe_write_generic_verify(
 			}
 			continue;
 		}
+		if (latency)
+			stress_latency_record(args, stress_latency_now() - t);
 		stress_bogo_inc(args);
 		bytes += ret;
 	} while (stress_continue(args));
@@ -464,16 +477,20 @@ static int stress_pipe_write_splice(
 	size_t offset = 0;
 	const size_t nbufs = buf_size / pipe_data_size;
 	const size_t offset_end = nbufs * pipe_data_size;
+	const bool latency = stress_latency_enabled();
 
 	iov.iov_len = pipe_data_size;
 
 	do {
 		register ssize_t ret;
+		uint64_t t = 0;
 
 		iov.iov_base = buf + offset;
 		offset += pipe_data_size;
 		if (offset >= offset_end)
 			offset = 0;
+		if (latency)
+			t = stress_latency_now();
 		ret = vmsplice(fd, &iov, 1, 0);
 		if (UNLIKELY(ret <= 0)) {
 			if ((errno == EAGAIN) || (errno == EINTR))
@@ -488,6 +505,8 @@ static int stress_pipe_write_splice(
 			}
 			continue;
 		}
+		if (latency)
+			stress_latency_record(args, stress_latency_now() - t);
 		stress_bogo_inc(args);
 		bytes += pipe_data_size;
 	} while (stress_continue(args));
@@ -515,11 +534,13 @@ static int stress_pipe_write_splice_verify(
 	size_t offset = 0;
 	const size_t nbufs = buf_size / pipe_data_size;
 	const size_t offset_end = nbufs * pipe_data_size;
+	const bool latency = stress_latency_enabled();
 
 	iov.iov_len = pipe_data_size;
 
 	do {
 		register ssize_t ret;
+		uint64_t t = 0;
 		uint32_t *buf32;
 
 		iov.iov_base = buf + offset;
@@ -528,6 +549,8 @@ static int stress_pipe_write_splice_verify(
 		offset += pipe_data_size;
 		if (offset >= offset_end)
 			offset = 0;
+		if (latency)
+			t = stress_latency_now();
 		ret = vmsplice(fd, &iov, 1, 0);
 		if (UNLIKELY(ret <= 0)) {
 			if ((errno == EAGAIN) || (errno == EINTR))
@@ -542,6 +565,8 @@ static int stress_pipe_write_splice_verify(
 			}
 			continue;
 		}
+		if (latency)
+			stress_latency_record(args, stress_latency_now() - t);
 		stress_bogo_inc(args);
 		bytes += pipe_data_size;
 	} while (stress_continue(args));
@@ -715,6 +740,7 @@ again:
 		rate = (duration > 0.0) ? ((double)bytes / duration) / (double)MB : 0.0;
 		stress_metrics_set(args, 0, "MB per sec pipe write rate",
 			rate, STRESS_HARMONIC_MEAN);
+		stress_latency_metrics(args, 1);
 
 		(void)close(pipefds[1]);
 		(void)shim_kill(pid, SIGPIPE);
@@ -19,6 +19,7 @@
 #include "stress-ng.h"
 #include "core-builtin.h"
 #include "core-cpu-cache.h"
+#include "core-mmap.h"
 #include "core-pragma.h"
 #include "core-put.h"
 
@@ -101,6 +102,22 @@ static void stress_randlist_free_item(stress_randlist_item_t **item, const size_
 	*item = NULL;
 }
 
+static size_t compact_mmap_size;	/* compact buffer mmap size, 0 = heap */
+
+/*
+ *  stress_randlist_free_compact()
+ *	free the compact buffer, it is mmap'd with --page-size
+ */
+static void stress_randlist_free_compact(stress_randlist_item_t *compact_ptr)
+{
+	if (compact_mmap_size) {
+		(void)munmap((void *)compact_ptr, compact_mmap_size);
+		compact_mmap_size = 0;
+	} else {
+		free(compact_ptr);
+	}
+}
+
 static void stress_randlist_free_ptrs(
 	stress_randlist_item_t *compact_ptr,
 	stress_randlist_item_t *ptrs[],
@@ -108,7 +125,7 @@ static void stress_randlist_free_ptrs(
 	const size_t randlist_size)
 {
 	if (compact_ptr) {
-		free(compact_ptr);
+		stress_randlist_free_compact(compact_ptr);
 	} else {
 		size_t i;
 
@@ -207,7 +224,19 @@ static int stress_randlist(stress_args_t *args)
 	if (randlist_compact) {
 		const size_t size = sizeof(*ptr) + randlist_size;
 
-		compact_ptr = calloc(randlist_items, size);
+		compact_mmap_size = 0;
+		if (stress_page_size_enabled()) {
+			size_t mmap_size = randlist_items * size;
+
+			compact_ptr = (stress_randlist_item_t *)stress_mmap_buffer(args->name,
+				args->instance, &mmap_size, PROT_READ | PROT_WRITE, MAP_PRIVATE);
+			if (compact_ptr == MAP_FAILED)
+				compact_ptr = NULL;
+			else
+				compact_mmap_size = mmap_size;
+		} else {
+			compact_ptr = calloc(randlist_items, size);
+		}
 		if (!compact_ptr) {
 			stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
 			free(ptrs);
@@ -300,7 +329,7 @@ retry:
 	pr_dbg("%s: heap allocations: %zd, mmap allocations: %zd\n", args->name, heap_allocs, mmap_allocs);
 
 	if (compact_ptr) {
-		free(compact_ptr);
+		stress_randlist_free_compact(compact_ptr);
 	} else {
 		for (ptr = head; ptr; ) {
 			next = ptr->next;
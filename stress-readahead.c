@@ -18,8 +18,15 @@
  *
  */
 #include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-io-engine.h"
+#include "core-mincore.h"
 #include "core-pragma.h"
 
+#if defined(HAVE_SYS_SYSMACROS_H)
+#include <sys/sysmacros.h>
+#endif
+
 #define MIN_READAHEAD_BYTES	(1 * MB)
 #define MAX_READAHEAD_BYTES	(MAX_FILE_LIMIT)
 #define DEFAULT_READAHEAD_BYTES	(64 * MB)
@@ -27,6 +34,8 @@
 #define BUF_ALIGNMENT		(4096)
 #define BUF_SIZE		(4096)
 #define MAX_OFFSETS		(16)
+#define CACHE_SAMPLE_MASK	(7)	/* sample page cache every 8 rounds */
+#define DEFAULT_WINDOW		(128 * KB)	/* default readahead window */
 
 static const stress_help_t help[] = {
 	{ NULL,	"readahead N",		"start N workers exercising file readahead" },
@@ -55,6 +64,22 @@ static const stress_opt_set_func_t opt_set_funcs[] = {
 
 typedef uint64_t	buffer_t;
 
+/*
+ *  page cache effectiveness of the readahead calls, sampled
+ *  between the readahead and the reads of the same blocks
+ */
+typedef struct {
+	uint64_t hits;		/* reads with all pages in the page cache */
+	uint64_t misses;	/* reads with pages not in the page cache */
+	uint64_t readaheads;	/* sampled readahead calls */
+	uint64_t issued;	/* pages the sampled readaheads brought into the page cache */
+	uint64_t used;		/* issued pages still in the page cache when read */
+	off_t window;		/* readahead window size */
+	off_t size;		/* file size */
+	uint64_t window_cached[MAX_OFFSETS];	/* window pages cached before readahead */
+	uint64_t block_cached[MAX_OFFSETS];	/* block pages cached before readahead */
+} stress_readahead_cache_t;
+
 static void OPTIMIZE3 stress_readahead_generate_offsets(
 	off_t *offsets,
 	const uint64_t rounded_readahead_bytes)
@@ -91,6 +116,203 @@ static int do_readahead(
 	return 0;
 }
 
+/*
+ *  stress_readahead_window_size()
+ *	return the readahead window size of the backing device
+ *	of the file, DEFAULT_WINDOW if it cannot be determined
+ */
+static off_t stress_readahead_window_size(const struct stat *statbuf)
+{
+#if defined(HAVE_SYS_SYSMACROS_H)
+	char path[PATH_MAX], buf[32];
+	unsigned long int kb;
+
+	(void)snprintf(path, sizeof(path), "/sys/class/bdi/%u:%u/read_ahead_kb",
+		(unsigned int)major(statbuf->st_dev),
+		(unsigned int)minor(statbuf->st_dev));
+	if ((stress_system_read(path, buf, sizeof(buf)) > 0) &&
+	    (sscanf(buf, "%lu", &kb) == 1) && (kb > 0))
+		return (off_t)(kb * KB);
+#else
+	(void)statbuf;
+#endif
+	return (off_t)DEFAULT_WINDOW;
+}
+
+/*
+ *  stress_readahead_window()
+ *	length of the readahead window at offset, clipped to the file size
+ */
+static inline off_t stress_readahead_window(
+	const stress_readahead_cache_t *cache,
+	const off_t offset)
+{
+	return STRESS_MINIMUM(cache->window, cache->size - offset);
+}
+
+/*
+ *  stress_readahead_cache_before()
+ *	sample the pages of the readahead windows and of the blocks
+ *	to be read that are in the page cache before the readaheads
+ */
+static void stress_readahead_cache_before(
+	const int fd,
+	const off_t *offsets,
+	stress_readahead_cache_t *cache)
+{
+	size_t i;
+
+	for (i = 0; i < MAX_OFFSETS; i++) {
+		stress_page_cache_stat_t pcstat;
+
+		cache->window_cached[i] = UINT64_MAX;
+		cache->block_cached[i] = UINT64_MAX;
+		if (stress_page_cache_stat(fd, offsets[i],
+				stress_readahead_window(cache, offsets[i]), &pcstat) < 0)
+			continue;
+		cache->window_cached[i] = pcstat.cached;
+		if (stress_page_cache_stat(fd, offsets[i], BUF_SIZE, &pcstat) < 0)
+			continue;
+		cache->block_cached[i] = pcstat.cached;
+	}
+}
+
+/*
+ *  stress_readahead_cache_issued()
+ *	sample the readahead windows just after the readaheads, the
+ *	pages newly in the page cache are the pages readahead issued
+ */
+static void stress_readahead_cache_issued(
+	const int fd,
+	const off_t *offsets,
+	stress_readahead_cache_t *cache)
+{
+	size_t i;
+
+	for (i = 0; i < MAX_OFFSETS; i++) {
+		stress_page_cache_stat_t pcstat;
+
+		if (cache->window_cached[i] == UINT64_MAX)
+			continue;
+		if (stress_page_cache_stat(fd, offsets[i],
+				stress_readahead_window(cache, offsets[i]), &pcstat) < 0)
+			continue;
+		cache->readaheads++;
+		if (pcstat.cached > cache->window_cached[i])
+			cache->issued += pcstat.cached - cache->window_cached[i];
+	}
+}
+
+/*
+ *  stress_readahead_cache_used()
+ *	check the block at offsets[i] just before it is read, count
+ *	a hit if it is fully in the page cache and count the pages
+ *	readahead brought in that have not been evicted as used
+ */
+static void stress_readahead_cache_used(
+	const int fd,
+	const off_t *offsets,
+	const size_t i,
+	stress_readahead_cache_t *cache)
+{
+	stress_page_cache_stat_t pcstat;
+
+	if (cache->block_cached[i] == UINT64_MAX)
+		return;
+	if (stress_page_cache_stat(fd, offsets[i], BUF_SIZE, &pcstat) < 0)
+		return;
+	if (pcstat.cached >= pcstat.pages)
+		cache->hits++;
+	else
+		cache->misses++;
+	if (pcstat.cached > cache->block_cached[i])
+		cache->used += pcstat.cached - cache->block_cached[i];
+}
+
+/*
+ *  stress_readahead_verify()
+ *	check the block read from offset contains the data
+ *	written when the file was created
+ */
+static void OPTIMIZE3 stress_readahead_verify(
+	stress_args_t *args,
+	const buffer_t *buf,
+	const off_t offset,
+	uint64_t *baddata)
+{
+	size_t j;
+	const off_t o = offset / BUF_SIZE;
+
+PRAGMA_UNROLL_N(8)
+	for (j = 0; j < (BUF_SIZE / sizeof(*buf)); j++) {
+		const buffer_t v = (buffer_t)o + j;
+
+		if (UNLIKELY(buf[j] != v))
+			(*baddata)++;
+	}
+	if (UNLIKELY(*baddata)) {
+		pr_fail("%s: error in data between 0x%jx and 0x%jx\n",
+			args->name,
+			(intmax_t)offset,
+			(intmax_t)offset + BUF_SIZE - 1);
+	}
+}
+
+/*
+ *  stress_readahead_engine_read()
+ *	read the blocks at the offsets as one batch using the
+ *	--io-engine selected I/O engine
+ */
+static int stress_readahead_engine_read(
+	stress_args_t *args,
+	stress_io_engine_t *engine,
+	buffer_t *buf,
+	const off_t *offsets,
+	const bool verify,
+	uint64_t *misreads,
+	uint64_t *baddata,
+	const char *fs_type)
+{
+	stress_io_req_t reqs[MAX_OFFSETS];
+	stress_io_req_t *reqps[MAX_OFFSETS];
+	size_t i;
+
+	for (i = 0; i < MAX_OFFSETS; i++) {
+		reqs[i].buf = (void *)((uint8_t *)buf + (i * BUF_SIZE));
+		reqs[i].offset = (uint64_t)offsets[i];
+		reqs[i].size = BUF_SIZE;
+		reqs[i].write = false;
+		reqps[i] = &reqs[i];
+	}
+	if (UNLIKELY(stress_io_engine_batch(engine, reqps, MAX_OFFSETS) < 0)) {
+		if (errno == EINTR)
+			return 0;
+		pr_fail("%s: %s I/O engine read failed, errno=%d (%s)%s\n",
+			args->name, stress_io_engine_name(),
+			errno, strerror(errno), fs_type);
+		return -1;
+	}
+
+	for (i = 0; i < MAX_OFFSETS; i++) {
+		const ssize_t res = reqs[i].res;
+
+		if (UNLIKELY(res <= 0)) {
+			if ((res == 0) || (res == -ECANCELED) || (res == -EINTR))
+				continue;
+			pr_fail("%s: read failed, errno=%d (%s)%s\n",
+				args->name, (int)-res, strerror((int)-res), fs_type);
+			return -1;
+		}
+		if (UNLIKELY(res != BUF_SIZE))
+			(*misreads)++;
+		if (verify)
+			stress_readahead_verify(args, (const buffer_t *)reqs[i].buf,
+				offsets[i], baddata);
+		stress_bogo_inc(args);
+	}
+	return 0;
+}
+
 /*
  *  stress_readahead
  *	stress file system cache via readahead calls
@@ -111,6 +333,15 @@ static int stress_readahead(stress_args_t *args)
 	off_t offsets[MAX_OFFSETS] ALIGN64;
 	int generate_offsets = 0;
 	const bool verify = !!(g_opt_flags & OPT_FLAGS_VERIFY);
+	const bool use_engine = stress_io_engine_selected();
+	stress_io_engine_t engine;
+	stress_readahead_cache_t cache;
+	uint32_t rounds = 0;
+	bool sample;
+	double rate;
+
+	(void)shim_memset(&engine, 0, sizeof(engine));
+	(void)shim_memset(&cache, 0, sizeof(cache));
 
 	if (!stress_get_setting("readahead-bytes", &readahead_bytes)) {
 		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
@@ -126,7 +357,9 @@ static int stress_readahead(stress_args_t *args)
 	if (ret < 0)
 		return stress_exit_status(-rc);
 
-	ret = posix_memalign((void **)&buf, BUF_ALIGNMENT, BUF_SIZE);
+	/* I/O engine reads are batched, one buffer per offset */
+	ret = posix_memalign((void **)&buf, BUF_ALIGNMENT,
+		use_engine ? BUF_SIZE * MAX_OFFSETS : BUF_SIZE);
 	if (ret || !buf) {
 		rc = stress_exit_status(errno);
 		pr_err("%s: cannot allocate buffer\n", args->name);
@@ -213,53 +446,63 @@ PRAGMA_UNROLL_N(8)
 	rounded_readahead_bytes = (uint64_t)statbuf.st_size -
 		(uint64_t)(statbuf.st_size % BUF_SIZE);
 
+	if (use_engine &&
+	    (stress_io_engine_open(args, &engine, fd, MAX_OFFSETS) != EXIT_SUCCESS)) {
+		rc = EXIT_NO_RESOURCE;
+		goto close_finish;
+	}
+
+	cache.window = stress_readahead_window_size(&statbuf);
+	cache.size = (off_t)rounded_readahead_bytes;
+
 	stress_set_proc_state(args->name, STRESS_STATE_RUN);
 
 	stress_readahead_generate_offsets(offsets, rounded_readahead_bytes);
 
 	do {
+		sample = ((rounds++ & CACHE_SAMPLE_MASK) == 0);
+		if (sample)
+			stress_readahead_cache_before(fd, offsets, &cache);
 		if (UNLIKELY(do_readahead(args, fd, fs_type, offsets) < 0))
 			goto close_finish;
+		if (sample)
+			stress_readahead_cache_issued(fd, offsets, &cache);
 
-		for (i = 0; i < MAX_OFFSETS; i++) {
-			ssize_t pret;
+		if (use_engine) {
+			if (sample) {
+				for (i = 0; i < MAX_OFFSETS; i++)
+					stress_readahead_cache_used(fd, offsets, (size_t)i, &cache);
+			}
+			if (UNLIKELY(stress_readahead_engine_read(args, &engine, buf,
+					offsets, verify, &misreads, &baddata, fs_type) < 0))
+				goto close_finish;
+		} else {
+			for (i = 0; i < MAX_OFFSETS; i++) {
+				ssize_t pret;
 rnd_rd_retry:
-			if (!stress_continue(args))
-				break;
-
-			pret = pread(fd, buf, BUF_SIZE, offsets[i]);
-			if (UNLIKELY(pret <= 0)) {
-				if ((errno == EAGAIN) || (errno == EINTR))
-					goto rnd_rd_retry;
-				if (errno) {
-					pr_fail("%s: read failed, errno=%d (%s)%s\n",
-						args->name, errno, strerror(errno), fs_type);
-					goto close_finish;
+				if (!stress_continue(args))
+					break;
+
+				if (sample)
+					stress_readahead_cache_used(fd, offsets, (size_t)i, &cache);
+				pret = pread(fd, buf, BUF_SIZE, offsets[i]);
+				if (UNLIKELY(pret <= 0)) {
+					if ((errno == EAGAIN) || (errno == EINTR))
+						goto rnd_rd_retry;
+					if (errno) {
+						pr_fail("%s: read failed, errno=%d (%s)%s\n",
+							args->name, errno, strerror(errno), fs_type);
+						goto close_finish;
+					}
+					continue;
 				}
-				continue;
-			}
-			if (UNLIKELY(pret != BUF_SIZE))
-				misreads++;
-
-			if (verify) {
-				size_t j;
-				const off_t o = offsets[i] / BUF_SIZE;
+				if (UNLIKELY(pret != BUF_SIZE))
+					misreads++;
 
-PRAGMA_UNROLL_N(8)
-				for (j = 0; j < (BUF_SIZE / sizeof(*buf)); j++) {
-					const buffer_t v = (buffer_t)o + j;
-
-					if (UNLIKELY(buf[j] != v))
-						baddata++;
-				}
-				if (UNLIKELY(baddata)) {
-					pr_fail("%s: error in data between 0x%jx and 0x%jx\n",
-						args->name,
-						(intmax_t)offsets[i],
-						(intmax_t)offsets[i] + BUF_SIZE - 1);
-				}
+				if (verify)
+					stress_readahead_verify(args, buf, offsets[i], &baddata);
+				stress_bogo_inc(args);
 			}
-			stress_bogo_inc(args);
 		}
 
 #if defined(HAVE_POSIX_FADVISE) &&	\
@@ -295,6 +538,7 @@ PRAGMA_UNROLL_N(8)
 	rc = EXIT_SUCCESS;
 close_finish:
 	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	stress_io_engine_close(&engine);
 	if (fd_wr >= 0)
 		(void)close(fd_wr);
 	(void)close(fd);
@@ -307,6 +551,19 @@ finish:
 		pr_dbg("%s: %" PRIu64 " incomplete random reads\n",
 			args->name, misreads);
 
+	rate = (cache.hits + cache.misses) > 0 ?
+		100.0 * (double)cache.hits / (double)(cache.hits + cache.misses) : 0.0;
+	stress_metrics_set(args, 0, "% page cache hits on sampled reads",
+		rate, STRESS_GEOMETRIC_MEAN);
+	rate = (cache.readaheads > 0) ?
+		(double)cache.issued / (double)cache.readaheads : 0.0;
+	stress_metrics_set(args, 1, "readahead pages issued per sampled readahead",
+		rate, STRESS_GEOMETRIC_MEAN);
+	rate = (cache.issued > 0) ?
+		100.0 * (double)cache.used / (double)cache.issued : 0.0;
+	stress_metrics_set(args, 2, "% readahead pages used",
+		STRESS_MINIMUM(rate, 100.0), STRESS_GEOMETRIC_MEAN);
+
 	return rc;
 }
 
@@ -18,6 +18,8 @@
  *
  */
 #include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-io-engine.h"
 
 #define MIN_SEEK_SIZE		(1 * MB)
 #define MAX_SEEK_SIZE		(MAX_FILE_LIMIT)
@@ -80,6 +82,66 @@ static off_t stress_shim_lseek(int fd, off_t offset, int whence)
 	return ret;
 }
 
+/*
+ *  stress_seek_engine_rw()
+ *	write and read at random offsets as one batch using
+ *	the --io-engine selected I/O engine
+ */
+static int stress_seek_engine_rw(
+	stress_args_t *args,
+	stress_io_engine_t *engine,
+	uint8_t *wr_buf,
+	uint8_t *rd_buf,
+	const size_t size,
+	const uint64_t len,
+	const char *fs_type)
+{
+	stress_io_req_t reqs[2];
+	stress_io_req_t *reqps[2] = { &reqs[0], &reqs[1] };
+	ssize_t res;
+
+	reqs[0].buf = (void *)wr_buf;
+	reqs[0].offset = stress_mwc64modn(len);
+	reqs[0].size = size;
+	reqs[0].write = true;
+	reqs[1].buf = (void *)rd_buf;
+	reqs[1].offset = stress_mwc64modn(len);
+	reqs[1].size = size;
+	reqs[1].write = false;
+
+	if (UNLIKELY(stress_io_engine_batch(engine, reqps, 2) < 0)) {
+		if (errno == EINTR)
+			return 0;
+		pr_fail("%s: %s I/O engine failed, errno=%d (%s)%s\n",
+			args->name, stress_io_engine_name(),
+			errno, strerror(errno), fs_type);
+		return -1;
+	}
+
+	res = reqs[0].res;
+	if (UNLIKELY(res < 0) &&
+	    (res != -ENOSPC) && (res != -EINTR) && (res != -ECANCELED)) {
+		pr_fail("%s: write failed, errno=%d (%s)%s\n",
+			args->name, (int)-res, strerror((int)-res), fs_type);
+		return -1;
+	}
+	res = reqs[1].res;
+	if (UNLIKELY(res < 0)) {
+		if ((res == -EINTR) || (res == -ECANCELED))
+			return 0;
+		pr_fail("%s: read failed, errno=%d (%s)%s\n",
+			args->name, (int)-res, strerror((int)-res), fs_type);
+		return -1;
+	}
+	if (UNLIKELY(((size_t)res != size) &&
+	    (g_opt_flags & OPT_FLAGS_VERIFY))) {
+		pr_fail("%s: incorrect read size, expecting %zu bytes\n",
+			args->name, size);
+		return -1;
+	}
+	return 0;
+}
+
 /*
  *  stress_seek
  *	stress I/O via random seeks and read/writes
@@ -94,6 +156,8 @@ static int stress_seek(stress_args_t *args)
 	uint8_t buf[512] ALIGN64;
 	const off_t bad_off_t = max_off_t();
 	const char *fs_type;
+	const bool use_engine = stress_io_engine_selected();
+	stress_io_engine_t engine;
 #if defined(HAVE_OFF64_T) &&	\
     defined(HAVE_LSEEK64)
 	off64_t	offset64 = (off64_t)0;
@@ -116,6 +180,7 @@ static int stress_seek(stress_args_t *args)
 	if (ret < 0)
 		return stress_exit_status(-ret);
 
+	(void)shim_memset(&engine, 0, sizeof(engine));
 	stress_rndbuf(buf, sizeof(buf));
 
 	(void)stress_temp_filename_args(args,
@@ -148,6 +213,12 @@ static int stress_seek(stress_args_t *args)
 		goto close_finish;
 	}
 
+	if (use_engine &&
+	    (stress_io_engine_open(args, &engine, fd, 2) != EXIT_SUCCESS)) {
+		rc = EXIT_NO_RESOURCE;
+		goto close_finish;
+	}
+
 	stress_set_proc_state(args->name, STRESS_STATE_RUN);
 
 	do {
@@ -155,6 +226,15 @@ static int stress_seek(stress_args_t *args)
 		uint8_t tmp[512] ALIGN64;
 		ssize_t rwret;
 
+		if (use_engine) {
+			if (UNLIKELY(stress_seek_engine_rw(args, &engine, buf, tmp,
+					sizeof(buf), len, fs_type) < 0)) {
+				rc = EXIT_FAILURE;
+				goto close_finish;
+			}
+			goto do_seeks;
+		}
+
 		offset = (off_t)stress_mwc64modn(len);
 		if (stress_shim_lseek(fd, (off_t)offset, SEEK_SET) < 0) {
 			pr_fail("%s: lseek failed, errno=%d (%s)%s\n",
@@ -207,6 +287,7 @@ re_read:
 			rc = EXIT_FAILURE;
 			goto close_finish;
 		}
+do_seeks:
 #if defined(SEEK_END)
 		if (UNLIKELY(stress_shim_lseek(fd, 0, SEEK_END) < 0)) {
 			if (errno != EINVAL) {
@@ -370,6 +451,7 @@ inc:
 	rc = EXIT_SUCCESS;
 close_finish:
 	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	stress_io_engine_close(&engine);
 	(void)close(fd);
 finish:
 	duration = (count > 0.0) ? duration / count : 0.0;
@@ -19,6 +19,7 @@
  */
 #include "stress-ng.h"
 #include "core-builtin.h"
+#include "core-latency.h"
 #include "core-pthread.h"
 
 #if defined(HAVE_SEMAPHORE_H)
@@ -79,6 +80,7 @@ static void OPTIMIZE3 *semaphore_posix_thrash(void *arg)
 	stress_args_t *args = p_args->args;
 	stress_sem_pthread_t *pthread = (stress_sem_pthread_t *)p_args->data;
 	static void *nowt = NULL;
+	const bool latency = stress_latency_enabled();
 
 	do {
 		int i, j = -1;
@@ -86,11 +88,14 @@ static void OPTIMIZE3 *semaphore_posix_thrash(void *arg)
 		for (i = 0; (i < 1000) && stress_continue_flag(); i++) {
 			int value;
 			struct timespec ts;
+			uint64_t t = 0;
 
 			if (UNLIKELY(sem_getvalue(&sem, &value) < 0)) {
 				pr_fail("%s: sem_getvalue failed, errno=%d (%s)\n",
 					args->name, errno, strerror(errno));
 			}
+			if (latency)
+				t = stress_latency_now();
 do_semwait:
 			j++;
 			if (j >= 3)
@@ -149,7 +154,12 @@ do_semwait:
 				goto do_return;
 			}
 
-			/* Locked at this point, bump counter */
+			/*
+			 *  Locked at this point, record the time taken to
+			 *  acquire the semaphore and bump counter
+			 */
+			if (latency)
+				stress_latency_record(args, stress_latency_now() - t);
 			stress_bogo_inc(args);
 
 			if (UNLIKELY(sem_post(&sem) < 0)) {
@@ -253,6 +263,7 @@ static int stress_sem(stress_args_t *args)
 		stress_metrics_set(args, 2, "sem_wait calls per sec",
 			wait_count / duration, STRESS_HARMONIC_MEAN);
 	}
+	stress_latency_metrics(args, 3);
 
 	(void)sem_destroy(&sem);
 
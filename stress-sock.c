@@ -22,6 +22,7 @@
 #include "core-attribute.h"
 #include "core-builtin.h"
 #include "core-killpid.h"
+#include "core-latency.h"
 #include "core-madvise.h"
 #include "core-net.h"
 
@@ -1035,6 +1036,7 @@ static int OPTIMIZE3 stress_sock_server(
 	double t, duration, metric;
 	uint64_t outq_bytes = 0, outq_samples = 0;
 	size_t sock_msgs = DEFAULT_SOCKET_MSGS;
+	const bool latency = stress_latency_enabled();
 #if defined(SIOCOUTQ)
 	uint32_t count = 0;
 #endif
@@ -1147,6 +1149,7 @@ static int OPTIMIZE3 stress_sock_server(
 			struct sockaddr saddr;
 			socklen_t len;
 			int sndbuf, opt;
+			uint64_t t_lat = 0;
 			struct msghdr ALIGN64 msg;
 			struct iovec ALIGN64 vec[MMAP_IO_SIZE / 16];
 #if defined(HAVE_SENDMMSG)
@@ -1239,6 +1242,8 @@ static int OPTIMIZE3 stress_sock_server(
 				case SOCKET_OPT_SEND:
 					for (i = 16; i < MMAP_IO_SIZE; i += 16) {
 retry_send:
+						if (latency)
+							t_lat = stress_latency_now();
 						if (UNLIKELY(send(sfd, buf, i, flag) < 0)) {
 							if (errno == ENOBUFS) {
 								flag = 0;
@@ -1250,6 +1255,8 @@ retry_send:
 							}
 							break;
 						} else {
+							if (latency)
+								stress_latency_record(args, stress_latency_now() - t_lat);
 							msgs++;
 						}
 					}
@@ -1263,6 +1270,8 @@ retry_send:
 					msg.msg_iov = vec;
 					msg.msg_iovlen = j;
 retry_sendmsg:
+					if (latency)
+						t_lat = stress_latency_now();
 					if (UNLIKELY(sendmsg(sfd, &msg, flag) < 0)) {
 						if (errno == ENOBUFS) {
 							flag = 0;
@@ -1273,6 +1282,8 @@ retry_sendmsg:
 								args->name, errno, strerror(errno));
 						}
 					} else {
+						if (latency)
+							stress_latency_record(args, stress_latency_now() - t_lat);
 						msgs += j;
 					}
 					break;
@@ -1288,6 +1299,8 @@ retry_sendmsg:
 						msgvec[i].msg_hdr.msg_iovlen = j;
 					}
 retry_sendmmsg:
+					if (latency)
+						t_lat = stress_latency_now();
 					if (UNLIKELY(sendmmsg(sfd, msgvec, MSGVEC_SIZE, flag) < 0)) {
 						if (errno == ENOBUFS) {
 							flag = 0;
@@ -1298,6 +1311,8 @@ retry_sendmmsg:
 								args->name, errno, strerror(errno));
 						}
 					} else {
+						if (latency)
+							stress_latency_record(args, stress_latency_now() - t_lat);
 						msgs += (MSGVEC_SIZE * j);
 					}
 					break;
@@ -1349,6 +1364,7 @@ retry_sendmmsg:
 	metric = (outq_samples > 0) ? (double)outq_bytes / (double)outq_samples : 0.0;
 	stress_metrics_set(args, 1, "byte average out queue length",
 		metric, STRESS_HARMONIC_MEAN);
+	stress_latency_metrics(args, 3);
 
 die_close:
 	(void)close(fd);
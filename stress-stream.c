@@ -31,11 +31,31 @@
 #include "stress-ng.h"
 #include "core-cpu.h"
 #include "core-cpu-cache.h"
+#include "core-mmap.h"
 #include "core-nt-store.h"
 #include "core-numa.h"
 #include "core-pragma.h"
 #include "core-target-clones.h"
 
+#if defined(HAVE_COMPILER_MUSL)
+#undef HAVE_IMMINTRIN_H
+#endif
+
+#if defined(HAVE_IMMINTRIN_H)
+#include <immintrin.h>
+#endif
+
+#if defined(HAVE_IMMINTRIN_H) &&	\
+    defined(STRESS_ARCH_X86_64) &&	\
+    (defined(HAVE_COMPILER_GCC) ||	\
+     defined(HAVE_COMPILER_CLANG) ||	\
+     defined(HAVE_COMPILER_ICX)) &&	\
+    !defined(HAVE_COMPILER_ICC)
+#define HAVE_STREAM_SIMD
+#define TARGET_AVX2		__attribute__ ((target("avx2")))
+#define TARGET_AVX512F		__attribute__ ((target("avx512f")))
+#endif
+
 #define MIN_STREAM_L3_SIZE	(4 * KB)
 #define MAX_STREAM_L3_SIZE	(MAX_MEM_LIMIT)
 #define DEFAULT_STREAM_L3_SIZE	(4 * MB)
@@ -46,17 +66,66 @@
 
 #define STORE(dst, src)			dst = src
 
+#define STREAM_NUMA_NODES_MAX	(8)	/* max nodes in --stream-numa matrix */
+#define STREAM_NUMA_SLICE	(1.0)	/* seconds on each node pair */
+#define STREAM_NUMA_METRICS	(3)	/* first --stream-numa metric index */
+
+#define STREAM_COPY		(0)
+#define STREAM_SCALE		(1)
+#define STREAM_ADD		(2)
+#define STREAM_TRIAD		(3)
+#define STREAM_KERNELS		(4)
+
 typedef struct {
 	const char *name;
 	const int advice;
 } stress_stream_madvise_info_t;
 
+typedef struct {
+	double bytes;		/* bytes read and written */
+	double duration;	/* time spent in the kernel */
+} stress_stream_numa_rate_t;
+
+/* --stream-method kernels, index0 argument order */
+typedef struct {
+	const char *name;
+	bool (*capable)(void);
+	void (*copy)(double *const RESTRICT c, const double *const RESTRICT a,
+		const uint64_t n, double *const RESTRICT rd_bytes,
+		double *const RESTRICT wr_bytes, double *const RESTRICT fp_ops);
+	void (*scale)(double *const RESTRICT b, const double *const RESTRICT c,
+		const double q, const uint64_t n, double *const RESTRICT rd_bytes,
+		double *const RESTRICT wr_bytes, double *const RESTRICT fp_ops);
+	void (*add)(const double *const RESTRICT a, const double *const RESTRICT b,
+		double *const RESTRICT c, const uint64_t n, double *const RESTRICT rd_bytes,
+		double *const RESTRICT wr_bytes, double *const RESTRICT fp_ops);
+	void (*triad)(double *const RESTRICT a, const double *const RESTRICT b,
+		const double *const RESTRICT c, const double q, const uint64_t n,
+		double *const RESTRICT rd_bytes, double *const RESTRICT wr_bytes,
+		double *const RESTRICT fp_ops);
+} stress_stream_method_t;
+
+/* --stream-numa cpu node x memory node bandwidth matrix */
+typedef struct {
+	int nodes[STREAM_NUMA_NODES_MAX];	/* NUMA memory node ids */
+	int n_nodes;				/* number of nodes in matrix */
+	int pair;				/* current node pair, -1 = none */
+	bool bound;				/* true if pair binding succeeded */
+	stress_stream_numa_rate_t rates[STREAM_KERNELS][STREAM_NUMA_NODES_MAX][STREAM_NUMA_NODES_MAX];
+} stress_stream_numa_t;
+
+static const char * const stream_kernel_names[STREAM_KERNELS] = {
+	"copy", "scale", "add", "triad"
+};
+
 static const stress_help_t help[] = {
 	{ NULL,	"stream N",		"start N workers exercising memory bandwidth" },
 	{ NULL,	"stream-index N",	"specify number of indices into the data (0..3)" },
 	{ NULL,	"stream-l3-size N",	"specify the L3 cache size of the CPU" },
 	{ NULL,	"stream-madvise M",	"specify mmap'd stream buffer madvise advice" },
+	{ NULL,	"stream-method M",	"specify stream kernels: auto, plain, nt, avx2, avx2nt, avx512, avx512nt" },
 	{ NULL,	"stream-mlock",		"attempt to mlock pages into memory" },
+	{ NULL,	"stream-numa",		"measure bandwidth for all CPU node x memory node pairs" },
 	{ NULL,	"stream-ops N",		"stop after N bogo stream operations" },
 	{ NULL,	NULL,                   NULL }
 };
@@ -87,6 +156,11 @@ static int stress_set_stream_mlock(const char *opt)
 	return stress_set_setting_true("stream-mlock", opt);
 }
 
+static int stress_set_stream_numa(const char *opt)
+{
+	return stress_set_setting_true("stream-numa", opt);
+}
+
 static int stress_set_stream_L3_size(const char *opt)
 {
 	uint64_t stream_L3_size;
@@ -637,6 +711,189 @@ PRAGMA_UNROLL_N(8)
 	*fp_ops += (double)n * 2.0;
 }
 
+#if defined(HAVE_STREAM_SIMD)
+/*
+ *  STRESS_STREAM_SIMD()
+ *	generate copy, scale, add and triad kernels using explicit
+ *	vector loads and stores, arrays are page aligned and n is a
+ *	multiple of 8 so no head or tail handling is required
+ */
+#define STRESS_STREAM_SIMD(name, target, vtype, width, set1, load, store, mul, add, fence) \
+static void target OPTIMIZE3 stress_stream_copy_ ## name(		\
+	double *const RESTRICT c,					\
+	const double *const RESTRICT a,					\
+	const uint64_t n,						\
+	double *const RESTRICT rd_bytes,				\
+	double *const RESTRICT wr_bytes,				\
+	double *const RESTRICT fp_ops)					\
+{									\
+	register uint64_t i;						\
+									\
+	for (i = 0; i < n; i += width)					\
+		store(c + i, load(a + i));				\
+	fence;								\
+									\
+	*rd_bytes += (double)n * (double)(sizeof(*a));			\
+	*wr_bytes += (double)n * (double)(sizeof(*c));			\
+	*fp_ops += 0.0;							\
+}									\
+									\
+static void target OPTIMIZE3 stress_stream_scale_ ## name(		\
+	double *const RESTRICT b,					\
+	const double *const RESTRICT c,					\
+	const double q,							\
+	const uint64_t n,						\
+	double *const RESTRICT rd_bytes,				\
+	double *const RESTRICT wr_bytes,				\
+	double *const RESTRICT fp_ops)					\
+{									\
+	register uint64_t i;						\
+	const vtype vq = set1(q);					\
+									\
+	for (i = 0; i < n; i += width)					\
+		store(b + i, mul(vq, load(c + i)));			\
+	fence;								\
+									\
+	*rd_bytes += (double)n * (double)(sizeof(*c));			\
+	*wr_bytes += (double)n * (double)(sizeof(*b));			\
+	*fp_ops += (double)n;						\
+}									\
+									\
+static void target OPTIMIZE3 stress_stream_add_ ## name(		\
+	const double *const RESTRICT a,					\
+	const double *const RESTRICT b,					\
+	double *const RESTRICT c,					\
+	const uint64_t n,						\
+	double *const RESTRICT rd_bytes,				\
+	double *const RESTRICT wr_bytes,				\
+	double *const RESTRICT fp_ops)					\
+{									\
+	register uint64_t i;						\
+									\
+	for (i = 0; i < n; i += width)					\
+		store(c + i, add(load(a + i), load(b + i)));		\
+	fence;								\
+									\
+	*rd_bytes += (double)n * (double)(sizeof(*a) + sizeof(*b));	\
+	*wr_bytes += (double)n * (double)(sizeof(*c));			\
+	*fp_ops += (double)n;						\
+}									\
+									\
+static void target OPTIMIZE3 stress_stream_triad_ ## name(		\
+	double *const RESTRICT a,					\
+	const double *const RESTRICT b,					\
+	const double *const RESTRICT c,					\
+	const double q,							\
+	const uint64_t n,						\
+	double *const RESTRICT rd_bytes,				\
+	double *const RESTRICT wr_bytes,				\
+	double *const RESTRICT fp_ops)					\
+{									\
+	register uint64_t i;						\
+	const vtype vq = set1(q);					\
+									\
+	for (i = 0; i < n; i += width)					\
+		store(a + i, add(load(b + i), mul(load(c + i), vq)));	\
+	fence;								\
+									\
+	*rd_bytes += (double)n * (double)(sizeof(*b) + sizeof(*c));	\
+	*wr_bytes += (double)n * (double)(sizeof(*a));			\
+	*fp_ops += (double)n * 2.0;					\
+}
+
+STRESS_STREAM_SIMD(avx2, TARGET_AVX2, __m256d, 4, _mm256_set1_pd, _mm256_load_pd,
+	_mm256_store_pd, _mm256_mul_pd, _mm256_add_pd, (void)0)
+STRESS_STREAM_SIMD(avx2nt, TARGET_AVX2, __m256d, 4, _mm256_set1_pd, _mm256_load_pd,
+	_mm256_stream_pd, _mm256_mul_pd, _mm256_add_pd, _mm_sfence())
+STRESS_STREAM_SIMD(avx512, TARGET_AVX512F, __m512d, 8, _mm512_set1_pd, _mm512_load_pd,
+	_mm512_store_pd, _mm512_mul_pd, _mm512_add_pd, (void)0)
+STRESS_STREAM_SIMD(avx512nt, TARGET_AVX512F, __m512d, 8, _mm512_set1_pd, _mm512_load_pd,
+	_mm512_stream_pd, _mm512_mul_pd, _mm512_add_pd, _mm_sfence())
+#endif
+
+static const stress_stream_method_t stream_methods[] = {
+	{ "auto",	NULL,	NULL, NULL, NULL, NULL },
+	{ "plain",	NULL,	stress_stream_copy_index0, stress_stream_scale_index0,
+			stress_stream_add_index0, stress_stream_triad_index0 },
+#if defined(HAVE_NT_STORE_DOUBLE)
+	{ "nt",		stress_cpu_x86_has_sse2,
+			stress_stream_copy_index0_nt, stress_stream_scale_index0_nt,
+			stress_stream_add_index0_nt, stress_stream_triad_index0_nt },
+#else
+	{ "nt",		NULL,	NULL, NULL, NULL, NULL },
+#endif
+#if defined(HAVE_STREAM_SIMD)
+	{ "avx2",	stress_cpu_x86_has_avx2,
+			stress_stream_copy_avx2, stress_stream_scale_avx2,
+			stress_stream_add_avx2, stress_stream_triad_avx2 },
+	{ "avx2nt",	stress_cpu_x86_has_avx2,
+			stress_stream_copy_avx2nt, stress_stream_scale_avx2nt,
+			stress_stream_add_avx2nt, stress_stream_triad_avx2nt },
+	{ "avx512",	stress_cpu_x86_has_avx512_f,
+			stress_stream_copy_avx512, stress_stream_scale_avx512,
+			stress_stream_add_avx512, stress_stream_triad_avx512 },
+	{ "avx512nt",	stress_cpu_x86_has_avx512_f,
+			stress_stream_copy_avx512nt, stress_stream_scale_avx512nt,
+			stress_stream_add_avx512nt, stress_stream_triad_avx512nt },
+#else
+	{ "avx2",	NULL,	NULL, NULL, NULL, NULL },
+	{ "avx2nt",	NULL,	NULL, NULL, NULL, NULL },
+	{ "avx512",	NULL,	NULL, NULL, NULL, NULL },
+	{ "avx512nt",	NULL,	NULL, NULL, NULL, NULL },
+#endif
+};
+
+static int stress_set_stream_method(const char *opt)
+{
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(stream_methods); i++) {
+		if (!strcmp(opt, stream_methods[i].name))
+			return stress_set_setting("stream-method", TYPE_ID_SIZE_T, &i);
+	}
+	(void)fprintf(stderr, "invalid stream-method '%s', allowed methods are:", opt);
+	for (i = 0; i < SIZEOF_ARRAY(stream_methods); i++)
+		(void)fprintf(stderr, " %s", stream_methods[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+/*
+ *  stress_stream_method_usable()
+ *	return true if a method is built in and supported by the CPU
+ */
+static bool stress_stream_method_usable(const stress_stream_method_t *method)
+{
+	if (!method->copy)
+		return false;
+	return method->capable ? method->capable() : true;
+}
+
+/*
+ *  stress_stream_method_get()
+ *	resolve the --stream-method kernels, auto and unsupported
+ *	methods use non-temporal stores if available, otherwise the
+ *	plain C kernels are used
+ */
+static const stress_stream_method_t *stress_stream_method_get(stress_args_t *args)
+{
+	size_t idx = 0;
+
+	(void)stress_get_setting("stream-method", &idx);
+	if (idx >= SIZEOF_ARRAY(stream_methods))
+		idx = 0;
+	if (idx > 0) {
+		if (stress_stream_method_usable(&stream_methods[idx]))
+			return &stream_methods[idx];
+		if (args->instance == 0)
+			pr_inf("%s: stream-method '%s' is not supported on this system, using auto\n",
+				args->name, stream_methods[idx].name);
+	}
+	if (stress_stream_method_usable(&stream_methods[2]))
+		return &stream_methods[2];
+	return &stream_methods[1];
+}
+
 static inline TARGET_CLONES OPTIMIZE3 void stress_stream_init_data(
 	double *const RESTRICT a,
 	double *const RESTRICT b,
@@ -694,14 +951,35 @@ PRAGMA_UNROLL_N(8)
 	return checksum;
 }
 
+/*
+ *  stress_stream_mmap()
+ *	mmap a stream buffer of *sz bytes, *sz is updated to the
+ *	size mapped when --page-size rounds it up to the page size
+ */
 static inline void *stress_stream_mmap(
 	stress_args_t *args,
-	const uint64_t sz,
+	uint64_t *sz,
 	const bool stream_mlock)
 {
 	void *ptr;
 
-	ptr = stress_mmap_populate(NULL, (size_t)sz, PROT_READ | PROT_WRITE,
+	if (stress_page_size_enabled()) {
+		size_t mmap_size = (size_t)*sz;
+
+		ptr = stress_mmap_buffer(args->name, args->instance, &mmap_size,
+			PROT_READ | PROT_WRITE, MAP_PRIVATE);
+		if (ptr == MAP_FAILED) {
+			pr_err("%s: cannot allocate %" PRIu64 " bytes\n",
+				args->name, *sz);
+		} else {
+			*sz = (uint64_t)mmap_size;
+			if (stream_mlock)
+				(void)shim_mlock(ptr, mmap_size);
+		}
+		return ptr;
+	}
+
+	ptr = stress_mmap_populate(NULL, (size_t)*sz, PROT_READ | PROT_WRITE,
 #if defined(HAVE_MADVISE)
 		MAP_PRIVATE |
 #else
@@ -711,17 +989,17 @@ static inline void *stress_stream_mmap(
 	/* Coverity Scan believes NULL can be returned, doh */
 	if (!ptr || (ptr == MAP_FAILED)) {
 		pr_err("%s: cannot allocate %" PRIu64 " bytes\n",
-			args->name, sz);
+			args->name, *sz);
 		ptr = MAP_FAILED;
 	} else {
 		if (stream_mlock)
-			(void)shim_mlock(ptr, (size_t)sz);
+			(void)shim_mlock(ptr, (size_t)*sz);
 #if defined(HAVE_MADVISE)
 		int advice = MADV_NORMAL;
 
 		(void)stress_get_setting("stream-madvise", &advice);
 
-		VOID_RET(int, madvise(ptr, (size_t)sz, advice));
+		VOID_RET(int, madvise(ptr, (size_t)*sz, advice));
 #else
 		UNEXPECTED
 #endif
@@ -802,6 +1080,193 @@ static void stress_stream_init_index(
 	}
 }
 
+/*
+ *  stress_stream_numa_init()
+ *	find the NUMA memory nodes for the --stream-numa matrix,
+ *	returns false if NUMA binding is not possible
+ */
+static bool stress_stream_numa_init(stress_args_t *args, stress_stream_numa_t *numa)
+{
+	unsigned long max_node;
+	int n;
+
+	n = stress_numa_mem_node_ids(numa->nodes, STREAM_NUMA_NODES_MAX, &max_node);
+	if (n < 1) {
+		if (args->instance == 0)
+			pr_inf("%s: cannot determine NUMA memory nodes, disabling --stream-numa\n",
+				args->name);
+		return false;
+	}
+	if (n > STREAM_NUMA_NODES_MAX) {
+		if (args->instance == 0)
+			pr_inf("%s: %d NUMA nodes found, only measuring the first %d nodes\n",
+				args->name, n, STREAM_NUMA_NODES_MAX);
+		n = STREAM_NUMA_NODES_MAX;
+	}
+	stress_numa_cpu_nodes_init();
+	numa->n_nodes = n;
+	numa->pair = -1;
+	numa->bound = false;
+	return true;
+}
+
+/*
+ *  stress_stream_numa_bind()
+ *	bind the process to the CPUs of node x and the stream buffers
+ *	to memory node y; all instances step through the x, y pairs on
+ *	the same wall clock slices so they load the same nodes together
+ */
+static void stress_stream_numa_bind(
+	stress_args_t *args,
+	stress_stream_numa_t *numa,
+	double *a,
+	double *b,
+	double *c,
+	const uint64_t sz)
+{
+	const int pairs = numa->n_nodes * numa->n_nodes;
+	const int pair = (int)((uint64_t)(stress_time_now() / STREAM_NUMA_SLICE) % (uint64_t)pairs);
+	const int cpu_node = numa->nodes[pair / numa->n_nodes];
+	const int mem_node = numa->nodes[pair % numa->n_nodes];
+
+	if (pair == numa->pair)
+		return;
+	numa->pair = pair;
+	numa->bound = false;
+
+	if (stress_numa_bind_cpus(cpu_node) < 0) {
+		pr_dbg("%s: cannot bind to CPUs on node %d, errno=%d (%s)\n",
+			args->name, cpu_node, errno, strerror(errno));
+		return;
+	}
+	if ((stress_numa_mbind_node(a, (size_t)sz, mem_node) < 0) ||
+	    (stress_numa_mbind_node(b, (size_t)sz, mem_node) < 0) ||
+	    (stress_numa_mbind_node(c, (size_t)sz, mem_node) < 0)) {
+		pr_dbg("%s: cannot bind buffers to memory node %d, errno=%d (%s)\n",
+			args->name, mem_node, errno, strerror(errno));
+		return;
+	}
+	numa->bound = true;
+}
+
+/*
+ *  stress_stream_numa_kernels()
+ *	run and individually time the copy, scale, add and triad
+ *	kernels and account the bandwidth to the current node pair,
+ *	returns the total time spent in the kernels
+ */
+static double stress_stream_numa_kernels(
+	stress_stream_numa_t *numa,
+	double *const RESTRICT a,
+	double *const RESTRICT b,
+	double *const RESTRICT c,
+	const double q,
+	const uint64_t n,
+	const stress_stream_method_t *method,
+	double *const RESTRICT rd_bytes,
+	double *const RESTRICT wr_bytes,
+	double *const RESTRICT fp_ops)
+{
+	double t[STREAM_KERNELS + 1], bytes[STREAM_KERNELS];
+	int k;
+
+	t[0] = stress_time_now();
+	method->copy(c, a, n, rd_bytes, wr_bytes, fp_ops);
+	t[1] = stress_time_now();
+	method->scale(b, c, q, n, rd_bytes, wr_bytes, fp_ops);
+	t[2] = stress_time_now();
+	method->add(c, b, a, n, rd_bytes, wr_bytes, fp_ops);
+	t[3] = stress_time_now();
+	method->triad(a, b, c, q, n, rd_bytes, wr_bytes, fp_ops);
+	t[4] = stress_time_now();
+	/* copy and scale touch 2 arrays, add and triad touch 3 arrays */
+	bytes[STREAM_COPY] = (double)n * (double)(2 * sizeof(*a));
+	bytes[STREAM_SCALE] = bytes[STREAM_COPY];
+	bytes[STREAM_ADD] = (double)n * (double)(3 * sizeof(*a));
+	bytes[STREAM_TRIAD] = bytes[STREAM_ADD];
+
+	if (numa->bound) {
+		const int x = numa->pair / numa->n_nodes;
+		const int y = numa->pair % numa->n_nodes;
+
+		for (k = 0; k < STREAM_KERNELS; k++) {
+			numa->rates[k][x][y].bytes += bytes[k];
+			numa->rates[k][x][y].duration += t[k + 1] - t[k];
+		}
+	}
+	return t[STREAM_KERNELS] - t[0];
+}
+
+/*
+ *  stress_stream_numa_report()
+ *	report the per kernel local and remote memory node bandwidth
+ *	as metrics, instance 0 also logs the CPU node x memory node
+ *	bandwidth matrix, which is too large to report as metrics
+ */
+static void stress_stream_numa_report(stress_args_t *args, const stress_stream_numa_t *numa)
+{
+	int k, x, y;
+	size_t idx = STREAM_NUMA_METRICS;
+
+	for (k = 0; k < STREAM_KERNELS; k++) {
+		stress_stream_numa_rate_t local = { 0.0, 0.0 }, remote = { 0.0, 0.0 };
+		char description[64];
+
+		for (x = 0; x < numa->n_nodes; x++) {
+			for (y = 0; y < numa->n_nodes; y++) {
+				const stress_stream_numa_rate_t *rate = &numa->rates[k][x][y];
+				stress_stream_numa_rate_t *sum = (x == y) ? &local : &remote;
+
+				sum->bytes += rate->bytes;
+				sum->duration += rate->duration;
+			}
+		}
+		if (local.duration > 0.0) {
+			(void)snprintf(description, sizeof(description),
+				"MB per sec %s, local memory node", stream_kernel_names[k]);
+			stress_metrics_set(args, idx, description,
+				(local.bytes / (double)MB) / local.duration,
+				STRESS_HARMONIC_MEAN);
+		}
+		idx++;
+		if (remote.duration > 0.0) {
+			(void)snprintf(description, sizeof(description),
+				"MB per sec %s, remote memory node", stream_kernel_names[k]);
+			stress_metrics_set(args, idx, description,
+				(remote.bytes / (double)MB) / remote.duration,
+				STRESS_HARMONIC_MEAN);
+		}
+		idx++;
+	}
+
+	if (args->instance != 0)
+		return;
+
+	for (k = 0; k < STREAM_KERNELS; k++) {
+		char buf[16 + (STREAM_NUMA_NODES_MAX * 12)];
+		size_t len;
+
+		len = (size_t)snprintf(buf, sizeof(buf), "%-5s MB/s cpu\\mem", stream_kernel_names[k]);
+		for (y = 0; y < numa->n_nodes; y++)
+			len += (size_t)snprintf(buf + len, sizeof(buf) - len, " %10d", numa->nodes[y]);
+		pr_inf("%s: %s\n", args->name, buf);
+
+		for (x = 0; x < numa->n_nodes; x++) {
+			len = (size_t)snprintf(buf, sizeof(buf), "%19d", numa->nodes[x]);
+			for (y = 0; y < numa->n_nodes; y++) {
+				const stress_stream_numa_rate_t *rate = &numa->rates[k][x][y];
+
+				if (rate->duration > 0.0)
+					len += (size_t)snprintf(buf + len, sizeof(buf) - len, " %10.1f",
+						(rate->bytes / (double)MB) / rate->duration);
+				else
+					len += (size_t)snprintf(buf + len, sizeof(buf) - len, " %10s", "-");
+			}
+			pr_inf("%s: %s\n", args->name, buf);
+		}
+	}
+}
+
 /*
  *  stress_stream()
  *	stress cache/memory/CPU with stream stressors
@@ -820,9 +1285,9 @@ static int stress_stream(stress_args_t *args)
 	uint32_t init_counter, init_counter_max;
 	bool guess = false;
 	bool stream_mlock = false;
-#if defined(HAVE_NT_STORE_DOUBLE)
-	const bool has_sse2 = stress_cpu_x86_has_sse2();
-#endif
+	bool stream_numa = false;
+	stress_stream_numa_t *numa = NULL;
+	const stress_stream_method_t *method;
 	double rd_bytes = 0.0, wr_bytes = 0.0;
 	const bool verify = !!(g_opt_flags & OPT_FLAGS_VERIFY);
 
@@ -836,6 +1301,25 @@ static int stress_stream(stress_args_t *args)
 		L3 = get_stream_L3_size(args);
 
 	(void)stress_get_setting("stream-index", &stream_index);
+	(void)stress_get_setting("stream-numa", &stream_numa);
+	method = stress_stream_method_get(args);
+	if (stream_numa) {
+		numa = calloc(1, sizeof(*numa));
+		if (!numa) {
+			pr_inf_skip("%s: cannot allocate NUMA bandwidth matrix, skipping stressor\n",
+				args->name);
+			return EXIT_NO_RESOURCE;
+		}
+		if (!stress_stream_numa_init(args, numa)) {
+			free(numa);
+			numa = NULL;
+		} else if (stream_index) {
+			if (args->instance == 0)
+				pr_inf("%s: --stream-numa uses unindexed data, ignoring --stream-index\n",
+					args->name);
+			stream_index = 0;
+		}
+	}
 
 	/* Have to take a hunch and badly guess size */
 	if (!L3) {
@@ -875,34 +1359,34 @@ static int stress_stream(stress_args_t *args)
 	n = (n + 7) & ~(uint64_t)7;
 	sz = n * sizeof(*a);
 
-	a = stress_stream_mmap(args, sz, stream_mlock);
+	a = stress_stream_mmap(args, &sz, stream_mlock);
 	if (a == MAP_FAILED)
 		goto err_unmap;
-	b = stress_stream_mmap(args, sz, stream_mlock);
+	b = stress_stream_mmap(args, &sz, stream_mlock);
 	if (b == MAP_FAILED)
 		goto err_unmap;
-	c = stress_stream_mmap(args, sz, stream_mlock);
+	c = stress_stream_mmap(args, &sz, stream_mlock);
 	if (c == MAP_FAILED)
 		goto err_unmap;
 
 	sz_idx = n * sizeof(size_t);
 	switch (stream_index) {
 	case 3:
-		idx3 = stress_stream_mmap(args, sz_idx, stream_mlock);
+		idx3 = stress_stream_mmap(args, &sz_idx, stream_mlock);
 		if (idx3 == MAP_FAILED)
 			goto err_unmap;
 		stress_stream_init_index(idx3, n);
 		goto case_stream_index_2;
 	case 2:
 case_stream_index_2:
-		idx2 = stress_stream_mmap(args, sz_idx, stream_mlock);
+		idx2 = stress_stream_mmap(args, &sz_idx, stream_mlock);
 		if (idx2 == MAP_FAILED)
 			goto err_unmap;
 		stress_stream_init_index(idx2, n);
 		goto case_stream_index_1;
 	case 1:
 case_stream_index_1:
-		idx1 = stress_stream_mmap(args, sz_idx, stream_mlock);
+		idx1 = stress_stream_mmap(args, &sz_idx, stream_mlock);
 		if (idx1 == MAP_FAILED)
 			goto err_unmap;
 		stress_stream_init_index(idx1, n);
@@ -930,6 +1414,13 @@ case_stream_index_1:
 		if (init_counter >= init_counter_max)
 			init_counter = 0;
 
+		if (numa) {
+			stress_stream_numa_bind(args, numa, a, b, c, sz);
+			dt += stress_stream_numa_kernels(numa, a, b, c, q, n, method,
+					&rd_bytes, &wr_bytes, &fp_ops);
+			goto verify;
+		}
+
 		switch (stream_index) {
 		case 3:
 			t1 = stress_time_now();
@@ -957,27 +1448,16 @@ case_stream_index_1:
 			break;
 		case 0:
 		default:
-#if defined(HAVE_NT_STORE_DOUBLE)
-			if (has_sse2) {
-				t1 = stress_time_now();
-				stress_stream_copy_index0_nt(c, a, n, &rd_bytes, &wr_bytes, &fp_ops);
-				stress_stream_scale_index0_nt(b, c, q, n, &rd_bytes, &wr_bytes, &fp_ops);
-				stress_stream_add_index0_nt(c, b, a, n,  &rd_bytes, &wr_bytes, &fp_ops);
-				stress_stream_triad_index0_nt(a, b, c, q, n, &rd_bytes, &wr_bytes, &fp_ops);
-				t2 = stress_time_now();
-				break;
-			}
-#endif
 			t1 = stress_time_now();
-			stress_stream_copy_index0(c, a, n, &rd_bytes, &wr_bytes, &fp_ops);
-			stress_stream_scale_index0(b, c, q, n, &rd_bytes, &wr_bytes, &fp_ops);
-			stress_stream_add_index0(c, b, a, n, &rd_bytes, &wr_bytes, &fp_ops);
-			stress_stream_triad_index0(a, b, c, q, n, &rd_bytes, &wr_bytes, &fp_ops);
+			method->copy(c, a, n, &rd_bytes, &wr_bytes, &fp_ops);
+			method->scale(b, c, q, n, &rd_bytes, &wr_bytes, &fp_ops);
+			method->add(c, b, a, n, &rd_bytes, &wr_bytes, &fp_ops);
+			method->triad(a, b, c, q, n, &rd_bytes, &wr_bytes, &fp_ops);
 			t2 = stress_time_now();
 			break;
 		}
 		dt += (t2 - t1);
-
+verify:
 		if (verify) {
 			double new_checksum;
 
@@ -1013,6 +1493,8 @@ case_stream_index_1:
 			mb_wr_rate, STRESS_HARMONIC_MEAN);
 		stress_metrics_set(args, 2, "Mflop per sec (double precision) compute rate",
 			fp_rate, STRESS_HARMONIC_MEAN);
+		if (numa)
+			stress_stream_numa_report(args, numa);
 	} else {
 		if (args->instance == 0)
 			pr_inf("%s: run duration too short to reliably determine memory rate\n", args->name);
@@ -1020,6 +1502,7 @@ case_stream_index_1:
 
 err_unmap:
 	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+	free(numa);
 	if (idx3 != MAP_FAILED)
 		(void)munmap((void *)idx3, sz_idx);
 	if (idx2 != MAP_FAILED)
@@ -1040,6 +1523,8 @@ static const stress_opt_set_func_t opt_set_funcs[] = {
 	{ OPT_stream_l3_size,	stress_set_stream_L3_size },
 	{ OPT_stream_madvise,	stress_set_stream_madvise },
 	{ OPT_stream_mlock,	stress_set_stream_mlock },
+	{ OPT_stream_method,	stress_set_stream_method },
+	{ OPT_stream_numa,	stress_set_stream_numa },
 	{ 0,			NULL }
 };
 
@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2024      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-builtin.h"
+#include "core-mmap.h"
+#include "core-perf.h"
+
+#define MIN_TLB_REACH_BYTES	(1 * MB)
+#define MAX_TLB_REACH_BYTES	(MAX_MEM_LIMIT)
+#define DEFAULT_TLB_REACH_BYTES	(256 * MB)
+
+#define TLB_REACH_MIN_PAGES	(4)		/* smallest footprint in pages */
+#define TLB_REACH_POINTS_MAX	(64)		/* max footprints per page size */
+#define TLB_REACH_LOADS_MIN	(1U << 20)	/* min loads per footprint */
+#define TLB_REACH_LOADS_MAX	(1U << 28)	/* max loads per footprint */
+#define TLB_REACH_NO_MISSES	(~0ULL)		/* dTLB misses not counted */
+#define TLB_REACH_LINE_SIZE	(64)		/* access offset step in a page */
+
+#define TLB_REACH_DTLB_RISE	(1.25)		/* ns per access rise at dTLB cliff */
+#define TLB_REACH_STLB_RISE	(1.25)		/* ns per access rise at STLB cliff */
+#define TLB_REACH_STLB_MISSES	(0.5)		/* dTLB misses per access at STLB cliff */
+
+static const stress_help_t help[] = {
+	{ NULL,	"tlb-reach N",		"start N workers that measure TLB reach and page walk costs" },
+	{ NULL,	"tlb-reach-bytes N",	"maximum footprint of the TLB reach sweep" },
+	{ NULL,	"tlb-reach-ops N",	"stop after N TLB reach sweeps" },
+	{ NULL,	"tlb-reach-page-size P","page sizes to measure: all, 4k, 2m or 1g" },
+	{ NULL,	NULL,			NULL }
+};
+
+/* page sizes that can be measured */
+typedef struct {
+	const char *name;		/* --tlb-reach-page-size name */
+	const int mode;			/* STRESS_PAGE_SIZE_* backing */
+	const size_t page_size;		/* page size, 0 = base page size */
+} stress_tlb_reach_page_t;
+
+/* per footprint results */
+typedef struct {
+	size_t pages;			/* footprint in pages */
+	double duration;		/* total time chasing */
+	double loads;			/* total loads */
+	double misses;			/* total dTLB misses */
+	bool misses_valid;		/* true if dTLB misses were counted */
+} stress_tlb_reach_point_t;
+
+/* per page size results */
+typedef struct {
+	size_t page_size;		/* actual page size */
+	size_t n_points;		/* number of footprints measured */
+	stress_tlb_reach_point_t points[TLB_REACH_POINTS_MAX];
+} stress_tlb_reach_result_t;
+
+static const stress_tlb_reach_page_t tlb_reach_pages[] = {
+	{ "4k",		STRESS_PAGE_SIZE_BASE,	0 },
+	{ "2m",		STRESS_PAGE_SIZE_2M,	2 * MB },
+	{ "1g",		STRESS_PAGE_SIZE_1G,	GB },
+};
+
+#define TLB_REACH_PAGE_SIZES	SIZEOF_ARRAY(tlb_reach_pages)
+
+static void *tlb_reach_sink;
+
+static int stress_set_tlb_reach_bytes(const char *opt)
+{
+	uint64_t tlb_reach_bytes;
+
+	tlb_reach_bytes = stress_get_uint64_byte(opt);
+	stress_check_range_bytes("tlb-reach-bytes", tlb_reach_bytes,
+		MIN_TLB_REACH_BYTES, MAX_TLB_REACH_BYTES);
+	return stress_set_setting("tlb-reach-bytes", TYPE_ID_UINT64, &tlb_reach_bytes);
+}
+
+static int stress_set_tlb_reach_page_size(const char *opt)
+{
+	size_t i;
+
+	if (!strcmp(opt, "all")) {
+		i = TLB_REACH_PAGE_SIZES;
+		return stress_set_setting("tlb-reach-page-size", TYPE_ID_SIZE_T, &i);
+	}
+	for (i = 0; i < TLB_REACH_PAGE_SIZES; i++) {
+		if (!strcasecmp(opt, tlb_reach_pages[i].name))
+			return stress_set_setting("tlb-reach-page-size", TYPE_ID_SIZE_T, &i);
+	}
+	(void)fprintf(stderr, "invalid tlb-reach-page-size '%s', allowed page sizes are: all", opt);
+	for (i = 0; i < TLB_REACH_PAGE_SIZES; i++)
+		(void)fprintf(stderr, " %s", tlb_reach_pages[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+/*
+ *  stress_tlb_reach_misses()
+ *	read the dTLB miss counter, TLB_REACH_NO_MISSES if not available
+ */
+static inline uint64_t stress_tlb_reach_misses(const int perf_fd)
+{
+#if defined(STRESS_PERF_STATS)
+	if (perf_fd >= 0)
+		return stress_perf_counter_read(perf_fd);
+#else
+	(void)perf_fd;
+#endif
+	return TLB_REACH_NO_MISSES;
+}
+
+/*
+ *  stress_tlb_reach_next()
+ *	next footprint in pages, steps are 4, 6, 8, 12, 16, 24..
+ */
+static inline size_t stress_tlb_reach_next(const size_t pages)
+{
+	return (pages & (pages - 1)) ? (pages * 4) / 3 : (pages * 3) / 2;
+}
+
+/*
+ *  stress_tlb_reach_chase_init()
+ *	link one cache line in each of the first pages pages into a
+ *	single randomly ordered cycle (Sattolo's algorithm) so each
+ *	load depends on the previous one and TLB prefetching is
+ *	defeated. The line used in each page is rotated so that the
+ *	lines are spread over the cache sets. Returns the start.
+ */
+static void *stress_tlb_reach_chase_init(
+	uint8_t *buf,
+	const size_t page_size,
+	const size_t pages,
+	size_t *perm)
+{
+	const size_t lines = page_size / TLB_REACH_LINE_SIZE;
+	size_t i;
+
+	for (i = 0; i < pages; i++)
+		perm[i] = i;
+	for (i = pages - 1; i > 0; i--) {
+		const size_t j = (size_t)stress_mwc64modn((uint64_t)i);
+		const size_t tmp = perm[i];
+
+		perm[i] = perm[j];
+		perm[j] = tmp;
+	}
+	for (i = 0; i < pages; i++) {
+		void **from = (void **)(buf + (i * page_size) + ((i % lines) * TLB_REACH_LINE_SIZE));
+		const size_t to = perm[i];
+
+		*from = (void *)(buf + (to * page_size) + ((to % lines) * TLB_REACH_LINE_SIZE));
+	}
+	return (void *)buf;
+}
+
+/*
+ *  stress_tlb_reach_chase()
+ *	follow a pointer chain for loads loads, return duration
+ */
+static double OPTIMIZE3 stress_tlb_reach_chase(void *start, const uint32_t loads)
+{
+	register void **ptr = (void **)start;
+	register uint32_t i;
+	double t1, t2;
+
+	t1 = stress_time_now();
+	for (i = 0; i < loads; i += 16) {
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+		ptr = (void **)*ptr;
+	}
+	t2 = stress_time_now();
+	tlb_reach_sink = (void *)ptr;
+
+	return t2 - t1;
+}
+
+/*
+ *  stress_tlb_reach_sweep()
+ *	map a buffer backed by the given page size and chase one
+ *	access per page over growing footprints, returns false if
+ *	the page size is not available
+ */
+static bool stress_tlb_reach_sweep(
+	stress_args_t *args,
+	const stress_tlb_reach_page_t *page,
+	const size_t tlb_reach_bytes,
+	const int perf_fd,
+	stress_tlb_reach_result_t *result)
+{
+	const size_t page_size = page->page_size ? page->page_size : args->page_size;
+	size_t mmap_size = tlb_reach_bytes & ~(page_size - 1);
+	size_t pages, max_pages, actual, n;
+	size_t *perm;
+	uint8_t *buf;
+
+	max_pages = mmap_size / page_size;
+	if (max_pages < TLB_REACH_MIN_PAGES) {
+		if (args->instance == 0)
+			pr_inf("%s: %s pages need --tlb-reach-bytes of at least %zuM, skipping %s pages\n",
+				args->name, page->name,
+				(size_t)((TLB_REACH_MIN_PAGES * page_size) / MB), page->name);
+		return false;
+	}
+
+	buf = (uint8_t *)stress_mmap_buffer_mode(args->name, args->instance, &mmap_size,
+		PROT_READ | PROT_WRITE, MAP_PRIVATE, page->mode);
+	if (buf == MAP_FAILED) {
+		if (args->instance == 0)
+			pr_inf("%s: cannot mmap %zuK of %s pages, errno=%d (%s), skipping %s pages\n",
+				args->name, mmap_size / 1024, page->name,
+				errno, strerror(errno), page->name);
+		return false;
+	}
+	actual = stress_mmap_page_size(buf, mmap_size);
+	if (actual && (actual != page_size)) {
+		if (args->instance == 0)
+			pr_inf("%s: %s pages are backed by %zuK pages, skipping %s pages\n",
+				args->name, page->name, actual / 1024, page->name);
+		(void)munmap((void *)buf, mmap_size);
+		return false;
+	}
+	perm = calloc(max_pages, sizeof(*perm));
+	if (!perm) {
+		pr_inf("%s: cannot allocate %zu page index, skipping %s pages\n",
+			args->name, max_pages, page->name);
+		(void)munmap((void *)buf, mmap_size);
+		return false;
+	}
+
+	result->page_size = page_size;
+	for (n = 0, pages = TLB_REACH_MIN_PAGES;
+	     (pages <= max_pages) && (n < TLB_REACH_POINTS_MAX) && stress_continue(args);
+	     pages = stress_tlb_reach_next(pages), n++) {
+		stress_tlb_reach_point_t *point = &result->points[n];
+		const size_t want = STRESS_MAXIMUM((size_t)TLB_REACH_LOADS_MIN, pages * 16);
+		uint32_t loads = (uint32_t)STRESS_MINIMUM(want, (size_t)TLB_REACH_LOADS_MAX);
+		uint64_t misses1, misses2;
+		void *start;
+
+		loads = (loads + 15) & ~15U;
+		start = stress_tlb_reach_chase_init(buf, page_size, pages, perm);
+		/* warm up, fill the TLBs and caches */
+		(void)stress_tlb_reach_chase(start, (uint32_t)STRESS_MINIMUM((pages + 15) & ~(size_t)15,
+			(size_t)TLB_REACH_LOADS_MAX));
+
+		misses1 = stress_tlb_reach_misses(perf_fd);
+		point->duration += stress_tlb_reach_chase(start, loads);
+		misses2 = stress_tlb_reach_misses(perf_fd);
+
+		point->pages = pages;
+		point->loads += (double)loads;
+		if ((misses1 != TLB_REACH_NO_MISSES) && (misses2 != TLB_REACH_NO_MISSES) &&
+		    (misses2 >= misses1)) {
+			point->misses += (double)(misses2 - misses1);
+			point->misses_valid = true;
+		}
+	}
+	if (n > result->n_points)
+		result->n_points = n;
+
+	free(perm);
+	(void)munmap((void *)buf, mmap_size);
+	return true;
+}
+
+/*
+ *  stress_tlb_reach_cliffs()
+ *	find the footprints in pages where the dTLB and STLB miss
+ *	cliffs occur, the dTLB cliff is the first rise of the ns per
+ *	access over the smallest footprint, the STLB cliff is where
+ *	most accesses miss the dTLB counter (page walks) or, without
+ *	perf, the next rise of the ns per access. The reach is the
+ *	largest footprint before the cliff, 0 if no cliff is found.
+ */
+static void stress_tlb_reach_cliffs(
+	const stress_tlb_reach_result_t *result,
+	const double *ns,
+	size_t *dtlb_reach,
+	size_t *stlb_reach)
+{
+	const stress_tlb_reach_point_t *points = result->points;
+	size_t i, dtlb = 0;
+
+	*dtlb_reach = 0;
+	*stlb_reach = 0;
+
+	for (i = 1; i < result->n_points; i++) {
+		if (ns[i] >= ns[0] * TLB_REACH_DTLB_RISE) {
+			dtlb = i;
+			*dtlb_reach = points[i - 1].pages;
+			break;
+		}
+	}
+	for (i = 1; i < result->n_points; i++) {
+		if (points[i].misses_valid) {
+			if (points[i].misses >= points[i].loads * TLB_REACH_STLB_MISSES) {
+				*stlb_reach = points[i - 1].pages;
+				break;
+			}
+		} else if (dtlb && (i > dtlb + 1) &&
+			   (ns[i] >= ns[dtlb + 1] * TLB_REACH_STLB_RISE)) {
+			*stlb_reach = points[i - 1].pages;
+			break;
+		}
+	}
+}
+
+/*
+ *  stress_tlb_reach_report()
+ *	log the ns per access of each footprint, the instance 0 log
+ *	has the full table, the cliffs are added to the metrics
+ */
+static void stress_tlb_reach_report(
+	stress_args_t *args,
+	const stress_tlb_reach_result_t *results)
+{
+	size_t i, j, idx = 0;
+	char tmp[64];
+
+	for (i = 0; i < TLB_REACH_PAGE_SIZES; i++) {
+		const stress_tlb_reach_result_t *result = &results[i];
+		const size_t page_kb = result->page_size / KB;
+		double ns[TLB_REACH_POINTS_MAX];
+		size_t dtlb_reach, stlb_reach;
+
+		if (!result->n_points)
+			continue;
+		for (j = 0; j < result->n_points; j++) {
+			const stress_tlb_reach_point_t *point = &result->points[j];
+
+			ns[j] = (point->loads > 0.0) ?
+				(point->duration * STRESS_DBL_NANOSECOND) / point->loads : 0.0;
+		}
+		stress_tlb_reach_cliffs(result, ns, &dtlb_reach, &stlb_reach);
+
+		if (args->instance == 0) {
+			pr_inf("%s: %zuK pages: %10s %12s %10s %14s\n", args->name, page_kb,
+				"pages", "footprint K", "ns/access", "dTLB miss/acc");
+			for (j = 0; j < result->n_points; j++) {
+				const stress_tlb_reach_point_t *point = &result->points[j];
+
+				if (point->misses_valid) {
+					pr_inf("%s: %zuK pages: %10zu %12zu %10.2f %14.3f\n",
+						args->name, page_kb, point->pages,
+						(point->pages * result->page_size) / 1024, ns[j],
+						point->misses / point->loads);
+				} else {
+					pr_inf("%s: %zuK pages: %10zu %12zu %10.2f %14s\n",
+						args->name, page_kb, point->pages,
+						(point->pages * result->page_size) / 1024, ns[j], "n/a");
+				}
+			}
+		}
+
+		(void)snprintf(tmp, sizeof(tmp), "%zuK pages ns per access (smallest footprint)", page_kb);
+		stress_metrics_set(args, idx++, tmp, ns[0], STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%zuK pages ns per access (largest footprint)", page_kb);
+		stress_metrics_set(args, idx++, tmp, ns[result->n_points - 1], STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%zuK pages dTLB reach KB", page_kb);
+		stress_metrics_set(args, idx++, tmp,
+			(double)((dtlb_reach * result->page_size) / KB), STRESS_GEOMETRIC_MEAN);
+		(void)snprintf(tmp, sizeof(tmp), "%zuK pages STLB reach KB", page_kb);
+		stress_metrics_set(args, idx++, tmp,
+			(double)((stlb_reach * result->page_size) / KB), STRESS_GEOMETRIC_MEAN);
+
+		if (args->instance == 0) {
+			if (dtlb_reach)
+				pr_inf("%s: %zuK pages: dTLB cliff after %zu pages (%zuK)\n",
+					args->name, page_kb, dtlb_reach,
+					(dtlb_reach * result->page_size) / 1024);
+			else
+				pr_inf("%s: %zuK pages: no dTLB cliff found\n", args->name, page_kb);
+			if (stlb_reach)
+				pr_inf("%s: %zuK pages: STLB cliff after %zu pages (%zuK)\n",
+					args->name, page_kb, stlb_reach,
+					(stlb_reach * result->page_size) / 1024);
+			else
+				pr_inf("%s: %zuK pages: no STLB cliff found, try a larger --tlb-reach-bytes\n",
+					args->name, page_kb);
+		}
+	}
+}
+
+/*
+ *  stress_tlb_reach()
+ *	stress the TLB by measuring the cost of one access per page
+ *	over growing footprints with different page sizes
+ */
+static int stress_tlb_reach(stress_args_t *args)
+{
+	uint64_t tlb_reach_bytes = DEFAULT_TLB_REACH_BYTES;
+	size_t tlb_reach_page_size = TLB_REACH_PAGE_SIZES;
+	stress_tlb_reach_result_t *results;
+	int perf_fd = -1;
+	bool measured = false, skip[TLB_REACH_PAGE_SIZES];
+	size_t i;
+
+	(void)stress_get_setting("tlb-reach-bytes", &tlb_reach_bytes);
+	(void)stress_get_setting("tlb-reach-page-size", &tlb_reach_page_size);
+
+	results = calloc(TLB_REACH_PAGE_SIZES, sizeof(*results));
+	if (!results) {
+		pr_inf_skip("%s: cannot allocate results, skipping stressor\n", args->name);
+		return EXIT_NO_RESOURCE;
+	}
+#if defined(STRESS_PERF_STATS)
+	perf_fd = stress_perf_dtlb_open();
+	if ((perf_fd < 0) && (args->instance == 0))
+		pr_inf("%s: dTLB miss perf counter not available, using access times only\n",
+			args->name);
+#endif
+
+	for (i = 0; i < TLB_REACH_PAGE_SIZES; i++)
+		skip[i] = (tlb_reach_page_size < TLB_REACH_PAGE_SIZES) && (tlb_reach_page_size != i);
+
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+
+	do {
+		for (i = 0; i < TLB_REACH_PAGE_SIZES; i++) {
+			if (skip[i])
+				continue;
+			if (!stress_continue(args))
+				break;
+			/* page sizes that are not available are not retried */
+			if (stress_tlb_reach_sweep(args, &tlb_reach_pages[i],
+						   (size_t)tlb_reach_bytes, perf_fd, &results[i]))
+				measured = true;
+			else
+				skip[i] = true;
+		}
+		if (!measured) {
+			pr_inf_skip("%s: no page sizes could be measured, skipping stressor\n",
+				args->name);
+			break;
+		}
+		stress_bogo_inc(args);
+	} while (stress_continue(args));
+
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+
+	if (perf_fd >= 0)
+		(void)close(perf_fd);
+	stress_tlb_reach_report(args, results);
+	free(results);
+
+	return measured ? EXIT_SUCCESS : EXIT_NO_RESOURCE;
+}
+
+static const stress_opt_set_func_t opt_set_funcs[] = {
+	{ OPT_tlb_reach_bytes,		stress_set_tlb_reach_bytes },
+	{ OPT_tlb_reach_page_size,	stress_set_tlb_reach_page_size },
+	{ 0,				NULL }
+};
+
+stressor_info_t stress_tlb_reach_info = {
+	.stressor = stress_tlb_reach,
+	.class = CLASS_MEMORY | CLASS_CPU_CACHE,
+	.opt_set_funcs = opt_set_funcs,
+	.help = help
+};
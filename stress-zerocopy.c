@@ -0,0 +1,1178 @@
+/*
+ * Copyright (C) 2024      Colin Ian King.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#include "stress-ng.h"
+#include "core-affinity.h"
+#include "core-builtin.h"
+#include "core-killpid.h"
+#include "core-net.h"
+#include "core-perf.h"
+#include "io-uring.h"
+
+#include <netinet/in.h>
+
+#if defined(HAVE_SYS_SENDFILE_H)
+#include <sys/sendfile.h>
+#endif
+
+#if defined(HAVE_LINUX_ERRQUEUE_H)
+#include <linux/errqueue.h>
+#endif
+
+#if defined(HAVE_LINUX_IO_URING_H)
+#include <linux/io_uring.h>
+#endif
+
+#if defined(HAVE_POLL_H)
+#include <poll.h>
+#endif
+
+#define MIN_ZEROCOPY_PORT	(1024)
+#define MAX_ZEROCOPY_PORT	(65535)
+#define DEFAULT_ZEROCOPY_PORT	(15000)
+
+#define MIN_ZEROCOPY_SIZE	(1 * KB)
+#define MAX_ZEROCOPY_SIZE	(16 * MB)
+#define DEFAULT_ZEROCOPY_SIZE	(64 * KB)
+
+#define ZEROCOPY_ROUND_BYTES	(32 * MB)	/* bytes sent per method per round */
+#define ZEROCOPY_RECV_SIZE	(256 * KB)	/* receiver buffer size */
+#define ZEROCOPY_RING_DEPTH	(8)		/* io-uring submission queue entries */
+#define ZEROCOPY_NOTIFS_MAX	(64)		/* max io-uring notifications pending */
+#define ZEROCOPY_NO_CYCLES	(~0ULL)		/* CPU cycles not counted */
+
+static const stress_help_t help[] = {
+	{ NULL,	"zerocopy N",		"start N workers comparing zero-copy socket send paths" },
+	{ NULL,	"zerocopy-method M",	"send method: all, send, msg-zerocopy, sendfile, splice or io-uring-zc" },
+	{ NULL,	"zerocopy-ops N",	"stop after N payloads have been sent" },
+	{ NULL,	"zerocopy-port P",	"use socket ports P to P + number of workers - 1" },
+	{ NULL,	"zerocopy-size N",	"size of each payload sent" },
+	{ NULL,	NULL,			NULL }
+};
+
+#if defined(HAVE_LINUX_IO_URING_H) &&	\
+    defined(HAVE_SYSCALL) &&		\
+    defined(__NR_io_uring_setup) &&	\
+    defined(__NR_io_uring_enter) &&	\
+    defined(IORING_OFF_SQ_RING) &&	\
+    defined(IORING_OFF_CQ_RING) &&	\
+    defined(IORING_OFF_SQES) &&		\
+    defined(IORING_CQE_F_MORE) &&	\
+    defined(IORING_CQE_F_NOTIF) &&	\
+    defined(HAVE_IORING_OP_SEND_ZC)
+#define HAVE_ZEROCOPY_IO_URING
+
+/*
+ *  Avoid GCCism of void * pointer arithmetic by casting to
+ *  uint8_t *, doing the offset and then casting back to void *
+ */
+#define ZEROCOPY_ADDR_OFFSET(addr, offset)	\
+	((void *)(((uint8_t *)addr) + offset))
+
+/*
+ *  io-uring state for IORING_OP_SEND_ZC
+ */
+typedef struct {
+	int ring_fd;			/* io-uring file descriptor */
+	unsigned *sq_head;		/* submission queue head */
+	unsigned *sq_tail;		/* submission queue tail */
+	unsigned *sq_mask;		/* submission queue ring mask */
+	unsigned *sq_array;		/* submission queue index array */
+	unsigned *cq_head;		/* completion queue head */
+	unsigned *cq_tail;		/* completion queue tail */
+	unsigned *cq_mask;		/* completion queue ring mask */
+	struct io_uring_cqe *cqes;	/* completion queue entries */
+	struct io_uring_sqe *sqes;	/* submission queue entries */
+	void *sq_mmap;			/* submission queue ring mapping */
+	void *cq_mmap;			/* completion queue ring mapping */
+	size_t sq_size;			/* size of sq_mmap */
+	size_t cq_size;			/* size of cq_mmap */
+	size_t sqes_size;		/* size of sqes mapping */
+	uint32_t notifs;		/* buffer notifications pending */
+	int32_t res;			/* result of last send */
+	bool res_valid;			/* true once the send result is reaped */
+} stress_zerocopy_ring_t;
+#endif
+
+/*
+ *  per stressor send state
+ */
+typedef struct {
+	int sfd;			/* connected socket */
+	int file_fd;			/* payload file for sendfile and splice */
+	int pipe_fds[2];		/* pipe for splice */
+	uint8_t *buf;			/* payload buffer */
+	size_t size;			/* payload size */
+	uint64_t zc_pending;		/* MSG_ZEROCOPY sends not completed */
+	uint64_t zc_completed;		/* MSG_ZEROCOPY sends completed */
+	uint64_t zc_copied;		/* MSG_ZEROCOPY sends the kernel copied */
+#if defined(HAVE_ZEROCOPY_IO_URING)
+	stress_zerocopy_ring_t *ring;	/* io-uring for SEND_ZC */
+#endif
+} stress_zerocopy_t;
+
+/*
+ *  a send method, init returns -1 if the method is not available
+ */
+typedef struct {
+	const char *name;		/* --zerocopy-method name */
+	int (*init)(stress_args_t *args, stress_zerocopy_t *zc);
+	int (*send)(stress_zerocopy_t *zc, const uint32_t payloads, uint64_t *bytes);
+	void (*deinit)(stress_zerocopy_t *zc);
+} stress_zerocopy_method_t;
+
+/* per method measurements */
+typedef struct {
+	double bytes;			/* bytes sent */
+	double duration;		/* time sending */
+	double cycles;			/* CPU cycles sending, from perf */
+	double cpu_time;		/* CPU time sending, from getrusage */
+	bool initialized;		/* method init succeeded */
+	bool disabled;			/* method not available */
+} stress_zerocopy_stats_t;
+
+static int stress_set_zerocopy_port(const char *opt)
+{
+	int zerocopy_port;
+
+	stress_set_net_port("zerocopy-port", opt,
+		MIN_ZEROCOPY_PORT, MAX_ZEROCOPY_PORT, &zerocopy_port);
+	return stress_set_setting("zerocopy-port", TYPE_ID_INT, &zerocopy_port);
+}
+
+static int stress_set_zerocopy_size(const char *opt)
+{
+	uint64_t zerocopy_size;
+
+	zerocopy_size = stress_get_uint64_byte(opt);
+	stress_check_range_bytes("zerocopy-size", zerocopy_size,
+		MIN_ZEROCOPY_SIZE, MAX_ZEROCOPY_SIZE);
+	return stress_set_setting("zerocopy-size", TYPE_ID_UINT64, &zerocopy_size);
+}
+
+/*
+ *  stress_zerocopy_send()
+ *	plain copying send(), the baseline
+ */
+static int stress_zerocopy_send(stress_zerocopy_t *zc, const uint32_t payloads, uint64_t *bytes)
+{
+	uint32_t i;
+
+	for (i = 0; i < payloads; i++) {
+		size_t sent = 0;
+
+		while (sent < zc->size) {
+			const ssize_t n = send(zc->sfd, zc->buf + sent, zc->size - sent, 0);
+
+			if (UNLIKELY(n <= 0))
+				return -1;
+			sent += (size_t)n;
+			*bytes += (uint64_t)n;
+		}
+	}
+	return 0;
+}
+
+#if defined(MSG_ZEROCOPY) &&		\
+    defined(SO_ZEROCOPY) &&		\
+    defined(MSG_ERRQUEUE) &&		\
+    defined(HAVE_LINUX_ERRQUEUE_H) &&	\
+    defined(SO_EE_ORIGIN_ZEROCOPY) &&	\
+    defined(SO_EE_CODE_ZEROCOPY_COPIED) &&	\
+    defined(IP_RECVERR) &&		\
+    defined(HAVE_POLL_H)
+#define HAVE_ZEROCOPY_MSG_ZEROCOPY
+
+/*
+ *  stress_zerocopy_msg_zerocopy_init()
+ *	enable MSG_ZEROCOPY sends on the socket
+ */
+static int stress_zerocopy_msg_zerocopy_init(stress_args_t *args, stress_zerocopy_t *zc)
+{
+	int so_zerocopy = 1;
+
+	(void)args;
+
+	zc->zc_pending = 0;
+	return setsockopt(zc->sfd, SOL_SOCKET, SO_ZEROCOPY, &so_zerocopy, sizeof(so_zerocopy));
+}
+
+/*
+ *  stress_zerocopy_msg_zerocopy_reap()
+ *	reap MSG_ZEROCOPY completion notifications from the socket
+ *	error queue, if wait is true wait until all sends in flight
+ *	have completed
+ */
+static int stress_zerocopy_msg_zerocopy_reap(stress_zerocopy_t *zc, const bool wait)
+{
+	for (;;) {
+		char control[128];
+		struct msghdr msg;
+		struct cmsghdr *cmsg;
+
+		(void)shim_memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		if (recvmsg(zc->sfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			struct pollfd pfd;
+
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+				return -1;
+			if (!wait || (zc->zc_pending == 0))
+				return 0;
+			if (!stress_continue_flag()) {
+				errno = EINTR;
+				return -1;
+			}
+			/* a non-empty error queue is flagged as POLLERR */
+			pfd.fd = zc->sfd;
+			pfd.events = 0;
+			pfd.revents = 0;
+			(void)poll(&pfd, 1, 100);
+			continue;
+		}
+
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			const struct sock_extended_err *serr;
+			uint64_t n;
+
+			if ((cmsg->cmsg_level != SOL_IP) || (cmsg->cmsg_type != IP_RECVERR))
+				continue;
+			serr = (const struct sock_extended_err *)CMSG_DATA(cmsg);
+			if ((serr->ee_errno != 0) || (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+				continue;
+
+			/* ee_info .. ee_data is the range of completed send ids */
+			n = (uint64_t)(serr->ee_data - serr->ee_info) + 1;
+			zc->zc_pending -= (n > zc->zc_pending) ? zc->zc_pending : n;
+			zc->zc_completed += n;
+			if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				zc->zc_copied += n;
+		}
+	}
+}
+
+/*
+ *  stress_zerocopy_msg_zerocopy()
+ *	send with MSG_ZEROCOPY, the payload pages are pinned rather
+ *	than copied and the kernel signals when they can be reused
+ */
+static int stress_zerocopy_msg_zerocopy(stress_zerocopy_t *zc, const uint32_t payloads, uint64_t *bytes)
+{
+	uint32_t i;
+
+	for (i = 0; i < payloads; i++) {
+		size_t sent = 0;
+
+		while (sent < zc->size) {
+			const ssize_t n = send(zc->sfd, zc->buf + sent, zc->size - sent, MSG_ZEROCOPY);
+
+			if (UNLIKELY(n <= 0)) {
+				/* out of optmem for pinned pages, reap and retry */
+				if ((n < 0) && (errno == ENOBUFS)) {
+					if (stress_zerocopy_msg_zerocopy_reap(zc, true) < 0)
+						return -1;
+					continue;
+				}
+				return -1;
+			}
+			sent += (size_t)n;
+			*bytes += (uint64_t)n;
+			zc->zc_pending++;
+		}
+		if (stress_zerocopy_msg_zerocopy_reap(zc, false) < 0)
+			return -1;
+	}
+	/* the buffer may only be reused once all sends have completed */
+	return stress_zerocopy_msg_zerocopy_reap(zc, true);
+}
+#endif
+
+#if defined(HAVE_SYS_SENDFILE_H) &&	\
+    defined(HAVE_SENDFILE)
+#define HAVE_ZEROCOPY_SENDFILE
+
+/*
+ *  stress_zerocopy_sendfile()
+ *	send the payload from the page cache with sendfile()
+ */
+static int stress_zerocopy_sendfile(stress_zerocopy_t *zc, const uint32_t payloads, uint64_t *bytes)
+{
+	uint32_t i;
+
+	for (i = 0; i < payloads; i++) {
+		off_t offset = 0;
+
+		while ((size_t)offset < zc->size) {
+			const ssize_t n = sendfile(zc->sfd, zc->file_fd, &offset, zc->size - (size_t)offset);
+
+			if (UNLIKELY(n <= 0))
+				return -1;
+			*bytes += (uint64_t)n;
+		}
+	}
+	return 0;
+}
+#endif
+
+#if defined(HAVE_SPLICE) &&	\
+    defined(SPLICE_F_MOVE) &&	\
+    defined(SPLICE_F_MORE)
+#define HAVE_ZEROCOPY_SPLICE
+
+/*
+ *  stress_zerocopy_splice_init()
+ *	create the pipe the payload is spliced through
+ */
+static int stress_zerocopy_splice_init(stress_args_t *args, stress_zerocopy_t *zc)
+{
+	(void)args;
+
+	if (pipe(zc->pipe_fds) < 0)
+		return -1;
+#if defined(F_SETPIPE_SZ)
+	/* a larger pipe means fewer splices, pipe-max-size may cap this */
+	VOID_RET(int, fcntl(zc->pipe_fds[1], F_SETPIPE_SZ, (int)zc->size));
+#endif
+	return 0;
+}
+
+/*
+ *  stress_zerocopy_splice()
+ *	splice the payload from the page cache into a pipe
+ *	and from the pipe into the socket
+ */
+static int stress_zerocopy_splice(stress_zerocopy_t *zc, const uint32_t payloads, uint64_t *bytes)
+{
+	uint32_t i;
+
+	for (i = 0; i < payloads; i++) {
+		loff_t offset = 0;
+
+		while ((size_t)offset < zc->size) {
+			ssize_t n;
+
+			n = splice(zc->file_fd, &offset, zc->pipe_fds[1], NULL,
+				zc->size - (size_t)offset, SPLICE_F_MOVE);
+			if (UNLIKELY(n <= 0))
+				return -1;
+			while (n > 0) {
+				const ssize_t m = splice(zc->pipe_fds[0], NULL, zc->sfd, NULL,
+					(size_t)n, SPLICE_F_MOVE | SPLICE_F_MORE);
+
+				if (UNLIKELY(m <= 0))
+					return -1;
+				n -= m;
+				*bytes += (uint64_t)m;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ *  stress_zerocopy_splice_deinit()
+ *	close the splice pipe
+ */
+static void stress_zerocopy_splice_deinit(stress_zerocopy_t *zc)
+{
+	(void)close(zc->pipe_fds[0]);
+	(void)close(zc->pipe_fds[1]);
+}
+#endif
+
+#if defined(HAVE_ZEROCOPY_IO_URING)
+/*
+ *  stress_zerocopy_io_uring_unmap()
+ *	unmap the rings and close the io-uring
+ */
+static void stress_zerocopy_io_uring_unmap(stress_zerocopy_ring_t *ring)
+{
+	if (ring->sqes)
+		(void)munmap((void *)ring->sqes, ring->sqes_size);
+	if (ring->cq_mmap && (ring->cq_mmap != ring->sq_mmap))
+		(void)munmap(ring->cq_mmap, ring->cq_size);
+	if (ring->sq_mmap)
+		(void)munmap(ring->sq_mmap, ring->sq_size);
+	if (ring->ring_fd >= 0)
+		(void)close(ring->ring_fd);
+	free(ring);
+}
+
+/*
+ *  stress_zerocopy_io_uring_init()
+ *	set up an io-uring and map the rings
+ */
+static int stress_zerocopy_io_uring_init(stress_args_t *args, stress_zerocopy_t *zc)
+{
+	stress_zerocopy_ring_t *ring;
+	struct io_uring_params p;
+	void *ptr;
+
+	(void)args;
+
+	ring = (stress_zerocopy_ring_t *)calloc(1, sizeof(*ring));
+	if (!ring)
+		return -1;
+
+	(void)shim_memset(&p, 0, sizeof(p));
+	ring->ring_fd = (int)syscall(__NR_io_uring_setup, ZEROCOPY_RING_DEPTH, &p);
+	if (ring->ring_fd < 0) {
+		free(ring);
+		return -1;
+	}
+
+	ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_size > ring->sq_size)
+			ring->sq_size = ring->cq_size;
+		ring->cq_size = ring->sq_size;
+	}
+	ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQ_RING);
+	if (ptr == MAP_FAILED)
+		goto err;
+	ring->sq_mmap = ptr;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_mmap = ring->sq_mmap;
+	} else {
+		ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_CQ_RING);
+		if (ptr == MAP_FAILED)
+			goto err;
+		ring->cq_mmap = ptr;
+	}
+
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ptr = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->ring_fd, IORING_OFF_SQES);
+	if (ptr == MAP_FAILED)
+		goto err;
+	ring->sqes = (struct io_uring_sqe *)ptr;
+
+	ring->sq_head = ZEROCOPY_ADDR_OFFSET(ring->sq_mmap, p.sq_off.head);
+	ring->sq_tail = ZEROCOPY_ADDR_OFFSET(ring->sq_mmap, p.sq_off.tail);
+	ring->sq_mask = ZEROCOPY_ADDR_OFFSET(ring->sq_mmap, p.sq_off.ring_mask);
+	ring->sq_array = ZEROCOPY_ADDR_OFFSET(ring->sq_mmap, p.sq_off.array);
+	ring->cq_head = ZEROCOPY_ADDR_OFFSET(ring->cq_mmap, p.cq_off.head);
+	ring->cq_tail = ZEROCOPY_ADDR_OFFSET(ring->cq_mmap, p.cq_off.tail);
+	ring->cq_mask = ZEROCOPY_ADDR_OFFSET(ring->cq_mmap, p.cq_off.ring_mask);
+	ring->cqes = ZEROCOPY_ADDR_OFFSET(ring->cq_mmap, p.cq_off.cqes);
+
+	zc->ring = ring;
+	return 0;
+err:
+	{
+		const int saved_errno = errno;
+
+		stress_zerocopy_io_uring_unmap(ring);
+		errno = saved_errno;
+	}
+	return -1;
+}
+
+/*
+ *  stress_zerocopy_io_uring_reap()
+ *	reap send results and buffer notifications, waiting until the
+ *	send result has been seen if want_result is true and until no
+ *	more than max_notifs notifications are pending
+ */
+static int stress_zerocopy_io_uring_reap(
+	stress_zerocopy_ring_t *ring,
+	const bool want_result,
+	const uint32_t max_notifs)
+{
+	for (;;) {
+		unsigned head = *ring->cq_head;
+
+		stress_asm_mb();
+		while (head != *ring->cq_tail) {
+			const struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+
+			if (cqe->flags & IORING_CQE_F_NOTIF) {
+				if (ring->notifs > 0)
+					ring->notifs--;
+			} else {
+				ring->res = cqe->res;
+				ring->res_valid = true;
+				/* a notification follows once the buffer is released */
+				if (cqe->flags & IORING_CQE_F_MORE)
+					ring->notifs++;
+			}
+			head++;
+			stress_asm_mb();
+		}
+		*ring->cq_head = head;
+		stress_asm_mb();
+
+		if ((!want_result || ring->res_valid) && (ring->notifs <= max_notifs))
+			return 0;
+		if (!stress_continue_flag()) {
+			errno = EINTR;
+			return -1;
+		}
+		if ((syscall(__NR_io_uring_enter, ring->ring_fd, 0, 1,
+			     IORING_ENTER_GETEVENTS, NULL, 0) < 0) && (errno != EINTR))
+			return -1;
+	}
+}
+
+/*
+ *  stress_zerocopy_io_uring_zc()
+ *	send with IORING_OP_SEND_ZC, each send completes with a result
+ *	and later a notification once the payload pages are released
+ */
+static int stress_zerocopy_io_uring_zc(stress_zerocopy_t *zc, const uint32_t payloads, uint64_t *bytes)
+{
+	stress_zerocopy_ring_t *ring = zc->ring;
+	uint32_t i;
+
+	for (i = 0; i < payloads; i++) {
+		size_t sent = 0;
+
+		while (sent < zc->size) {
+			const unsigned tail = *ring->sq_tail;
+			const unsigned index = tail & *ring->sq_mask;
+			struct io_uring_sqe *sqe = &ring->sqes[index];
+
+			(void)shim_memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_SEND_ZC;
+			sqe->fd = zc->sfd;
+			sqe->addr = (uintptr_t)(zc->buf + sent);
+			sqe->len = (uint32_t)(zc->size - sent);
+			ring->sq_array[index] = index;
+			stress_asm_mb();
+			*ring->sq_tail = tail + 1;
+			stress_asm_mb();
+
+			ring->res_valid = false;
+			/*
+			 *  enter can be interrupted before the SQE is consumed,
+			 *  resubmit until the kernel has taken it, otherwise
+			 *  reaping would wait for a send that was never issued
+			 */
+			for (;;) {
+				const long ret = syscall(__NR_io_uring_enter, ring->ring_fd, 1, 1,
+							 IORING_ENTER_GETEVENTS, NULL, 0);
+
+				stress_asm_mb();
+				if (*ring->sq_head != tail)
+					break;
+				if (((ret < 0) && (errno != EINTR)) || !stress_continue_flag()) {
+					const int saved_errno = (ret < 0) ? errno : EINTR;
+
+					/* take the unconsumed SQE back off the ring */
+					*ring->sq_tail = tail;
+					stress_asm_mb();
+					errno = saved_errno;
+					return -1;
+				}
+			}
+			if (stress_zerocopy_io_uring_reap(ring, true, ZEROCOPY_NOTIFS_MAX) < 0)
+				return -1;
+			if (UNLIKELY(ring->res <= 0)) {
+				errno = (ring->res < 0) ? -ring->res : EPIPE;
+				return -1;
+			}
+			sent += (size_t)ring->res;
+			*bytes += (uint64_t)ring->res;
+		}
+	}
+	/* the buffer may only be reused once all notifications are in */
+	return stress_zerocopy_io_uring_reap(ring, false, 0);
+}
+
+/*
+ *  stress_zerocopy_io_uring_deinit()
+ *	tear down the io-uring
+ */
+static void stress_zerocopy_io_uring_deinit(stress_zerocopy_t *zc)
+{
+	stress_zerocopy_io_uring_unmap(zc->ring);
+	zc->ring = NULL;
+}
+#endif
+
+static const stress_zerocopy_method_t zerocopy_methods[] = {
+	{ "send",		NULL,					stress_zerocopy_send,		NULL },
+#if defined(HAVE_ZEROCOPY_MSG_ZEROCOPY)
+	{ "msg-zerocopy",	stress_zerocopy_msg_zerocopy_init,	stress_zerocopy_msg_zerocopy,	NULL },
+#endif
+#if defined(HAVE_ZEROCOPY_SENDFILE)
+	{ "sendfile",		NULL,					stress_zerocopy_sendfile,	NULL },
+#endif
+#if defined(HAVE_ZEROCOPY_SPLICE)
+	{ "splice",		stress_zerocopy_splice_init,		stress_zerocopy_splice,		stress_zerocopy_splice_deinit },
+#endif
+#if defined(HAVE_ZEROCOPY_IO_URING)
+	{ "io-uring-zc",	stress_zerocopy_io_uring_init,		stress_zerocopy_io_uring_zc,	stress_zerocopy_io_uring_deinit },
+#endif
+};
+
+#define ZEROCOPY_METHODS	SIZEOF_ARRAY(zerocopy_methods)
+
+static int stress_set_zerocopy_method(const char *opt)
+{
+	size_t i;
+
+	if (!strcmp(opt, "all")) {
+		i = ZEROCOPY_METHODS;
+		return stress_set_setting("zerocopy-method", TYPE_ID_SIZE_T, &i);
+	}
+	for (i = 0; i < ZEROCOPY_METHODS; i++) {
+		if (!strcmp(opt, zerocopy_methods[i].name))
+			return stress_set_setting("zerocopy-method", TYPE_ID_SIZE_T, &i);
+	}
+	(void)fprintf(stderr, "invalid zerocopy-method '%s', allowed methods are: all", opt);
+	for (i = 0; i < ZEROCOPY_METHODS; i++)
+		(void)fprintf(stderr, " %s", zerocopy_methods[i].name);
+	(void)fprintf(stderr, "\n");
+	return -1;
+}
+
+/*
+ *  stress_zerocopy_cpu_time()
+ *	user and system CPU time of the calling process
+ */
+static double stress_zerocopy_cpu_time(void)
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) < 0)
+		return 0.0;
+	return stress_timeval_to_double(&usage.ru_utime) +
+	       stress_timeval_to_double(&usage.ru_stime);
+}
+
+/*
+ *  stress_zerocopy_cycles()
+ *	CPU cycles used so far, user and kernel
+ */
+static inline uint64_t stress_zerocopy_cycles(const int perf_fd)
+{
+#if defined(STRESS_PERF_STATS)
+	if (perf_fd >= 0)
+		return stress_perf_counter_read(perf_fd);
+#else
+	(void)perf_fd;
+#endif
+	return ZEROCOPY_NO_CYCLES;
+}
+
+/*
+ *  stress_zerocopy_receiver()
+ *	connect to the sender and drain the socket, verifying
+ *	the payload data if --verify is enabled
+ */
+static int stress_zerocopy_receiver(
+	stress_args_t *args,
+	const pid_t mypid,
+	const int zerocopy_port,
+	const uint8_t *payload,
+	const size_t size)
+{
+	struct sockaddr *addr;
+	socklen_t addr_len = 0;
+	uint8_t *buf;
+	uint64_t delay = 10000, offset = 0;
+	const bool verify = !!(g_opt_flags & OPT_FLAGS_VERIFY);
+	int fd, rc = EXIT_SUCCESS;
+
+	stress_parent_died_alarm();
+	(void)sched_settings_apply(true);
+
+	buf = (uint8_t *)malloc(ZEROCOPY_RECV_SIZE);
+	if (!buf)
+		return EXIT_NO_RESOURCE;
+
+retry:
+	if (!stress_continue_flag()) {
+		free(buf);
+		return EXIT_SUCCESS;
+	}
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		pr_fail("%s: socket failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		free(buf);
+		return EXIT_FAILURE;
+	}
+	if (stress_set_sockaddr(args->name, args->instance, mypid,
+			AF_INET, zerocopy_port,
+			&addr, &addr_len, NET_ADDR_LOOPBACK) < 0) {
+		(void)close(fd);
+		free(buf);
+		return EXIT_FAILURE;
+	}
+	if (connect(fd, addr, addr_len) < 0) {
+		(void)close(fd);
+		(void)shim_usleep(delay);
+
+		/* Backoff */
+		delay += 10000;
+		if (delay > 250000)
+			delay = 250000;
+		goto retry;
+	}
+
+	for (;;) {
+		const ssize_t n = recv(fd, buf, ZEROCOPY_RECV_SIZE, 0);
+		ssize_t i;
+
+		if (n <= 0) {
+			if ((n < 0) && (errno != EINTR) && (errno != ECONNRESET)) {
+				pr_fail("%s: recv failed, errno=%d (%s)\n",
+					args->name, errno, strerror(errno));
+				rc = EXIT_FAILURE;
+			}
+			break;
+		}
+		if (!verify)
+			continue;
+		/* every payload is the same, so the stream repeats the payload */
+		for (i = 0; i < n; i++) {
+			const size_t idx = (size_t)((offset + (uint64_t)i) % size);
+
+			if (UNLIKELY(buf[i] != payload[idx])) {
+				pr_fail("%s: payload data mismatch at stream offset %" PRIu64 "\n",
+					args->name, offset + (uint64_t)i);
+				rc = EXIT_FAILURE;
+				break;
+			}
+		}
+		if (rc != EXIT_SUCCESS)
+			break;
+		offset += (uint64_t)n;
+	}
+	(void)close(fd);
+	free(buf);
+
+	return rc;
+}
+
+/*
+ *  stress_zerocopy_accept()
+ *	listen on the loopback port and accept the receiver
+ */
+static int stress_zerocopy_accept(
+	stress_args_t *args,
+	const pid_t mypid,
+	const int zerocopy_port,
+	int *rc)
+{
+	struct sockaddr *addr;
+	socklen_t addr_len = 0;
+	int fd, sfd, so_reuseaddr = 1;
+
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		*rc = stress_exit_status(errno);
+		pr_fail("%s: socket failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		return -1;
+	}
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR,
+		&so_reuseaddr, sizeof(so_reuseaddr)) < 0) {
+		*rc = stress_exit_status(errno);
+		pr_fail("%s: setsockopt failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		(void)close(fd);
+		return -1;
+	}
+	if (stress_set_sockaddr(args->name, args->instance, mypid,
+			AF_INET, zerocopy_port,
+			&addr, &addr_len, NET_ADDR_LOOPBACK) < 0) {
+		*rc = EXIT_FAILURE;
+		(void)close(fd);
+		return -1;
+	}
+	if (bind(fd, addr, addr_len) < 0) {
+		*rc = stress_exit_status(errno);
+		pr_fail("%s: bind failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		(void)close(fd);
+		return -1;
+	}
+	if (listen(fd, 1) < 0) {
+		*rc = EXIT_FAILURE;
+		pr_fail("%s: listen failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		(void)close(fd);
+		return -1;
+	}
+	sfd = accept(fd, (struct sockaddr *)NULL, NULL);
+	if (sfd < 0) {
+		if ((errno != EINTR) || stress_continue_flag()) {
+			*rc = EXIT_FAILURE;
+			pr_fail("%s: accept failed, errno=%d (%s)\n",
+				args->name, errno, strerror(errno));
+		}
+	}
+	(void)close(fd);
+
+	return sfd;
+}
+
+/*
+ *  stress_zerocopy_report()
+ *	report throughput and sender CPU cost per method and the
+ *	percentage of MSG_ZEROCOPY sends the kernel had to copy
+ */
+static void stress_zerocopy_report(
+	stress_args_t *args,
+	const stress_zerocopy_t *zc,
+	const stress_zerocopy_stats_t *stats,
+	const bool have_cycles)
+{
+	size_t i, idx = 0;
+
+	for (i = 0; i < ZEROCOPY_METHODS; i++) {
+		const stress_zerocopy_stats_t *st = &stats[i];
+		const char *name = zerocopy_methods[i].name;
+		char tmp[64];
+
+		if ((st->bytes <= 0.0) || (st->duration <= 0.0))
+			continue;
+
+		(void)snprintf(tmp, sizeof(tmp), "%s Gbit/sec", name);
+		stress_metrics_set(args, idx++, tmp,
+			(st->bytes * 8.0) / (st->duration * 1.0E9), STRESS_HARMONIC_MEAN);
+		if (have_cycles) {
+			(void)snprintf(tmp, sizeof(tmp), "%s CPU cycles per byte", name);
+			stress_metrics_set(args, idx++, tmp,
+				st->cycles / st->bytes, STRESS_GEOMETRIC_MEAN);
+		} else {
+			(void)snprintf(tmp, sizeof(tmp), "%s CPU nanosecs per byte", name);
+			stress_metrics_set(args, idx++, tmp,
+				(st->cpu_time * STRESS_DBL_NANOSECOND) / st->bytes, STRESS_GEOMETRIC_MEAN);
+		}
+	}
+	if (zc->zc_completed > 0)
+		stress_metrics_set(args, idx, "% msg-zerocopy sends copied",
+			100.0 * (double)zc->zc_copied / (double)zc->zc_completed,
+			STRESS_GEOMETRIC_MEAN);
+}
+
+/*
+ *  stress_zerocopy_sender()
+ *	send the payload through each method in turn
+ */
+static int stress_zerocopy_sender(
+	stress_args_t *args,
+	stress_zerocopy_t *zc,
+	const size_t zerocopy_method,
+	const pid_t mypid,
+	const int zerocopy_port)
+{
+	stress_zerocopy_stats_t stats[ZEROCOPY_METHODS];
+	const uint32_t round_payloads = (zc->size >= ZEROCOPY_ROUND_BYTES) ?
+		1 : (uint32_t)(ZEROCOPY_ROUND_BYTES / zc->size);
+	int perf_fd = -1, rc = EXIT_SUCCESS;
+	bool have_cycles, sending = true;
+	size_t i, enabled = 0;
+
+	(void)shim_memset(stats, 0, sizeof(stats));
+
+	if (stress_sig_stop_stressing(args->name, SIGALRM) < 0)
+		return EXIT_FAILURE;
+
+	zc->sfd = stress_zerocopy_accept(args, mypid, zerocopy_port, &rc);
+	if (zc->sfd < 0)
+		return rc;
+
+	for (i = 0; i < ZEROCOPY_METHODS; i++) {
+		const stress_zerocopy_method_t *method = &zerocopy_methods[i];
+
+		if ((zerocopy_method < ZEROCOPY_METHODS) && (zerocopy_method != i)) {
+			stats[i].disabled = true;
+			continue;
+		}
+		if (method->init && (method->init(args, zc) < 0)) {
+			if (args->instance == 0)
+				pr_inf("%s: %s method not available, errno=%d (%s), skipping it\n",
+					args->name, method->name, errno, strerror(errno));
+			stats[i].disabled = true;
+			continue;
+		}
+		stats[i].initialized = true;
+		enabled++;
+	}
+	if (enabled == 0) {
+		pr_inf_skip("%s: no send methods available, skipping stressor\n", args->name);
+		rc = EXIT_NO_RESOURCE;
+		goto close_sfd;
+	}
+
+#if defined(STRESS_PERF_STATS)
+	perf_fd = stress_perf_cycles_open();
+#endif
+	have_cycles = (perf_fd >= 0);
+	if (!have_cycles && (args->instance == 0))
+		pr_inf("%s: CPU cycle perf counter not available, reporting CPU time per byte\n",
+			args->name);
+
+	do {
+		for (i = 0; sending && (i < ZEROCOPY_METHODS); i++) {
+			const stress_zerocopy_method_t *method = &zerocopy_methods[i];
+			stress_zerocopy_stats_t *st = &stats[i];
+			uint64_t bytes = 0, c1, c2;
+			uint32_t payloads = round_payloads;
+			double t1, t2, cpu1, cpu2;
+			int ret;
+
+			if (st->disabled)
+				continue;
+			if (!stress_continue(args))
+				break;
+			/* don't overshoot --zerocopy-ops */
+			if (args->max_ops) {
+				const uint64_t left = args->max_ops - stress_bogo_get(args);
+
+				if (left < (uint64_t)payloads)
+					payloads = (uint32_t)left;
+			}
+
+			c1 = stress_zerocopy_cycles(perf_fd);
+			cpu1 = stress_zerocopy_cpu_time();
+			t1 = stress_time_now();
+			ret = method->send(zc, payloads, &bytes);
+			t2 = stress_time_now();
+			cpu2 = stress_zerocopy_cpu_time();
+			c2 = stress_zerocopy_cycles(perf_fd);
+
+			st->bytes += (double)bytes;
+			st->duration += t2 - t1;
+			st->cpu_time += cpu2 - cpu1;
+			if ((c1 != ZEROCOPY_NO_CYCLES) && (c2 != ZEROCOPY_NO_CYCLES))
+				st->cycles += (double)(c2 - c1);
+			stress_bogo_add(args, bytes / zc->size);
+
+			if (ret < 0) {
+				if ((errno == EINTR) || (errno == EPIPE) || (errno == ECONNRESET)) {
+					/* stopped or the receiver has gone */
+					sending = false;
+				} else if ((bytes == 0) &&
+					   ((errno == EINVAL) || (errno == EOPNOTSUPP) || (errno == ENOSYS))) {
+					if (args->instance == 0)
+						pr_inf("%s: %s method not supported, errno=%d (%s), skipping it\n",
+							args->name, method->name, errno, strerror(errno));
+					st->disabled = true;
+					if (--enabled == 0)
+						sending = false;
+				} else {
+					pr_fail("%s: %s method failed, errno=%d (%s)\n",
+						args->name, method->name, errno, strerror(errno));
+					rc = EXIT_FAILURE;
+					sending = false;
+				}
+			}
+		}
+	} while (sending && stress_continue(args));
+
+	if (perf_fd >= 0)
+		(void)close(perf_fd);
+
+	stress_zerocopy_report(args, zc, stats, have_cycles);
+
+	for (i = 0; i < ZEROCOPY_METHODS; i++) {
+		const stress_zerocopy_method_t *method = &zerocopy_methods[i];
+
+		if (stats[i].initialized && method->deinit)
+			method->deinit(zc);
+	}
+close_sfd:
+	(void)shutdown(zc->sfd, SHUT_RDWR);
+	(void)close(zc->sfd);
+
+	return rc;
+}
+
+static void stress_zerocopy_sigpipe_handler(int signum)
+{
+	(void)signum;
+
+	stress_continue_set_flag(false);
+}
+
+/*
+ *  stress_zerocopy_file()
+ *	create an unlinked file holding the payload
+ *	for the sendfile and splice methods
+ */
+static int stress_zerocopy_file(stress_args_t *args, stress_zerocopy_t *zc)
+{
+	char filename[PATH_MAX];
+	size_t written = 0;
+	int fd;
+
+	(void)stress_temp_filename_args(args,
+		filename, sizeof(filename), stress_mwc32());
+	if ((fd = open(filename, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR)) < 0) {
+		pr_err("%s: open %s failed, errno=%d (%s)\n",
+			args->name, filename, errno, strerror(errno));
+		return -1;
+	}
+	(void)shim_unlink(filename);
+
+	while (written < zc->size) {
+		const ssize_t n = write(fd, zc->buf + written, zc->size - written);
+
+		if (n <= 0) {
+			pr_err("%s: write to %s failed, errno=%d (%s)\n",
+				args->name, filename, errno, strerror(errno));
+			(void)close(fd);
+			return -1;
+		}
+		written += (size_t)n;
+	}
+	return fd;
+}
+
+/*
+ *  stress_zerocopy
+ *	compare copying and zero-copy socket send paths
+ *	streaming the same payload over loopback TCP
+ */
+static int stress_zerocopy(stress_args_t *args)
+{
+	stress_zerocopy_t zc;
+	pid_t pid, mypid = getpid();
+	int zerocopy_port = DEFAULT_ZEROCOPY_PORT;
+	uint64_t zerocopy_size = DEFAULT_ZEROCOPY_SIZE;
+	size_t zerocopy_method = ZEROCOPY_METHODS;
+	int rc = EXIT_SUCCESS, ret, reserved_port, parent_cpu;
+	size_t i;
+
+	if (stress_sigchld_set_handler(args) < 0)
+		return EXIT_NO_RESOURCE;
+
+	(void)stress_get_setting("zerocopy-method", &zerocopy_method);
+	(void)stress_get_setting("zerocopy-port", &zerocopy_port);
+	if (!stress_get_setting("zerocopy-size", &zerocopy_size)) {
+		if (g_opt_flags & OPT_FLAGS_MAXIMIZE)
+			zerocopy_size = MAX_ZEROCOPY_SIZE;
+		if (g_opt_flags & OPT_FLAGS_MINIMIZE)
+			zerocopy_size = MIN_ZEROCOPY_SIZE;
+	}
+
+	(void)shim_memset(&zc, 0, sizeof(zc));
+	zc.size = (size_t)zerocopy_size;
+	zc.sfd = -1;
+	zc.pipe_fds[0] = -1;
+	zc.pipe_fds[1] = -1;
+
+	/* page aligned so MSG_ZEROCOPY and SEND_ZC pin whole pages */
+	zc.buf = (uint8_t *)mmap(NULL, zc.size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (zc.buf == MAP_FAILED) {
+		pr_inf_skip("%s: cannot mmap %zu byte payload buffer, skipping stressor\n",
+			args->name, zc.size);
+		return EXIT_NO_RESOURCE;
+	}
+	for (i = 0; i < zc.size; i++)
+		zc.buf[i] = stress_ascii64[(i ^ (i >> 6)) & 63];
+
+	ret = stress_temp_dir_mk_args(args);
+	if (ret < 0) {
+		rc = stress_exit_status(-ret);
+		goto unmap_buf;
+	}
+	zc.file_fd = stress_zerocopy_file(args, &zc);
+	if (zc.file_fd < 0) {
+		rc = EXIT_NO_RESOURCE;
+		goto rm_dir;
+	}
+
+	zerocopy_port += args->instance;
+	reserved_port = stress_net_reserve_ports(zerocopy_port, zerocopy_port);
+	if (reserved_port < 0) {
+		pr_inf_skip("%s: cannot reserve port %d, skipping stressor\n",
+			args->name, zerocopy_port);
+		rc = EXIT_NO_RESOURCE;
+		goto close_file;
+	}
+	zerocopy_port = reserved_port;
+
+	pr_dbg("%s: process [%d] using socket port %d\n",
+		args->name, (int)args->pid, zerocopy_port);
+
+	if (stress_sighandler(args->name, SIGPIPE, stress_zerocopy_sigpipe_handler, NULL) < 0) {
+		rc = EXIT_NO_RESOURCE;
+		goto release_port;
+	}
+
+	stress_set_proc_state(args->name, STRESS_STATE_RUN);
+again:
+	parent_cpu = stress_get_cpu();
+	pid = fork();
+	if (pid < 0) {
+		if (stress_redo_fork(args, errno))
+			goto again;
+		if (!stress_continue(args))
+			goto finish;
+		pr_err("%s: fork failed, errno=%d (%s)\n",
+			args->name, errno, strerror(errno));
+		rc = EXIT_FAILURE;
+		goto finish;
+	} else if (pid == 0) {
+		(void)stress_change_cpu(args, parent_cpu);
+
+		rc = stress_zerocopy_receiver(args, mypid, zerocopy_port, zc.buf, zc.size);
+		_exit(rc);
+	} else {
+		int status;
+
+		rc = stress_zerocopy_sender(args, &zc, zerocopy_method, mypid, zerocopy_port);
+		/* the receiver exits once the socket is shut down */
+		if (shim_waitpid(pid, &status, 0) == pid) {
+			if (WIFEXITED(status) && (WEXITSTATUS(status) != EXIT_SUCCESS) &&
+			    (rc == EXIT_SUCCESS))
+				rc = WEXITSTATUS(status);
+		} else {
+			(void)stress_kill_pid_wait(pid, NULL);
+		}
+	}
+finish:
+	stress_set_proc_state(args->name, STRESS_STATE_DEINIT);
+release_port:
+	stress_net_release_ports(zerocopy_port, zerocopy_port);
+close_file:
+	(void)close(zc.file_fd);
+rm_dir:
+	(void)stress_temp_dir_rm_args(args);
+unmap_buf:
+	(void)munmap((void *)zc.buf, zc.size);
+
+	return rc;
+}
+
+static const stress_opt_set_func_t opt_set_funcs[] = {
+	{ OPT_zerocopy_method,	stress_set_zerocopy_method },
+	{ OPT_zerocopy_port,	stress_set_zerocopy_port },
+	{ OPT_zerocopy_size,	stress_set_zerocopy_size },
+	{ 0,			NULL },
+};
+
+stressor_info_t stress_zerocopy_info = {
+	.stressor = stress_zerocopy,
+	.class = CLASS_NETWORK | CLASS_OS,
+	.opt_set_funcs = opt_set_funcs,
+	.verify = VERIFY_OPTIONAL,
+	.help = help
+};